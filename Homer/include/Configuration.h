@@ -236,6 +236,7 @@ public:
     /* additional fixed values */
     int GetSystrayTimeout(){ return 6000; /* ms */ }
     int GetContactPresenceCheckPeriod(){ return 60*1000; /* 1 minute to allow NAT hole punching based on bidirectional SIP probe request ping-pong */ }
+    int GetContactPresenceScheduleInterval(){ return 1000; /* ms, presence checks are spread over the check period in steps of this size */ }
 
     /* debugging state machine */
     bool DebuggingEnabled();
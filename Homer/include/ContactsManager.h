@@ -29,6 +29,7 @@
 #define _CONTACTS_POOL_
 
 #include <Widgets/OverviewContactsWidget.h>
+#include <HBTime.h>
 
 #include <QAbstractItemModel>
 #include <QMutex>
@@ -45,6 +46,15 @@ namespace Homer { namespace Gui {
 #define         CONTACT_UNAVAILABLE             0
 #define         CONTACT_AVAILABLE               1
 
+// presence subscription state of a contact
+#define         CONTACT_SUBSCRIPTION_REJECTED   -1 // peer doesn't support presence subscriptions, fall back to probing
+#define         CONTACT_SUBSCRIPTION_NONE       0
+#define         CONTACT_SUBSCRIPTION_PENDING    1
+#define         CONTACT_SUBSCRIPTION_ACTIVE     2 // peer notifies state changes, no probing needed
+
+// back off for unreachable contacts: up to 2^x check periods between two probes
+#define         CONTACT_PRESENCE_MAX_BACKOFF    4
+
 struct ContactDescriptor
 {
     QString        Name;
@@ -54,6 +64,10 @@ struct ContactDescriptor
     enum TransportType Transport;
     int            State; // 0-offline, 1-online/available
     unsigned int   Id;
+    /* presence scheduling */
+    int64_t        PresenceNextCheck; // time stamp in us
+    int            PresenceFailures; // consecutive unanswered probes
+    int            PresenceSubscription; // see CONTACT_SUBSCRIPTION_*
 
     QString     toString();
     std::string getUserStdStr();
@@ -110,8 +124,10 @@ public:
     bool SplitAddress(QString pAddr, QString &pUser, QString &pHost, QString &pPort);
 
     /* contact availability management */
-    void ProbeAvailabilityForAll();
+    void ProbeAvailabilityForAll(); // reschedules the presence checks of all contacts, spread over one check period
+    void ProcessPresenceSchedule(); // sends due presence checks, has to be called every GetContactPresenceScheduleInterval()
     void UpdateContactState(QString pContact, enum TransportType pContactTransport, bool pState);
+    void UpdateContactSubscription(QString pContact, enum TransportType pContactTransport, int pSubscriptionState);
 
     /* sorting */
     void SortByState(bool pDescending);
@@ -121,6 +137,9 @@ public:
     void RegisterAtController(ContactListModel *pContactsModel);
 
 private:
+    bool IsThisContact(ContactsVector::iterator pContact, QString pContactId, QString pContactTransport);
+    void ResetPresenceSchedule(ContactDescriptor &pContact, int64_t pNextCheck);
+
     ContactListModel    *mContactsModel;
     ContactsVector      mContacts;
     std::string         mContactsFile;
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Sliding window with selective acknowledgments and congestion control for file transfers
+ * Author:  Thomas Volkert
+ * Since:   2012-12-04
+ */
+
+#ifndef _FILE_TRANSFER_WINDOW_
+#define _FILE_TRANSFER_WINDOW_
+
+#include <HBTime.h>
+
+#include <map>
+#include <vector>
+
+namespace Homer { namespace Gui {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// congestion window limits in packets
+#define FTW_INITIAL_WINDOW              4
+#define FTW_MAX_WINDOW                  1024
+
+// number of SACK blocks per acknowledgment
+#define FTW_MAX_SACK_BLOCKS             4
+
+// number of packets which have to be acknowledged above a hole before the hole is treated as lost
+#define FTW_DUPLICATE_THRESHOLD         3
+
+// retransmission timeout limits
+#define FTW_INITIAL_RTO                 1000 // ms
+#define FTW_MIN_RTO                     200 // ms
+#define FTW_MAX_RTO                     8000 // ms
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct FileTransferRange
+{
+    uint64_t    Start;
+    uint64_t    End;
+};
+
+typedef std::vector<FileTransferRange> FileTransferRanges;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// sender side: decides which fragment is sent next, the caller has to serialize all calls
+class FileTransferWindow
+{
+public:
+    FileTransferWindow(uint64_t pStreamSize, unsigned int pSegmentSize);
+
+    virtual ~FileTransferWindow();
+
+    /* sending */
+    bool GetNextSegment(int64_t pNow, uint64_t &pStart, uint64_t &pEnd, bool &pRetransmission); // returns false if the window is closed
+    int64_t GetTimeout(int64_t pNow); // in us, -1 if nothing is in flight
+
+    /* feedback from receiver */
+    void ReceivedSack(int64_t pNow, uint64_t pCumulativeAck, const FileTransferRanges &pBlocks, uint64_t pEcho);
+    void Seek(uint64_t pPosition);
+
+    /* state */
+    bool IsComplete();
+    uint64_t GetAcknowledged();
+    void SetMaximumWindow(int pPackets);
+    double GetCongestionWindow();
+    int64_t GetSmoothedRtt(); // in us
+    int64_t GetRetransmissionCounter();
+
+    /* simulated loopback transfer with the given RTT and loss ratio, returns the throughput in MB/s */
+    static double RunLoopbackBenchmark(int pRtt, float pLoss, uint64_t pStreamSize, int pMaximumWindow = FTW_MAX_WINDOW, int64_t *pRetransmissions = NULL);
+
+private:
+    typedef std::multimap<int64_t, uint64_t> SendTimes;
+    struct Segment
+    {
+        uint64_t    End;
+        int64_t     SendTime;
+        bool        Retransmitted;
+        bool        Sacked;
+        bool        Lost;
+        bool        InPipe;
+        SendTimes::iterator SendTimeEntry;
+    };
+    typedef std::map<uint64_t, Segment> Segments;
+
+    void AddToPipe(uint64_t pStart, Segment &pSegment);
+    void RemoveFromPipe(Segment &pSegment);
+    void CheckRetransmissionTimeout(int64_t pNow);
+    void DetectLosses();
+    void EnterRecovery();
+    void UpdateRtt(int64_t pRtt);
+
+    Segments            mInFlight;
+    SendTimes           mPipe; // segments which are neither acknowledged nor considered as lost, ordered by send time
+    uint64_t            mStreamSize;
+    unsigned int        mSegmentSize;
+    uint64_t            mAcknowledged;
+    uint64_t            mNext;
+    uint64_t            mHighestSacked;
+    uint64_t            mRecoveryPoint;
+    bool                mInRecovery;
+    double              mCongestionWindow;
+    double              mSlowStartThreshold;
+    int                 mMaximumWindow;
+    int64_t             mSmoothedRtt;
+    int64_t             mRttVariance;
+    int64_t             mRto;
+    int64_t             mRetransmissions;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// receiver side: tracks received fragments, the caller has to serialize all calls
+class FileTransferScoreboard
+{
+public:
+    FileTransferScoreboard();
+
+    virtual ~FileTransferScoreboard();
+
+    bool Received(uint64_t pStart, uint64_t pEnd); // returns false for duplicates
+    uint64_t GetCumulativeAck();
+    void GetSackBlocks(FileTransferRanges &pBlocks);
+    void Seek(uint64_t pPosition);
+
+private:
+    typedef std::map<uint64_t, uint64_t> Ranges;
+
+    Ranges              mRanges; // received ranges beyond mCumulativeAck
+    uint64_t            mCumulativeAck;
+    uint64_t            mLastReceived;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}}
+
+#endif
@@ -43,6 +43,9 @@ using namespace Homer::Base;
 // de/activate acknowledgments of file data packets
 //#define FTM_ACK_DATA_PACKETS
 
+// de/activate windowed transfers with selective acknowledgments, otherwise the stop-and-wait scheme is used
+#define FTM_WINDOWED_TRANSFERS
+
 //#define FTM_DEBUG_TIMING
 
 #define FTM_DEBUG_DATA_PACKETS
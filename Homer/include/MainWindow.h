@@ -45,7 +45,9 @@
 #include <Widgets/OverviewPlaylistWidget.h>
 #include <Widgets/ParticipantWidget.h>
 #include <Widgets/VideoWidget.h>
+#include <ActiveSpeakerDetector.h>
 #include <AudioPlayback.h>
+#include <DeviceRegistry.h>
 #include <Meeting.h>
 #include <MeetingEvents.h>
 
@@ -82,7 +84,8 @@ class MainWindow:
         public QMainWindow,
         AudioPlayback,
         public Ui_MainWindow,
-        public MeetingObserver
+        public MeetingObserver,
+        public DeviceRegistryObserver
 {
 Q_OBJECT
     ;
@@ -123,6 +126,7 @@ private slots:
     void actionActivateDebuggingGlobally();
     void actionActivateNetworkSimulationWidgets();
     void actionActivateMosaicMode(bool pActive);
+    void UpdateVideoSubscriptions();
 
     void activatedSysTray(QSystemTrayIcon::ActivationReason pReason);
 
@@ -134,13 +138,19 @@ private slots:
 
 private:
     void initializeConfiguration(QStringList &pArguments);
+    void readStartupSettings();
+    void initializeCodecs();
+    void initializeStartSound();
+    void initializeContacts();
     void initializeGUI();
     void initializeLanguage();
     void initializeFeatureDisablers(QStringList &pArguments);
     void initializeDebugging(QStringList &pArguments);
     void ShowFfmpegCaps(QStringList &pArguments);
+    void initializeNetworkInterfaces();
     void initializeConferenceManagement();
     void initializeVideoAudioIO();
+    void initializeDesktopSources();
     void initializeColoring();
     void initializeWidgetsAndMenus();
     void initializeScreenCapturing();
@@ -161,7 +171,7 @@ private:
     void SetLanguage(QString pLanguage);
     void CreateSysTray();
     void loadSettings();
-    bool GetNetworkInfo(LocalAddressesList &pLocalAddressesList, QString &pLocalSourceIp, QString &pLocalLoopIp);
+    bool GetNetworkInfo(LocalAddressesList &pLocalAddressesList, QString &pLocalSourceIp, QString &pLocalLoopIp, QString pLastSipListenerAddress);
     QString CompleteIpAddress(QString pAddr);
     ParticipantWidget* AddParticipantSession(QString pUser, QString pHost, QString pPort, enum TransportType pTransport, QString pIp, int pInitState);
     void DeleteParticipantSession(ParticipantWidget *pParticipantWidget);
@@ -169,12 +179,15 @@ private:
     /* handle incoming Meeting events */
     void GetEventSource(GeneralEvent *pEvent, QString &pSender, QString &pSenderApp);
     virtual void handleMeetingEvent(GeneralEvent *pEvent);
+    /* handle changed device lists, called by the hotplug monitor */
+    virtual void handleDeviceRegistryEvent(std::string pEnumerator, enum MediaType pMediaType);
 
     QHttp           		    *mHttpGetVersionServer;
     QString		 			    mAbsBinPath;
     AvailabilityWidget 		    *mOnlineStatusWidget;
     StreamingControlWidget 	    *mMediaSourcesControlWidget;
     LocalAddressesList 		    mLocalAddresses;
+    QString                     mLocalSourceIp;
     OverviewContactsWidget 	    *mOverviewContactsWidget;
     OverviewDataStreamsWidget   *mOverviewDataStreamsWidget;
     OverviewErrorsWidget        *mOverviewErrorsWidget;
@@ -201,6 +214,14 @@ private:
     static bool                 mStarting;
     /* program timing */
     QTime                       mStartTime;
+    /* startup, copies of the settings which are used by background steps */
+    QString                     mStartupSipListenerAddress;
+    QString                     mStartupStunServer;
+    std::string                 mStartupContactFile;
+    bool                        mStartupNatSupport;
+    int                         mStartupSipStartPort;
+    enum TransportType          mStartupSipListenerTransport;
+    int                         mStartupVideoAudioStartPort;
     /* network simulator */
     #if HOMER_NETWORK_SIMULATOR
         NetworkSimulator            *mNetworkSimulator;
@@ -213,6 +234,8 @@ private:
 	bool						mMosaicModeToolBarOnlineStatusWasVisible;
 	bool						mMosaicModeToolBarMediaSourcesWasVisible;
     QPalette					mMosaicOriginalPalette;
+    ActiveSpeakerDetector       mActiveSpeakerDetector;
+    QTimer                      *mActiveSpeakerTimer;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -31,6 +31,9 @@
 #include <MediaSource.h>
 
 #include <QWidget>
+#include <QImage>
+#include <QRect>
+#include <QVector>
 #include <QTime>
 #include <QMutex>
 #include <QWaitCondition>
@@ -52,6 +55,11 @@ using namespace Homer::Multimedia;
 #define DESKTOP_SEGMENT_MIN_WIDTH                   352
 #define DESKTOP_SEGMENT_MIN_HEIGHT                  288
 
+// edge length of the tiles which are compared between two screenshots
+#define MSD_TILE_SIZE                               32
+// an unchanged screen is delivered with this period in order to keep receivers up to date
+#define MSD_REFRESH_PERIOD                          1000 // ms
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class MediaSourceDesktop:
@@ -103,6 +111,9 @@ protected:
 private:
     friend class SegmentSelectionDialog;
 
+    /* change detection */
+    void DetectChangedRegions(const QImage &pScreenshot, QVector<QRect> &pRegions);
+
     bool				mMouseVisualization;
     bool				mAutoDesktop;
     QPainter            *mTargetPainter;
@@ -111,7 +122,11 @@ private:
     void                *mOutputScreenshot;
     void                *mOriginalScreenshot;
     bool                mScreenshotUpdated;
+    bool                mOutputScreenshotValid;
+    QImage              mLastScreenshot;
+    QImage              mMouseImage;
     QTime               mLastTimeGrabbed;
+    QTime               mLastTimeDelivered;
     QMutex				mMutexScreenshot, mMutexGrabberActive;
     QWaitCondition      mWaitConditionScreenshotUpdated;
     /* recording */
@@ -46,6 +46,7 @@
 #include <QKeyEvent>
 #include <QMainWindow>
 
+#include <AVSynchronizer.h>
 #include <MediaSource.h>
 #include <MeetingEvents.h>
 
@@ -104,6 +105,7 @@ public:
 
     /* A/V sync. */
     void SyncClock(MediaSource* pSource);
+    void SetAVSynchronizer(AVSynchronizer *pAVSynchronizer);
 
     /* multiple channels control */
     bool SupportsMultipleInputStreams();
@@ -177,6 +179,7 @@ protected:
     /* A/V synch. */
     bool                mSyncClockAsap;
     MediaSource*        mSyncClockMasterSource;
+    AVSynchronizer      *mAVSynchronizer;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,121 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: dependency graph of the application startup steps with concurrent execution of independent steps
+ * Author:  Thomas Volkert
+ * Since:   2012-12-11
+ */
+
+#ifndef _STARTUP_GRAPH_
+#define _STARTUP_GRAPH_
+
+#include <HBCondition.h>
+#include <HBMutex.h>
+#include <HBThread.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Homer { namespace Gui {
+
+using namespace Homer::Base;
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define STARTUP StartupGraph::getInstance()
+
+///////////////////////////////////////////////////////////////////////////////
+
+class MainWindow;
+typedef void (MainWindow::*StartupFunction)();
+
+enum StartupStepState
+{
+    STARTUP_STEP_WAITING = 0,
+    STARTUP_STEP_RUNNING,
+    STARTUP_STEP_FINISHED
+};
+
+struct StartupStep
+{
+    std::string             Name;
+    StartupFunction         Function;
+    bool                    Background;
+    std::vector<int>        Dependencies;
+    enum StartupStepState   State;
+    int64_t                 StartTime; // in us, relative to the start of the graph
+    int64_t                 Duration; // in us
+};
+
+typedef std::vector<StartupStep> StartupSteps;
+
+///////////////////////////////////////////////////////////////////////////////
+
+class StartupWorker;
+
+class StartupGraph
+{
+public:
+    StartupGraph();
+
+    virtual ~StartupGraph();
+
+    static StartupGraph& getInstance();
+
+    /* steps run in the main thread unless they are marked as background steps,
+     * dependencies are given as comma separated list of the names of formerly added steps */
+    void addStep(std::string pName, StartupFunction pFunction, std::string pDependencies = "", bool pBackground = false);
+    bool run(MainWindow *pMainWindow); // returns after all steps are finished, false if a step has failed
+    void reportFailure(std::string pReason); // called by a failed step, no further steps are started afterwards
+    std::string getFailureReason();
+
+    /* statistic */
+    StartupSteps getSteps();
+    int64_t getDuration(); // in us
+    int64_t getMainThreadWaitingTime(); // in us, time the main thread had to wait for background steps
+    std::string getReport();
+
+private:
+    friend class StartupWorker;
+
+    int findStep(std::string pName);
+    bool isReady(int pStep);
+    void executeStep(int pStep);
+
+    MainWindow          *mMainWindow;
+    StartupSteps        mSteps;
+    int                 mFinishedSteps;
+    int64_t             mStartTime;
+    int64_t             mDuration;
+    int64_t             mMainThreadWaitingTime;
+    bool                mFailed;
+    std::string         mFailureReason;
+    Mutex               mMutex;
+    Condition           mStepFinishedCondition;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}}
+
+#endif
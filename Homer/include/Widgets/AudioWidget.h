@@ -57,6 +57,9 @@ using namespace Homer::Multimedia;
 
 #define SAMPLE_BUFFER_SIZE               16
 
+// the audio level is reported as silence if no samples were grabbed within this time, e.g., a stalled or closed stream
+#define AUDIO_LEVEL_TIMEOUT              500 // ms
+
 // de/activate frame handling
 //#define AUDIO_WIDGET_DEBUG_FRAMES
 
@@ -165,6 +168,12 @@ public:
     int64_t GetPlaybackGapsCounter();
     int GetPlaybackQueueUsage();
     int GetPlaybackQueueSize();
+    bool GetAdaptivePlayout();
+    int GetPlayoutDelay(); // in ms
+    int GetPlayoutTargetDelay(); // in ms
+
+    /* audio level */
+    int GetAudioLevel(); // peak level of the last grabbed samples in % of the full scale
 
     AudioWidget *GetAudioWidget();
 
@@ -208,6 +217,9 @@ private:
     /* A/V synch. */
     float               mUserAVDrift;
     float               mVideoDelayAVDrift;
+    /* audio level */
+    int                 mAudioLevel;
+    int64_t             mAudioLevelTime;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
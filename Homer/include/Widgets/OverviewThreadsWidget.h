@@ -63,6 +63,7 @@ private:
     virtual void contextMenuEvent(QContextMenuEvent *pContextMenuEvent);
     void FillCellText(int pRow, int pCol, QString pText);
     void FillRow(int pRow, Homer::Monitor::ProcessStatistic *pStats);
+    QString GetMemoryPoolReport();
 
     QPoint              mWinPos;
     QAction             *mAssignedAction;
@@ -147,6 +147,7 @@ public:
 
     /* Mosaic mode */
     void ToggleMosaicMode(bool pActive);
+    void SetVideoSubscription(enum VideoSubscription pSubscription);
 
 private slots:
     void ActionPlayPauseMovieFile(QString pFileName = "");
@@ -262,6 +263,7 @@ private:
     QString             	mCurrentMovieFile;
     MovieControlWidget      *mFullscreeMovieControlWidget;
     bool                    mAVSynchActive;
+    AVSynchronizer          *mAVSynchronizer; // continuous A/V sync. of live streams, audio playout is the master clock
     bool                    mAVPreBuffering;
     bool                    mAvPreBufferingAutoRestart;
     /* Mosaic mode */
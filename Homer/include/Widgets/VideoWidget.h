@@ -47,6 +47,8 @@
 #include <QFocusEvent>
 #include <QStringList>
 
+#include <ActiveSpeakerDetector.h>
+#include <FrameDropPolicy.h>
 #include <MediaSource.h>
 #include <MeetingEvents.h>
 
@@ -68,6 +70,9 @@ class ParticipantWidget;
 // de/activate automatic frame dropping in case the video widget is invisible (default is off)
 //#define VIDEO_WIDGET_DROP_WHEN_INVISIBLE
 
+// de/activate skipping of decoding and scaling for received streams while the video widget is invisible, e.g., hidden, docked away or minimized (default is on)
+#define VIDEO_WIDGET_SKIP_DECODING_WHEN_INVISIBLE
+
 // de/activate frame handling
 //#define VIDEO_WIDGET_DEBUG_FRAMES
 
@@ -109,6 +114,7 @@ public:
 
     /* Mosaic mode */
     void ToggleMosaicMode(bool pActive);
+    void SetVideoSubscription(enum VideoSubscription pSubscription);
 
 public slots:
     void ToggleVisibility();
@@ -120,7 +126,7 @@ private slots:
 private:
     bool IsFullScreen();
     void DialogAddNetworkSink();
-    void ShowFrame(void* pBuffer);
+    void ShowFrame(void* pBuffer, struct VideoFrameFormat pFrameFormat);
     void SetScaling(float pVideoScaleFactor);
     bool IsCurrentScaleFactor(float pScaleFactor);
     void SetResolutionFormat(VideoFormat pFormat);
@@ -135,6 +141,9 @@ private:
     /* status message per OSD text */
     void ShowOsdMessage(QString pText);
 
+    /* decoder suspension */
+    void UpdateDecoderSuspension();
+
     virtual void contextMenuEvent(QContextMenuEvent *event);
     virtual void dragEnterEvent(QDragEnterEvent *pEvent);
     virtual void dropEvent(QDropEvent *pEvent);
@@ -151,6 +160,8 @@ private:
     virtual void mouseReleaseEvent(QMouseEvent *pEvent);
     virtual void focusOutEvent(QFocusEvent *pEvent);
     virtual void timerEvent(QTimerEvent *pEvent);
+    virtual void showEvent(QShowEvent *pEvent);
+    virtual void hideEvent(QHideEvent *pEvent);
 
     /* user activity handling */
     void FullscreenMarkUserActive();
@@ -206,6 +217,10 @@ private:
     QTime				mTimeLastWidgetUpdate;
     /* Mosaic mode */
     bool				mMosaicMode;
+    enum VideoSubscription mVideoSubscription;
+    /* decoder suspension while invisible */
+    bool                mHidden;
+    QTime               mTimeHidden;
 };
 
 
@@ -222,14 +237,17 @@ public:
 
     /* forwarded interface to media source */
     void SetGrabResolution(int pX, int pY);
+    void SetOutputFormat(int pX, int pY, bool pMirrorHorizontal, bool pMirrorVertical);
 
     /* device control */
     VideoDevices GetPossibleDevices();
 
     /* frame grabbing */
     void SetFrameDropping(bool pDrop);
-    int GetCurrentFrame(void **pFrame, float *pFrameRate = NULL);
+    int GetCurrentFrame(void **pFrame, float *pFrameRate = NULL, struct VideoFrameFormat *pFrameFormat = NULL);
     int GetLastFrameNumber();
+    int64_t GetDroppedFrames(); // frames which were skipped because the widget couldn't keep up
+    void SetFrameRateLimit(int pFps); // 0 means unlimited
 
     VideoWidget *GetVideoWidget();
 
@@ -238,6 +256,7 @@ private:
     void DeinitFrameBuffers();
     void InitFrameBuffer(int pBufferId);
     void DoSetGrabResolution();
+    void DoSetOutputFormat();
     virtual void DoSetCurrentDevice();
     virtual void DoPlayNewFile();
     virtual void DoSeek();
@@ -251,14 +270,25 @@ private:
     void                *mFrame[FRAME_BUFFER_SIZE];
     unsigned long       mFrameNumber[FRAME_BUFFER_SIZE];
     int                 mFrameSize[FRAME_BUFFER_SIZE];
+    struct VideoFrameFormat mFrameFormat[FRAME_BUFFER_SIZE];
     int                 mFrameCurrentIndex, mFrameGrabIndex;
 
     int                 mResX;
     int                 mResY;
     int					mFrameWidthLastGrabbedFrame;
     int					mFrameHeightLastGrabbedFrame;
+    /* output format for the video widget */
+    bool                mSetOutputFormatAsap;
+    bool                mOutputFormatSupported;
+    int                 mOutputResX;
+    int                 mOutputResY;
+    bool                mOutputMirrorHorizontal;
+    bool                mOutputMirrorVertical;
     int                 mPendingNewFrames;
     bool                mDropFrames;
+    FrameDropPolicy     mFrameDropPolicy; // thins out the frames if the GUI can't keep up
+    int                 mFrameRateLimit;
+    int64_t             mLastFrameDeliveryTime;
     /* frame statistics */
     int                 mMissingFrames;
     /* A/V synch. */
@@ -208,6 +208,7 @@ void ContactsManager::LoadPool(string pContactsFile)
 				LOG(LOG_VERBOSE, "Loaded contact: name=%s, address=%s, port=%s, transport=%s", QString(tContact.Name.toAscii()).toStdString().c_str(), QString(tContact.User.toAscii() + "@" + tContact.Host.toAscii()).toStdString().c_str(), tContact.Port.toStdString().c_str(), Socket::TransportType2String(tContact.Transport).c_str());
 				tContact.Id = tEntry.attribute("Index", "0").toUInt();
 				tContact.State = CONTACT_UNAVAILABLE;
+				ResetPresenceSchedule(tContact, 0);
 
 				mContacts.push_back(tContact);
 			}else
@@ -239,10 +240,11 @@ void ContactsManager::AddContact(ContactDescriptor &pContact)
 {
     pContact.State = CONTACT_UNAVAILABLE;
 
+    // check the new contact with the next scheduling step
+    ResetPresenceSchedule(pContact, 0);
+
     mContactsMutex.lock();
     mContacts.push_back(pContact);
-    if (CONF.GetSipContactsProbing())
-        MEETING.SendProbe(MEETING.SipCreateId(pContact.getUserStdStr(), pContact.getHostStdStr(), pContact.getPortStdStr()), pContact.Transport);
     mContactsMutex.unlock();
     if (mContactsModel != NULL)
         mContactsModel->UpdateView();
@@ -326,6 +328,7 @@ ContactDescriptor* ContactsManager::CreateContactDescriptor(QString pUser, QStri
     tResult->User = pUser;
     tResult->Host = pHost;
     tResult->Port = pPort;
+    ResetPresenceSchedule(*tResult, 0);
 
     return tResult;
 }
@@ -448,6 +451,23 @@ bool ContactsManager::FavorizedContact(QString pUser, QString pHost, QString pPo
     return tFound;
 }
 
+void ContactsManager::ResetPresenceSchedule(ContactDescriptor &pContact, int64_t pNextCheck)
+{
+    pContact.PresenceNextCheck = pNextCheck;
+    pContact.PresenceFailures = 0;
+    pContact.PresenceSubscription = CONTACT_SUBSCRIPTION_NONE;
+}
+
+bool ContactsManager::IsThisContact(ContactsVector::iterator pContact, QString pContactId, QString pContactTransport)
+{
+    QString tItTransport = QString(Socket::TransportType2String(pContact->Transport).c_str());
+    if (tItTransport == "auto")
+        tItTransport = "UDP";
+    LOG(LOG_VERBOSE, "Comparing %s==%s, %s==%s", MEETING.SipCreateId(pContact->getUserStdStr(), pContact->getHostStdStr(), pContact->getPortStdStr()).c_str(), pContactId.toStdString().c_str(), tItTransport.toStdString().c_str(), pContactTransport.toStdString().c_str());
+
+    return ((MEETING.SipCreateId(pContact->getUserStdStr(), pContact->getHostStdStr(), pContact->getPortStdStr()) == pContactId.toStdString()) && (tItTransport == pContactTransport));
+}
+
 void ContactsManager::ProbeAvailabilityForAll()
 {
     if (!CONF.GetSipContactsProbing())
@@ -456,13 +476,81 @@ void ContactsManager::ProbeAvailabilityForAll()
     mContactsMutex.lock();
 
     ContactsVector::iterator tIt, tItEnd = mContacts.end();
+    int64_t tNow = Time::GetTimeStamp();
+    int64_t tPeriod = (int64_t)CONF.GetContactPresenceCheckPeriod() * 1000;
+    int64_t tContacts = (int64_t)mContacts.size();
+    int64_t tIndex = 0;
 
+    // spread the checks evenly over one period instead of sending a burst of probes
     for (tIt = mContacts.begin(); tIt != tItEnd; tIt++)
     {
-        MEETING.SendProbe(MEETING.SipCreateId(tIt->getUserStdStr(), tIt->getHostStdStr(), tIt->getPortStdStr()), tIt->Transport);
+        tIt->PresenceNextCheck = tNow + tPeriod * tIndex / tContacts;
+        tIt->PresenceFailures = 0;
+        if (tIt->PresenceSubscription == CONTACT_SUBSCRIPTION_REJECTED)
+            tIt->PresenceSubscription = CONTACT_SUBSCRIPTION_NONE;
+        tIndex++;
     }
 
     mContactsMutex.unlock();
+
+    ProcessPresenceSchedule();
+}
+
+void ContactsManager::ProcessPresenceSchedule()
+{
+    if (!CONF.GetSipContactsProbing())
+        return;
+
+    ContactsVector tProbes, tSubscriptions;
+    ContactsVector::iterator tIt, tItEnd;
+    int64_t tNow = Time::GetTimeStamp();
+    int64_t tPeriod = (int64_t)CONF.GetContactPresenceCheckPeriod() * 1000;
+
+    mContactsMutex.lock();
+
+    // limit the checks per scheduling step to the share of the contacts pool which belongs to one step of the check period
+    int tBudget = (mContacts.size() * CONF.GetContactPresenceScheduleInterval() + CONF.GetContactPresenceCheckPeriod() - 1) / CONF.GetContactPresenceCheckPeriod();
+    if (tBudget < 1)
+        tBudget = 1;
+
+    tItEnd = mContacts.end();
+    for (tIt = mContacts.begin(); (tIt != tItEnd) && (tBudget > 0); tIt++)
+    {
+        if (tIt->PresenceNextCheck > tNow)
+            continue;
+
+        // the peer notifies us about state changes, the SIP stack refreshes the short-lived subscription and a failed refresh resets it, which resumes probing
+        if (tIt->PresenceSubscription == CONTACT_SUBSCRIPTION_ACTIVE)
+        {
+            tIt->PresenceNextCheck = tNow + tPeriod;
+            continue;
+        }
+
+        if (tIt->PresenceSubscription == CONTACT_SUBSCRIPTION_NONE)
+        {
+            tIt->PresenceSubscription = CONTACT_SUBSCRIPTION_PENDING;
+            tSubscriptions.push_back(*tIt);
+        }
+
+        // back off exponentially for unreachable contacts
+        int tBackoff = (tIt->PresenceFailures < CONTACT_PRESENCE_MAX_BACKOFF) ? tIt->PresenceFailures : CONTACT_PRESENCE_MAX_BACKOFF;
+        tIt->PresenceNextCheck = tNow + (tPeriod << tBackoff);
+        tProbes.push_back(*tIt);
+        tBudget--;
+    }
+
+    mContactsMutex.unlock();
+
+    // signaling is done without holding the mutex because answers of the registrar may be delivered synchronously
+    for (tIt = tSubscriptions.begin(); tIt != tSubscriptions.end(); tIt++)
+    {
+        if (!MEETING.SendPresenceSubscription(MEETING.SipCreateId(tIt->getUserStdStr(), tIt->getHostStdStr(), tIt->getPortStdStr()), tIt->Transport))
+            UpdateContactSubscription(QString::fromLocal8Bit(MEETING.SipCreateId(tIt->getUserStdStr(), tIt->getHostStdStr(), tIt->getPortStdStr()).c_str()), tIt->Transport, CONTACT_SUBSCRIPTION_REJECTED);
+    }
+    for (tIt = tProbes.begin(); tIt != tProbes.end(); tIt++)
+    {
+        MEETING.SendProbe(MEETING.SipCreateId(tIt->getUserStdStr(), tIt->getHostStdStr(), tIt->getPortStdStr()), tIt->Transport);
+    }
 }
 
 void ContactsManager::UpdateContactState(QString pContact, enum TransportType pContactTransport, bool pState)
@@ -471,6 +559,7 @@ void ContactsManager::UpdateContactState(QString pContact, enum TransportType pC
     QString tContactTransport = QString(Socket::TransportType2String(pContactTransport).c_str());
     if (tContactTransport == "auto")
         tContactTransport = "UDP";
+    bool tChanged = false;
 
     pContact = QString(pContact.toLocal8Bit());
     LOG(LOG_VERBOSE, "Updating availability state for %s[%s] to %d", pContact.toStdString().c_str(), tContactTransport.toStdString().c_str(), pState);
@@ -478,22 +567,46 @@ void ContactsManager::UpdateContactState(QString pContact, enum TransportType pC
     mContactsMutex.lock();
     for (tIt = mContacts.begin(); tIt != tItEnd; tIt++)
     {
-        QString tItTransport = QString(Socket::TransportType2String(tIt->Transport).c_str());
-        if (tItTransport == "auto")
-            tItTransport = "UDP";
-        LOG(LOG_VERBOSE, "Comparing %s==%s, %s==%s", MEETING.SipCreateId(tIt->getUserStdStr(), tIt->getHostStdStr(), tIt->getPortStdStr()).c_str(), pContact.toStdString().c_str(), tItTransport.toStdString().c_str(), tContactTransport.toStdString().c_str());
-        if ((MEETING.SipCreateId(tIt->getUserStdStr(), tIt->getHostStdStr(), tIt->getPortStdStr()) == pContact.toStdString()) && (tItTransport == tContactTransport))
+        if (IsThisContact(tIt, pContact, tContactTransport))
         {
+            if (tIt->State != (int)pState)
+                tChanged = true;
             tIt->State = pState;
+            if (pState)
+                tIt->PresenceFailures = 0;
+            else if (tIt->PresenceSubscription != CONTACT_SUBSCRIPTION_ACTIVE)
+                tIt->PresenceFailures++;
             LOG(LOG_VERBOSE, " ..found and set state");
         }
     }
     mContactsMutex.unlock();
 
-    if (mContactsModel != NULL)
+    if ((tChanged) && (mContactsModel != NULL))
         mContactsModel->UpdateView();
 }
 
+void ContactsManager::UpdateContactSubscription(QString pContact, enum TransportType pContactTransport, int pSubscriptionState)
+{
+    ContactsVector::iterator tIt, tItEnd = mContacts.end();
+    QString tContactTransport = QString(Socket::TransportType2String(pContactTransport).c_str());
+    if (tContactTransport == "auto")
+        tContactTransport = "UDP";
+
+    pContact = QString(pContact.toLocal8Bit());
+    LOG(LOG_VERBOSE, "Updating presence subscription for %s[%s] to %d", pContact.toStdString().c_str(), tContactTransport.toStdString().c_str(), pSubscriptionState);
+
+    mContactsMutex.lock();
+    for (tIt = mContacts.begin(); tIt != tItEnd; tIt++)
+    {
+        if (IsThisContact(tIt, pContact, tContactTransport))
+        {
+            tIt->PresenceSubscription = pSubscriptionState;
+            LOG(LOG_VERBOSE, " ..found and set subscription state");
+        }
+    }
+    mContactsMutex.unlock();
+}
+
 void ContactsManager::SortByState(bool pDescending)
 {
     mSortDescending = pDescending;
@@ -32,6 +32,7 @@
 #include <Meeting.h>
 #include <MediaSourceMuxer.h>
 #include <MediaSourceFile.h>
+#include <DeviceRegistry.h>
 #include <HBSocket.h>
 #include <Logger.h>
 #include <Snippets.h>
@@ -171,6 +172,9 @@ void ConfigurationDialog::LoadConfiguration()
     QString tCurMaxPackSize;
     QString tCurBitRate;
 
+    // without hotplug detection the cached device lists would never change
+    DEVICE_REGISTRY.Rescan();
+
     mAudioCaptureDevices = mAudioWorker->GetPossibleDevices();
     mVideoCaptureDevices = mVideoWorker->GetPossibleDevices();
 
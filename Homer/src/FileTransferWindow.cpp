@@ -0,0 +1,547 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of sliding window with selective acknowledgments and congestion control for file transfers
+ * Author:  Thomas Volkert
+ * Since:   2012-12-04
+ */
+
+#include <FileTransferWindow.h>
+#include <FileTransfersManager.h>
+#include <Logger.h>
+
+#include <queue>
+
+namespace Homer { namespace Gui {
+
+using namespace std;
+using namespace Homer::Base;
+
+///////////////////////////////////////////////////////////////////////////////
+
+FileTransferWindow::FileTransferWindow(uint64_t pStreamSize, unsigned int pSegmentSize)
+{
+    mStreamSize = pStreamSize;
+    mSegmentSize = pSegmentSize;
+    mAcknowledged = 0;
+    mNext = 0;
+    mHighestSacked = 0;
+    mRecoveryPoint = 0;
+    mInRecovery = false;
+    mCongestionWindow = FTW_INITIAL_WINDOW;
+    mSlowStartThreshold = FTW_MAX_WINDOW;
+    mMaximumWindow = FTW_MAX_WINDOW;
+    mSmoothedRtt = 0;
+    mRttVariance = 0;
+    mRto = FTW_INITIAL_RTO * 1000;
+    mRetransmissions = 0;
+}
+
+FileTransferWindow::~FileTransferWindow()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileTransferWindow::AddToPipe(uint64_t pStart, Segment &pSegment)
+{
+    pSegment.SendTimeEntry = mPipe.insert(SendTimes::value_type(pSegment.SendTime, pStart));
+    pSegment.InPipe = true;
+}
+
+void FileTransferWindow::RemoveFromPipe(Segment &pSegment)
+{
+    if (pSegment.InPipe)
+    {
+        mPipe.erase(pSegment.SendTimeEntry);
+        pSegment.InPipe = false;
+    }
+}
+
+bool FileTransferWindow::GetNextSegment(int64_t pNow, uint64_t &pStart, uint64_t &pEnd, bool &pRetransmission)
+{
+    CheckRetransmissionTimeout(pNow);
+
+    int tWindow = (int)mCongestionWindow;
+    if (tWindow > mMaximumWindow)
+        tWindow = mMaximumWindow;
+    if (tWindow < 1)
+        tWindow = 1;
+    if ((int)mPipe.size() >= tWindow)
+        return false;
+
+    // lost segments are repaired before new data is sent
+    Segments::iterator tIt;
+    for (tIt = mInFlight.begin(); tIt != mInFlight.end(); tIt++)
+    {
+        if (tIt->second.Lost)
+        {
+            tIt->second.Lost = false;
+            tIt->second.Retransmitted = true;
+            tIt->second.SendTime = pNow;
+            AddToPipe(tIt->first, tIt->second);
+            mRetransmissions++;
+
+            pStart = tIt->first;
+            pEnd = tIt->second.End;
+            pRetransmission = true;
+            return true;
+        }
+    }
+
+    if (mNext >= mStreamSize)
+        return false;
+
+    Segment tSegment;
+    tSegment.End = mNext + mSegmentSize;
+    if (tSegment.End > mStreamSize)
+        tSegment.End = mStreamSize;
+    tSegment.SendTime = pNow;
+    tSegment.Retransmitted = false;
+    tSegment.Sacked = false;
+    tSegment.Lost = false;
+    tIt = mInFlight.insert(Segments::value_type(mNext, tSegment)).first;
+    AddToPipe(tIt->first, tIt->second);
+
+    pStart = mNext;
+    pEnd = tSegment.End;
+    pRetransmission = false;
+    mNext = tSegment.End;
+
+    return true;
+}
+
+int64_t FileTransferWindow::GetTimeout(int64_t pNow)
+{
+    if (mPipe.empty())
+        return -1;
+
+    int64_t tResult = mPipe.begin()->first + mRto - pNow;
+    if (tResult < 0)
+        tResult = 0;
+
+    return tResult;
+}
+
+void FileTransferWindow::CheckRetransmissionTimeout(int64_t pNow)
+{
+    if ((mPipe.empty()) || (pNow - mPipe.begin()->first < mRto))
+        return;
+
+    LOG(LOG_VERBOSE, "Retransmission timeout after %ld us, acknowledged: %lu, congestion window: %.2f", mRto, mAcknowledged, mCongestionWindow);
+
+    mSlowStartThreshold = (double)mPipe.size() / 2;
+    if (mSlowStartThreshold < 2)
+        mSlowStartThreshold = 2;
+    mCongestionWindow = 1;
+    mInRecovery = false;
+
+    // exponential back-off
+    mRto *= 2;
+    if (mRto > FTW_MAX_RTO * 1000)
+        mRto = FTW_MAX_RTO * 1000;
+
+    // everything which wasn't reported by the receiver has to be sent again
+    Segments::iterator tIt;
+    for (tIt = mInFlight.begin(); tIt != mInFlight.end(); tIt++)
+    {
+        if (!tIt->second.Sacked)
+        {
+            RemoveFromPipe(tIt->second);
+            tIt->second.Lost = true;
+        }
+    }
+}
+
+void FileTransferWindow::ReceivedSack(int64_t pNow, uint64_t pCumulativeAck, const FileTransferRanges &pBlocks, uint64_t pEcho)
+{
+    int tNewlyAcknowledged = 0;
+
+    // RTT sample from the segment which triggered this acknowledgment, ambiguous samples of retransmissions are ignored (Karn)
+    Segments::iterator tIt = mInFlight.find(pEcho);
+    if ((tIt != mInFlight.end()) && (!tIt->second.Retransmitted) && (!tIt->second.Sacked))
+        UpdateRtt(pNow - tIt->second.SendTime);
+
+    // cumulative part
+    if (pCumulativeAck > mNext)
+        pCumulativeAck = mNext;
+    if (pCumulativeAck > mAcknowledged)
+    {
+        while ((!mInFlight.empty()) && (mInFlight.begin()->second.End <= pCumulativeAck))
+        {
+            if (!mInFlight.begin()->second.Sacked)
+                tNewlyAcknowledged++;
+            RemoveFromPipe(mInFlight.begin()->second);
+            mInFlight.erase(mInFlight.begin());
+        }
+        mAcknowledged = pCumulativeAck;
+        if (mHighestSacked < mAcknowledged)
+            mHighestSacked = mAcknowledged;
+    }
+
+    // selective part
+    FileTransferRanges::const_iterator tBlockIt;
+    for (tBlockIt = pBlocks.begin(); tBlockIt != pBlocks.end(); tBlockIt++)
+    {
+        uint64_t tBlockEnd = tBlockIt->End;
+        if (tBlockEnd > mNext)
+            tBlockEnd = mNext;
+        for (tIt = mInFlight.lower_bound(tBlockIt->Start); (tIt != mInFlight.end()) && (tIt->second.End <= tBlockEnd); tIt++)
+        {
+            if (!tIt->second.Sacked)
+            {
+                RemoveFromPipe(tIt->second);
+                tIt->second.Sacked = true;
+                tIt->second.Lost = false;
+                tNewlyAcknowledged++;
+            }
+        }
+        if (mHighestSacked < tBlockEnd)
+            mHighestSacked = tBlockEnd;
+    }
+
+    if ((mInRecovery) && (mAcknowledged >= mRecoveryPoint))
+        mInRecovery = false;
+
+    // window growth: slow start or congestion avoidance
+    if (!mInRecovery)
+    {
+        for (int i = 0; i < tNewlyAcknowledged; i++)
+        {
+            if (mCongestionWindow < mSlowStartThreshold)
+                mCongestionWindow += 1;
+            else
+                mCongestionWindow += 1 / mCongestionWindow;
+        }
+        if (mCongestionWindow > mMaximumWindow)
+            mCongestionWindow = mMaximumWindow;
+    }
+
+    DetectLosses();
+}
+
+void FileTransferWindow::DetectLosses()
+{
+    bool tFoundLoss = false;
+    uint64_t tLimit = (uint64_t)FTW_DUPLICATE_THRESHOLD * mSegmentSize;
+
+    // a hole is lost if enough data above it was reported by the receiver, repeated losses of retransmissions are left to the RTO
+    Segments::iterator tIt;
+    for (tIt = mInFlight.begin(); (tIt != mInFlight.end()) && (tIt->second.End + tLimit <= mHighestSacked); tIt++)
+    {
+        if ((tIt->second.InPipe) && (!tIt->second.Retransmitted))
+        {
+            RemoveFromPipe(tIt->second);
+            tIt->second.Lost = true;
+            tFoundLoss = true;
+        }
+    }
+
+    if ((tFoundLoss) && (!mInRecovery))
+        EnterRecovery();
+}
+
+void FileTransferWindow::EnterRecovery()
+{
+    // multiplicative decrease, once per window of data
+    mSlowStartThreshold = mCongestionWindow / 2;
+    if (mSlowStartThreshold < 2)
+        mSlowStartThreshold = 2;
+    mCongestionWindow = mSlowStartThreshold;
+    mRecoveryPoint = mNext;
+    mInRecovery = true;
+}
+
+void FileTransferWindow::UpdateRtt(int64_t pRtt)
+{
+    // RFC 6298, with the lower bound applied to the variance term
+    if (mSmoothedRtt == 0)
+    {
+        mSmoothedRtt = pRtt;
+        mRttVariance = pRtt / 2;
+    }else
+    {
+        int64_t tDiff = mSmoothedRtt - pRtt;
+        if (tDiff < 0)
+            tDiff = -tDiff;
+        mRttVariance = (3 * mRttVariance + tDiff) / 4;
+        mSmoothedRtt = (7 * mSmoothedRtt + pRtt) / 8;
+    }
+
+    // the variance term is bounded below, otherwise a stable RTT would shrink the RTO to the RTT itself
+    int64_t tVariance = 4 * mRttVariance;
+    if (tVariance < FTW_MIN_RTO * 1000)
+        tVariance = FTW_MIN_RTO * 1000;
+    mRto = mSmoothedRtt + tVariance;
+    if (mRto > FTW_MAX_RTO * 1000)
+        mRto = FTW_MAX_RTO * 1000;
+}
+
+void FileTransferWindow::Seek(uint64_t pPosition)
+{
+    if (pPosition > mStreamSize)
+        pPosition = mStreamSize;
+
+    LOG(LOG_VERBOSE, "Restarting window at position %lu, acknowledged so far: %lu", pPosition, mAcknowledged);
+
+    // the receiver has everything before the given position and nothing after it
+    mInFlight.clear();
+    mPipe.clear();
+    mAcknowledged = pPosition;
+    mNext = pPosition;
+    mHighestSacked = pPosition;
+    mInRecovery = false;
+    if (mCongestionWindow > FTW_INITIAL_WINDOW)
+        mCongestionWindow = FTW_INITIAL_WINDOW;
+}
+
+bool FileTransferWindow::IsComplete()
+{
+    return (mAcknowledged >= mStreamSize);
+}
+
+uint64_t FileTransferWindow::GetAcknowledged()
+{
+    return mAcknowledged;
+}
+
+void FileTransferWindow::SetMaximumWindow(int pPackets)
+{
+    if (pPackets < 1)
+        pPackets = 1;
+    if (pPackets > FTW_MAX_WINDOW)
+        pPackets = FTW_MAX_WINDOW;
+    mMaximumWindow = pPackets;
+    if (mCongestionWindow > mMaximumWindow)
+        mCongestionWindow = mMaximumWindow;
+}
+
+double FileTransferWindow::GetCongestionWindow()
+{
+    return mCongestionWindow;
+}
+
+int64_t FileTransferWindow::GetSmoothedRtt()
+{
+    return mSmoothedRtt;
+}
+
+int64_t FileTransferWindow::GetRetransmissionCounter()
+{
+    return mRetransmissions;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// bottleneck of the simulated loopback path
+#define FTW_BENCHMARK_LINK_RATE         100 // Mbit/s
+#define FTW_BENCHMARK_QUEUE_SIZE        128 // packets
+#define FTW_BENCHMARK_OVERHEAD          80 // bytes of FTM and transport headers per packet
+#define FTW_BENCHMARK_MAX_DURATION      ((int64_t)3600 * 1000 * 1000) // us
+
+struct BenchmarkEvent
+{
+    int64_t             Time;
+    uint64_t            Sequence;
+    bool                IsData;
+    uint64_t            Start, End;
+    uint64_t            CumulativeAck;
+    FileTransferRanges  Blocks;
+
+    bool operator<(const BenchmarkEvent &pOther) const
+    {
+        // std::priority_queue returns the largest element first
+        if (Time != pOther.Time)
+            return Time > pOther.Time;
+        return Sequence > pOther.Sequence;
+    }
+};
+
+double FileTransferWindow::RunLoopbackBenchmark(int pRtt, float pLoss, uint64_t pStreamSize, int pMaximumWindow, int64_t *pRetransmissions)
+{
+    FileTransferWindow tWindow(pStreamSize, FTM_DATA_PACKET_SIZE);
+    FileTransferScoreboard tScoreboard;
+    priority_queue<BenchmarkEvent> tEvents;
+    int64_t tNow = 0;
+    int64_t tLinkFree = 0;
+    int64_t tOneWay = (int64_t)pRtt * 1000 / 2;
+    int64_t tTransmissionTime = (int64_t)(FTM_DATA_PACKET_SIZE + FTW_BENCHMARK_OVERHEAD) * 8 / FTW_BENCHMARK_LINK_RATE;
+    uint64_t tSequence = 0;
+    uint32_t tRandom = 0x2012;
+    uint32_t tLossThreshold = (uint32_t)(pLoss / 100 * 0xFFFF);
+
+    tWindow.SetMaximumWindow(pMaximumWindow);
+
+    while ((!tWindow.IsComplete()) && (tNow < FTW_BENCHMARK_MAX_DURATION))
+    {
+        // sender: fill the window
+        uint64_t tStart, tEnd;
+        bool tRetransmission;
+        while (tWindow.GetNextSegment(tNow, tStart, tEnd, tRetransmission))
+        {
+            // drop-tail queue in front of the bottleneck
+            if (tLinkFree < tNow)
+                tLinkFree = tNow;
+            if ((tLinkFree - tNow) / tTransmissionTime >= FTW_BENCHMARK_QUEUE_SIZE)
+                continue;
+            tLinkFree += tTransmissionTime;
+
+            // random loss on the path, reproducible by using a fixed LCG
+            tRandom = tRandom * 1103515245 + 12345;
+            if (((tRandom >> 16) & 0xFFFF) < tLossThreshold)
+                continue;
+
+            BenchmarkEvent tEvent;
+            tEvent.Time = tLinkFree + tOneWay;
+            tEvent.Sequence = tSequence++;
+            tEvent.IsData = true;
+            tEvent.Start = tStart;
+            tEvent.End = tEnd;
+            tEvent.CumulativeAck = 0;
+            tEvents.push(tEvent);
+        }
+
+        // advance virtual time to the next packet arrival or to the next retransmission timeout
+        int64_t tTimeout = tWindow.GetTimeout(tNow);
+        if ((!tEvents.empty()) && ((tTimeout < 0) || (tEvents.top().Time <= tNow + tTimeout)))
+        {
+            BenchmarkEvent tEvent = tEvents.top();
+            tEvents.pop();
+            tNow = tEvent.Time;
+            if (tEvent.IsData)
+            {
+                // receiver: answer each fragment with a SACK
+                tScoreboard.Received(tEvent.Start, tEvent.End);
+                tEvent.Time = tNow + tOneWay;
+                tEvent.Sequence = tSequence++;
+                tEvent.IsData = false;
+                tEvent.CumulativeAck = tScoreboard.GetCumulativeAck();
+                tScoreboard.GetSackBlocks(tEvent.Blocks);
+                tEvents.push(tEvent);
+            }else
+                tWindow.ReceivedSack(tNow, tEvent.CumulativeAck, tEvent.Blocks, tEvent.Start);
+        }else if (tTimeout >= 0)
+            tNow += tTimeout;
+        else
+            break;
+    }
+
+    if (pRetransmissions != NULL)
+        *pRetransmissions = tWindow.GetRetransmissionCounter();
+
+    if ((!tWindow.IsComplete()) || (tNow <= 0))
+        return 0;
+
+    return (double)pStreamSize / 1024 / 1024 / ((double)tNow / 1000 / 1000);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FileTransferScoreboard::FileTransferScoreboard()
+{
+    mCumulativeAck = 0;
+    mLastReceived = 0;
+}
+
+FileTransferScoreboard::~FileTransferScoreboard()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileTransferScoreboard::Received(uint64_t pStart, uint64_t pEnd)
+{
+    if (pEnd <= mCumulativeAck)
+        return false;
+    if (pStart < mCumulativeAck)
+        pStart = mCumulativeAck;
+
+    // is this range already covered?
+    Ranges::iterator tIt = mRanges.upper_bound(pStart);
+    if (tIt != mRanges.begin())
+    {
+        Ranges::iterator tPrev = tIt;
+        tPrev--;
+        if (tPrev->second >= pEnd)
+            return false;
+        // merge with preceding range
+        if (tPrev->second >= pStart)
+        {
+            pStart = tPrev->first;
+            mRanges.erase(tPrev);
+        }
+    }
+
+    // merge with following ranges
+    while ((tIt != mRanges.end()) && (tIt->first <= pEnd))
+    {
+        if (tIt->second > pEnd)
+            pEnd = tIt->second;
+        mRanges.erase(tIt++);
+    }
+
+    mLastReceived = pStart;
+    if (pStart == mCumulativeAck)
+        mCumulativeAck = pEnd;
+    else
+        mRanges[pStart] = pEnd;
+
+    return true;
+}
+
+uint64_t FileTransferScoreboard::GetCumulativeAck()
+{
+    return mCumulativeAck;
+}
+
+void FileTransferScoreboard::GetSackBlocks(FileTransferRanges &pBlocks)
+{
+    pBlocks.clear();
+
+    // the most recently changed range comes first, the remaining slots are filled with the highest ranges
+    Ranges::iterator tRecent = mRanges.find(mLastReceived);
+    if (tRecent != mRanges.end())
+    {
+        FileTransferRange tRange = {tRecent->first, tRecent->second};
+        pBlocks.push_back(tRange);
+    }
+
+    Ranges::reverse_iterator tIt;
+    for (tIt = mRanges.rbegin(); (tIt != mRanges.rend()) && (pBlocks.size() < FTW_MAX_SACK_BLOCKS); tIt++)
+    {
+        if ((tRecent != mRanges.end()) && (tIt->first == tRecent->first))
+            continue;
+        FileTransferRange tRange = {tIt->first, tIt->second};
+        pBlocks.push_back(tRange);
+    }
+}
+
+void FileTransferScoreboard::Seek(uint64_t pPosition)
+{
+    mRanges.clear();
+    mCumulativeAck = pPosition;
+    mLastReceived = pPosition;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
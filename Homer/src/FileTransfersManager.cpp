@@ -28,6 +28,7 @@
 #include <MediaSourceMem.h>
 #include <MediaSourceNet.h>
 #include <FileTransfersManager.h>
+#include <FileTransferWindow.h>
 #include <ProcessStatisticService.h>
 #include <HBSocket.h>
 #include <HBTime.h>
@@ -62,6 +63,7 @@ uint32_t sLocalSessionId = 0;
 #define FTM_PDU_TRANSFER_CONTINUE           0x05
 #define FTM_PDU_TRANSFER_DATA               0x10
 #define FTM_PDU_TRANSFER_SEEK               0x11
+#define FTM_PDU_TRANSFER_SACK               0x12
 
 static string getNameFromPduType(int pType)
 {
@@ -81,6 +83,8 @@ static string getNameFromPduType(int pType)
             return "Transfer data";
         case FTM_PDU_TRANSFER_SEEK:
             return "Transfer seek";
+        case FTM_PDU_TRANSFER_SACK:
+            return "Transfer selective acknowledgment";
         default:
             "Unsupported PDU type";
     }
@@ -106,7 +110,8 @@ union HomerFtmHeader{
 union HomerFtmBeginHeader{
     struct{
         uint32_t     DataAcks:1;       /* request for data acknowledgments */
-        uint32_t     mbz:31;           /* must be zero */
+        uint32_t     Windowed:1;       /* request for windowed transfer with selective acknowledgments */
+        uint32_t     mbz:30;           /* must be zero */
         uint32_t     Port;             /* sender's management port number */
         uint64_t     Size;             /* file size */
         char         Name[256];        /* file name */
@@ -129,6 +134,20 @@ union HomerFtmSeekHeader{
     uint32_t Data[2];
 };
 
+union HomerFtmSackHeader{
+    struct{
+        uint64_t     CumulativeAck;     /* position up to which the transfer stream was received completely */
+        uint64_t     Echo;              /* start offset of the fragment which triggered this acknowledgment */
+        uint32_t     Blocks;            /* number of valid SACK blocks */
+        uint32_t     mbz;               /* must be zero */
+        struct{
+            uint64_t Start;             /* range's start offset */
+            uint64_t End;               /* range's end offset */
+        } __attribute__((__packed__)) Block[FTW_MAX_SACK_BLOCKS]; /* received ranges beyond the cumulative acknowledgment */
+    } __attribute__((__packed__));
+    uint32_t Data[6 + 4 * FTW_MAX_SACK_BLOCKS];
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 FileTransfersManagerObservable::FileTransfersManagerObservable()
@@ -206,6 +225,7 @@ private:
     /* send thread */
     virtual void* Run(void* pArgs = NULL);
     void StopSendThread();
+    void SendDataWindowed();
 
     /* data sending */
     bool SendPacket(char* pData, unsigned int pSize);
@@ -220,6 +240,7 @@ private:
     bool SendRequestTransferContinue();
     bool SendRequestTransferData(char *pData, unsigned int pDataSize, uint64_t pStart, uint64_t pEnd);
     bool SendRequestTransferSeek(uint64_t pPosition);
+    bool SendRequestTransferSack(uint64_t pEcho);
 
     /* acknowledge */
     bool AcknowledgeRequest(HomerFtmHeader *pHeader);
@@ -239,10 +260,18 @@ private:
         void ReceivedTransferDataResponse(HomerFtmHeader *pHeader);
     void ReceivedTransferSeek(HomerFtmHeader *pHeader, char *pPayload, unsigned int pPayloadSize);
         void ReceivedTransferSeekResponse(HomerFtmHeader *pHeader);
+    void ReceivedTransferSack(HomerFtmHeader *pHeader, char *pPayload, unsigned int pPayloadSize);
 
     bool                mRemoteClosedTransfer;
     bool                mUsesDataAcks;
     bool                mCanceled;
+    bool                mPaused;
+    /* windowed transfer */
+    bool                mUsesWindow;
+    FileTransferWindow  *mSendWindow;
+    FileTransferScoreboard *mReceiveScoreboard;
+    Mutex               mWindowMutex;
+    Condition           mConditionWindowChanged;
     Condition           mConditionRemoteWantsTransferBegin, mConditionRemoteAcksTransferData, mConditionRemoteAcksTransferEnd;
     unsigned int        mSessionId;
     unsigned int        mSourceId;
@@ -250,6 +279,7 @@ private:
     unsigned int        mSenderMessageCounter;
     unsigned int        mReceiverMessageCounter;
     char                *mPacketSendBuffer;
+    Mutex               mSendMutex;
     bool                mSenderActive;
     FILE                *mLocalFile;
     Mutex               mFileReadMutex;
@@ -276,6 +306,25 @@ static void CreateRequest(HomerFtmHeader *pHeader, unsigned int pSourceId, unsig
     pHeader->SequenceNumber = pMessageNumber;
 }
 
+// fseek()/ftell() are limited to "long" and would truncate positions beyond 2 GB on WIN32 and 32 bit systems
+static int SeekFile(FILE *pFile, uint64_t pPosition)
+{
+    #if defined(WIN32) || defined(WIN64)
+        return _fseeki64(pFile, (__int64)pPosition, SEEK_SET);
+    #else
+        return fseeko(pFile, (off_t)pPosition, SEEK_SET);
+    #endif
+}
+
+static int64_t TellFile(FILE *pFile)
+{
+    #if defined(WIN32) || defined(WIN64)
+        return (int64_t)_ftelli64(pFile);
+    #else
+        return (int64_t)ftello(pFile);
+    #endif
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///// FILE Sender
 ///////////////////////////////////////////////////////////////////////////////
@@ -293,10 +342,17 @@ FileTransfer::FileTransfer()
     mSenderMessageCounter = 0;
     mReceiverMessageCounter = 0;
     mSenderActive = false;
+    mPaused = false;
+    mSendWindow = NULL;
+    mReceiveScoreboard = NULL;
     mUsesDataAcks = false;
     #ifdef FTM_ACK_DATA_PACKETS
         mUsesDataAcks = true; //TODO: check if NAPI socket provides lossless and activate ACKs here automatically
     #endif
+    mUsesWindow = false;
+    #ifdef FTM_WINDOWED_TRANSFERS
+        mUsesWindow = true;
+    #endif
 }
 
 FileTransfer::~FileTransfer()
@@ -308,6 +364,8 @@ FileTransfer::~FileTransfer()
     }
     if (mPacketSendBuffer != NULL)
         free(mPacketSendBuffer);
+    delete mSendWindow;
+    delete mReceiveScoreboard;
     LOG(LOG_VERBOSE, "Destroyed");
 }
 
@@ -418,15 +476,32 @@ bool FileTransfer::IsSenderActive()
 void FileTransfer::PauseFileTransfer()
 {
     LOG(LOG_VERBOSE, "Pausing file transfer for %s", mFileName.c_str());
+    if (IsSenderActive())
+    {
+        mWindowMutex.lock();
+        mPaused = true;
+        mWindowMutex.unlock();
+    }
     if (!SendRequestTransferPause())
         LOG(LOG_ERROR, "SendRequestTransferPause() failed");
 }
 
 void FileTransfer::ContinueFileTransfer()
 {
-    LOG(LOG_VERBOSE, "Pausing file transfer for %s", mFileName.c_str());
+    LOG(LOG_VERBOSE, "Continuing file transfer for %s", mFileName.c_str());
+    if (IsSenderActive())
+    {
+        mWindowMutex.lock();
+        mPaused = false;
+        mConditionWindowChanged.SignalAll();
+        mWindowMutex.unlock();
+    }
     if (!SendRequestTransferContinue())
         LOG(LOG_ERROR, "SendRequestTransferContinue() failed");
+
+    // resume the windowed transfer after the last completely received byte
+    if ((!IsSenderActive()) && (mUsesWindow))
+        SendRequestTransferSeek(mFileTransferredSize);
 }
 
 void FileTransfer::CancelFileTransfer()
@@ -447,6 +522,8 @@ void FileTransfer::ReceiverAcknowledgesTransferBegin(string pLocalFileName)
     {
         // open the local file
         mLocalFile = fopen(mFileName.c_str(), "wb");
+        if (mUsesWindow)
+            mReceiveScoreboard = new FileTransferScoreboard();
     }
 }
 
@@ -477,6 +554,8 @@ bool FileTransfer::SendRequest(int pRequestType, char *pData, unsigned int pData
 {
     bool tResult = false;
 
+    mSendMutex.lock();
+
     // prepare main header data
     HomerFtmHeader *tHeader = (HomerFtmHeader*) mPacketSendBuffer;
     CreateRequest(tHeader, mSourceId, mSessionId, ++mSenderMessageCounter, pRequestType);
@@ -497,6 +576,8 @@ bool FileTransfer::SendRequest(int pRequestType, char *pData, unsigned int pData
     }else
         LOG(LOG_ERROR, "Packet is too big");
 
+    mSendMutex.unlock();
+
     return tResult;
 }
 
@@ -504,6 +585,8 @@ bool FileTransfer::AcknowledgeRequest(HomerFtmHeader *pHeader)
 {
     bool tResult = false;
 
+    mSendMutex.lock();
+
     // prepare main header data
     pHeader->Request = 0;
     pHeader->SequenceNumber = ++mSenderMessageCounter;
@@ -520,6 +603,8 @@ bool FileTransfer::AcknowledgeRequest(HomerFtmHeader *pHeader)
     }else
         LOG(LOG_ERROR, "Packet is too big");
 
+    mSendMutex.unlock();
+
     return tResult;
 }
 
@@ -554,6 +639,10 @@ bool FileTransfer::SendRequestTransferBegin()
     // set own data ACK policy in FTM begin header
     tBeginHeader.DataAcks = mUsesDataAcks;
 
+    // set own transfer scheme in FTM begin header, the receiver answers with the result of the negotiation
+    tBeginHeader.Windowed = mUsesWindow;
+    tBeginHeader.mbz = 0;
+
     tResult = SendRequest(FTM_PDU_TRANSFER_BEGIN, (char*)&tBeginHeader, sizeof(tBeginHeader));
 
     //TODO: signal to observer
@@ -634,6 +723,30 @@ bool FileTransfer::SendRequestTransferSeek(uint64_t pPosition)
     return tResult;
 }
 
+bool FileTransfer::SendRequestTransferSack(uint64_t pEcho)
+{
+    bool tResult = false;
+
+    HomerFtmSackHeader tSackHeader;
+    FileTransferRanges tBlocks;
+
+    // set receiver state in FTM SACK header
+    tSackHeader.CumulativeAck = mReceiveScoreboard->GetCumulativeAck();
+    tSackHeader.Echo = pEcho;
+    tSackHeader.mbz = 0;
+    mReceiveScoreboard->GetSackBlocks(tBlocks);
+    tSackHeader.Blocks = tBlocks.size();
+    for (unsigned int i = 0; i < tBlocks.size(); i++)
+    {
+        tSackHeader.Block[i].Start = tBlocks[i].Start;
+        tSackHeader.Block[i].End = tBlocks[i].End;
+    }
+
+    tResult = SendRequest(FTM_PDU_TRANSFER_SACK, (char*)&tSackHeader, sizeof(tSackHeader));
+
+    return tResult;
+}
+
 void FileTransfer::ReceivedTransferBegin(HomerFtmHeader *pHeader, char *pPayload, unsigned int pPayloadSize)
 {
     if (pPayloadSize != sizeof(HomerFtmBeginHeader))
@@ -655,12 +768,15 @@ void FileTransfer::ReceivedTransferBegin(HomerFtmHeader *pHeader, char *pPayload
     if (IsSenderActive())
     {// we are sender
         LOG(LOG_VERBOSE, "TRANSFER-BEGIN hand-shake finished, remote acknowledged transfer of file \"%s\" with size %ld", mFileName.c_str(), mFileSize);
+        // the receiver has answered with the negotiated transfer scheme
+        mUsesWindow = mUsesWindow && tBeginHeader->Windowed;
         mConditionRemoteWantsTransferBegin.SignalAll();
     }else
     {// we are receiver
         mFileName = string (tFileName);
         mFileSize = tBeginHeader->Size;
         mUsesDataAcks = tBeginHeader->DataAcks;
+        mUsesWindow = mUsesWindow && tBeginHeader->Windowed;
 
         // ask the user about file destination on disc
         FTMAN.notifyObserversTransferBeginRequest(GetId(), mPeerName, mFileName, mFileSize);
@@ -716,6 +832,9 @@ void FileTransfer::ReceivedTransferCancel(HomerFtmHeader *pHeader)
         LOG(LOG_WARN, "Sending wake up to \"RemoteAcksTransferEnd\"");
     #endif
     mConditionRemoteAcksTransferEnd.SignalAll();
+    mWindowMutex.lock();
+    mConditionWindowChanged.SignalAll();
+    mWindowMutex.unlock();
 
     //TODO: notifyObserver
 }
@@ -726,6 +845,13 @@ void FileTransfer::ReceivedTransferPause(HomerFtmHeader *pHeader)
 
     AcknowledgeRequest(pHeader);
 
+    if (IsSenderActive())
+    {
+        mWindowMutex.lock();
+        mPaused = true;
+        mWindowMutex.unlock();
+    }
+
     //TODO: notifyObserver
 }
 
@@ -735,6 +861,14 @@ void FileTransfer::ReceivedTransferContinue(HomerFtmHeader *pHeader)
 
     AcknowledgeRequest(pHeader);
 
+    if (IsSenderActive())
+    {
+        mWindowMutex.lock();
+        mPaused = false;
+        mConditionWindowChanged.SignalAll();
+        mWindowMutex.unlock();
+    }
+
     //TODO: notifyObserver
 }
 
@@ -746,6 +880,43 @@ void FileTransfer::ReceivedTransferData(HomerFtmHeader *pHeader, char *pPayload,
         LOG(LOG_VERBOSE, "Remote signaled %d bytes of transfer data for file %s with size %ld", (int)tFragmentSize, mFileName.c_str(), mFileSize);
     #endif
 
+    if (mUsesWindow)
+    {
+        if ((pPayloadSize < sizeof(HomerFtmDataHeader)) || (tDataHeader->End < tDataHeader->Start) || (tFragmentSize > pPayloadSize - sizeof(HomerFtmDataHeader)))
+        {
+            LOG(LOG_WARN, "Received invalid fragment from %lu to %lu", tDataHeader->Start, tDataHeader->End);
+            return;
+        }
+
+        // fragments may arrive in any order, each one is stored at its position and reported via SACK
+        if ((mLocalFile != NULL) && (mReceiveScoreboard != NULL) && (tDataHeader->End > mReceiveScoreboard->GetCumulativeAck()))
+        {
+            #ifdef FTM_DEBUG_DATA_PACKETS
+                LOG(LOG_VERBOSE, "Storing in file \"%s\" the fragment from %lu to %lu", mFileName.c_str(), tDataHeader->Start, tDataHeader->End);
+            #endif
+
+            char *tFragment = pPayload + sizeof(HomerFtmDataHeader);
+
+            size_t tResult = 0;
+            if (SeekFile(mLocalFile, tDataHeader->Start) == 0)
+                tResult = fwrite((void*)tFragment, 1, (size_t)tFragmentSize, mLocalFile);
+            if (tResult != tFragmentSize)
+                LOG(LOG_ERROR, "Error when writing fragment to file, wrote %d bytes instead of %lu bytes", (int)tResult, tFragmentSize);
+            else
+            {
+                mReceiveScoreboard->Received(tDataHeader->Start, tDataHeader->End);
+                mFileTransferredSize = mReceiveScoreboard->GetCumulativeAck();
+            }
+        }
+
+        if (mReceiveScoreboard != NULL)
+            SendRequestTransferSack(tDataHeader->Start);
+
+        FTMAN.notifyObserverTransferData(GetId(), mFileTransferredSize);
+
+        return;
+    }
+
     if (tDataHeader->Start != mFileTransferredSize)
     {
         LOG(LOG_WARN, "Detected a gap in received transfer stream: %lu bytes successfully received, current fragment starts at position %lu", mFileTransferredSize, tDataHeader->Start);
@@ -798,7 +969,7 @@ void FileTransfer::ReceivedTransferSeek(HomerFtmHeader *pHeader, char *pPayload,
     {
         mFileTransferredSize = tSeekHeader->Position;
         int tRes = 0;
-        if ((tRes = fseek(mLocalFile, mFileTransferredSize, SEEK_SET)) < 0)
+        if ((tRes = SeekFile(mLocalFile, mFileTransferredSize)) < 0)
         {
             LOG(LOG_ERROR, "File seeking failed because \"%s\"", strerror(tRes));
         }
@@ -807,6 +978,16 @@ void FileTransfer::ReceivedTransferSeek(HomerFtmHeader *pHeader, char *pPayload,
 
     mFileReadMutex.unlock();
 
+    // restart the window at the position where the receiver wants to resume
+    mWindowMutex.lock();
+    if (mSendWindow != NULL)
+    {
+        mSendWindow->Seek(tSeekHeader->Position);
+        mFileTransferredSize = mSendWindow->GetAcknowledged();
+        mConditionWindowChanged.SignalAll();
+    }
+    mWindowMutex.unlock();
+
     // send ACK
     AcknowledgeRequest(pHeader);
 
@@ -818,6 +999,36 @@ void FileTransfer::ReceivedTransferSeek(HomerFtmHeader *pHeader, char *pPayload,
     //TODO: notifyObserver
 }
 
+void FileTransfer::ReceivedTransferSack(HomerFtmHeader *pHeader, char *pPayload, unsigned int pPayloadSize)
+{
+    if (pPayloadSize != sizeof(HomerFtmSackHeader))
+    {
+        LOG(LOG_WARN, "Size of payload differs from size of HomerFtmSackHeader");
+        return;
+    }
+
+    HomerFtmSackHeader *tSackHeader = (HomerFtmSackHeader*)pPayload;
+    FileTransferRanges tBlocks;
+    for (unsigned int i = 0; (i < tSackHeader->Blocks) && (i < FTW_MAX_SACK_BLOCKS); i++)
+    {
+        FileTransferRange tRange = {tSackHeader->Block[i].Start, tSackHeader->Block[i].End};
+        tBlocks.push_back(tRange);
+    }
+
+    #ifdef FTM_DEBUG_DATA_PACKETS
+        LOG(LOG_VERBOSE, "Remote acknowledged transfer data up to %lu and %d additional ranges for file %s with size %ld", tSackHeader->CumulativeAck, (int)tBlocks.size(), mFileName.c_str(), mFileSize);
+    #endif
+
+    mWindowMutex.lock();
+    if (mSendWindow != NULL)
+    {
+        mSendWindow->ReceivedSack(Time::GetTimeStamp(), tSackHeader->CumulativeAck, tBlocks, tSackHeader->Echo);
+        mFileTransferredSize = mSendWindow->GetAcknowledged();
+        mConditionWindowChanged.SignalAll();
+    }
+    mWindowMutex.unlock();
+}
+
 void FileTransfer::ReceivedTransferBeginResponse(HomerFtmHeader *pHeader)
 {
     LOG(LOG_VERBOSE, "Remote acknowledged begin of transfer data for file %s with size %ld", mFileName.c_str(), mFileSize);
@@ -931,6 +1142,12 @@ void FileTransfer::FtmCallBack(HomerFtmHeader *pHeader, char *pPayload, unsigned
             else
                 ReceivedTransferSeekResponse(pHeader);
             break;
+        case FTM_PDU_TRANSFER_SACK:
+            if (pHeader->Request == true)
+                ReceivedTransferSack(pHeader, pPayload, pPayloadSize);
+            else
+                LOG(LOG_WARN, "Unexpected response for selective acknowledgment");
+            break;
         default:
             LOG(LOG_WARN, "Unsupported PDU type");
             break;
@@ -942,9 +1159,63 @@ void FileTransfer::StopSendThread()
     mCanceled = true;
     mSocketToPeer->cancel();
     mConditionRemoteWantsTransferBegin.SignalAll();
+    mWindowMutex.lock();
+    mConditionWindowChanged.SignalAll();
+    mWindowMutex.unlock();
     StopThread(2000);
 }
 
+void FileTransfer::SendDataWindowed()
+{
+    char tBuffer[FTM_DATA_PACKET_SIZE];
+    uint64_t tStart, tEnd;
+    bool tRetransmission;
+
+    mWindowMutex.lock();
+    while ((!mCanceled) && (!mRemoteClosedTransfer) && (!mSendWindow->IsComplete()))
+    {
+        int64_t tNow = Time::GetTimeStamp();
+        if ((mPaused) || (!mSendWindow->GetNextSegment(tNow, tStart, tEnd, tRetransmission)))
+        {
+            // wait for SACKs, the next retransmission timeout or a pause/continue/cancel
+            int64_t tTimeout = mSendWindow->GetTimeout(tNow);
+            int tWaitTime = FTM_KEEP_ALIVE_TIME;
+            if ((!mPaused) && (tTimeout >= 0))
+                tWaitTime = (int)(tTimeout / 1000) + 1;
+            mConditionWindowChanged.Wait(&mWindowMutex, tWaitTime);
+            continue;
+        }
+        mWindowMutex.unlock();
+
+        // ###################################################
+        // read fragment from local file
+        // ###################################################
+        size_t tResult = 0;
+        mFileReadMutex.lock();
+        if (SeekFile(mLocalFile, tStart) == 0)
+            tResult = fread((void*)tBuffer, 1, (size_t)(tEnd - tStart), mLocalFile);
+        mFileReadMutex.unlock();
+
+        // ###################################################
+        // transmit file fragment, lost ones are repaired via the window
+        // ###################################################
+        if (tResult == tEnd - tStart)
+        {
+            #ifdef FTM_DEBUG_DATA_PACKETS
+                if (tRetransmission)
+                    LOG(LOG_WARN, "Retransmitting fragment from %lu to %lu", tStart, tEnd);
+            #endif
+            SendRequestTransferData(tBuffer, tResult, tStart, tEnd);
+        }else
+            LOG(LOG_ERROR, "Error when reading in local file \"%s\"", mFileName.c_str());
+
+        mWindowMutex.lock();
+    }
+
+    LOG(LOG_VERBOSE, "Windowed transmission stopped, acknowledged: %lu bytes, retransmissions: %ld, smoothed RTT: %ld us", mSendWindow->GetAcknowledged(), mSendWindow->GetRetransmissionCounter(), mSendWindow->GetSmoothedRtt());
+    mWindowMutex.unlock();
+}
+
 void* FileTransfer::Run(void* pArgs)
 {
     LOG(LOG_VERBOSE, "Started thread for sending file %s", mFileName.c_str());
@@ -975,55 +1246,67 @@ void* FileTransfer::Run(void* pArgs)
                 size_t tResult = 0;
                 bool tEof = false;
                 mRemoteClosedTransfer = false;
+                if (mUsesWindow)
+                {
+                    LOG(LOG_VERBOSE, "Using windowed transfer with selective acknowledgments");
+                    mWindowMutex.lock();
+                    mSendWindow = new FileTransferWindow(mFileSize, FTM_DATA_PACKET_SIZE);
+                    mWindowMutex.unlock();
+                }
                 do
                 {
-                    do
+                    if (mUsesWindow)
+                        SendDataWindowed();
+                    else
                     {
-                        // ###################################################
-                        // read fragment from local file
-                        // ###################################################
-                        int64_t tStart = INT_MAX;
-                        int64_t tEnd = 0;
-                        mFileReadMutex.lock();
-                        if (!feof(mLocalFile))
+                        do
                         {
-                            tStart = ftell(mLocalFile);
-                            tResult = fread((void*)tBuffer, 1, FTM_DATA_PACKET_SIZE, mLocalFile);
-                            if (tResult != FTM_DATA_PACKET_SIZE)
+                            // ###################################################
+                            // read fragment from local file
+                            // ###################################################
+                            int64_t tStart = INT_MAX;
+                            int64_t tEnd = 0;
+                            mFileReadMutex.lock();
+                            if (!feof(mLocalFile))
                             {
-                                if (!feof(mLocalFile))
-                                    LOG(LOG_ERROR, "Error when reading in local file \"%s\"", mFileName.c_str());
-                                else
-                                    tEof = true;
-                            }
-                            tEnd = ftell(mLocalFile);
-                            mFileTransferredSize = tEnd;
-                        }else
-                            LOG(LOG_VERBOSE, "EOF reached");
-                        mFileReadMutex.unlock();
-
-                        // ###################################################
-                        // transmit file fragment (and retransmit if necessary)
-                        // ###################################################
-                        bool tRetransmission;
-                        if (tStart < tEnd)
-                        {
-                            do{
-                                tRetransmission = false;
-                                SendRequestTransferData(tBuffer, tResult, tStart, tEnd);
-                                if(mUsesDataAcks)
+                                tStart = TellFile(mLocalFile);
+                                tResult = fread((void*)tBuffer, 1, FTM_DATA_PACKET_SIZE, mLocalFile);
+                                if (tResult != FTM_DATA_PACKET_SIZE)
                                 {
-                                    // wait until hand-shake is completed
-                                    mConditionRemoteAcksTransferData.Reset();
-                                    if (!mConditionRemoteAcksTransferData.Wait(NULL, FTM_DATA_ACK_TIME))
+                                    if (!feof(mLocalFile))
+                                        LOG(LOG_ERROR, "Error when reading in local file \"%s\"", mFileName.c_str());
+                                    else
+                                        tEof = true;
+                                }
+                                tEnd = TellFile(mLocalFile);
+                                mFileTransferredSize = tEnd;
+                            }else
+                                LOG(LOG_VERBOSE, "EOF reached");
+                            mFileReadMutex.unlock();
+
+                            // ###################################################
+                            // transmit file fragment (and retransmit if necessary)
+                            // ###################################################
+                            bool tRetransmission;
+                            if (tStart < tEnd)
+                            {
+                                do{
+                                    tRetransmission = false;
+                                    SendRequestTransferData(tBuffer, tResult, tStart, tEnd);
+                                    if(mUsesDataAcks)
                                     {
-                                        LOG(LOG_WARN, "Timeout occurred while waiting for ACK of data transfer, retransmitting the packet");
-                                        tRetransmission = true;
+                                        // wait until hand-shake is completed
+                                        mConditionRemoteAcksTransferData.Reset();
+                                        if (!mConditionRemoteAcksTransferData.Wait(NULL, FTM_DATA_ACK_TIME))
+                                        {
+                                            LOG(LOG_WARN, "Timeout occurred while waiting for ACK of data transfer, retransmitting the packet");
+                                            tRetransmission = true;
+                                        }
                                     }
-                                }
-                            }while(tRetransmission);
-                        }
-                    }while(!tEof);
+                                }while(tRetransmission);
+                            }
+                        }while(!tEof);
+                    }
 
                     LOG(LOG_VERBOSE, ">>> Ready to finish transmission of file \"%s\" to %s:%u, waiting for peer", mFileName.c_str(), mPeerName.c_str(), mPeerPort);
                     SendRequestTransferSuccess();
@@ -55,8 +55,11 @@
 #include <MediaSourceDesktop.h>
 #include <MediaSourceLogo.h>
 #include <Header_NetworkSimulator.h>
+#include <Emulator/EmuSetup.h>
+#include <NAPI.h>
 #include <ProcessStatisticService.h>
 #include <Snippets.h>
+#include <StartupGraph.h>
 
 #include <QPlastiqueStyle>
 #include <QApplication>
@@ -87,6 +90,33 @@ namespace Homer { namespace Gui {
 
 #define IPV6_LINK_LOCAL_PREFIX                          "fe80" //TODO: check the range FE80-FFFF (link local, site local, multicast)
 
+#define MAIN_WINDOW_EVENT_DEVICES_CHANGED               (QEvent::User + 2001)
+
+// how often are the video subscriptions updated based on the audio levels of the participants in mosaic mode?
+#define MAIN_WINDOW_ACTIVE_SPEAKER_PERIOD               250 // ms
+
+///////////////////////////////////////////////////////////////////////////////
+
+class DevicesChangedEvent:
+    public QEvent
+{
+public:
+    DevicesChangedEvent(QString pEnumerator, enum MediaType pMediaType):QEvent((QEvent::Type)MAIN_WINDOW_EVENT_DEVICES_CHANGED), mEnumerator(pEnumerator), mMediaType(pMediaType)
+    {
+    }
+    QString GetEnumerator()
+    {
+        return mEnumerator;
+    }
+    enum MediaType GetMediaType()
+    {
+        return mMediaType;
+    }
+private:
+    QString         mEnumerator;
+    enum MediaType  mMediaType;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 bool MainWindow::mShuttingDown = false;
@@ -110,6 +140,7 @@ MainWindow::MainWindow(QStringList pArguments, QString pAbsBinPath) :
     mMediaSourceLogo = NULL;
     mCurrentLanguage = "";
     mTranslator = NULL;
+    mActiveSpeakerTimer = NULL;
     #if HOMER_NETWORK_SIMULATOR
         mNetworkSimulator = NULL;
     #endif
@@ -138,42 +169,49 @@ MainWindow::MainWindow(QStringList pArguments, QString pAbsBinPath) :
     initializeFeatureDisablers(pArguments);
     // show ffmpeg data
     ShowFfmpegCaps(pArguments);
-
-    // audio playback - start sound
-    #ifndef DEBUG_VERSION
-        LOG(LOG_VERBOSE, "Playing start sound..");
-        OpenPlaybackDevice("Start/stop");
-        if (CONF.GetStartSound())
-            StartAudioPlayback(CONF.GetStartSoundFile());
-    #endif
-
+    // copy the settings which are needed by background steps
+    readStartupSettings();
+
+    // startup graph: independent steps run concurrently, background steps neither use the stored settings nor any Qt widget
+    // init ffmpeg codecs, formats and devices
+    STARTUP.addStep("codecs", &MainWindow::initializeCodecs, "", true);
+    // retrieve info about network devices
+    STARTUP.addStep("network-interfaces", &MainWindow::initializeNetworkInterfaces, "", true);
+    // init contact database, runs on the main thread because it stores the contact file and reads the probing settings
+    STARTUP.addStep("contacts", &MainWindow::initializeContacts);
+    // init Meeting and start the SIP stack and the STUN based NAT detection
+    STARTUP.addStep("conference", &MainWindow::initializeConferenceManagement, "network-interfaces", true);
+    // init audio/video muxers and probe capture devices
+    STARTUP.addStep("devices", &MainWindow::initializeVideoAudioIO, "codecs", true);
     // create basic GUI objects
-    initializeGUI();
+    STARTUP.addStep("gui", &MainWindow::initializeGUI);
     // set language
-    initializeLanguage();
-    // retrieve info about network devices and init Meeting
-    initializeConferenceManagement();
-    // init audio/video muxers
-    initializeVideoAudioIO();
+    STARTUP.addStep("language", &MainWindow::initializeLanguage, "gui");
+    // audio playback - start sound
+    STARTUP.addStep("start-sound", &MainWindow::initializeStartSound, "codecs");
+    // auto update check
+    STARTUP.addStep("update-check", &MainWindow::triggerUpdateCheck, "gui");
+    // init desktop and logo video sources
+    STARTUP.addStep("desktop-sources", &MainWindow::initializeDesktopSources, "devices");
     // configure Meeting and video/audio muxers
-    loadSettings();
+    STARTUP.addStep("settings", &MainWindow::loadSettings, "conference,desktop-sources");
     // create additional widgets and menus
-    initializeWidgetsAndMenus();
+    STARTUP.addStep("widgets", &MainWindow::initializeWidgetsAndMenus, "language,settings,contacts");
     // set coloring for GUI objects
-    initializeColoring();
-    // init contact database
-    CONTACTS.Init(CONF.GetContactFile().toStdString());
+    STARTUP.addStep("coloring", &MainWindow::initializeColoring, "widgets");
     // connect signals and slots, set visibility of some GUI objects
-    connectSignalsSlots();
-    // auto update check
-    triggerUpdateCheck();
+    STARTUP.addStep("signals", &MainWindow::connectSignalsSlots, "widgets");
     // init screen capturing
-    initializeScreenCapturing();
+    STARTUP.addStep("screen-capturing", &MainWindow::initializeScreenCapturing, "desktop-sources");
+    if (!STARTUP.run(this))
+        exit(-1);
+
     // init network simulator
     initializeNetworkSimulator(pArguments);
-    // delayed call to register at Stun and Sip server
+    // delayed call to register at Sip server
     QTimer::singleShot(2000, this, SLOT(registerAtStunSipServer()));
     ProcessRemainingArguments(pArguments);
+    LOG(LOG_INFO, "Startup finished after %d ms", mStartTime.elapsed());
     mStarting = false;
 }
 
@@ -215,6 +253,39 @@ void MainWindow::initializeConfiguration(QStringList &pArguments)
     removeArguments(pArguments, "-SetDefaults");
 }
 
+void MainWindow::readStartupSettings()
+{
+    // the configuration isn't thread-safe, hence background steps of the startup graph use these copies
+    mStartupSipListenerAddress = CONF.GetSipListenerAddress();
+    mStartupNatSupport = CONF.GetNatSupportActivation();
+    mStartupStunServer = CONF.GetStunServer();
+    mStartupSipStartPort = CONF.GetSipStartPort();
+    mStartupSipListenerTransport = CONF.GetSipListenerTransport();
+    mStartupVideoAudioStartPort = CONF.GetVideoAudioStartPort();
+    mStartupContactFile = CONF.GetContactFile().toStdString();
+}
+
+void MainWindow::initializeCodecs()
+{
+    LOG(LOG_VERBOSE, "Initialization of codecs..");
+    MediaSource::FfmpegInit();
+}
+
+void MainWindow::initializeStartSound()
+{
+    #ifndef DEBUG_VERSION
+        LOG(LOG_VERBOSE, "Playing start sound..");
+        OpenPlaybackDevice("Start/stop");
+        if (CONF.GetStartSound())
+            StartAudioPlayback(CONF.GetStartSoundFile());
+    #endif
+}
+
+void MainWindow::initializeContacts()
+{
+    CONTACTS.Init(mStartupContactFile);
+}
+
 void MainWindow::initializeGUI()
 {
     LOG(LOG_VERBOSE, "Initialization of GUI..");
@@ -350,6 +421,21 @@ void MainWindow::initializeScreenCapturing()
 
 void MainWindow::initializeNetworkSimulator(QStringList &pArguments, bool pForce)
 {
+    // built-in network emulator for NAPI based transports
+    QStringList tEmulatorArgs = pArguments.filter("-NetworkEmulator=");
+    if (tEmulatorArgs.size())
+    {
+        EmuSettings tSettings;
+        QString tDescription = tEmulatorArgs.last().remove("-NetworkEmulator=");
+        if (EmuSetup::parseSettings(tDescription.toStdString(), tSettings))
+        {
+            LOG(LOG_WARN, "Emulating network conditions \"%s\" for NAPI based transports", tDescription.toStdString().c_str());
+            EmuSetup::setDefaultSettings(tSettings);
+            NAPI.selectImpl(NETWORK_EMULATOR);
+        }
+        removeArguments(pArguments, "-NetworkEmulator");
+    }
+
     // use defines here until plugin-interface is integrated completely
     #if HOMER_NETWORK_SIMULATOR
         if (mNetworkSimulator != NULL)
@@ -448,13 +534,12 @@ void MainWindow::initializeDebugging(QStringList &pArguments)
     LOG(LOG_VERBOSE, "#############################################");
 }
 
-void MainWindow::initializeConferenceManagement()
+void MainWindow::initializeNetworkInterfaces()
 {
-    QString tLocalSourceIp = "";
     QString tLocalLoopIp = "";
-    bool tInterfaceFound = GetNetworkInfo(mLocalAddresses, tLocalSourceIp, tLocalLoopIp);
+    mLocalSourceIp = "";
+    bool tInterfaceFound = GetNetworkInfo(mLocalAddresses, mLocalSourceIp, tLocalLoopIp, mStartupSipListenerAddress);
 
-    LOG(LOG_VERBOSE, "Initialization of conference management..");
     if (!tInterfaceFound)
     {
         if (tLocalLoopIp != "")
@@ -462,28 +547,33 @@ void MainWindow::initializeConferenceManagement()
             LOG(LOG_INFO, "No fitting network interface towards outside found");
             LOG(LOG_INFO, "Using loopback interface with IP address: %s", tLocalLoopIp.toStdString().c_str());
             LOG(LOG_INFO, "==>>>>> NETWORK TIMEOUTS ARE POSSIBLE! APPLICATION MAY HANG FOR MOMENTS! <<<<<==");
-            tLocalSourceIp = tLocalLoopIp;
+            mLocalSourceIp = tLocalLoopIp;
         }else
         {
             LOG(LOG_ERROR, "No fitting network interface present");
-            exit(-1);
+            // this step runs in a background thread, the main thread terminates the application
+            STARTUP.reportFailure("no fitting network interface present");
         }
     }
+}
 
-    CONF.SetSipListenerAddress(tLocalSourceIp);
-
+void MainWindow::initializeConferenceManagement()
+{
+    LOG(LOG_VERBOSE, "Initialization of conference management..");
     if (CONF.ConferencingEnabled())
     {
-        LOG(LOG_INFO, "Using conference management IP address: %s", tLocalSourceIp.toStdString().c_str());
-        MEETING.Init(tLocalSourceIp.toStdString(), mLocalAddresses, CONF.GetNatSupportActivation(), "BROADCAST", CONF.GetSipStartPort(), CONF.GetSipListenerTransport(), CONF.GetSipStartPort() + 10, CONF.GetVideoAudioStartPort());
+        LOG(LOG_INFO, "Using conference management IP address: %s", mLocalSourceIp.toStdString().c_str());
+        MEETING.Init(mLocalSourceIp.toStdString(), mLocalAddresses, mStartupNatSupport, "BROADCAST", mStartupSipStartPort, mStartupSipListenerTransport, mStartupSipStartPort + 10, mStartupVideoAudioStartPort);
+        // start NAT detection already now, a later registration at the SIP server waits for its result
+        if (mStartupNatSupport)
+            MEETING.SetStunServer(mStartupStunServer.toStdString());
     }
     MEETING.AddObserver(this);
 }
 
 void MainWindow::registerAtStunSipServer()
 {
-    if (CONF.GetNatSupportActivation())
-        MEETING.SetStunServer(CONF.GetStunServer().toStdString());
+    // the STUN server was already set during startup
     // is centralized mode selected activated?
     if (CONF.GetSipInfrastructureMode() == 1)
         MEETING.RegisterAtServer(CONF.GetSipUserName().toStdString(), CONF.GetSipPassword().toStdString(), CONF.GetSipServer().toStdString(), CONF.GetSipServerPort());
@@ -507,8 +597,6 @@ void MainWindow::initializeVideoAudioIO()
     #ifdef APPLE
 //        mOwnVideoMuxer->RegisterMediaSource(new MediaSourceCoreVideo());
     #endif
-	mOwnVideoMuxer->RegisterMediaSource(mMediaSourceDesktop = new MediaSourceDesktop());
-    mOwnVideoMuxer->RegisterMediaSource(mMediaSourceLogo = new MediaSourceLogo());
     // ############################
     // ### AUDIO
     // ############################
@@ -518,6 +606,17 @@ void MainWindow::initializeVideoAudioIO()
     {
         mOwnAudioMuxer->RegisterMediaSource(new MediaSourcePortAudio());
     }
+
+    // get informed about hotplugged devices
+    DEVICE_REGISTRY.AddObserver(this);
+}
+
+void MainWindow::initializeDesktopSources()
+{
+    // these sources depend on Qt objects and have to be created in the main thread
+    LOG(LOG_VERBOSE, "Creating desktop and logo media objects..");
+    mOwnVideoMuxer->RegisterMediaSource(mMediaSourceDesktop = new MediaSourceDesktop());
+    mOwnVideoMuxer->RegisterMediaSource(mMediaSourceLogo = new MediaSourceLogo());
 }
 
 void MainWindow::initializeColoring()
@@ -617,16 +716,15 @@ void MainWindow::initializeWidgetsAndMenus()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool MainWindow::GetNetworkInfo(LocalAddressesList &pLocalAddressesList, QString &pLocalSourceIp, QString &pLocalLoopIp)
+bool MainWindow::GetNetworkInfo(LocalAddressesList &pLocalAddressesList, QString &pLocalSourceIp, QString &pLocalLoopIp, QString pLastSipListenerAddress)
 {
-    QString tLastSipListenerAddress = CONF.GetSipListenerAddress();
     bool tLocalInterfaceSet = false;
     pLocalSourceIp = "";
 
     //### determine all local IP addresses
     QList<QHostAddress> tQtLocalAddresses = QNetworkInterface::allAddresses();
 
-    LOG(LOG_INFO, "Last listener address: %s", tLastSipListenerAddress.toStdString().c_str());
+    LOG(LOG_INFO, "Last listener address: %s", pLastSipListenerAddress.toStdString().c_str());
     LOG(LOG_INFO, "Locally usable IPv4/6 addresses are:");
     for (int i = 0; i < tQtLocalAddresses.size(); i++)
     {
@@ -635,9 +733,9 @@ bool MainWindow::GetNetworkInfo(LocalAddressesList &pLocalAddressesList, QString
         {
             LOG(LOG_INFO, "...%s", tAddress.toStdString().c_str());
 
-            if (tAddress == tLastSipListenerAddress)
+            if (tAddress == pLastSipListenerAddress)
             {
-                pLocalSourceIp = tLastSipListenerAddress;
+                pLocalSourceIp = pLastSipListenerAddress;
                 LOG(LOG_INFO, ">>> last time used as conference address");
             }
 
@@ -787,6 +885,9 @@ void MainWindow::loadSettings()
     LOG(LOG_VERBOSE, "Loading program settings..");
     LOG(LOG_VERBOSE, "..meeting settings");
 
+    // the selected conference address is the preferred one for the next start
+    CONF.SetSipListenerAddress(mLocalSourceIp);
+
     MEETING.SetLocalUserName(QString(CONF.GetUserName().toLocal8Bit()).toStdString());
     MEETING.SetLocalUserMailAdr(QString(CONF.GetUserMail().toLocal8Bit()).toStdString());
     MEETING.SetAvailabilityState(CONF.GetConferenceAvailability().toStdString());
@@ -926,11 +1027,16 @@ void MainWindow::closeEvent(QCloseEvent* pEvent)
     // stop the screenshot creating timer function
     LOG(LOG_VERBOSE, "..stopping GUI capturing");
     mScreenShotTimer->stop();
+    if (mActiveSpeakerTimer != NULL)
+        mActiveSpeakerTimer->stop();
 
     // prevent the system from further incoming events
     LOG(LOG_VERBOSE, "..stopping conference manager");
     MEETING.Stop();
 
+    LOG(LOG_VERBOSE, "..stopping device notifications");
+    DEVICE_REGISTRY.DeleteObserver(this);
+
     //HINT: delete MediaSourcesControlWidget before local participant widget to avoid crashes caused by race conditions (control widget has a timer which calls local participant widget's video widget!)
     LOG(LOG_VERBOSE, "..destroying media source control widget");
     delete mMediaSourcesControlWidget;
@@ -1018,6 +1124,11 @@ void MainWindow::handleMeetingEvent(GeneralEvent *pEvent)
     QApplication::postEvent(this, (QEvent*) new QMeetingEvent(pEvent));
 }
 
+void MainWindow::handleDeviceRegistryEvent(std::string pEnumerator, enum MediaType pMediaType)
+{
+    QApplication::postEvent(this, (QEvent*) new DevicesChangedEvent(QString(pEnumerator.c_str()), pMediaType));
+}
+
 void MainWindow::GetEventSource(GeneralEvent *pEvent, QString &pSender, QString &pSenderApp)
 {
     pSender = (pEvent->SenderName != "") ? QString(pEvent->SenderName.c_str()) : QString(pEvent->Sender.c_str());
@@ -1113,6 +1224,17 @@ void MainWindow::changeEvent (QEvent *pEvent)
 
 void MainWindow::customEvent(QEvent* pEvent)
 {
+    // hotplugged devices: the device menus are always built from the current device lists, we only inform the user here
+    if (pEvent->type() == MAIN_WINDOW_EVENT_DEVICES_CHANGED)
+    {
+        DevicesChangedEvent *tDCEvent = (DevicesChangedEvent*)pEvent;
+        QString tType = (tDCEvent->GetMediaType() == MEDIA_VIDEO) ? "video" : "audio";
+        LOG(LOG_INFO, "Available %s devices of %s have changed", tType.toStdString().c_str(), tDCEvent->GetEnumerator().toStdString().c_str());
+        if ((mSysTrayIcon != NULL) && (!mShuttingDown))
+            mSysTrayIcon->showMessage("Devices changed", "The available " + tType + " devices have changed (" + tDCEvent->GetEnumerator() + ")", QSystemTrayIcon::Information, CONF.GetSystrayTimeout());
+        return;
+    }
+
     // make sure we have our user defined QEvent
     if (pEvent->type() != QEvent::User)
         return;
@@ -1143,6 +1265,8 @@ void MainWindow::customEvent(QEvent* pEvent)
     PublicationFailedEvent *tPFEvent;
     OptionsAcceptEvent *tOAEvent;
     OptionsUnavailableEvent *tOUAEvent;
+    SubscriptionPresenceNotifyEvent *tSPNEvent;
+    SubscriptionPresenceUnavailableEvent *tSPUEvent;
     GeneralEvent *tEvent = ((QMeetingEvent*) pEvent)->getEvent();
     ParticipantWidget *tParticipantWidget;
     AddNetworkSinkDialog *tANSDialog =  NULL;
@@ -1163,6 +1287,8 @@ void MainWindow::customEvent(QEvent* pEvent)
                                                 (tEvent->getType() != REGISTRATION_FAILED) &&
                                                 (tEvent->getType() != OPTIONS_ACCEPT) &&
                                                 (tEvent->getType() != OPTIONS_UNAVAILABLE) &&
+                                                (tEvent->getType() != SUBSCRIPTION_PRESENCE_NOTIFY) &&
+                                                (tEvent->getType() != SUBSCRIPTION_PRESENCE_UNAVAILABLE) &&
                                                 (tEvent->getType() != PUBLICATION) &&
                                                 (tEvent->getType() != PUBLICATION_FAILED))
     {
@@ -1254,6 +1380,43 @@ void MainWindow::customEvent(QEvent* pEvent)
                         }
                     }
 
+                    break;
+        case SUBSCRIPTION_PRESENCE_NOTIFY:
+                    //######################## PRESENCE NOTIFY ##########################
+                    tSPNEvent = (SubscriptionPresenceNotifyEvent*) tEvent;
+
+                    // further probing isn't needed because the peer informs us about each state change
+                    CONTACTS.UpdateContactSubscription(QString::fromLocal8Bit(tSPNEvent->Sender.c_str()), tSPNEvent->Transport, CONTACT_SUBSCRIPTION_ACTIVE);
+                    CONTACTS.UpdateContactState(QString::fromLocal8Bit(tSPNEvent->Sender.c_str()), tSPNEvent->Transport, tSPNEvent->Available ? CONTACT_AVAILABLE : CONTACT_UNAVAILABLE);
+
+                    // inform participant widget about new state
+                    if (mParticipantWidgets.size())
+                    {
+                        // search for corresponding participant widget
+                        for (tIt = mParticipantWidgets.begin(); tIt != mParticipantWidgets.end(); tIt++)
+                        {
+                            if ((*tIt)->IsThisParticipant(QString(tSPNEvent->Sender.c_str()), tSPNEvent->Transport))
+                            {
+                                tKnownParticipant = true;
+                                (*tIt)->UpdateParticipantState(tSPNEvent->Available ? CONTACT_AVAILABLE : CONTACT_UNAVAILABLE);
+                                break;
+                            }
+                        }
+                    }
+
+                    break;
+        case SUBSCRIPTION_PRESENCE_UNAVAILABLE:
+                    //######################## PRESENCE UNAVAILABLE ##########################
+                    tSPUEvent = (SubscriptionPresenceUnavailableEvent*) tEvent;
+
+                    LOG(LOG_VERBOSE, "Presence subscription unavailable, reason is \"%s\"(%d), falling back to probing", tSPUEvent->Description.c_str(), tSPUEvent->StatusCode);
+
+                    // retry the subscription later if the peer was only unreachable or has terminated the subscription, otherwise the peer doesn't support it
+                    if ((tSPUEvent->StatusCode == 0) || (tSPUEvent->StatusCode == 408) || (tSPUEvent->StatusCode == 503))
+                        CONTACTS.UpdateContactSubscription(QString::fromLocal8Bit(tSPUEvent->Sender.c_str()), tSPUEvent->Transport, CONTACT_SUBSCRIPTION_NONE);
+                    else
+                        CONTACTS.UpdateContactSubscription(QString::fromLocal8Bit(tSPUEvent->Sender.c_str()), tSPUEvent->Transport, CONTACT_SUBSCRIPTION_REJECTED);
+
                     break;
         case GENERAL_ERROR:
                     //############################ GENERAL_ERROR #############################
@@ -1736,6 +1899,7 @@ void MainWindow::DeleteParticipantSession(ParticipantWidget *pParticipantWidget)
 
     if (tSessionType == PARTICIPANT)
     {
+        mActiveSpeakerDetector.RemoveParticipant(tParticipantName.toStdString());
         if (!MEETING.CloseParticipantSession(QString(tParticipantName.toLocal8Bit()).toStdString(), tParticipantTransport))
         {
             LOG(LOG_ERROR, "Could not close the session with participant");
@@ -2010,8 +2174,26 @@ void MainWindow::actionActivateMosaicMode(bool pActive)
 		QPalette tPalette = palette();
 		tPalette.setColor(QPalette::Window, QColor(0, 0, 0));
 		setPalette(tPalette);
+
+		// the video subscriptions follow the active speaker
+		if (mActiveSpeakerTimer == NULL)
+		{
+		    mActiveSpeakerTimer = new QTimer(this);
+		    connect(mActiveSpeakerTimer, SIGNAL(timeout()), this, SLOT(UpdateVideoSubscriptions()));
+		}
+		mActiveSpeakerDetector.Reset();
+		mActiveSpeakerTimer->start(MAIN_WINDOW_ACTIVE_SPEAKER_PERIOD);
 	}else
 	{
+		if (mActiveSpeakerTimer != NULL)
+		    mActiveSpeakerTimer->stop();
+		if (mParticipantWidgets.size())
+		{
+		    for (tIt = mParticipantWidgets.begin(); tIt != mParticipantWidgets.end(); tIt++)
+		    {
+		        (*tIt)->SetVideoSubscription(VIDEO_SUBSCRIPTION_FULL);
+		    }
+		}
 		setPalette(mMosaicOriginalPalette);
 		showNormal();
 		setWindowFlags(mMosaicModeFormerWindowFlags);
@@ -2037,6 +2219,25 @@ void MainWindow::actionActivateMosaicMode(bool pActive)
 	}
 }
 
+void MainWindow::UpdateVideoSubscriptions()
+{
+    ParticipantWidgetList::iterator tIt;
+
+    for (tIt = mParticipantWidgets.begin(); tIt != mParticipantWidgets.end(); tIt++)
+    {
+        if (((*tIt)->GetSessionType() == PARTICIPANT) && ((*tIt)->GetAudioWorker() != NULL))
+            mActiveSpeakerDetector.UpdateAudioLevel((*tIt)->GetParticipantName().toStdString(), (*tIt)->GetAudioWorker()->GetAudioLevel());
+    }
+
+    mActiveSpeakerDetector.Process();
+
+    for (tIt = mParticipantWidgets.begin(); tIt != mParticipantWidgets.end(); tIt++)
+    {
+        if ((*tIt)->GetSessionType() == PARTICIPANT)
+            (*tIt)->SetVideoSubscription(mActiveSpeakerDetector.GetVideoSubscription((*tIt)->GetParticipantName().toStdString()));
+    }
+}
+
 void MainWindow::actionActivateToolBarOnlineStatus(bool pActive)
 {
 	LOG(LOG_VERBOSE, "Setting online status tool bar visibility to: %d", pActive);
@@ -69,6 +69,9 @@ MediaSourceDesktop::MediaSourceDesktop(string pDesiredDevice):
     mWidget = NULL;
     mOutputScreenshot = NULL;
     mOriginalScreenshot = NULL;
+    mScreenshotUpdated = false;
+    mOutputScreenshotValid = false;
+    mMouseImage = QImage(":/images/MouseBlack.png").scaled(16, 32);
 
     // reset grabbing offset values
     mGrabOffsetX = 0;
@@ -209,6 +212,8 @@ bool MediaSourceDesktop::OpenVideoGrabDevice(int pResX, int pResY, float pFps)
     //######################################################
     InitFpsEmulator();
     mLastTimeGrabbed == QTime(0, 0, 0, 0);
+    mLastTimeDelivered = QTime::currentTime();
+    mOutputScreenshotValid = false;
     mSourceStartPts = 0;
     mFrameNumber = 0;
     mMediaType = MEDIA_VIDEO;
@@ -250,6 +255,7 @@ bool MediaSourceDesktop::CloseGrabDevice()
         mOutputScreenshot = NULL;
         free(mOriginalScreenshot);
         mOriginalScreenshot = NULL;
+        mLastScreenshot = QImage();
 
         LOG(LOG_INFO, "...closed");
 
@@ -277,6 +283,7 @@ void MediaSourceDesktop::DoSetVideoGrabResolution(int pResX, int pResY)
     mSourceResY = pResY;
 
     mOutputScreenshot = malloc(mTargetResX * mTargetResY * MSD_BYTES_PER_PIXEL * sizeof(char));
+    mOutputScreenshotValid = false;
 
     mMutexScreenshot.unlock();
 }
@@ -416,26 +423,30 @@ void MediaSourceDesktop::CreateScreenshot()
 		tSourcePixmap = tSourcePixmap.scaled(mSourceResX, mSourceResY);
 	}
 
+	QImage tSourceImage;
+	if (!tSourcePixmap.isNull())
+		tSourceImage = tSourcePixmap.toImage().convertToFormat(QImage::Format_RGB32);
+
 	//####################################################################
 	//### MOUSE VISUALIZATION
 	//####################################################################
-	if (mMouseVisualization)
+	if ((mMouseVisualization) && (!tSourceImage.isNull()))
 	{
 		QPoint tMousePos = QCursor::pos();
-		if ((tMousePos.x() < tSourcePixmap.width()) && (tMousePos.y() < tSourcePixmap.height()))
+		if ((tMousePos.x() < tSourceImage.width()) && (tMousePos.y() < tSourceImage.height()))
 		{// mouse is in visible area
 			int tMousePosInSourcePixmapX = mSourceResX * tMousePos.x() / tCaptureResX;
 			int tMousePosInSourcePixmapY = mSourceResY * tMousePos.y() / tCaptureResY;
 
 			//LOG(LOG_VERBOSE, "Mouse position: %d*%d", tMousePosInSourcePixmapX, tMousePosInSourcePixmapY);
-			QPainter *tPainter = new QPainter(&tSourcePixmap);
+			QPainter *tPainter = new QPainter(&tSourceImage);
 			//TODO: add support for click visualization
-			tPainter->drawPixmap(tMousePosInSourcePixmapX, tMousePosInSourcePixmapY, QPixmap(":/images/MouseBlack.png").scaled(16, 32));
+			tPainter->drawImage(tMousePosInSourcePixmapX, tMousePosInSourcePixmapY, mMouseImage);
 			delete tPainter;
 		}
 	}
 
-	if(!tSourcePixmap.isNull())
+	if(!tSourceImage.isNull())
     {
 		// record screenshot via ffmpeg
 		if (mRecording)
@@ -445,9 +456,9 @@ void MediaSourceDesktop::CreateScreenshot()
 				LOG(LOG_ERROR, "Unable to allocate memory for RGB frame");
 			}else
 			{
-				QImage tSourceImage = QImage((unsigned char*)mOriginalScreenshot, mSourceResX, mSourceResY, QImage::Format_RGB32);
-				QPainter *tSourcePainter = new QPainter(&tSourceImage);
-				tSourcePainter->drawPixmap(0, 0, tSourcePixmap);
+				QImage tRecordImage = QImage((unsigned char*)mOriginalScreenshot, mSourceResX, mSourceResY, QImage::Format_RGB32);
+				QPainter *tSourcePainter = new QPainter(&tRecordImage);
+				tSourcePainter->drawImage(0, 0, tSourceImage);
 				delete tSourcePainter;
 
 				// Assign appropriate parts of buffer to image planes in tRGBFrame
@@ -467,18 +478,58 @@ void MediaSourceDesktop::CreateScreenshot()
 			}
 		}
 
-		// get the scaled version of the capture screen segment
-		QPixmap tTargetPixmap = tSourcePixmap.scaled(mTargetResX, mTargetResY);
+		//####################################################################
+		//### CHANGE DETECTION
+		//####################################################################
+		QVector<QRect> tChangedRegions;
+		DetectChangedRegions(tSourceImage, tChangedRegions);
+		mLastScreenshot = tSourceImage;
 
 		// lock screenshot buffer
 		mMutexScreenshot.lock();
-		QImage tTargetImage = QImage((unsigned char*)mOutputScreenshot, mTargetResX, mTargetResY, QImage::Format_RGB32);
-		QPainter *tTargetPainter = new QPainter(&tTargetImage);
-		tTargetPainter->drawPixmap(0, 0, tTargetPixmap);
-		delete tTargetPainter;
-		mScreenshotUpdated = true;
+
+		if (!mOutputScreenshotValid)
+		{
+			tChangedRegions.clear();
+			tChangedRegions.push_back(tSourceImage.rect());
+		}
+
+		//####################################################################
+		//### SCALING of changed regions to target resolution
+		//####################################################################
+		if (!tChangedRegions.isEmpty())
+		{
+			#ifdef MSD_DEBUG_PACKETS
+				LOG(LOG_VERBOSE, "Screenshot has %d changed regions", tChangedRegions.size());
+			#endif
+			QImage tTargetImage = QImage((unsigned char*)mOutputScreenshot, mTargetResX, mTargetResY, QImage::Format_RGB32);
+			QPainter *tTargetPainter = new QPainter(&tTargetImage);
+			for (int i = 0; i < tChangedRegions.size(); i++)
+			{
+				// the target region is aligned to whole pixels and covers the entire changed region
+				int tLeft = tChangedRegions[i].left() * mTargetResX / tSourceImage.width();
+				int tTop = tChangedRegions[i].top() * mTargetResY / tSourceImage.height();
+				int tRight = ((tChangedRegions[i].right() + 1) * mTargetResX + tSourceImage.width() - 1) / tSourceImage.width();
+				int tBottom = ((tChangedRegions[i].bottom() + 1) * mTargetResY + tSourceImage.height() - 1) / tSourceImage.height();
+				QRectF tTargetRegion(tLeft, tTop, tRight - tLeft, tBottom - tTop);
+				QRectF tSourceRegion((qreal)tLeft * tSourceImage.width() / mTargetResX, (qreal)tTop * tSourceImage.height() / mTargetResY, (qreal)(tRight - tLeft) * tSourceImage.width() / mTargetResX, (qreal)(tBottom - tTop) * tSourceImage.height() / mTargetResY);
+				tTargetPainter->drawImage(tTargetRegion, tSourceImage, tSourceRegion);
+			}
+			delete tTargetPainter;
+			mOutputScreenshotValid = true;
+			mScreenshotUpdated = true;
+		}else
+		{
+			// refresh the receivers from time to time even if nothing has changed
+			int tTimeSinceDelivery = mLastTimeDelivered.msecsTo(tCurrentTime);
+			if ((tTimeSinceDelivery >= MSD_REFRESH_PERIOD) || (tTimeSinceDelivery < 0 /* midnight */))
+				mScreenshotUpdated = true;
+		}
+
 		// notify consumer about new screenshot
-		mWaitConditionScreenshotUpdated.wakeAll();
+		if (mScreenshotUpdated)
+			mWaitConditionScreenshotUpdated.wakeAll();
+
 		// unlock screenshot buffer again
 		mMutexScreenshot.unlock();
     }else
@@ -487,6 +538,75 @@ void MediaSourceDesktop::CreateScreenshot()
     mMutexGrabberActive.unlock();
 }
 
+void MediaSourceDesktop::DetectChangedRegions(const QImage &pScreenshot, QVector<QRect> &pRegions)
+{
+    pRegions.clear();
+
+    if ((mLastScreenshot.isNull()) || (mLastScreenshot.size() != pScreenshot.size()))
+    {
+        pRegions.push_back(pScreenshot.rect());
+        return;
+    }
+
+    int tWidth = pScreenshot.width();
+    int tHeight = pScreenshot.height();
+    int tTilesX = (tWidth + MSD_TILE_SIZE - 1) / MSD_TILE_SIZE;
+    int tTilesY = (tHeight + MSD_TILE_SIZE - 1) / MSD_TILE_SIZE;
+    int tChangedTiles = 0;
+
+    for (int tTileY = 0; tTileY < tHeight; tTileY += MSD_TILE_SIZE)
+    {
+        int tTileHeight = (tHeight - tTileY < MSD_TILE_SIZE) ? tHeight - tTileY : MSD_TILE_SIZE;
+        int tRunStart = -1;
+
+        // the additional iteration closes a run of changed tiles at the right border
+        for (int tTile = 0; tTile <= tTilesX; tTile++)
+        {
+            bool tChanged = false;
+            if (tTile < tTilesX)
+            {
+                int tTileX = tTile * MSD_TILE_SIZE;
+                int tTileBytes = ((tWidth - tTileX < MSD_TILE_SIZE) ? tWidth - tTileX : MSD_TILE_SIZE) * MSD_BYTES_PER_PIXEL;
+                for (int y = tTileY; (y < tTileY + tTileHeight) && (!tChanged); y++)
+                    tChanged = (memcmp(pScreenshot.scanLine(y) + tTileX * MSD_BYTES_PER_PIXEL, mLastScreenshot.scanLine(y) + tTileX * MSD_BYTES_PER_PIXEL, tTileBytes) != 0);
+            }
+
+            if (tChanged)
+            {
+                tChangedTiles++;
+                if (tRunStart < 0)
+                    tRunStart = tTile;
+            }else if (tRunStart >= 0)
+            {
+                int tRunEndX = (tTile * MSD_TILE_SIZE < tWidth) ? tTile * MSD_TILE_SIZE : tWidth;
+                QRect tRun(tRunStart * MSD_TILE_SIZE, tTileY, tRunEndX - tRunStart * MSD_TILE_SIZE, tTileHeight);
+
+                // extend a region of the previous tile row if it has the same horizontal extent
+                bool tMerged = false;
+                for (int i = pRegions.size() - 1; (i >= 0) && (pRegions[i].bottom() + 1 >= tTileY); i--)
+                {
+                    if ((pRegions[i].bottom() + 1 == tTileY) && (pRegions[i].left() == tRun.left()) && (pRegions[i].width() == tRun.width()))
+                    {
+                        pRegions[i].setBottom(tRun.bottom());
+                        tMerged = true;
+                        break;
+                    }
+                }
+                if (!tMerged)
+                    pRegions.push_back(tRun);
+                tRunStart = -1;
+            }
+        }
+    }
+
+    // scale the entire screenshot at once if most of it has changed
+    if (tChangedTiles * 2 > tTilesX * tTilesY)
+    {
+        pRegions.clear();
+        pRegions.push_back(pScreenshot.rect());
+    }
+}
+
 int MediaSourceDesktop::GrabChunk(void* pChunkBuffer, int& pChunkSize, bool pDropChunk)
 {
     // lock grabbing
@@ -531,8 +651,9 @@ int MediaSourceDesktop::GrabChunk(void* pChunkBuffer, int& pChunkSize, bool pDro
     // additional Qt based lock for QWaitCondition
     mMutexScreenshot.lock();
 
-    // waiting for new data
-    mWaitConditionScreenshotUpdated.wait(&mMutexScreenshot);
+    // waiting for new data, an unchanged screen isn't delivered until the next refresh
+    if (!mScreenshotUpdated)
+        mWaitConditionScreenshotUpdated.wait(&mMutexScreenshot);
 
     // was wait interrupted because of a call to StopGrabbing ?
 	if (mGrabbingStopped)
@@ -547,6 +668,7 @@ int MediaSourceDesktop::GrabChunk(void* pChunkBuffer, int& pChunkSize, bool pDro
 
     memcpy(pChunkBuffer, mOutputScreenshot, mTargetResX * mTargetResY * MSD_BYTES_PER_PIXEL);
     mScreenshotUpdated = false;
+    mLastTimeDelivered = QTime::currentTime();
 
     // unlock again and enable new screenshots
     mMutexScreenshot.unlock();
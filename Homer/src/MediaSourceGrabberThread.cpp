@@ -73,6 +73,7 @@ MediaSourceGrabberThread::MediaSourceGrabberThread(QString pName, MediaSource *p
     QThread()
 {
 	mSyncClockMasterSource = NULL;
+	mAVSynchronizer = NULL;
     mSyncClockAsap = false;
     mSetGrabResolutionAsap = false;
     mStartRecorderAsap = false;
@@ -344,6 +345,12 @@ void MediaSourceGrabberThread::SyncClock(MediaSource* pSource)
     mGrabbingCondition.wakeAll();
 }
 
+void MediaSourceGrabberThread::SetAVSynchronizer(AVSynchronizer *pAVSynchronizer)
+{
+    LOG(LOG_VERBOSE, "Setting A/V synchronizer to %p", pAVSynchronizer);
+    mAVSynchronizer = pAVSynchronizer;
+}
+
 bool MediaSourceGrabberThread::SupportsMultipleInputStreams()
 {
     if (mMediaSource != NULL)
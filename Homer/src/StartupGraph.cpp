@@ -0,0 +1,347 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the startup graph
+ * Author:  Thomas Volkert
+ * Since:   2012-12-11
+ */
+
+#include <StartupGraph.h>
+#include <MainWindow.h>
+#include <ProcessStatisticService.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+#include <stdio.h>
+
+namespace Homer { namespace Gui {
+
+using namespace std;
+using namespace Homer::Monitor;
+
+StartupGraph sStartupGraph;
+
+///////////////////////////////////////////////////////////////////////////////
+
+class StartupWorker:
+    public Thread
+{
+public:
+    StartupWorker(StartupGraph *pGraph, int pStep);
+
+    virtual ~StartupWorker();
+
+private:
+    virtual void* Run(void* pArgs = NULL);
+
+    StartupGraph        *mGraph;
+    int                 mStep;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+StartupWorker::StartupWorker(StartupGraph *pGraph, int pStep)
+{
+    mGraph = pGraph;
+    mStep = pStep;
+}
+
+StartupWorker::~StartupWorker()
+{
+}
+
+void* StartupWorker::Run(void* pArgs)
+{
+    SVC_PROCESS_STATISTIC.AssignThreadName("Startup-" + mGraph->mSteps[mStep].Name);
+
+    mGraph->executeStep(mStep);
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StartupGraph::StartupGraph()
+{
+    mMainWindow = NULL;
+    mFinishedSteps = 0;
+    mStartTime = 0;
+    mDuration = 0;
+    mMainThreadWaitingTime = 0;
+    mFailed = false;
+}
+
+StartupGraph::~StartupGraph()
+{
+}
+
+StartupGraph& StartupGraph::getInstance()
+{
+    return sStartupGraph;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int StartupGraph::findStep(string pName)
+{
+    for (int i = 0; i < (int)mSteps.size(); i++)
+    {
+        if (mSteps[i].Name == pName)
+            return i;
+    }
+
+    return -1;
+}
+
+void StartupGraph::addStep(string pName, StartupFunction pFunction, string pDependencies, bool pBackground)
+{
+    StartupStep tStep;
+
+    tStep.Name = pName;
+    tStep.Function = pFunction;
+    tStep.Background = pBackground;
+    tStep.State = STARTUP_STEP_WAITING;
+    tStep.StartTime = 0;
+    tStep.Duration = 0;
+
+    // resolve the dependencies, only formerly added steps are allowed and hence the graph can't contain cycles
+    size_t tPos = 0;
+    while (tPos <= pDependencies.size())
+    {
+        size_t tEnd = pDependencies.find(',', tPos);
+        if (tEnd == string::npos)
+            tEnd = pDependencies.size();
+        string tDependency = pDependencies.substr(tPos, tEnd - tPos);
+        if (tDependency != "")
+        {
+            int tDependencyStep = findStep(tDependency);
+            if (tDependencyStep != -1)
+                tStep.Dependencies.push_back(tDependencyStep);
+            else
+                LOG(LOG_ERROR, "Startup step \"%s\" depends on unknown step \"%s\", ignoring this dependency", pName.c_str(), tDependency.c_str());
+        }
+        tPos = tEnd + 1;
+    }
+
+    mMutex.lock();
+    mSteps.push_back(tStep);
+    mMutex.unlock();
+}
+
+bool StartupGraph::isReady(int pStep)
+{
+    if (mSteps[pStep].State != STARTUP_STEP_WAITING)
+        return false;
+
+    vector<int>::iterator tIt;
+    for (tIt = mSteps[pStep].Dependencies.begin(); tIt != mSteps[pStep].Dependencies.end(); tIt++)
+    {
+        if (mSteps[*tIt].State != STARTUP_STEP_FINISHED)
+            return false;
+    }
+
+    return true;
+}
+
+void StartupGraph::executeStep(int pStep)
+{
+    int64_t tStartTime = Time::GetTimeStamp();
+    LOG(LOG_VERBOSE, "Starting step \"%s\"..", mSteps[pStep].Name.c_str());
+
+    (mMainWindow->*mSteps[pStep].Function)();
+
+    int64_t tEndTime = Time::GetTimeStamp();
+
+    mMutex.lock();
+    mSteps[pStep].StartTime = tStartTime - mStartTime;
+    mSteps[pStep].Duration = tEndTime - tStartTime;
+    mSteps[pStep].State = STARTUP_STEP_FINISHED;
+    mFinishedSteps++;
+    mStepFinishedCondition.SignalAll();
+    mMutex.unlock();
+
+    LOG(LOG_INFO, "Startup step \"%s\" took %.1f ms (%s thread)", mSteps[pStep].Name.c_str(), (float)(tEndTime - tStartTime) / 1000, mSteps[pStep].Background ? "background" : "main");
+}
+
+bool StartupGraph::run(MainWindow *pMainWindow)
+{
+    vector<StartupWorker*> tWorkers;
+
+    LOG(LOG_VERBOSE, "Running startup graph with %d steps..", (int)mSteps.size());
+
+    mMutex.lock();
+
+    mMainWindow = pMainWindow;
+    mStartTime = Time::GetTimeStamp();
+    mFinishedSteps = 0;
+    mMainThreadWaitingTime = 0;
+    mFailed = false;
+
+    while (mFinishedSteps < (int)mSteps.size())
+    {
+        int tMainThreadStep = -1;
+
+        // a failed step stops the startup, but the running background steps have to finish before their workers are deleted
+        if (mFailed)
+        {
+            bool tStepsRunning = false;
+            for (int i = 0; i < (int)mSteps.size(); i++)
+            {
+                if (mSteps[i].State == STARTUP_STEP_RUNNING)
+                    tStepsRunning = true;
+            }
+            if (!tStepsRunning)
+                break;
+            mStepFinishedCondition.Wait(&mMutex);
+            continue;
+        }
+
+        // start all ready background steps and select the first ready main thread step
+        for (int i = 0; i < (int)mSteps.size(); i++)
+        {
+            if (!isReady(i))
+                continue;
+
+            if (mSteps[i].Background)
+            {
+                StartupWorker *tWorker = new StartupWorker(this, i);
+                mSteps[i].State = STARTUP_STEP_RUNNING;
+                if (tWorker->StartThread())
+                {
+                    tWorkers.push_back(tWorker);
+                    continue;
+                }
+                LOG(LOG_WARN, "Failed to start background thread for startup step \"%s\", executing it in main thread", mSteps[i].Name.c_str());
+                delete tWorker;
+                mSteps[i].State = STARTUP_STEP_WAITING;
+            }
+            if (tMainThreadStep == -1)
+                tMainThreadStep = i;
+        }
+
+        if (tMainThreadStep != -1)
+        {
+            mSteps[tMainThreadStep].State = STARTUP_STEP_RUNNING;
+            mMutex.unlock();
+            executeStep(tMainThreadStep);
+            mMutex.lock();
+        }else
+        {
+            // nothing to do for the main thread until the next background step finishes
+            int64_t tWaitStartTime = Time::GetTimeStamp();
+            mStepFinishedCondition.Wait(&mMutex);
+            mMainThreadWaitingTime += Time::GetTimeStamp() - tWaitStartTime;
+        }
+    }
+
+    mDuration = Time::GetTimeStamp() - mStartTime;
+
+    mMutex.unlock();
+
+    // all steps are finished, the workers are about to terminate
+    vector<StartupWorker*>::iterator tIt;
+    for (tIt = tWorkers.begin(); tIt != tWorkers.end(); tIt++)
+    {
+        (*tIt)->StopThread(1000);
+        delete (*tIt);
+    }
+
+    if (mFailed)
+    {
+        LOG(LOG_ERROR, "Startup graph failed after %.1f ms because \"%s\"", (float)mDuration / 1000, mFailureReason.c_str());
+        return false;
+    }
+
+    LOG(LOG_INFO, "Startup graph finished after %.1f ms, main thread waited %.1f ms for background steps", (float)mDuration / 1000, (float)mMainThreadWaitingTime / 1000);
+
+    return true;
+}
+
+void StartupGraph::reportFailure(string pReason)
+{
+    mMutex.lock();
+    if (!mFailed)
+    {
+        mFailed = true;
+        mFailureReason = pReason;
+    }
+    mMutex.unlock();
+}
+
+string StartupGraph::getFailureReason()
+{
+    string tResult;
+
+    mMutex.lock();
+    tResult = mFailureReason;
+    mMutex.unlock();
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StartupSteps StartupGraph::getSteps()
+{
+    StartupSteps tResult;
+
+    mMutex.lock();
+    tResult = mSteps;
+    mMutex.unlock();
+
+    return tResult;
+}
+
+int64_t StartupGraph::getDuration()
+{
+    return mDuration;
+}
+
+int64_t StartupGraph::getMainThreadWaitingTime()
+{
+    return mMainThreadWaitingTime;
+}
+
+string StartupGraph::getReport()
+{
+    string tResult = "";
+    char tLine[256];
+
+    StartupSteps tSteps = getSteps();
+    StartupSteps::iterator tIt;
+    for (tIt = tSteps.begin(); tIt != tSteps.end(); tIt++)
+    {
+        if (tIt->State == STARTUP_STEP_FINISHED)
+            snprintf(tLine, sizeof(tLine), "%s: started at %.1f ms, took %.1f ms (%s thread)\n", tIt->Name.c_str(), (float)tIt->StartTime / 1000, (float)tIt->Duration / 1000, tIt->Background ? "background" : "main");
+        else
+            snprintf(tLine, sizeof(tLine), "%s: not finished\n", tIt->Name.c_str());
+        tResult += tLine;
+    }
+    snprintf(tLine, sizeof(tLine), "Overall: %.1f ms, main thread waited %.1f ms for background steps", (float)mDuration / 1000, (float)mMainThreadWaitingTime / 1000);
+    tResult += tLine;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -555,6 +555,8 @@ QStringList AudioWidget::GetAudioStatistic()
         tLine_Playback += ", " + QString("%1").arg(tPlaybackBuffers) + "/" + QString("%1").arg(mAudioWorker->GetPlaybackQueueSize()) + " " + Homer::Gui::AudioWidget::tr("frames buffered");
     if (tGaps > 0)
         tLine_Playback += " (" + QString("%1").arg(tGaps) + " gaps found)";
+    if (mAudioWorker->GetAdaptivePlayout())
+        tLine_Playback += ", " + Homer::Gui::AudioWidget::tr("playout:") + " " + QString("%1").arg(mAudioWorker->GetPlayoutDelay()) + " ms (" + Homer::Gui::AudioWidget::tr("target") + " " + QString("%1").arg(mAudioWorker->GetPlayoutTargetDelay()) + " ms)";
 
     //############################################
     //### Line 5: current position within file
@@ -627,17 +629,14 @@ QStringList AudioWidget::GetAudioStatistic()
 	return tAudioStatistic;
 }
 
-void AudioWidget::ShowSample(void* pBuffer, int pSampleSize)
+// peak level of a block of 16 bit stereo samples in % of the full scale
+static int CalculateAudioLevel(void* pBuffer, int pSampleSize)
 {
-    int tMSecs = QTime::currentTime().msec();
     short int tData = 0;
-    int tSum = 0, tMax = 1, tMin = -1;
-    int tLevel = 0;
+    int tMax = 1, tMin = -1;
 
     // sample size is given in bytes but we use 16 bit values, furthermore we are using stereo -> division by 4
     int tSampleAmount = pSampleSize / 4;
-    //if (pSampleSize != 4096)
-        //printf("AudioWidget-SampleSize: %d Sps: %d SampleNumber: %d\n", pSampleSize, pSps, pSampleNumber);
 
     //#############################################################
     //### find minimum and maximum values
@@ -645,13 +644,10 @@ void AudioWidget::ShowSample(void* pBuffer, int pSampleSize)
     for (int i = 0; i < tSampleAmount; i++)
     {
         tData = *((int16_t*)pBuffer + i * 2);
-        tSum += tData;
         if (tData < tMin)
             tMin = tData;
         if (tData > tMax)
             tMax = tData;
-        //if (i < 20)
-            //printf("%4hd ", tData);
     }
     //LOG(LOG_WARN, "Audio samples have a range of %d / %d", tMin, tMax);
 
@@ -671,13 +667,20 @@ void AudioWidget::ShowSample(void* pBuffer, int pSampleSize)
     if (tScaledMax > 100)
         tScaledMax = 100;
 
+    if (tScaledMin > tScaledMax)
+        return tScaledMin;
+    else
+        return tScaledMax;
+}
+
+void AudioWidget::ShowSample(void* pBuffer, int pSampleSize)
+{
+    int tMSecs = QTime::currentTime().msec();
+
     //#############################################################
     //### set the level of the level bar widget
     //#############################################################
-    if (tScaledMin > tScaledMax)
-        showAudioLevel(tScaledMin);
-    else
-        showAudioLevel(tScaledMax);
+    showAudioLevel(CalculateAudioLevel(pBuffer, pSampleSize));
 
     //#############################################################
     //### draw statistics
@@ -721,7 +724,6 @@ void AudioWidget::ShowSample(void* pBuffer, int pSampleSize)
         }
     }
 
-    //printf("Sum: %d SampleSize: %d SampleAmount: %d Average: %d Min: %d Max: %d scaledMin: %d scaledMax: %d\n", tSum, pSampleSize, tSampleAmount, (int)tSum/pSampleSize, tMin, tMax, tScaledMin, tScaledMax);
 }
 
 void AudioWidget::showAudioLevel(int pLevel)
@@ -902,6 +904,8 @@ AudioWorkerThread::AudioWorkerThread(QString pName, MediaSource *pAudioSource, A
     mSampleGrabIndex = 0;
     mDropSamples = false;
     mWorkerWithNewData = false;
+    mAudioLevel = 0;
+    mAudioLevelTime = 0;
 }
 
 AudioWorkerThread::~AudioWorkerThread()
@@ -1007,6 +1011,39 @@ int AudioWorkerThread::GetPlaybackQueueSize()
         return 0;
 }
 
+bool AudioWorkerThread::GetAdaptivePlayout()
+{
+    if (mWaveOut != NULL)
+        return mWaveOut->GetAdaptivePlayout();
+    else
+        return false;
+}
+
+int AudioWorkerThread::GetPlayoutDelay()
+{
+    if (mWaveOut != NULL)
+        return mWaveOut->GetPlayoutDelay();
+    else
+        return 0;
+}
+
+int AudioWorkerThread::GetPlayoutTargetDelay()
+{
+    if (mWaveOut != NULL)
+        return mWaveOut->GetPlayoutTargetDelay();
+    else
+        return 0;
+}
+
+int AudioWorkerThread::GetAudioLevel()
+{
+    // the grabbing may block if the stream stalls
+    if (Time::GetTimeStamp() - mAudioLevelTime > AUDIO_LEVEL_TIMEOUT * 1000)
+        return 0;
+
+    return mAudioLevel;
+}
+
 void AudioWorkerThread::SetSampleDropping(bool pDrop)
 {
     mDropSamples = pDrop;
@@ -1223,6 +1260,10 @@ void AudioWorkerThread::ResetPlayback()
 {
     bool tAudioWasMuted = mAudioOutMuted;
 
+    // live sources (e.g., network streams) get an adaptive playout buffer, files are played with the fixed queue limit
+    if (mWaveOut != NULL)
+        mWaveOut->SetAdaptivePlayout(!mMediaSource->SupportsSeeking());
+
     if (!tAudioWasMuted)
     {
         DoStopPlayback();
@@ -1341,6 +1382,8 @@ void AudioWorkerThread::run()
     {
         mAudioWidget->InformAboutNewSource();
     }
+    if (mWaveOut != NULL)
+        mWaveOut->SetAdaptivePlayout(!mMediaSource->SupportsSeeking());
 
     mLastFrameNumber = 0;
 
@@ -1422,6 +1465,14 @@ void AudioWorkerThread::run()
                 LOG(LOG_WARN, "Got from media source the sample block %d with size of %d bytes and stored it as index %d", tFrameNumber, tFrameSize, mSampleGrabIndex);
             #endif
 
+            // the level is also needed while the widget is invisible, e.g., for the active speaker detection
+            if ((tFrameNumber >= 0) && (tFrameSize > 0))
+            {
+                mAudioLevel = CalculateAudioLevel(mSamples[mSampleGrabIndex], tFrameSize);
+                mAudioLevelTime = Time::GetTimeStamp();
+            }else
+                mAudioLevel = 0;
+
 			//printf("SampleSize: %d Sample: %d\n", mSamplesSize[mSampleGrabIndex], tSampleNumber);
 
 			// play the sample block if audio out isn't currently muted
@@ -1434,7 +1485,16 @@ void AudioWorkerThread::run()
 			            LOG(LOG_VERBOSE, "Writing buffer at %p with size of %d bytes to audio output FIFO", mSamples[mSampleGrabIndex], tFrameSize);
 			        #endif
 			        mWaveOut->WriteChunk(mSamples[mSampleGrabIndex], tFrameSize);
-			        if (AUDIO_MAX_PLAYBACK_QUEUE > 0)
+			        // audio playout is the master clock for the video playback
+			        // the offset covers the playout buffer and the backend's queue up to the device, without a known device latency the synchronizer stays inactive
+			        if (mAVSynchronizer != NULL)
+			        {
+			            int tOutputLatency = mWaveOut->GetOutputLatency();
+			            if (tOutputLatency >= 0)
+			                mAVSynchronizer->UpdateAudioClock(mMediaSource->GetSynchronizationTimestamp(), (int64_t)(mWaveOut->GetPlayoutDelay() + tOutputLatency) * 1000);
+			        }
+			        // the adaptive playout controls the queue by itself
+			        if ((AUDIO_MAX_PLAYBACK_QUEUE > 0) && (!mWaveOut->GetAdaptivePlayout()))
 			            mWaveOut->LimitQueue(AUDIO_MAX_PLAYBACK_QUEUE);
 			    }
 			}else
@@ -1488,6 +1548,7 @@ void AudioWorkerThread::run()
             }
         }else
         {
+            mAudioLevel = 0;
         	if (mSourceAvailable)
         		LOG(LOG_VERBOSE, "AudioWorkerThread is in pause state");
         	else
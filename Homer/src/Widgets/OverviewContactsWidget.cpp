@@ -80,6 +80,9 @@ OverviewContactsWidget::OverviewContactsWidget(QAction *pAssignedAction, QMainWi
     mTvContacts->setModel(mContactListModel);
     SetVisible(CONF.GetVisibilityContactsWidget());
     mAssignedAction->setChecked(CONF.GetVisibilityContactsWidget());
+
+    // drive the presence scheduler of the contacts pool, also while this widget is hidden
+    mTimerId = startTimer(CONF.GetContactPresenceScheduleInterval());
 }
 
 OverviewContactsWidget::~OverviewContactsWidget()
@@ -111,12 +114,8 @@ void OverviewContactsWidget::SetVisible(bool pVisible)
     {
         move(mWinPos);
         show();
-        // update GUI elements every x ms
-        mTimerId = startTimer(CONF.GetContactPresenceCheckPeriod());
     }else
     {
-        if (mTimerId != -1)
-            killTimer(mTimerId);
         mWinPos = pos();
         hide();
     }
@@ -156,8 +155,8 @@ void OverviewContactsWidget::timerEvent(QTimerEvent *pEvent)
     #endif
     if (pEvent->timerId() == mTimerId)
     {
-        CONTACTS.ProbeAvailabilityForAll();
-        mContactListModel->UpdateView();
+        // the view is updated by the contacts pool whenever a contact state changes
+        CONTACTS.ProcessPresenceSchedule();
     }
 }
 
@@ -331,6 +330,10 @@ void OverviewContactsWidget::Dialog2Contact(ContactEditDialog *pCED, ContactDesc
 	pContact->Host = pContact->Host.toLower();
     pContact->Port      = (QString("%1").arg(pCED->mSbPort->value()));
     pContact->Transport = Socket::String2TransportType(pCED->mCbTransport->currentText().toStdString());
+    // the address might have changed, restart presence checking from scratch
+    pContact->PresenceNextCheck = 0;
+    pContact->PresenceFailures = 0;
+    pContact->PresenceSubscription = CONTACT_SUBSCRIPTION_NONE;
     if (pNewContact)
     {
         pContact->Id    = CONTACTS.GetNextFreeId();
@@ -30,7 +30,9 @@
 #include <Configuration.h>
 #include <Logger.h>
 #include <HBSystem.h>
+#include <HBMemoryPool.h>
 #include <Snippets.h>
+#include <StartupGraph.h>
 
 #include <QDockWidget>
 #include <QMainWindow>
@@ -93,12 +95,13 @@ void OverviewThreadsWidget::initializeGUI()
     setupUi(this);
 
     // hide id column
-    mTwThreads->setColumnHidden(12, true);
-    mTwThreads->sortItems(12);
+    mTwThreads->setColumnHidden(13, true);
+    mTwThreads->sortItems(13);
     mTwThreads->horizontalHeader()->setResizeMode(QHeaderView::Interactive);
     mTwThreads->horizontalHeader()->resizeSection(0, mTwThreads->horizontalHeader()->sectionSize(0) * 3);
-    mTwThreads->horizontalHeader()->resizeSection(7, mTwThreads->horizontalHeader()->sectionSize(7) * 2);
+    mTwThreads->horizontalHeader()->resizeSection(7, mTwThreads->horizontalHeader()->sectionSize(7) * 3);
     mTwThreads->horizontalHeader()->resizeSection(8, mTwThreads->horizontalHeader()->sectionSize(8) * 2);
+    mTwThreads->horizontalHeader()->resizeSection(9, mTwThreads->horizontalHeader()->sectionSize(9) * 2);
 
     UpdateView();
 }
@@ -118,6 +121,11 @@ void OverviewThreadsWidget::contextMenuEvent(QContextMenuEvent *pContextMenuEven
     tAction->setCheckable(true);
     tAction->setChecked(mScaleToOneCpuCore);
 
+    tMenu.addSeparator();
+
+    tMenu.addAction(Homer::Gui::OverviewThreadsWidget::tr("Show startup timing"));
+    tMenu.addAction(Homer::Gui::OverviewThreadsWidget::tr("Show memory pool usage"));
+
     QAction* tPopupRes = tMenu.exec(pContextMenuEvent->globalPos());
     if (tPopupRes != NULL)
     {
@@ -128,6 +136,16 @@ void OverviewThreadsWidget::contextMenuEvent(QContextMenuEvent *pContextMenuEven
             UpdateView();
             return;
         }
+        if (tPopupRes->text().compare(Homer::Gui::OverviewThreadsWidget::tr("Show startup timing")) == 0)
+        {
+            ShowMessage(Homer::Gui::OverviewThreadsWidget::tr("Startup timing"), QString(STARTUP.getReport().c_str()));
+            return;
+        }
+        if (tPopupRes->text().compare(Homer::Gui::OverviewThreadsWidget::tr("Show memory pool usage")) == 0)
+        {
+            ShowMessage(Homer::Gui::OverviewThreadsWidget::tr("Memory pool usage"), GetMemoryPoolReport());
+            return;
+        }
     }
 }
 
@@ -185,12 +203,28 @@ void OverviewThreadsWidget::FillRow(int pRow, ProcessStatistic *pStats)
     FillCellText(pRow, 4, QString("%1").arg(tStatValues.ThreadCount));
     FillCellText(pRow, 5, QString("%1").arg(tStatValues.PriorityBase));
     FillCellText(pRow, 6, QString("%1").arg(tStatValues.Priority));
-    FillCellText(pRow, 7, Int2ByteExpression(tStatValues.MemVirtual) + " bytes");
-    FillCellText(pRow, 8, Int2ByteExpression(tStatValues.MemPhysical) + " bytes");
-    FillCellText(pRow, 9, QString("%1 %").arg(tStatValues.LoadUser * tScaleFactor, 0, 'f', 2));
-    FillCellText(pRow, 10, QString("%1 %").arg(tStatValues.LoadSystem * tScaleFactor, 0, 'f', 2));
-    FillCellText(pRow, 11, QString("%1 %").arg(tStatValues.LoadTotal * tScaleFactor, 0, 'f', 2));
-    FillCellText(pRow, 12, QString("%1").arg(pRow));
+    FillCellText(pRow, 7, QString(pStats->GetThreadPolicy().c_str()));
+    FillCellText(pRow, 8, Int2ByteExpression(tStatValues.MemVirtual) + " bytes");
+    FillCellText(pRow, 9, Int2ByteExpression(tStatValues.MemPhysical) + " bytes");
+    FillCellText(pRow, 10, QString("%1 %").arg(tStatValues.LoadUser * tScaleFactor, 0, 'f', 2));
+    FillCellText(pRow, 11, QString("%1 %").arg(tStatValues.LoadSystem * tScaleFactor, 0, 'f', 2));
+    FillCellText(pRow, 12, QString("%1 %").arg(tStatValues.LoadTotal * tScaleFactor, 0, 'f', 2));
+    FillCellText(pRow, 13, QString("%1").arg(pRow));
+}
+
+QString OverviewThreadsWidget::GetMemoryPoolReport()
+{
+    QString tResult;
+
+    MemoryUsages tUsages = MEMORY_POOL.GetMemoryUsage();
+    MemoryUsages::iterator tIt;
+    for (tIt = tUsages.begin(); tIt != tUsages.end(); tIt++)
+    {
+        tResult += QString(tIt->Subsystem.c_str()) + ": " + QString("%1").arg(tIt->Buffers) + " buffers, " + Int2ByteExpression(tIt->Bytes) + " bytes (requested " + Int2ByteExpression(tIt->RequestedBytes) + " bytes, peak " + Int2ByteExpression(tIt->PeakBytes) + " bytes), " + QString("%1").arg(tIt->Allocations) + " allocations\n";
+    }
+    tResult += "Cached for reuse: " + Int2ByteExpression(MEMORY_POOL.GetCachedBytes()) + " bytes";
+
+    return tResult;
 }
 
 void OverviewThreadsWidget::UpdateView()
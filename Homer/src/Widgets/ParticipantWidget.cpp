@@ -85,6 +85,8 @@ namespace Homer { namespace Gui {
 #define AV_SYNC_CONSECUTIVE_ASYNC_THRESHOLD_TRY_RESET                4
 // size of the pre-buffer during a live conference
 #define AV_CONFERENCE_BUFFER									   0.2 // seconds
+// size of the video pre-buffer during a live conference, video follows the audio playout and needs no own jitter buffer
+#define AV_CONFERENCE_VIDEO_BUFFER								   0.05 // seconds
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -100,6 +102,7 @@ ParticipantWidget::ParticipantWidget(enum SessionType pSessionType, MainWindow *
     mLastAudioSynchronizationTimestamp = 0;
     mLastVideoSynchronizationTimestamp = 0;
     mAVSynchActive = false;
+    mAVSynchronizer = NULL;
     mAVPreBuffering = false;
     mAvPreBufferingAutoRestart = false;
     mCurrentMovieFile = "";
@@ -174,6 +177,8 @@ ParticipantWidget::~ParticipantWidget()
     delete mAudioWidget;
     delete mMessageWidget;
     delete mSessionInfoWidget;
+    if (mAVSynchronizer != NULL)
+        delete mAVSynchronizer;
     if (mAssignedActionAVControls != NULL)
         delete mAssignedActionAVControls;
 	if (mMosaicModeGenericTitleWidget != NULL)
@@ -297,8 +302,9 @@ void ParticipantWidget::Init(QMenu *pVideoMenu, QMenu *pAudioMenu, QMenu *pAVCon
 						mVideoSource = new MediaSourceNet(mVideoReceiveSocket, true);
 						mVideoSource->SetPreBufferingActivation(true);
 						mVideoSource->SetPreBufferingAutoRestartActivation(true);
-						mVideoSource->SetFrameBufferPreBufferingTime(AV_CONFERENCE_BUFFER);
+						mVideoSource->SetFrameBufferPreBufferingTime(AV_CONFERENCE_VIDEO_BUFFER);
 						mVideoSource->SetInputStreamPreferences(CONF.GetVideoCodec().toStdString());
+						mVideoSource->SetPeerName(mSessionName.toStdString());
 						mVideoWidgetFrame->hide();
 						mVideoWidget->Init(mMainWindow, this, mVideoSource, pVideoMenu, mSessionName);
 					}else
@@ -310,10 +316,19 @@ void ParticipantWidget::Init(QMenu *pVideoMenu, QMenu *pAudioMenu, QMenu *pAVCon
 						mAudioSource->SetPreBufferingAutoRestartActivation(true);
 						mAudioSource->SetFrameBufferPreBufferingTime(AV_CONFERENCE_BUFFER);
 						mAudioSource->SetInputStreamPreferences(CONF.GetAudioCodec().toStdString());
+						mAudioSource->SetPeerName(mSessionName.toStdString());
 						mAudioWidget->Init(mAudioSource, pAudioMenu, mSessionName);
 					}else
 						LOG(LOG_ERROR, "Determined audio socket is NULL");
 
+					// video playback is scheduled continuously against the audio playout
+					if ((mVideoReceiveSocket != NULL) && (mAudioReceiveSocket != NULL))
+					{
+					    mAVSynchronizer = new AVSynchronizer(mSessionName.toStdString());
+					    mVideoWidget->GetWorker()->SetAVSynchronizer(mAVSynchronizer);
+					    mAudioWidget->GetWorker()->SetAVSynchronizer(mAVSynchronizer);
+					}
+
 					// hide Homer logo
 					mLogoFrame->hide();
 
@@ -1392,6 +1407,10 @@ void ParticipantWidget::AVSync()
         if (!mAVSynchActive)
             return;
 
+        // the A/V synchronizer aligns live streams for every frame
+        if ((mAVSynchronizer != NULL) && (mAVSynchronizer->IsSynchronizing()))
+            return;
+
         int64_t tCurTime = Time::GetTimeStamp();
         if ((tCurTime - mTimeOfLastAVSynch  >= AV_SYNC_MIN_PERIOD * 1000))
         {
@@ -1491,6 +1510,10 @@ float ParticipantWidget::GetAVDrift(int64_t *pVideoSyncTime, int64_t *pAudioSync
 
     float tResult = 0;
 
+	// the drift measured by the A/V synchronizer refers to the real audio playout and is more precise
+	if ((mAVSynchronizer != NULL) && (mAVSynchronizer->IsSynchronizing()))
+	    return ((float)mAVSynchronizer->GetDrift()) / 1000000;
+
 	// do we have valid synchronization timestamps from video and audio source?
 	if ((tAudioSyncTime != 0) && (tVideoSyncTime != 0))
 	{// we are able to synch. audio and video
@@ -1819,6 +1842,12 @@ void ParticipantWidget::ToggleMosaicMode(bool pActive)
 	mVideoWidget->ToggleMosaicMode(pActive);
 }
 
+void ParticipantWidget::SetVideoSubscription(enum VideoSubscription pSubscription)
+{
+    if (mVideoWidget != NULL)
+        mVideoWidget->SetVideoSubscription(pSubscription);
+}
+
 void ParticipantWidget::ActionSeekMovieFile(int pPos)
 {
 	LOG(LOG_VERBOSE, "User moved playback slider to position %d", pPos);
@@ -30,6 +30,7 @@
 #include <MediaSourceMuxer.h>
 #include <MediaSourceFile.h>
 #include <MediaSourceDesktop.h>
+#include <DeviceRegistry.h>
 #include <Configuration.h>
 #include <Logger.h>
 #include <Snippets.h>
@@ -161,6 +162,9 @@ void StreamingControlWidget::StartScreenSegmentStreaming()
 
 void StreamingControlWidget::StartCameraStreaming()
 {
+    // a camera could have been plugged in without being detected
+    DEVICE_REGISTRY.Rescan(MEDIA_VIDEO);
+
     VideoDevices tList = mVideoWorker->GetPossibleDevices();
     VideoDevices::iterator tIt;
     QString tSelectedDevice = "";
@@ -192,6 +196,8 @@ void StreamingControlWidget::StartCameraStreaming()
 
 void StreamingControlWidget::StartVoiceStreaming()
 {
+    DEVICE_REGISTRY.Rescan(MEDIA_AUDIO);
+
     AudioDevices tList = mAudioWorker->GetPossibleDevices();
     AudioDevices::iterator tIt;
     QString tSelectedDevice = "";
@@ -86,6 +86,12 @@ using namespace Homer::Monitor;
 
 #define VIDEO_WIDGET_FS_MAX_MOUSE_IDLE_TIME       		3 // seconds
 
+// how long has the video widget to be invisible before the decoding of its stream is suspended? (avoids waiting for key frames when toggling the fullscreen mode)
+#define VIDEO_WIDGET_SUSPEND_DECODING_DELAY             2 // seconds
+
+// frame rate for participants with a thumbnail video subscription in mosaic mode
+#define VIDEO_WIDGET_THUMBNAIL_FPS                      5
+
 // how long should a OSD status message stay on the screen?
 #define VIDEO_WIDGET_OSD_PERIOD                   		3 // seconds
 
@@ -188,6 +194,9 @@ VideoWidget::VideoWidget(QWidget* pParent):
     mVideoSource = NULL;
     mVideoWorker = NULL;
     mMainWindow = NULL;
+    mHidden = true;
+    mTimeHidden = QTime::currentTime();
+    mVideoSubscription = VIDEO_SUBSCRIPTION_FULL;
     mAssignedAction = NULL;
     mSmoothPresentation = CONF.GetSmoothVideoPresentation();
     parentWidget()->hide();
@@ -738,6 +747,9 @@ QStringList VideoWidget::GetVideoStatistic()
         tLine_Frame += ")";
     }
     tLine_Frame += (mVideoSource->GetChunkDropCounter() ? (" (" + QString("%1").arg(mVideoSource->GetChunkDropCounter()) + " " + Homer::Gui::VideoWidget::tr("lost packets") + ")") : "") + (mVideoSource->GetFragmentBufferCounter() ? (" (" + QString("%1").arg(mVideoSource->GetFragmentBufferCounter()) + "/" + QString("%1").arg(mVideoSource->GetFragmentBufferSize()) + " " + Homer::Gui::VideoWidget::tr("buffered packets") + ")") : "");
+    int64_t tDroppedFrames = mVideoSource->DroppedFrames() + mVideoWorker->GetDroppedFrames();
+    if (tDroppedFrames > 0)
+        tLine_Frame += " (" + QString("%1").arg(tDroppedFrames) + " " + Homer::Gui::VideoWidget::tr("dropped frames") + ")";
 
     //############################################
     //### Line 3: FPS and pre-buffer time
@@ -752,6 +764,9 @@ QStringList VideoWidget::GetVideoStatistic()
     	else
     	    tLine_Fps += ")";
     }
+    int64_t tTimeToFirstFrame = mVideoSource->GetTimeToFirstFrame();
+    if (tTimeToFirstFrame > 0)
+        tLine_Fps += " (" + Homer::Gui::VideoWidget::tr("first frame after") + " " + QString("%1").arg(tTimeToFirstFrame) + " ms)";
 
     //############################################
     //### Line 4: video codec and resolution
@@ -861,7 +876,7 @@ QStringList VideoWidget::GetVideoStatistic()
     return tVideoStatistic;
 }
 
-void VideoWidget::ShowFrame(void* pBuffer)
+void VideoWidget::ShowFrame(void* pBuffer, struct VideoFrameFormat pFrameFormat)
 {
     int tMSecs = QTime::currentTime().msec();
 
@@ -871,25 +886,20 @@ void VideoWidget::ShowFrame(void* pBuffer)
     setUpdatesEnabled(false);
 
     //#############################################################
-    //### get frame from media source and mirror it if selected
+    //### get frame from media source
     //#############################################################
-    QImage tCurrentFrame = QImage((unsigned char*)pBuffer, mResX, mResY, QImage::Format_RGB32);
+    QImage tCurrentFrame = QImage((unsigned char*)pBuffer, pFrameFormat.ResX, pFrameFormat.ResY, QImage::Format_RGB32);
     if (tCurrentFrame.isNull())
     {
         setUpdatesEnabled(true);
     	return;
-    }else
-    	mCurrentFrame = tCurrentFrame;
-
-    if ((mVideoMirroredHorizontal) || (mVideoMirroredVertical))
-    	mCurrentFrame = mCurrentFrame.mirrored(mVideoMirroredHorizontal, mVideoMirroredVertical);
+    }
 
     //#############################################################
-    //### scale to the dimension of this video widget
+    //### calculate the dimension within this video widget
     //#############################################################
     // keep aspect ratio if requested
 	QTime tTime = QTime::currentTime();
-	Qt::AspectRatioMode tAspectMode = Qt::IgnoreAspectRatio;
 	float tSelectedAspectMode = SupportedAspectRatios[mAspectRatio].ratio;
 
 	if (tSelectedAspectMode == -1 /* window */)
@@ -898,12 +908,13 @@ void VideoWidget::ShowFrame(void* pBuffer)
         mCurrentFrameOutputHeight = height();
 	}else if (tSelectedAspectMode == 0 /* original */)
 	{
-        mCurrentFrameOutputWidth = width();
-        mCurrentFrameOutputHeight = height();
-        tAspectMode = Qt::KeepAspectRatio;
+        QSize tOutputSize(mResX, mResY);
+        tOutputSize.scale(width(), height(), Qt::KeepAspectRatio);
+        mCurrentFrameOutputWidth = tOutputSize.width();
+        mCurrentFrameOutputHeight = tOutputSize.height();
 	}else
 	{
-        mCurrentFrameOutputWidth = mCurrentFrame.width();
+        mCurrentFrameOutputWidth = mResX;
         mCurrentFrameOutputHeight = (int)mCurrentFrameOutputWidth / SupportedAspectRatios[mAspectRatio].ratio; // adapt aspect ratio
 	}
 
@@ -925,9 +936,30 @@ void VideoWidget::ShowFrame(void* pBuffer)
 		}
 	}
 
-	mCurrentFrame = mCurrentFrame.scaled(mCurrentFrameOutputWidth, mCurrentFrameOutputHeight, tAspectMode, mSmoothPresentation ? Qt::SmoothTransformation : Qt::FastTransformation);
-	mCurrentFrameOutputWidth = mCurrentFrame.width();
-	mCurrentFrameOutputHeight = mCurrentFrame.height();
+	if (mCurrentFrameOutputWidth < 1)
+	    mCurrentFrameOutputWidth = 1;
+	if (mCurrentFrameOutputHeight < 1)
+	    mCurrentFrameOutputHeight = 1;
+
+	// let the media source scale and mirror the next frames during decoding, the GUI thread has only to copy them afterwards
+	mVideoWorker->SetOutputFormat(mCurrentFrameOutputWidth, mCurrentFrameOutputHeight, mVideoMirroredHorizontal, mVideoMirroredVertical);
+
+    //#############################################################
+    //### mirror and scale the frame if the media source hasn't done this
+    //#############################################################
+	bool tNeedsMirroring = ((pFrameFormat.MirroredHorizontal != mVideoMirroredHorizontal) || (pFrameFormat.MirroredVertical != mVideoMirroredVertical));
+	bool tNeedsScaling = ((pFrameFormat.ResX != mCurrentFrameOutputWidth) || (pFrameFormat.ResY != mCurrentFrameOutputHeight));
+	if ((!tNeedsMirroring) && (!tNeedsScaling))
+	{// frame is already prepared, copy it because we draw the OSD on top of it and the worker reuses its frame buffers
+	    mCurrentFrame = tCurrentFrame.copy();
+	}else
+	{// media source doesn't support this or the output format has changed in the meantime
+	    mCurrentFrame = tCurrentFrame;
+	    if (tNeedsMirroring)
+	        mCurrentFrame = mCurrentFrame.mirrored(pFrameFormat.MirroredHorizontal != mVideoMirroredHorizontal, pFrameFormat.MirroredVertical != mVideoMirroredVertical);
+	    if (tNeedsScaling)
+	        mCurrentFrame = mCurrentFrame.scaled(mCurrentFrameOutputWidth, mCurrentFrameOutputHeight, Qt::IgnoreAspectRatio, mSmoothPresentation ? Qt::SmoothTransformation : Qt::FastTransformation);
+	}
 
     int tTimeDiff = QTime::currentTime().msecsTo(tTime);
     // did we spend too much time with transforming the image?
@@ -1312,6 +1344,23 @@ void VideoWidget::ToggleMosaicMode(bool pActive)
 	mMosaicMode = pActive;
 }
 
+void VideoWidget::SetVideoSubscription(enum VideoSubscription pSubscription)
+{
+    if (mVideoSubscription == pSubscription)
+        return;
+
+    LOG(LOG_VERBOSE, "Changing video subscription of %s from \"%s\" to \"%s\"", mVideoTitle.toStdString().c_str(), ActiveSpeakerDetector::VideoSubscriptionToString(mVideoSubscription).c_str(), ActiveSpeakerDetector::VideoSubscriptionToString(pSubscription).c_str());
+    mVideoSubscription = pSubscription;
+
+    // thumbnails are presented with a reduced frame rate, the picture of a paused video freezes
+    bool tThumbnail = (pSubscription == VIDEO_SUBSCRIPTION_THUMBNAIL);
+    // the decoder of a received stream drops the thumbnail frames before they are scaled, otherwise they are dropped before presentation
+    bool tDecoderThumbnail = ((mVideoSource != NULL) && (mVideoSource->SetDecoderThumbnailMode(tThumbnail)));
+    if (mVideoWorker != NULL)
+        mVideoWorker->SetFrameRateLimit(((tThumbnail) && (!tDecoderThumbnail)) ? VIDEO_WIDGET_THUMBNAIL_FPS : 0);
+    UpdateDecoderSuspension();
+}
+
 void VideoWidget::ToggleVisibility()
 {
     if (isVisible())
@@ -1766,6 +1815,41 @@ void VideoWidget::focusOutEvent(QFocusEvent *pEvent)
 	QWidget::focusOutEvent(pEvent);
 }
 
+void VideoWidget::showEvent(QShowEvent *pEvent)
+{
+    // the decoder continues with the next key frame
+    mHidden = false;
+    UpdateDecoderSuspension();
+    QWidget::showEvent(pEvent);
+}
+
+void VideoWidget::hideEvent(QHideEvent *pEvent)
+{
+    // also received if the main window is minimized or the parent dock widget is hidden, decoding is suspended in timerEvent()
+    mHidden = true;
+    mTimeHidden = QTime::currentTime();
+    QWidget::hideEvent(pEvent);
+}
+
+void VideoWidget::UpdateDecoderSuspension()
+{
+    if (mVideoSource == NULL)
+        return;
+
+    bool tSuspend = (mVideoSubscription == VIDEO_SUBSCRIPTION_PAUSED);
+    #ifdef VIDEO_WIDGET_SKIP_DECODING_WHEN_INVISIBLE
+        // suspend the decoding only if the widget stays invisible, it is hidden for a short time when toggling the fullscreen mode
+        if ((mHidden) && (mTimeHidden.msecsTo(QTime::currentTime()) > VIDEO_WIDGET_SUSPEND_DECODING_DELAY * 1000))
+            tSuspend = true;
+    #endif
+
+    if (mVideoSource->IsDecoderSuspended() != tSuspend)
+    {
+        if (mVideoSource->SetDecoderSuspended(tSuspend))
+            LOG(LOG_VERBOSE, "%s decoding of the stream of video widget %s", tSuspend ? "Suspended" : "Resumed", mVideoTitle.toStdString().c_str());
+    }
+}
+
 void VideoWidget::timerEvent(QTimerEvent *pEvent)
 {
     #ifdef DEBUG_VIDEOWIDGET_PERFORMANCE
@@ -1787,6 +1871,8 @@ void VideoWidget::timerEvent(QTimerEvent *pEvent)
         return;
     }
 
+    UpdateDecoderSuspension();
+
     if (IsFullScreen())
     {
         int tTimeSinceLastMouseMove = mTimeOfLastMouseMove.msecsTo(QTime::currentTime());
@@ -1818,6 +1904,7 @@ void VideoWidget::timerEvent(QTimerEvent *pEvent)
 void VideoWidget::customEvent(QEvent *pEvent)
 {
     void* tFrame;
+    struct VideoFrameFormat tFrameFormat;
 
     // make sure we have a user event here
     if (pEvent->type() != QEvent::User)
@@ -1853,7 +1940,7 @@ void VideoWidget::customEvent(QEvent *pEvent)
 							LOG(LOG_VERBOSE, "Called GetCurrentFrame() %d times", tLoopCount);
 					#endif
 					mPendingNewFrameSignals--;
-					mCurrentFrameNumber = mVideoWorker->GetCurrentFrame(&tFrame, &mCurrentFrameRate);
+					mCurrentFrameNumber = mVideoWorker->GetCurrentFrame(&tFrame, &mCurrentFrameRate, &tFrameFormat);
 
 					// video delay
 					int tWorkerLastFrame = mVideoWorker->GetLastFrameNumber();
@@ -1899,7 +1986,7 @@ void VideoWidget::customEvent(QEvent *pEvent)
 						}
 
 						// display the current video frame
-						ShowFrame(tFrame);
+						ShowFrame(tFrame, tFrameFormat);
 						#ifdef VIDEO_WIDGET_DEBUG_FRAMES
 							LOG(LOG_WARN, "Showing frame: %d, pending signals about new frames %d", mCurrentFrameNumber, mPendingNewFrameSignals);
 						#endif
@@ -1976,9 +2063,15 @@ void VideoWidget::FullscreenMarkUserIdle()
 }
 
 VideoWorkerThread::VideoWorkerThread(QString pName, MediaSource *pVideoSource, VideoWidget *pVideoWidget):
-    MediaSourceGrabberThread(pName, pVideoSource)
+    MediaSourceGrabberThread(pName, pVideoSource), mFrameDropPolicy("Video widget " + pName.toStdString())
 {
     mSetGrabResolutionAsap = false;
+    mSetOutputFormatAsap = false;
+    mOutputFormatSupported = false;
+    mOutputResX = 0;
+    mOutputResY = 0;
+    mOutputMirrorHorizontal = false;
+    mOutputMirrorVertical = false;
     mWaitForFirstFrameAfterSeeking = false;
     mMissingFrames = 0;
     mResX = 352;
@@ -1989,6 +2082,8 @@ VideoWorkerThread::VideoWorkerThread(QString pName, MediaSource *pVideoSource, V
     mFrameCurrentIndex = FRAME_BUFFER_SIZE - 1;
     mFrameGrabIndex = 0;
     mDropFrames = false;
+    mFrameRateLimit = 0;
+    mLastFrameDeliveryTime = 0;
     InitFrameBuffers();
 }
 
@@ -2005,6 +2100,10 @@ void VideoWorkerThread::InitFrameBuffers()
         mFrame[i] = mMediaSource->AllocChunkBuffer(mFrameSize[i], MEDIA_VIDEO);
 
         mFrameNumber[i] = 0;
+        mFrameFormat[i].ResX = mResX;
+        mFrameFormat[i].ResY = mResY;
+        mFrameFormat[i].MirroredHorizontal = false;
+        mFrameFormat[i].MirroredVertical = false;
 
         //LOG(LOG_VERBOSE, "Initiating frame buffer %d with resolution %d*%d", i, mResX, mResY);
         QImage tFrameImage = QImage((unsigned char*)mFrame[i], mResX, mResY, QImage::Format_RGB32);
@@ -2033,6 +2132,11 @@ void VideoWorkerThread::SetFrameDropping(bool pDrop)
     mDropFrames = pDrop;
 }
 
+void VideoWorkerThread::SetFrameRateLimit(int pFps)
+{
+    mFrameRateLimit = pFps;
+}
+
 void VideoWorkerThread::SetGrabResolution(int pX, int pY)
 {
     if ((mResX != pX) || (mResY != pY))
@@ -2046,6 +2150,21 @@ void VideoWorkerThread::SetGrabResolution(int pX, int pY)
     }
 }
 
+void VideoWorkerThread::SetOutputFormat(int pX, int pY, bool pMirrorHorizontal, bool pMirrorVertical)
+{
+    if ((mOutputResX != pX) || (mOutputResY != pY) || (mOutputMirrorHorizontal != pMirrorHorizontal) || (mOutputMirrorVertical != pMirrorVertical))
+    {
+        #ifdef VIDEO_WIDGET_DEBUG_FRAMES
+            LOG(LOG_VERBOSE, "Setting output format to %d*%d, mirroring: %d/%d", pX, pY, pMirrorHorizontal, pMirrorVertical);
+        #endif
+        mOutputResX = pX;
+        mOutputResY = pY;
+        mOutputMirrorHorizontal = pMirrorHorizontal;
+        mOutputMirrorVertical = pMirrorVertical;
+        mSetOutputFormatAsap = true;
+    }
+}
+
 VideoDevices VideoWorkerThread::GetPossibleDevices()
 {
     VideoDevices tResult;
@@ -2120,6 +2239,14 @@ void VideoWorkerThread::DoSetGrabResolution()
     mDeliverMutex.unlock();
 }
 
+void VideoWorkerThread::DoSetOutputFormat()
+{
+    mSetOutputFormatAsap = false;
+
+    // sources without support deliver frames in grab resolution and the video widget transforms them
+    mOutputFormatSupported = mMediaSource->SetVideoOutputFormat(mOutputResX, mOutputResY, mOutputMirrorHorizontal, mOutputMirrorVertical);
+}
+
 void VideoWorkerThread::DoSeek()
 {
     MediaSourceGrabberThread::DoSeek();
@@ -2250,7 +2377,7 @@ void VideoWorkerThread::HandlePlayFileSuccess()
     mVideoWidget->SetVisible(true);
 }
 
-int VideoWorkerThread::GetCurrentFrame(void **pFrame, float *pFrameRate)
+int VideoWorkerThread::GetCurrentFrame(void **pFrame, float *pFrameRate, struct VideoFrameFormat *pFrameFormat)
 {
     int tResult = -1;
 
@@ -2296,6 +2423,8 @@ int VideoWorkerThread::GetCurrentFrame(void **pFrame, float *pFrameRate)
         CalculateFrameRate(pFrameRate);
 
         *pFrame = mFrame[mFrameCurrentIndex];
+        if (pFrameFormat != NULL)
+            *pFrameFormat = mFrameFormat[mFrameCurrentIndex];
         tResult = mFrameNumber[mFrameCurrentIndex];
     }else
         LOG(LOG_WARN, "Can't deliver new frame, pending frames: %d, grab resolution invalid: %d, have to reset source: %d", mPendingNewFrames, mSetGrabResolutionAsap, mResetMediaSourceAsap);
@@ -2315,6 +2444,11 @@ int VideoWorkerThread::GetLastFrameNumber()
     return mLastFrameNumber;
 }
 
+int64_t VideoWorkerThread::GetDroppedFrames()
+{
+    return mFrameDropPolicy.GetDroppedFrames();
+}
+
 VideoWidget *VideoWorkerThread::GetVideoWidget()
 {
 	return mVideoWidget;
@@ -2391,6 +2525,10 @@ void VideoWorkerThread::run()
         if (mSetGrabResolutionAsap)
             DoSetGrabResolution();
 
+        // change the output format
+        if (mSetOutputFormatAsap)
+            DoSetOutputFormat();
+
         // start video recording
         if (mStartRecorderAsap)
             DoStartRecorder();
@@ -2457,22 +2595,82 @@ void VideoWorkerThread::run()
 			    mFrameWidthLastGrabbedFrame = tSourceResX;
 			    mFrameHeightLastGrabbedFrame = tSourceResY;
 
+			    // the media source might have scaled and mirrored the frame already for the video widget
+			    struct VideoFrameFormat tFrameFormat;
+			    if (mOutputFormatSupported)
+			    {
+			        tFrameFormat = mMediaSource->GetVideoFrameFormat();
+			        if (tFrameFormat.ResX * tFrameFormat.ResY * 4 > tFrameSize)
+			        {
+			            LOG(LOG_WARN, "Frame %d with %d bytes is too small for format %d*%d, dropping it", tFrameNumber, tFrameSize, tFrameFormat.ResX, tFrameFormat.ResY);
+			            continue;
+			        }
+			    }else
+			    {
+			        tFrameFormat.ResX = mResX;
+			        tFrameFormat.ResY = mResY;
+			        tFrameFormat.MirroredHorizontal = false;
+			        tFrameFormat.MirroredVertical = false;
+			    }
+
+			    // schedule the frame against the audio playout
+			    if (mAVSynchronizer != NULL)
+			    {
+			        int64_t tWaitTime, tClockCorrection;
+			        enum AVSyncAction tAction = mAVSynchronizer->ScheduleVideoFrame(mMediaSource->GetSynchronizationTimestamp(), mMediaSource->GetFrameRate(), tWaitTime, tClockCorrection);
+			        if (tClockCorrection != 0)
+			            mMediaSource->TimeShift(tClockCorrection);
+			        if (tAction == AV_SYNC_WAIT)
+			            usleep(tWaitTime);
+			        if (tAction == AV_SYNC_DROP)
+			        {
+			            #ifdef VIDEO_WIDGET_DEBUG_FRAMES
+			                LOG(LOG_VERBOSE, "Dropping late frame %d for A/V synchronization", tFrameNumber);
+			            #endif
+			            continue;
+			        }
+			    }
+
+			    // reduced frame rate, e.g., for thumbnails in mosaic mode
+			    int tFrameRateLimit = mFrameRateLimit;
+			    if (tFrameRateLimit > 0)
+			    {
+			        int64_t tCurrentTime = Time::GetTimeStamp();
+			        if (tCurrentTime - mLastFrameDeliveryTime < 1000 * 1000 / tFrameRateLimit)
+			        {
+                        #ifdef VIDEO_WIDGET_DEBUG_FRAMES
+                            LOG(LOG_VERBOSE, "Dropping frame %d because of the frame rate limit of %d fps", tFrameNumber, tFrameRateLimit);
+                        #endif
+			            continue;
+			        }
+			        mLastFrameDeliveryTime = tCurrentTime;
+			    }
+
+			    // overload: drop single frames evenly distributed instead of running full and skipping the entire buffer
+			    mFrameDropPolicy.Update(mPendingNewFrames, FRAME_BUFFER_SIZE);
+			    if (mFrameDropPolicy.DropDecodedFrame())
+			    {
+                    #ifdef VIDEO_WIDGET_DEBUG_FRAMES
+                        LOG(LOG_VERBOSE, "Dropping frame %d because the widget can't keep up", tFrameNumber);
+                    #endif
+			        continue;
+			    }
+
 				// lock
 				mDeliverMutex.lock();
 
 				mFrameNumber[mFrameGrabIndex] = tFrameNumber;
+				mFrameFormat[mFrameGrabIndex] = tFrameFormat;
                 if (mPendingNewFrames < FRAME_BUFFER_SIZE)
                 {
                     mPendingNewFrames++;
                     mVideoWidget->InformAboutNewFrame();
                 }else
                 {
-                    LOG(LOG_WARN, "System too slow?, frame buffer of %d entries is full, will drop all frames, grab index: %d, current read index: %d", FRAME_BUFFER_SIZE, mFrameGrabIndex, mFrameCurrentIndex);
-                    mPendingNewFrames = 1;
-                    mFrameCurrentIndex = mFrameGrabIndex -1;
-                    if (mFrameCurrentIndex < 0)
-                    	mFrameCurrentIndex = FRAME_BUFFER_SIZE - 1;
-
+                    LOG(LOG_WARN, "System too slow?, frame buffer of %d entries is full, will drop the oldest frame, grab index: %d, current read index: %d", FRAME_BUFFER_SIZE, mFrameGrabIndex, mFrameCurrentIndex);
+                    // the new frame has replaced the oldest pending one, continue with the next oldest
+                    mFrameCurrentIndex = mFrameGrabIndex;
+                    mFrameDropPolicy.ReportDroppedFrame();
                 }
 				mFrameGrabIndex++;
 				if (mFrameGrabIndex >= FRAME_BUFFER_SIZE)
@@ -29,8 +29,10 @@
 #include <HomerApplication.h>
 #include <Logger.h>
 #include <Configuration.h>
+#include <FileTransferWindow.h>
 
 #include <string>
+#include <string.h>
 #include <stdio.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -233,10 +235,14 @@ int WINAPI WinMain(HINSTANCE pInstance,	HINSTANCE pPrevInstance, LPSTR pCmdLine,
         printf("   -Disable=IPv6                       disable IPv6 support\n");
         printf("   -Disable=QoS                        disable QoS support\n");
         printf("   -Enable=NetSim                      enables network simulator\n");
+        printf("   -NetworkEmulator=<settings>         emulate network conditions for NAPI based transports, settings: delay=<ms>,jitter=<ms>,loss=<%%>,reorder=<%%>,rate=<KB/s>,ber=<bit error rate>,seed=<number>\n");
         printf("   -ListVideoCodecs                    list all supported video codecs of the used libavcodec\n");
         printf("   -ListAudioCodecs                    list all supported audio codecs of the used libavcodec\n");
         printf("   -ListInputFormats                   list all supported input formats of the used libavformat\n");
         printf("   -ListOutputFormats                  list all supported output formats of the used libavformat\n");
+        printf("\n");
+        printf("Options for diagnostics:\n");
+        printf("   -BenchmarkFileTransfer=<rtt>:<loss> compare windowed and stop-and-wait file transfers over a simulated loopback path with the given RTT in ms and loss in percent, and exit\n");
         printf("\n");
 	    exit(0);
 	}
@@ -247,6 +253,20 @@ int WINAPI WinMain(HINSTANCE pInstance,	HINSTANCE pPrevInstance, LPSTR pCmdLine,
         exit(0);
 	}
 
+	if (tFirstArg.find("-BenchmarkFileTransfer=") == 0)
+	{
+	    int tRtt = 100;
+	    float tLoss = 0;
+	    sscanf(tFirstArg.c_str() + strlen("-BenchmarkFileTransfer="), "%d:%f", &tRtt, &tLoss);
+	    int64_t tRetransmissionsWindowed = 0, tRetransmissionsStopAndWait = 0;
+	    double tWindowed = FileTransferWindow::RunLoopbackBenchmark(tRtt, tLoss, 64 * 1024 * 1024, FTW_MAX_WINDOW, &tRetransmissionsWindowed);
+	    double tStopAndWait = FileTransferWindow::RunLoopbackBenchmark(tRtt, tLoss, 4 * 1024 * 1024, 1, &tRetransmissionsStopAndWait);
+        printf("Simulated file transfer with RTT %d ms and loss %.2f %%:\n", tRtt, tLoss);
+        printf("   windowed:      %8.3f MB/s (%ld retransmissions)\n", tWindowed, (long)tRetransmissionsWindowed);
+        printf("   stop-and-wait: %8.3f MB/s (%ld retransmissions)\n", tStopAndWait, (long)tRetransmissionsStopAndWait);
+        exit(0);
+	}
+
     #ifdef RELEASE_VERSION
 	    printf("Homer-Conferencing, Version "RELEASE_VERSION_STRING"\n");
 	    printf("Copyright (C) 2008 Thomas Volkert <thomas@homer-conferencing.com>\n");
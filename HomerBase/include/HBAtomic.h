@@ -0,0 +1,140 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: wrapper for os independent atomic operations
+ * Author:  Thomas Volkert
+ * Since:   2012-12-18
+ */
+
+#ifndef _BASE_ATOMIC_
+#define _BASE_ATOMIC_
+
+#include <stdint.h>
+
+#include <Header_Windows.h>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// all operations act as full memory barrier
+class Atomic
+{
+public:
+    /* returns the new value */
+    static inline int Add(volatile int *pValue, int pDelta);
+    /* returns true if the value was equal to pExpected and got replaced by pNew */
+    static inline bool CompareAndSwap(volatile int *pValue, int pExpected, int pNew);
+    static inline bool CompareAndSwap(volatile unsigned int *pValue, unsigned int pExpected, unsigned int pNew);
+    static inline bool CompareAndSwap(volatile int64_t *pValue, int64_t pExpected, int64_t pNew);
+    /* returns the old value */
+    static inline int Exchange(volatile int *pValue, int pNew);
+    static inline int64_t Exchange(volatile int64_t *pValue, int64_t pNew);
+    static inline void Barrier();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(WIN32) || defined(WIN64)
+
+int Atomic::Add(volatile int *pValue, int pDelta)
+{
+    return (int)InterlockedExchangeAdd((volatile LONG*)pValue, (LONG)pDelta) + pDelta;
+}
+
+bool Atomic::CompareAndSwap(volatile int *pValue, int pExpected, int pNew)
+{
+    return (InterlockedCompareExchange((volatile LONG*)pValue, (LONG)pNew, (LONG)pExpected) == (LONG)pExpected);
+}
+
+bool Atomic::CompareAndSwap(volatile unsigned int *pValue, unsigned int pExpected, unsigned int pNew)
+{
+    return (InterlockedCompareExchange((volatile LONG*)pValue, (LONG)pNew, (LONG)pExpected) == (LONG)pExpected);
+}
+
+bool Atomic::CompareAndSwap(volatile int64_t *pValue, int64_t pExpected, int64_t pNew)
+{
+    return (InterlockedCompareExchange64((volatile LONGLONG*)pValue, (LONGLONG)pNew, (LONGLONG)pExpected) == (LONGLONG)pExpected);
+}
+
+int Atomic::Exchange(volatile int *pValue, int pNew)
+{
+    return (int)InterlockedExchange((volatile LONG*)pValue, (LONG)pNew);
+}
+
+int64_t Atomic::Exchange(volatile int64_t *pValue, int64_t pNew)
+{
+    return (int64_t)InterlockedExchange64((volatile LONGLONG*)pValue, (LONGLONG)pNew);
+}
+
+void Atomic::Barrier()
+{
+    MemoryBarrier();
+}
+
+#else
+
+int Atomic::Add(volatile int *pValue, int pDelta)
+{
+    return __sync_add_and_fetch(pValue, pDelta);
+}
+
+bool Atomic::CompareAndSwap(volatile int *pValue, int pExpected, int pNew)
+{
+    return __sync_bool_compare_and_swap(pValue, pExpected, pNew);
+}
+
+bool Atomic::CompareAndSwap(volatile unsigned int *pValue, unsigned int pExpected, unsigned int pNew)
+{
+    return __sync_bool_compare_and_swap(pValue, pExpected, pNew);
+}
+
+bool Atomic::CompareAndSwap(volatile int64_t *pValue, int64_t pExpected, int64_t pNew)
+{
+    return __sync_bool_compare_and_swap(pValue, pExpected, pNew);
+}
+
+int Atomic::Exchange(volatile int *pValue, int pNew)
+{
+    // __sync_lock_test_and_set is only an acquire barrier
+    __sync_synchronize();
+    return __sync_lock_test_and_set(pValue, pNew);
+}
+
+int64_t Atomic::Exchange(volatile int64_t *pValue, int64_t pNew)
+{
+    __sync_synchronize();
+    return __sync_lock_test_and_set(pValue, pNew);
+}
+
+void Atomic::Barrier()
+{
+    __sync_synchronize();
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
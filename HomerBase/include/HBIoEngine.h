@@ -0,0 +1,124 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: asynchronous socket I/O of many datagram sockets with few threads
+ * Author:  Thomas Volkert
+ * Since:   2012-12-08
+ */
+
+#ifndef _BASE_IO_ENGINE_
+#define _BASE_IO_ENGINE_
+
+#include <HBSocket.h>
+#include <HBMutex.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// completion threads, each one owns a separate kernel ring, sockets are assigned to them by their handle
+#define IO_ENGINE_DEFAULT_THREADS               1
+#define IO_ENGINE_MAX_THREADS                   8
+
+// submission queue entries per ring
+#define IO_ENGINE_RING_ENTRIES                  256
+
+// buffers of each ring, registered once at the kernel, they limit the packets in flight
+#define IO_ENGINE_BUFFERS                       256
+#define IO_ENGINE_BUFFER_SIZE                   (8 * 1024) // same as MEDIA_SOURCE_MEM_FRAGMENT_BUFFER_SIZE, larger packets are sent synchronously
+
+// packets of this size are sent directly out of the registered buffers, smaller ones are cheaper to copy
+#define IO_ENGINE_ZERO_COPY_MIN_SIZE            1024
+
+// deferred submissions are flushed when this number of packets is reached or at least with the given period
+#define IO_ENGINE_SUBMIT_BATCH                  32
+#define IO_ENGINE_FLUSH_PERIOD                  5 // ms
+
+#define IO_ENGINE                               IoEngine::GetInstance()
+
+//#define IO_ENGINE_DEBUG_PACKETS
+
+///////////////////////////////////////////////////////////////////////////////
+
+// interface for users of asynchronous reception, called by the completion threads
+class IoReceiver
+{
+public:
+    IoReceiver() { }
+    virtual ~IoReceiver() { }
+
+    /* a size of -1 signals a receive error, returning false stops the reception */
+    virtual bool OnReceive(std::string pSourceHost, unsigned int pSourcePort, char *pData, int pSize) = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class IoEngineWorker;
+
+class IoEngine
+{
+public:
+    IoEngine();
+
+    virtual ~IoEngine();
+
+    static IoEngine& GetInstance();
+
+    /* configuration, has to be done before the first usage, 0 threads deactivate the engine */
+    void SetThreadCount(int pCount);
+    int GetThreadCount();
+    bool IsAvailable(); // false if the OS doesn't support asynchronous I/O or the engine was deactivated
+    bool IsSupported(Socket *pSocket); // only datagram sockets are handled, all others are served synchronously
+
+    /* sending: the data is copied, the submission is deferred as long as the caller signals further packets */
+    bool Send(Socket *pSocket, std::string pTargetHost, unsigned int pTargetPort, void *pBuffer, ssize_t pBufferSize, bool pMorePackets = false); // returns false if the socket failed before
+    void Flush(Socket *pSocket);
+    void Drain(Socket *pSocket); // waits until all packets of the socket have left, has to be called before the socket is destroyed
+
+    /* reception: the receiver is called from a completion thread, unregistering must not be done within the callback */
+    bool RegisterReceiver(Socket *pSocket, IoReceiver *pReceiver);
+    void UnregisterReceiver(Socket *pSocket);
+
+    /* statistic */
+    int64_t GetSubmittedPackets();
+    int64_t GetSubmissionCalls();
+
+private:
+    bool Start();
+    IoEngineWorker* GetWorker(Socket *pSocket);
+
+    Mutex               mMutex;
+    bool                mStarted;
+    bool                mAvailable;
+    int                 mThreadCount;
+    std::vector<IoEngineWorker*> mWorkers;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: size class based pool for large media buffers with per subsystem memory accounting
+ * Author:  Thomas Volkert
+ * Since:   2012-12-05
+ */
+
+#ifndef _BASE_MEMORY_POOL_
+#define _BASE_MEMORY_POOL_
+
+#include <HBMutex.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// size classes are powers of two from 1 KB up to 64 MB, larger buffers bypass the pool
+#define MEMORY_POOL_MIN_CLASS                   10
+#define MEMORY_POOL_MAX_CLASS                   26
+
+// upper limit for memory which is kept in the free lists for reuse
+#define MEMORY_POOL_CACHE_LIMIT                 (64 * 1024 * 1024)
+
+#define MEMORY_POOL                             MemoryPool::GetInstance()
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct MemoryUsage
+{
+    std::string     Subsystem;
+    int64_t         Buffers; // currently allocated buffers
+    int64_t         Bytes; // currently allocated bytes including the size class rounding
+    int64_t         RequestedBytes; // currently requested bytes
+    int64_t         PeakBytes;
+    int64_t         Allocations; // allocations and reallocations so far
+};
+
+typedef std::vector<MemoryUsage> MemoryUsages;
+
+///////////////////////////////////////////////////////////////////////////////
+
+class MemoryPool
+{
+public:
+    MemoryPool();
+
+    virtual ~MemoryPool();
+
+    static MemoryPool& GetInstance();
+
+    /* allocation: every buffer is accounted for the given subsystem */
+    void* Alloc(std::string pSubsystem, unsigned int pSize);
+    void* Grow(void *pBuffer, unsigned int pSize); // keeps the buffer content like realloc(), returns the given buffer if it is already large enough
+    void Free(void *pBuffer);
+    static unsigned int GetCapacity(void *pBuffer);
+
+    /* accounting */
+    MemoryUsages GetMemoryUsage();
+    int64_t GetCachedBytes();
+    void Trim(); // releases all cached buffers to the OS
+
+private:
+    struct BufferHeader;
+
+    int GetSizeClass(unsigned int pSize);
+    int GetSubsystemIndex(std::string pSubsystem);
+    void Account(int pSubsystem, int64_t pBytes, int64_t pRequestedBytes, int pBuffers);
+
+    Mutex               mMutex;
+    std::vector<void*>  mFreeLists[MEMORY_POOL_MAX_CLASS + 1];
+    int64_t             mCachedBytes;
+    MemoryUsages        mUsage;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
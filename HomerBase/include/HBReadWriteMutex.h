@@ -0,0 +1,74 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: wrapper for os independent reader/writer lock handling
+ * Author:  Thomas Volkert
+ * Since:   2012-12-03
+ */
+
+#ifndef _BASE_READ_WRITE_MUTEX_
+#define _BASE_READ_WRITE_MUTEX_
+
+#if defined(LINUX) || defined(APPLE) || defined(BSD)
+#include <pthread.h>
+#define OS_DEP_RW_MUTEX pthread_rwlock_t
+#endif
+
+#include <Header_Windows.h>
+#include <HBMutex.h>
+
+// Windows XP lacks slim reader/writer locks, fall back to an exclusive mutex
+#if defined(WIN32) || defined(WIN64)
+#define OS_DEP_RW_MUTEX Mutex
+#endif
+
+#include <string>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ReadWriteMutex
+{
+public:
+    ReadWriteMutex( );
+
+    virtual ~ReadWriteMutex( );
+
+    /* every function returns TRUE if successful */
+    bool lockRead(); // shared access, several readers are allowed in parallel
+    bool lockWrite(); // exclusive access
+    bool unlock();
+
+    /* for debbuging */
+    void AssignName(std::string pName);
+
+private:
+    OS_DEP_RW_MUTEX mMutex;
+    std::string     mName;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: work-stealing task scheduler with one queue per CPU core
+ * Author:  Thomas Volkert
+ * Since:   2012-12-10
+ */
+
+#ifndef _BASE_TASK_SCHEDULER_
+#define _BASE_TASK_SCHEDULER_
+
+#include <HBCondition.h>
+#include <HBMutex.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// number of worker threads, the scheduler uses one per CPU core within these limits
+#define TASK_SCHEDULER_MIN_THREADS              2
+#define TASK_SCHEDULER_MAX_THREADS              16
+
+// weight of a new measurement for the average scheduling latency
+#define TASK_SCHEDULER_LATENCY_WEIGHT           0.05
+
+#define TASK_SCHEDULER                          TaskScheduler::GetInstance()
+
+//#define TS_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+// a lower value is served first, queued audio work is always done before any video work
+enum TaskPriority
+{
+    TASK_PRIORITY_AUDIO = 0,
+    TASK_PRIORITY_VIDEO,
+    TASK_PRIORITY_STATISTIC
+};
+#define TASK_PRIORITIES                         3
+
+///////////////////////////////////////////////////////////////////////////////
+
+// a pipeline stage which is executed by the scheduler each time it was triggered, e.g., by its input FIFO
+class Task
+{
+public:
+    Task(enum TaskPriority pPriority = TASK_PRIORITY_VIDEO, std::string pName = "");
+
+    virtual ~Task();
+
+    /* processes a limited amount of the waiting work without blocking, returns true if further work is waiting */
+    virtual bool Execute() = 0;
+
+    enum TaskPriority GetTaskPriority();
+    std::string GetTaskName();
+
+private:
+    friend class TaskScheduler;
+
+    enum TaskPriority   mTaskPriority;
+    std::string         mTaskName;
+    volatile int        mTaskState;
+    volatile bool       mTaskDetaching;
+    int64_t             mTaskQueueTime;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class TaskWorker;
+
+class TaskScheduler
+{
+public:
+    TaskScheduler();
+
+    virtual ~TaskScheduler();
+
+    static TaskScheduler& GetInstance();
+
+    /* tasks: a task is executed by only one worker at the same time, triggers during its execution cause another run */
+    void Attach(Task *pTask);
+    void Detach(Task *pTask); // waits until no worker executes the task anymore, has to be called before the task is destroyed
+    void Trigger(Task *pTask); // new work is waiting, can be called from any thread
+
+    /* statistic */
+    int GetThreadCount();
+    int GetTaskCount();
+    int GetQueuedTasks(enum TaskPriority pPriority);
+    int GetAverageLatency(enum TaskPriority pPriority); // in us, time between the trigger of a task and its execution
+    int64_t GetExecutedTasks();
+    int64_t GetStolenTasks();
+
+private:
+    friend class TaskWorker;
+
+    void Start();
+    void Stop();
+    void Enqueue(Task *pTask, int pWorker);
+    int GetCurrentWorker();
+    /* worker side */
+    Task* FetchTask(int pWorker);
+    void WaitForTask();
+    void ExecuteTask(Task *pTask, int pWorker);
+
+    Mutex               mMutex;
+    bool                mStarted;
+    volatile bool       mSchedulerNeeded;
+    std::vector<TaskWorker*> mWorkers;
+    volatile int        mTaskCount;
+    volatile int        mNextWorker;
+    volatile int        mQueuedTasks[TASK_PRIORITIES];
+    /* idle workers */
+    Mutex               mIdleMutex;
+    Condition           mIdleCondition;
+    volatile int        mIdleWorkers;
+    /* detaching tasks */
+    Mutex               mDetachMutex;
+    Condition           mDetachCondition;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -40,14 +40,46 @@ typedef void*(*THREAD_MAIN)(void*);
 #define OS_DEP_THREAD HANDLE
 #endif
 
+#include <string>
 #include <vector>
 
 #define THREAD_DEFAULT_STACK_SIZE			(2 * 1024 * 1024)
 
+// the last CPU core is reserved for audio threads if the machine has at least this number of cores
+#define THREAD_AUDIO_CORE_MIN_CORES         4
+
 namespace Homer { namespace Base {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// role of a thread, it determines the scheduling class and the CPU cores of the thread
+enum ThreadRole
+{
+    THREAD_ROLE_DEFAULT = 0,
+    THREAD_ROLE_AUDIO_IO,
+    THREAD_ROLE_VIDEO_CODEC,
+    THREAD_ROLE_NETWORK,
+    THREAD_ROLE_HOUSEKEEPING
+};
+#define THREAD_ROLES                        5
+
+enum ThreadCores
+{
+    THREAD_CORES_ALL = 0,
+    THREAD_CORES_AUDIO, // the reserved audio core
+    THREAD_CORES_SHARED // all cores except the reserved audio core
+};
+
+struct ThreadPolicy
+{
+    int                 RealTimePriority; // 1-99 for SCHED_FIFO/SCHED_RR, 0 selects the default scheduler
+    bool                RoundRobin; // SCHED_RR instead of SCHED_FIFO
+    int                 Nice; // used for the default scheduler and as fallback if real-time scheduling isn't permitted
+    enum ThreadCores    Cores;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 class Thread
 {
 public:
@@ -65,6 +97,14 @@ public:
     static int GetPId();
     static int GetPPId();
     static std::vector<int> GetTIds();
+    /* scheduling of the calling thread */
+    static bool SetScheduling(int pRealTimePriority, bool pRoundRobin, int pNice, std::string &pDescription);
+    static bool SetAffinity(enum ThreadCores pCores, std::string &pDescription);
+    static bool ApplyRole(enum ThreadRole pRole, std::string &pDescription); // pDescription returns the applied policy
+    /* role policy table */
+    static std::string GetRoleName(enum ThreadRole pRole);
+    static ThreadPolicy GetRolePolicy(enum ThreadRole pRole);
+    static void SetRolePolicy(enum ThreadRole pRole, ThreadPolicy pPolicy);
     static bool GetThreadStatistic(int pTid, unsigned long &pMemVirtual, unsigned long &pMemPhysical, int &pPid, int &pPPid, float &pLoadUser, float &pLoadSystem, float &pLoadTotal, int &pPriority, int &pNice, int &pThreadCount, unsigned long long &pLastUserTicsThread, unsigned long long &pLastKernelTicsThread, unsigned long long &pLastSystemTime);
 
 private:
@@ -0,0 +1,1041 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of asynchronous socket I/O based on io_uring
+ * Author:  Thomas Volkert
+ * Since:   2012-12-08
+ */
+
+#include <HBIoEngine.h>
+#include <HBThread.h>
+#include <HBCondition.h>
+#include <Logger.h>
+
+#include <map>
+#include <string.h>
+#include <stdlib.h>
+
+// the io_uring interface of Linux >= 6.0 (zero copy send) is detected by the build system, otherwise synchronous sockets are used
+#if defined(LINUX) && defined(HAVE_IO_URING)
+#define IO_ENGINE_IO_URING
+#endif
+
+#if defined(IO_ENGINE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+static IoEngine sIoEngine;
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(IO_ENGINE_IO_URING)
+
+// user data of requests which don't belong to a buffer
+#define IO_ENGINE_CANCEL_TAG                    0xFFFFFFFFFFFFFFFFULL
+
+enum IoRequestType{
+    IO_REQUEST_FREE = 0,
+    IO_REQUEST_SEND,
+    IO_REQUEST_RECEIVE
+};
+
+struct IoRequest
+{
+    enum IoRequestType  Type;
+    int                 Handle;
+    char                *Data; // points into the registered buffer area
+    int                 Size;
+    struct msghdr       Message;
+    struct iovec        Vector;
+    SocketAddressDescriptor Address;
+};
+
+struct IoSocketState
+{
+    Socket              *DataSocket;
+    int                 PendingPackets; // deferred, submitted or waiting for the zero copy notification
+    bool                Broken;
+    IoReceiver          *Receiver;
+    int                 ReceiveRequest;
+    bool                Canceling;
+};
+
+struct IoCompletion
+{
+    uint64_t            UserData;
+    int                 Result;
+    unsigned int        Flags;
+};
+
+typedef std::map<int, IoSocketState> IoSocketStates;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// one kernel ring with its registered buffers and the thread which reaps the completions
+class IoEngineWorker:
+    public Thread
+{
+public:
+    IoEngineWorker(int pIndex);
+
+    virtual ~IoEngineWorker();
+
+    bool Init();
+    void Start();
+    void Stop();
+
+    bool Send(Socket *pSocket, std::string pTargetHost, unsigned int pTargetPort, SocketAddressDescriptor *pAddress, unsigned int pAddressSize, void *pBuffer, int pBufferSize, bool pMorePackets);
+    void Flush();
+    void Drain(Socket *pSocket);
+    bool RegisterReceiver(Socket *pSocket, IoReceiver *pReceiver);
+    void UnregisterReceiver(Socket *pSocket);
+
+    int64_t GetSubmittedPackets();
+    int64_t GetSubmissionCalls();
+
+private:
+    /* completion thread */
+    virtual void* Run(void* pArgs = NULL);
+
+    IoSocketState& GetSocketState(Socket *pSocket);
+    struct io_uring_sqe* GetSqe();
+    int PublishSubmissions();
+    void Submit();
+    void WaitForCompletions(int pToSubmit);
+    void ProcessCompletions();
+    void HandleSendCompletion(IoRequest &pRequest, int pResult, unsigned int pFlags);
+    void HandleReceiveCompletion(int pRequest, int pResult);
+    void PrepareReceive(int pRequest);
+    void ReleaseRequest(int pRequest);
+
+    int                 mIndex;
+    bool                mWorkerNeeded;
+    int                 mWorkerTId;
+    bool                mZeroCopy;
+    /* ring */
+    int                 mRingFd;
+    void                *mSqRing;
+    size_t              mSqRingSize;
+    void                *mCqRing;
+    size_t              mCqRingSize;
+    struct io_uring_sqe *mSqes;
+    size_t              mSqesSize;
+    volatile unsigned int *mSqHead, *mSqTail;
+    unsigned int        mSqMask, mSqEntries;
+    volatile unsigned int *mCqHead, *mCqTail;
+    unsigned int        mCqMask;
+    struct io_uring_cqe *mCqes;
+    unsigned int        mSqLocalTail;
+    int                 mPendingSubmissions;
+    /* buffers */
+    char                *mBufferArea;
+    IoRequest           mRequests[IO_ENGINE_BUFFERS];
+    std::vector<int>    mFreeRequests;
+    /* sockets */
+    IoSocketStates      mSocketStates;
+    Mutex               mMutex;
+    Condition           mStateCondition;
+    /* statistic */
+    int64_t             mSubmittedPackets;
+    int64_t             mSubmissionCalls;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int IoUringSetup(unsigned int pEntries, struct io_uring_params *pParams)
+{
+    return (int)syscall(__NR_io_uring_setup, pEntries, pParams);
+}
+
+static int IoUringEnter(int pFd, unsigned int pToSubmit, unsigned int pMinComplete, unsigned int pFlags, void *pArg, size_t pArgSize)
+{
+    return (int)syscall(__NR_io_uring_enter, pFd, pToSubmit, pMinComplete, pFlags, pArg, pArgSize);
+}
+
+static int IoUringRegister(int pFd, unsigned int pOpcode, void *pArg, unsigned int pArgs)
+{
+    return (int)syscall(__NR_io_uring_register, pFd, pOpcode, pArg, pArgs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+IoEngineWorker::IoEngineWorker(int pIndex)
+{
+    mIndex = pIndex;
+    mWorkerNeeded = false;
+    mWorkerTId = 0;
+    mZeroCopy = false;
+    mRingFd = -1;
+    mSqRing = MAP_FAILED;
+    mSqRingSize = 0;
+    mCqRing = MAP_FAILED;
+    mCqRingSize = 0;
+    mSqes = (struct io_uring_sqe*)MAP_FAILED;
+    mSqesSize = 0;
+    mSqLocalTail = 0;
+    mPendingSubmissions = 0;
+    mBufferArea = NULL;
+    mSubmittedPackets = 0;
+    mSubmissionCalls = 0;
+}
+
+IoEngineWorker::~IoEngineWorker()
+{
+    Stop();
+
+    // closing the ring cancels all requests in flight, the kernel keeps its own references to the registered buffers
+    if (mRingFd != -1)
+        close(mRingFd);
+    if ((mCqRing != MAP_FAILED) && (mCqRing != mSqRing))
+        munmap(mCqRing, mCqRingSize);
+    if (mSqRing != MAP_FAILED)
+        munmap(mSqRing, mSqRingSize);
+    if (mSqes != MAP_FAILED)
+        munmap(mSqes, mSqesSize);
+    if (mBufferArea != NULL)
+        munmap(mBufferArea, (size_t)IO_ENGINE_BUFFERS * IO_ENGINE_BUFFER_SIZE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool IoEngineWorker::Init()
+{
+    struct io_uring_params tParams;
+
+    // every request may cause two completions (zero copy send + notification)
+    memset(&tParams, 0, sizeof(tParams));
+    tParams.flags = IORING_SETUP_CQSIZE;
+    tParams.cq_entries = 2 * IO_ENGINE_BUFFERS + IO_ENGINE_RING_ENTRIES;
+
+    mRingFd = IoUringSetup(IO_ENGINE_RING_ENTRIES, &tParams);
+    if (mRingFd < 0)
+    {
+        LOG(LOG_WARN, "Failed to setup I/O ring %d because \"%s\"(%d)", mIndex, strerror(errno), errno);
+        mRingFd = -1;
+        return false;
+    }
+    if (!(tParams.features & IORING_FEAT_EXT_ARG))
+    {
+        LOG(LOG_WARN, "Kernel doesn't support timed waits for I/O completions");
+        return false;
+    }
+
+    /* map the rings */
+    mSqRingSize = tParams.sq_off.array + tParams.sq_entries * sizeof(unsigned int);
+    mCqRingSize = tParams.cq_off.cqes + tParams.cq_entries * sizeof(struct io_uring_cqe);
+    if (tParams.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (mCqRingSize > mSqRingSize)
+            mSqRingSize = mCqRingSize;
+        mCqRingSize = mSqRingSize;
+    }
+    mSqRing = mmap(NULL, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQ_RING);
+    if (mSqRing == MAP_FAILED)
+    {
+        LOG(LOG_ERROR, "Failed to map submission queue because \"%s\"(%d)", strerror(errno), errno);
+        return false;
+    }
+    if (tParams.features & IORING_FEAT_SINGLE_MMAP)
+        mCqRing = mSqRing;
+    else
+    {
+        mCqRing = mmap(NULL, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_CQ_RING);
+        if (mCqRing == MAP_FAILED)
+        {
+            LOG(LOG_ERROR, "Failed to map completion queue because \"%s\"(%d)", strerror(errno), errno);
+            return false;
+        }
+    }
+    mSqesSize = tParams.sq_entries * sizeof(struct io_uring_sqe);
+    mSqes = (struct io_uring_sqe*)mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, IORING_OFF_SQES);
+    if (mSqes == MAP_FAILED)
+    {
+        LOG(LOG_ERROR, "Failed to map submission entries because \"%s\"(%d)", strerror(errno), errno);
+        return false;
+    }
+
+    mSqHead = (volatile unsigned int*)((char*)mSqRing + tParams.sq_off.head);
+    mSqTail = (volatile unsigned int*)((char*)mSqRing + tParams.sq_off.tail);
+    mSqMask = *(unsigned int*)((char*)mSqRing + tParams.sq_off.ring_mask);
+    mSqEntries = tParams.sq_entries;
+    mCqHead = (volatile unsigned int*)((char*)mCqRing + tParams.cq_off.head);
+    mCqTail = (volatile unsigned int*)((char*)mCqRing + tParams.cq_off.tail);
+    mCqMask = *(unsigned int*)((char*)mCqRing + tParams.cq_off.ring_mask);
+    mCqes = (struct io_uring_cqe*)((char*)mCqRing + tParams.cq_off.cqes);
+    mSqLocalTail = *mSqTail;
+
+    // the entries are used in the same order as the slots of the submission queue
+    unsigned int *tSqArray = (unsigned int*)((char*)mSqRing + tParams.sq_off.array);
+    for (unsigned int i = 0; i < mSqEntries; i++)
+        tSqArray[i] = i;
+
+    /* register the buffers: the kernel pins the pages once instead of for every request */
+    size_t tBufferAreaSize = (size_t)IO_ENGINE_BUFFERS * IO_ENGINE_BUFFER_SIZE;
+    mBufferArea = (char*)mmap(NULL, tBufferAreaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mBufferArea == MAP_FAILED)
+    {
+        mBufferArea = NULL;
+        LOG(LOG_ERROR, "Failed to allocate %d bytes for I/O buffers", (int)tBufferAreaSize);
+        return false;
+    }
+    struct iovec tBufferAreaVector;
+    tBufferAreaVector.iov_base = mBufferArea;
+    tBufferAreaVector.iov_len = tBufferAreaSize;
+    if (IoUringRegister(mRingFd, IORING_REGISTER_BUFFERS, &tBufferAreaVector, 1) < 0)
+    {
+        LOG(LOG_WARN, "Failed to register I/O buffers because \"%s\"(%d), will copy all outgoing packets", strerror(errno), errno);
+    }else
+    {
+        // zero copy sending out of registered buffers is available since Linux 6.0
+        int tProbeSize = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+        struct io_uring_probe *tProbe = (struct io_uring_probe*)malloc(tProbeSize);
+        memset(tProbe, 0, tProbeSize);
+        if ((IoUringRegister(mRingFd, IORING_REGISTER_PROBE, tProbe, 256) == 0) && (tProbe->last_op >= IORING_OP_SEND_ZC) && (tProbe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED))
+            mZeroCopy = true;
+        free(tProbe);
+    }
+
+    for (int i = IO_ENGINE_BUFFERS - 1; i >= 0; i--)
+    {
+        mRequests[i].Type = IO_REQUEST_FREE;
+        mRequests[i].Handle = -1;
+        mRequests[i].Data = mBufferArea + (size_t)i * IO_ENGINE_BUFFER_SIZE;
+        mRequests[i].Size = 0;
+        mFreeRequests.push_back(i);
+    }
+
+    LOG(LOG_VERBOSE, "I/O ring %d with %u entries and %d registered buffers of %d bytes created, zero copy sending: %d", mIndex, mSqEntries, IO_ENGINE_BUFFERS, IO_ENGINE_BUFFER_SIZE, mZeroCopy);
+
+    return true;
+}
+
+void IoEngineWorker::Start()
+{
+    mWorkerNeeded = true;
+    StartThread();
+}
+
+void IoEngineWorker::Stop()
+{
+    int tSignalingRound = 0;
+
+    if (!mWorkerNeeded)
+        return;
+
+    mWorkerNeeded = false;
+
+    // the completion thread wakes up at least with the flush period
+    do
+    {
+        if(tSignalingRound > 0)
+            LOG(LOG_WARN, "Signaling round %d to stop I/O ring %d, system has high load", tSignalingRound, mIndex);
+        tSignalingRound++;
+
+        mMutex.lock();
+        mStateCondition.SignalAll();
+        mMutex.unlock();
+    }while(!StopThread(1000));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+IoSocketState& IoEngineWorker::GetSocketState(Socket *pSocket)
+{
+    IoSocketStates::iterator tIt = mSocketStates.find(pSocket->GetHandle());
+
+    if (tIt == mSocketStates.end())
+    {
+        IoSocketState tState;
+        tState.DataSocket = pSocket;
+        tState.PendingPackets = 0;
+        tState.Broken = false;
+        tState.Receiver = NULL;
+        tState.ReceiveRequest = -1;
+        tState.Canceling = false;
+        tIt = mSocketStates.insert(std::pair<int, IoSocketState>(pSocket->GetHandle(), tState)).first;
+    }
+
+    return tIt->second;
+}
+
+struct io_uring_sqe* IoEngineWorker::GetSqe()
+{
+    // submission queue full: hand over the deferred entries to the kernel
+    if (mSqLocalTail - *mSqHead >= mSqEntries)
+        Submit();
+    if (mSqLocalTail - *mSqHead >= mSqEntries)
+        return NULL;
+
+    struct io_uring_sqe *tResult = &mSqes[mSqLocalTail & mSqMask];
+    memset(tResult, 0, sizeof(struct io_uring_sqe));
+    mSqLocalTail++;
+    mPendingSubmissions++;
+
+    return tResult;
+}
+
+int IoEngineWorker::PublishSubmissions()
+{
+    int tResult = mPendingSubmissions;
+
+    // make the new entries visible to the kernel, whoever enters the kernel next submits them
+    __sync_synchronize();
+    *mSqTail = mSqLocalTail;
+    __sync_synchronize();
+    mPendingSubmissions = 0;
+
+    return tResult;
+}
+
+void IoEngineWorker::Submit()
+{
+    if (mPendingSubmissions == 0)
+        return;
+
+    int tToSubmit = PublishSubmissions();
+    int tResult = IoUringEnter(mRingFd, tToSubmit, 0, 0, NULL, 0);
+    mSubmissionCalls++;
+    if (tResult < 0)
+    {
+        // EAGAIN/EBUSY: the completion queue is congested, the completion thread retries after reaping
+        if ((errno != EAGAIN) && (errno != EBUSY) && (errno != EINTR))
+            LOG(LOG_ERROR, "Failed to submit %d I/O requests because \"%s\"(%d)", tToSubmit, strerror(errno), errno);
+        mPendingSubmissions += tToSubmit;
+        return;
+    }
+
+    #ifdef IO_ENGINE_DEBUG_PACKETS
+        LOG(LOG_VERBOSE, "Submitted %d of %d I/O requests of ring %d", tResult, tToSubmit, mIndex);
+    #endif
+
+    mSubmittedPackets += tResult;
+    mPendingSubmissions += tToSubmit - tResult;
+}
+
+void IoEngineWorker::WaitForCompletions(int pToSubmit)
+{
+    struct io_uring_getevents_arg tArgs;
+
+    memset(&tArgs, 0, sizeof(tArgs));
+    struct __kernel_timespec tTimeout;
+    tTimeout.tv_sec = 0;
+    tTimeout.tv_nsec = (long long)IO_ENGINE_FLUSH_PERIOD * 1000 * 1000;
+    tArgs.sigmask_sz = _NSIG / 8;
+    tArgs.ts = (uint64_t)(uintptr_t)&tTimeout;
+
+    // submit and wait with one system call
+    int tResult = IoUringEnter(mRingFd, pToSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &tArgs, sizeof(tArgs));
+    if (pToSubmit > 0)
+        mSubmissionCalls++;
+    if (tResult < 0)
+    {
+        if ((errno != ETIME) && (errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY))
+        {
+            LOG(LOG_ERROR, "Failed to wait for I/O completions because \"%s\"(%d)", strerror(errno), errno);
+            Suspend(IO_ENGINE_FLUSH_PERIOD * 1000);
+        }
+        tResult = 0;
+    }
+    if (tResult < pToSubmit)
+    {
+        mMutex.lock();
+        mPendingSubmissions += pToSubmit - tResult;
+        mMutex.unlock();
+    }
+    mSubmittedPackets += tResult;
+}
+
+void IoEngineWorker::ProcessCompletions()
+{
+    std::vector<IoCompletion> tCompletions;
+
+    /* fetch all completions at once to release the queue entries early */
+    mMutex.lock();
+    unsigned int tHead = *mCqHead;
+    __sync_synchronize();
+    unsigned int tTail = *mCqTail;
+    __sync_synchronize();
+    while (tHead != tTail)
+    {
+        struct io_uring_cqe *tCqe = &mCqes[tHead & mCqMask];
+        IoCompletion tCompletion;
+        tCompletion.UserData = tCqe->user_data;
+        tCompletion.Result = tCqe->res;
+        tCompletion.Flags = tCqe->flags;
+        tCompletions.push_back(tCompletion);
+        tHead++;
+    }
+    __sync_synchronize();
+    *mCqHead = tHead;
+
+    // send completions only release buffers, receive completions call the receiver and are handled outside of the lock
+    std::vector<IoCompletion>::iterator tIt;
+    for (tIt = tCompletions.begin(); tIt != tCompletions.end(); tIt++)
+    {
+        if ((tIt->UserData == IO_ENGINE_CANCEL_TAG) || (tIt->UserData >= IO_ENGINE_BUFFERS))
+            continue;
+        IoRequest &tRequest = mRequests[tIt->UserData];
+        if (tRequest.Type == IO_REQUEST_SEND)
+            HandleSendCompletion(tRequest, tIt->Result, tIt->Flags);
+    }
+    mMutex.unlock();
+
+    for (tIt = tCompletions.begin(); tIt != tCompletions.end(); tIt++)
+    {
+        if ((tIt->UserData != IO_ENGINE_CANCEL_TAG) && (tIt->UserData < IO_ENGINE_BUFFERS) && (mRequests[tIt->UserData].Type == IO_REQUEST_RECEIVE))
+            HandleReceiveCompletion((int)tIt->UserData, tIt->Result);
+    }
+}
+
+void IoEngineWorker::HandleSendCompletion(IoRequest &pRequest, int pResult, unsigned int pFlags)
+{
+    IoSocketStates::iterator tIt = mSocketStates.find(pRequest.Handle);
+
+    // result of a zero copy send: further notification follows when the kernel doesn't need the buffer anymore
+    if (!(pFlags & IORING_CQE_F_NOTIF))
+    {
+        if (pResult < 0)
+        {
+            LOG(LOG_ERROR, "Error when sending data via socket %d because of \"%s\"(%d)", pRequest.Handle, strerror(-pResult), -pResult);
+            if (tIt != mSocketStates.end())
+                tIt->second.Broken = true;
+        }else if (pResult < pRequest.Size)
+        {
+            LOG(LOG_ERROR, "Insufficient data on socket %d was sent", pRequest.Handle);
+        }
+        if (pFlags & IORING_CQE_F_MORE)
+            return;
+    }
+
+    ReleaseRequest((int)(&pRequest - mRequests));
+    if (tIt != mSocketStates.end())
+    {
+        tIt->second.PendingPackets--;
+        // also wake up senders which wait for a free buffer
+        if ((tIt->second.PendingPackets == 0) || (mFreeRequests.size() == 1))
+            mStateCondition.SignalAll();
+    }
+}
+
+void IoEngineWorker::HandleReceiveCompletion(int pRequest, int pResult)
+{
+    IoRequest &tRequest = mRequests[pRequest];
+    IoReceiver *tReceiver = NULL;
+    Socket *tSocket = NULL;
+    bool tContinue = false;
+
+    mMutex.lock();
+    IoSocketStates::iterator tIt = mSocketStates.find(tRequest.Handle);
+    if ((tIt != mSocketStates.end()) && (!tIt->second.Canceling) && (mWorkerNeeded))
+    {
+        tReceiver = tIt->second.Receiver;
+        tSocket = tIt->second.DataSocket;
+    }
+    mMutex.unlock();
+
+    if (tReceiver != NULL)
+    {
+        if (pResult >= 0)
+        {
+            unsigned int tSourcePort = 0;
+            string tSourceHost = Socket::GetAddrFromDescriptor(&tRequest.Address, &tSourcePort);
+            if (tSourceHost == "")
+                LOG(LOG_ERROR ,"Could not determine the UDP/UDP-Lite source address for socket %d", tRequest.Handle);
+            tSocket->SetPeerHost(tSourceHost);
+            tSocket->SetPeerPort(tSourcePort);
+
+            #ifdef IO_ENGINE_DEBUG_PACKETS
+                LOG(LOG_VERBOSE, "Received %d bytes via socket %d from %s<%u>", pResult, tRequest.Handle, tSourceHost.c_str(), tSourcePort);
+            #endif
+
+            tContinue = tReceiver->OnReceive(tSourceHost, tSourcePort, tRequest.Data, pResult);
+        }else
+        {
+            LOG(LOG_ERROR, "Error when receiving data via socket %d because of \"%s\"(%d)", tRequest.Handle, strerror(-pResult), -pResult);
+            tContinue = tReceiver->OnReceive("", 0, tRequest.Data, -1);
+        }
+    }
+
+    mMutex.lock();
+    tIt = mSocketStates.find(tRequest.Handle);
+    if ((tContinue) && (tIt != mSocketStates.end()) && (!tIt->second.Canceling) && (mWorkerNeeded))
+    {
+        PrepareReceive(pRequest);
+    }else
+    {
+        ReleaseRequest(pRequest);
+        if (tIt != mSocketStates.end())
+        {
+            tIt->second.Receiver = NULL;
+            tIt->second.ReceiveRequest = -1;
+        }
+        mStateCondition.SignalAll();
+    }
+    mMutex.unlock();
+}
+
+void IoEngineWorker::PrepareReceive(int pRequest)
+{
+    IoRequest &tRequest = mRequests[pRequest];
+
+    struct io_uring_sqe *tSqe = GetSqe();
+    if (tSqe == NULL)
+    {
+        LOG(LOG_ERROR, "Submission queue of I/O ring %d is congested, reception stalls", mIndex);
+        return;
+    }
+
+    memset(&tRequest.Message, 0, sizeof(tRequest.Message));
+    tRequest.Vector.iov_base = tRequest.Data;
+    tRequest.Vector.iov_len = IO_ENGINE_BUFFER_SIZE;
+    tRequest.Message.msg_name = &tRequest.Address.sa;
+    tRequest.Message.msg_namelen = sizeof(tRequest.Address.sa_stor);
+    tRequest.Message.msg_iov = &tRequest.Vector;
+    tRequest.Message.msg_iovlen = 1;
+
+    tSqe->opcode = IORING_OP_RECVMSG;
+    tSqe->fd = tRequest.Handle;
+    tSqe->addr = (uint64_t)(uintptr_t)&tRequest.Message;
+    tSqe->len = 1;
+    tSqe->user_data = (uint64_t)pRequest;
+}
+
+void IoEngineWorker::ReleaseRequest(int pRequest)
+{
+    mRequests[pRequest].Type = IO_REQUEST_FREE;
+    mRequests[pRequest].Handle = -1;
+    mFreeRequests.push_back(pRequest);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool IoEngineWorker::Send(Socket *pSocket, string pTargetHost, unsigned int pTargetPort, SocketAddressDescriptor *pAddress, unsigned int pAddressSize, void *pBuffer, int pBufferSize, bool pMorePackets)
+{
+    mMutex.lock();
+
+    IoSocketState &tState = GetSocketState(pSocket);
+    if (tState.Broken)
+    {
+        mMutex.unlock();
+        return false;
+    }
+
+    // all buffers are in flight: the kernel can't keep up, fall back to a blocking send
+    if (mFreeRequests.empty())
+    {
+        // a synchronous send must not overtake the queued packets of this socket: wait until they are sent or a buffer is free again
+        //HINT: a receiver which sends from within the completion thread can't wait for completions
+        Submit();
+        while ((mFreeRequests.empty()) && (tState.PendingPackets > 0) && (mWorkerNeeded) && (Thread::GetTId() != mWorkerTId))
+            mStateCondition.Wait(&mMutex, IO_ENGINE_FLUSH_PERIOD);
+        if (tState.Broken)
+        {
+            mMutex.unlock();
+            return false;
+        }
+        if (mFreeRequests.empty())
+        {
+            mMutex.unlock();
+            LOG(LOG_WARN, "All buffers of I/O ring %d are in flight, sending synchronously", mIndex);
+            return pSocket->Send(pTargetHost, pTargetPort, pBuffer, (ssize_t)pBufferSize);
+        }
+    }
+
+    struct io_uring_sqe *tSqe = GetSqe();
+    if (tSqe == NULL)
+    {
+        mMutex.unlock();
+        LOG(LOG_WARN, "Submission queue of I/O ring %d is congested, dropping packet of %d bytes", mIndex, pBufferSize);
+        return true;
+    }
+
+    int tRequestIndex = mFreeRequests.back();
+    mFreeRequests.pop_back();
+    IoRequest &tRequest = mRequests[tRequestIndex];
+    tRequest.Type = IO_REQUEST_SEND;
+    tRequest.Handle = pSocket->GetHandle();
+    tRequest.Size = pBufferSize;
+    memcpy(tRequest.Data, pBuffer, pBufferSize);
+    memcpy(&tRequest.Address, pAddress, pAddressSize);
+
+    if ((mZeroCopy) && (pBufferSize >= IO_ENGINE_ZERO_COPY_MIN_SIZE))
+    {
+        tSqe->opcode = IORING_OP_SEND_ZC;
+        tSqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        tSqe->buf_index = 0;
+        tSqe->addr = (uint64_t)(uintptr_t)tRequest.Data;
+        tSqe->len = pBufferSize;
+        tSqe->addr2 = (uint64_t)(uintptr_t)&tRequest.Address.sa;
+        tSqe->addr_len = (uint16_t)pAddressSize;
+    }else
+    {
+        memset(&tRequest.Message, 0, sizeof(tRequest.Message));
+        tRequest.Vector.iov_base = tRequest.Data;
+        tRequest.Vector.iov_len = pBufferSize;
+        tRequest.Message.msg_name = &tRequest.Address.sa;
+        tRequest.Message.msg_namelen = pAddressSize;
+        tRequest.Message.msg_iov = &tRequest.Vector;
+        tRequest.Message.msg_iovlen = 1;
+        tSqe->opcode = IORING_OP_SENDMSG;
+        tSqe->addr = (uint64_t)(uintptr_t)&tRequest.Message;
+        tSqe->len = 1;
+    }
+    tSqe->fd = tRequest.Handle;
+    tSqe->msg_flags = MSG_NOSIGNAL;
+    tSqe->user_data = (uint64_t)tRequestIndex;
+    tState.PendingPackets++;
+
+    if ((!pMorePackets) || (mPendingSubmissions >= IO_ENGINE_SUBMIT_BATCH))
+        Submit();
+
+    mMutex.unlock();
+
+    return true;
+}
+
+void IoEngineWorker::Flush()
+{
+    mMutex.lock();
+    Submit();
+    mMutex.unlock();
+}
+
+void IoEngineWorker::Drain(Socket *pSocket)
+{
+    mMutex.lock();
+    Submit();
+    IoSocketStates::iterator tIt = mSocketStates.find(pSocket->GetHandle());
+    while ((tIt != mSocketStates.end()) && (tIt->second.PendingPackets > 0) && (mWorkerNeeded))
+    {
+        mStateCondition.Wait(&mMutex, 100);
+        tIt = mSocketStates.find(pSocket->GetHandle());
+    }
+    // forget the socket, its handle might be reused for another socket
+    if ((tIt != mSocketStates.end()) && (tIt->second.Receiver == NULL))
+        mSocketStates.erase(tIt);
+    mMutex.unlock();
+}
+
+bool IoEngineWorker::RegisterReceiver(Socket *pSocket, IoReceiver *pReceiver)
+{
+    mMutex.lock();
+
+    IoSocketState &tState = GetSocketState(pSocket);
+    if ((tState.Receiver != NULL) || (mFreeRequests.empty()))
+    {
+        mMutex.unlock();
+        LOG(LOG_ERROR, "Failed to register receiver for socket %d", pSocket->GetHandle());
+        return false;
+    }
+
+    int tRequestIndex = mFreeRequests.back();
+    mFreeRequests.pop_back();
+    mRequests[tRequestIndex].Type = IO_REQUEST_RECEIVE;
+    mRequests[tRequestIndex].Handle = pSocket->GetHandle();
+    tState.Receiver = pReceiver;
+    tState.ReceiveRequest = tRequestIndex;
+    tState.Canceling = false;
+    PrepareReceive(tRequestIndex);
+    Submit();
+
+    mMutex.unlock();
+
+    LOG(LOG_VERBOSE, "Receiving via socket %d at I/O ring %d", pSocket->GetHandle(), mIndex);
+
+    return true;
+}
+
+void IoEngineWorker::UnregisterReceiver(Socket *pSocket)
+{
+    mMutex.lock();
+
+    IoSocketStates::iterator tIt = mSocketStates.find(pSocket->GetHandle());
+    if ((tIt != mSocketStates.end()) && (tIt->second.Receiver != NULL))
+    {
+        tIt->second.Canceling = true;
+
+        // cancel the pending reception, the completion releases its buffer
+        struct io_uring_sqe *tSqe = GetSqe();
+        if (tSqe != NULL)
+        {
+            tSqe->opcode = IORING_OP_ASYNC_CANCEL;
+            tSqe->fd = -1;
+            tSqe->addr = (uint64_t)tIt->second.ReceiveRequest;
+            tSqe->user_data = IO_ENGINE_CANCEL_TAG;
+            Submit();
+        }
+
+        while ((tIt != mSocketStates.end()) && (tIt->second.Receiver != NULL) && (mWorkerNeeded))
+        {
+            mStateCondition.Wait(&mMutex, 100);
+            tIt = mSocketStates.find(pSocket->GetHandle());
+        }
+        LOG(LOG_VERBOSE, "Stopped receiving via socket %d at I/O ring %d", pSocket->GetHandle(), mIndex);
+    }
+    if ((tIt != mSocketStates.end()) && (tIt->second.PendingPackets == 0) && (tIt->second.Receiver == NULL))
+        mSocketStates.erase(tIt);
+
+    mMutex.unlock();
+}
+
+int64_t IoEngineWorker::GetSubmittedPackets()
+{
+    return mSubmittedPackets;
+}
+
+int64_t IoEngineWorker::GetSubmissionCalls()
+{
+    return mSubmissionCalls;
+}
+
+void* IoEngineWorker::Run(void* pArgs)
+{
+    LOG(LOG_VERBOSE, "Completion thread of I/O ring %d started", mIndex);
+    mWorkerTId = GetTId();
+
+    while(mWorkerNeeded)
+    {
+        // hand over deferred and re-armed requests
+        mMutex.lock();
+        int tToSubmit = PublishSubmissions();
+        mMutex.unlock();
+
+        WaitForCompletions(tToSubmit);
+        ProcessCompletions();
+    }
+
+    LOG(LOG_VERBOSE, "Completion thread of I/O ring %d finished", mIndex);
+
+    return NULL;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+IoEngine::IoEngine()
+{
+    mStarted = false;
+    mAvailable = false;
+    mThreadCount = IO_ENGINE_DEFAULT_THREADS;
+}
+
+IoEngine::~IoEngine()
+{
+    // HINT: the completion threads are terminated together with the process, the kernel releases the rings and buffers
+}
+
+IoEngine& IoEngine::GetInstance()
+{
+    return sIoEngine;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void IoEngine::SetThreadCount(int pCount)
+{
+    mMutex.lock();
+    if (mStarted)
+        LOG(LOG_WARN, "I/O engine is already running with %d threads, ignoring new thread count %d", mThreadCount, pCount);
+    else
+    {
+        if (pCount > IO_ENGINE_MAX_THREADS)
+            pCount = IO_ENGINE_MAX_THREADS;
+        if (pCount < 0)
+            pCount = 0;
+        mThreadCount = pCount;
+    }
+    mMutex.unlock();
+}
+
+int IoEngine::GetThreadCount()
+{
+    return mThreadCount;
+}
+
+bool IoEngine::Start()
+{
+    mMutex.lock();
+    if (!mStarted)
+    {
+        mStarted = true;
+        #if defined(IO_ENGINE_IO_URING)
+            for (int i = 0; i < mThreadCount; i++)
+            {
+                IoEngineWorker *tWorker = new IoEngineWorker(i);
+                if (!tWorker->Init())
+                {
+                    delete tWorker;
+                    break;
+                }
+                mWorkers.push_back(tWorker);
+            }
+            if ((mThreadCount > 0) && ((int)mWorkers.size() == mThreadCount))
+            {
+                for (unsigned int i = 0; i < mWorkers.size(); i++)
+                    mWorkers[i]->Start();
+                mAvailable = true;
+                LOG(LOG_INFO, "Asynchronous socket I/O with %d completion threads started", mThreadCount);
+            }else
+            {
+                for (unsigned int i = 0; i < mWorkers.size(); i++)
+                    delete mWorkers[i];
+                mWorkers.clear();
+            }
+        #endif
+        if (!mAvailable)
+            LOG(LOG_INFO, "Asynchronous socket I/O isn't available, using synchronous sockets");
+    }
+    mMutex.unlock();
+
+    return mAvailable;
+}
+
+bool IoEngine::IsAvailable()
+{
+    if (!mStarted)
+        return Start();
+
+    return mAvailable;
+}
+
+bool IoEngine::IsSupported(Socket *pSocket)
+{
+    if ((pSocket == NULL) || (pSocket->GetHandle() == -1))
+        return false;
+
+    if ((pSocket->GetTransportType() != SOCKET_UDP) && (pSocket->GetTransportType() != SOCKET_UDP_LITE))
+        return false;
+
+    return IsAvailable();
+}
+
+IoEngineWorker* IoEngine::GetWorker(Socket *pSocket)
+{
+    return mWorkers[pSocket->GetHandle() % mWorkers.size()];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool IoEngine::Send(Socket *pSocket, string pTargetHost, unsigned int pTargetPort, void *pBuffer, ssize_t pBufferSize, bool pMorePackets)
+{
+    if ((!IsSupported(pSocket)) || (pBufferSize > IO_ENGINE_BUFFER_SIZE))
+        return pSocket->Send(pTargetHost, pTargetPort, pBuffer, pBufferSize);
+
+    #if defined(IO_ENGINE_IO_URING)
+        SocketAddressDescriptor tAddressDescriptor;
+        unsigned int tAddressDescriptorSize;
+        if (!Socket::FillAddrDescriptor(pTargetHost, pTargetPort, &tAddressDescriptor, tAddressDescriptorSize))
+        {
+            LOG(LOG_ERROR ,"Could not process the target address of socket %d", pSocket->GetHandle());
+            return false;
+        }
+
+        // same peer book keeping as for synchronous sending
+        pSocket->SetPeerHost(pTargetHost);
+        pSocket->SetPeerPort(pTargetPort);
+
+        return GetWorker(pSocket)->Send(pSocket, pTargetHost, pTargetPort, &tAddressDescriptor, tAddressDescriptorSize, pBuffer, (int)pBufferSize, pMorePackets);
+    #else
+        return false;
+    #endif
+}
+
+void IoEngine::Flush(Socket *pSocket)
+{
+    if (!IsSupported(pSocket))
+        return;
+
+    #if defined(IO_ENGINE_IO_URING)
+        GetWorker(pSocket)->Flush();
+    #endif
+}
+
+void IoEngine::Drain(Socket *pSocket)
+{
+    if (!IsSupported(pSocket))
+        return;
+
+    #if defined(IO_ENGINE_IO_URING)
+        GetWorker(pSocket)->Drain(pSocket);
+    #endif
+}
+
+bool IoEngine::RegisterReceiver(Socket *pSocket, IoReceiver *pReceiver)
+{
+    if (!IsSupported(pSocket))
+        return false;
+
+    #if defined(IO_ENGINE_IO_URING)
+        return GetWorker(pSocket)->RegisterReceiver(pSocket, pReceiver);
+    #else
+        return false;
+    #endif
+}
+
+void IoEngine::UnregisterReceiver(Socket *pSocket)
+{
+    if (!IsSupported(pSocket))
+        return;
+
+    #if defined(IO_ENGINE_IO_URING)
+        GetWorker(pSocket)->UnregisterReceiver(pSocket);
+    #endif
+}
+
+int64_t IoEngine::GetSubmittedPackets()
+{
+    int64_t tResult = 0;
+
+    #if defined(IO_ENGINE_IO_URING)
+        for (unsigned int i = 0; i < mWorkers.size(); i++)
+            tResult += mWorkers[i]->GetSubmittedPackets();
+    #endif
+
+    return tResult;
+}
+
+int64_t IoEngine::GetSubmissionCalls()
+{
+    int64_t tResult = 0;
+
+    #if defined(IO_ENGINE_IO_URING)
+        for (unsigned int i = 0; i < mWorkers.size(); i++)
+            tResult += mWorkers[i]->GetSubmissionCalls();
+    #endif
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -0,0 +1,260 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of a size class based pool for large media buffers
+ * Author:  Thomas Volkert
+ * Since:   2012-12-05
+ */
+
+#include <Logger.h>
+#include <HBMemoryPool.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+// hidden header in front of every buffer, 16 bytes to keep the alignment of malloc()
+struct MemoryPool::BufferHeader
+{
+    uint32_t        Capacity;
+    int32_t         SizeClass; // -1 if the buffer bypasses the pool
+    int32_t         Subsystem;
+    uint32_t        RequestedSize;
+};
+
+static MemoryPool sMemoryPool;
+static bool sMemoryPoolReady = false;
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryPool::MemoryPool()
+{
+    mCachedBytes = 0;
+    sMemoryPoolReady = true;
+}
+
+MemoryPool::~MemoryPool()
+{
+    Trim();
+    sMemoryPoolReady = false;
+}
+
+MemoryPool& MemoryPool::GetInstance()
+{
+    return sMemoryPool;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int MemoryPool::GetSizeClass(unsigned int pSize)
+{
+    int tResult = MEMORY_POOL_MIN_CLASS;
+
+    while ((tResult <= MEMORY_POOL_MAX_CLASS) && ((1U << tResult) < pSize))
+        tResult++;
+
+    if (tResult > MEMORY_POOL_MAX_CLASS)
+        tResult = -1;
+
+    return tResult;
+}
+
+int MemoryPool::GetSubsystemIndex(string pSubsystem)
+{
+    for (unsigned int i = 0; i < mUsage.size(); i++)
+    {
+        if (mUsage[i].Subsystem == pSubsystem)
+            return (int)i;
+    }
+
+    MemoryUsage tUsage;
+    tUsage.Subsystem = pSubsystem;
+    tUsage.Buffers = 0;
+    tUsage.Bytes = 0;
+    tUsage.RequestedBytes = 0;
+    tUsage.PeakBytes = 0;
+    tUsage.Allocations = 0;
+    mUsage.push_back(tUsage);
+
+    return (int)mUsage.size() - 1;
+}
+
+void MemoryPool::Account(int pSubsystem, int64_t pBytes, int64_t pRequestedBytes, int pBuffers)
+{
+    MemoryUsage &tUsage = mUsage[pSubsystem];
+
+    tUsage.Buffers += pBuffers;
+    tUsage.Bytes += pBytes;
+    tUsage.RequestedBytes += pRequestedBytes;
+    if (tUsage.Bytes > tUsage.PeakBytes)
+        tUsage.PeakBytes = tUsage.Bytes;
+    if (pBytes > 0)
+        tUsage.Allocations++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* MemoryPool::Alloc(string pSubsystem, unsigned int pSize)
+{
+    BufferHeader *tHeader = NULL;
+    int tSizeClass = GetSizeClass(pSize);
+    unsigned int tCapacity = (tSizeClass != -1) ? (1U << tSizeClass) : pSize;
+
+    mMutex.lock();
+
+    // reuse a cached buffer of the same size class
+    if ((tSizeClass != -1) && (!mFreeLists[tSizeClass].empty()))
+    {
+        tHeader = (BufferHeader*)mFreeLists[tSizeClass].back();
+        mFreeLists[tSizeClass].pop_back();
+        mCachedBytes -= tCapacity;
+    }
+
+    mMutex.unlock();
+
+    if (tHeader == NULL)
+    {
+        tHeader = (BufferHeader*)malloc(sizeof(BufferHeader) + tCapacity);
+        if (tHeader == NULL)
+        {
+            LOG(LOG_ERROR, "Failed to allocate %u bytes for subsystem %s", tCapacity, pSubsystem.c_str());
+            return NULL;
+        }
+    }
+
+    mMutex.lock();
+    tHeader->Capacity = tCapacity;
+    tHeader->SizeClass = tSizeClass;
+    tHeader->Subsystem = GetSubsystemIndex(pSubsystem);
+    tHeader->RequestedSize = pSize;
+    Account(tHeader->Subsystem, tCapacity, pSize, 1);
+    mMutex.unlock();
+
+    return (void*)(tHeader + 1);
+}
+
+void* MemoryPool::Grow(void *pBuffer, unsigned int pSize)
+{
+    if (pBuffer == NULL)
+        return NULL;
+
+    BufferHeader *tHeader = ((BufferHeader*)pBuffer) - 1;
+    if (tHeader->Capacity >= pSize)
+        return pBuffer;
+
+    mMutex.lock();
+    string tSubsystem = mUsage[tHeader->Subsystem].Subsystem;
+    mMutex.unlock();
+
+    LOG(LOG_VERBOSE, "Growing buffer of subsystem %s from %u to %u bytes", tSubsystem.c_str(), tHeader->Capacity, pSize);
+
+    void *tResult = Alloc(tSubsystem, pSize);
+    if (tResult != NULL)
+    {
+        memcpy(tResult, pBuffer, tHeader->Capacity);
+        Free(pBuffer);
+    }
+
+    return tResult;
+}
+
+void MemoryPool::Free(void *pBuffer)
+{
+    if (pBuffer == NULL)
+        return;
+
+    BufferHeader *tHeader = ((BufferHeader*)pBuffer) - 1;
+
+    // the pool was already destroyed during process termination
+    if (!sMemoryPoolReady)
+    {
+        free(tHeader);
+        return;
+    }
+
+    mMutex.lock();
+    Account(tHeader->Subsystem, -(int64_t)tHeader->Capacity, -(int64_t)tHeader->RequestedSize, -1);
+    if ((tHeader->SizeClass != -1) && (mCachedBytes + tHeader->Capacity <= MEMORY_POOL_CACHE_LIMIT))
+    {
+        mFreeLists[tHeader->SizeClass].push_back(tHeader);
+        mCachedBytes += tHeader->Capacity;
+        tHeader = NULL;
+    }
+    mMutex.unlock();
+
+    if (tHeader != NULL)
+        free(tHeader);
+}
+
+unsigned int MemoryPool::GetCapacity(void *pBuffer)
+{
+    if (pBuffer == NULL)
+        return 0;
+
+    return (((BufferHeader*)pBuffer) - 1)->Capacity;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryUsages MemoryPool::GetMemoryUsage()
+{
+    MemoryUsages tResult;
+
+    mMutex.lock();
+    tResult = mUsage;
+    mMutex.unlock();
+
+    return tResult;
+}
+
+int64_t MemoryPool::GetCachedBytes()
+{
+    int64_t tResult;
+
+    mMutex.lock();
+    tResult = mCachedBytes;
+    mMutex.unlock();
+
+    return tResult;
+}
+
+void MemoryPool::Trim()
+{
+    mMutex.lock();
+    for (int i = MEMORY_POOL_MIN_CLASS; i <= MEMORY_POOL_MAX_CLASS; i++)
+    {
+        while (!mFreeLists[i].empty())
+        {
+            free(mFreeLists[i].back());
+            mFreeLists[i].pop_back();
+        }
+    }
+    mCachedBytes = 0;
+    mMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
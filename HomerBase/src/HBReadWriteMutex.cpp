@@ -0,0 +1,96 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of os independent reader/writer lock handling
+ * Author:  Thomas Volkert
+ * Since:   2012-12-03
+ */
+
+#include <Logger.h>
+#include <HBReadWriteMutex.h>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+ReadWriteMutex::ReadWriteMutex()
+{
+    mName = "";
+    #if defined(LINUX) || defined(APPLE) || defined(BSD)
+        if (pthread_rwlock_init(&mMutex, NULL) != 0)
+            LOG(LOG_ERROR, "Initiation of reader/writer mutex failed");
+	#endif
+}
+
+ReadWriteMutex::~ReadWriteMutex()
+{
+    #if defined(LINUX) || defined(APPLE) || defined(BSD)
+        if (pthread_rwlock_destroy(&mMutex) != 0)
+            LOG(LOG_ERROR, "Destruction of reader/writer mutex failed");
+	#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ReadWriteMutex::lockRead()
+{
+    #if defined(LINUX) || defined(APPLE) || defined(BSD)
+		return !pthread_rwlock_rdlock(&mMutex);
+	#endif
+	#if defined(WIN32) ||defined(WIN64)
+		return mMutex.lock();
+	#endif
+}
+
+bool ReadWriteMutex::lockWrite()
+{
+    #if defined(LINUX) || defined(APPLE) || defined(BSD)
+		return !pthread_rwlock_wrlock(&mMutex);
+	#endif
+	#if defined(WIN32) ||defined(WIN64)
+		return mMutex.lock();
+	#endif
+}
+
+bool ReadWriteMutex::unlock()
+{
+    #if defined(LINUX) || defined(APPLE) || defined(BSD)
+		return !pthread_rwlock_unlock(&mMutex);
+	#endif
+	#if defined(WIN32) ||defined(WIN64)
+		return mMutex.unlock();
+	#endif
+}
+
+void ReadWriteMutex::AssignName(string pName)
+{
+    mName = pName;
+    #if defined(WIN32) ||defined(WIN64)
+        mMutex.AssignName(pName);
+    #endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -0,0 +1,478 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of a work-stealing task scheduler
+ * Author:  Thomas Volkert
+ * Since:   2012-12-10
+ */
+
+#include <HBTaskScheduler.h>
+#include <HBAtomic.h>
+#include <HBThread.h>
+#include <HBSystem.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+#include <deque>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+static TaskScheduler sTaskScheduler;
+
+///////////////////////////////////////////////////////////////////////////////
+
+enum TaskState{
+    TASK_DETACHED = 0,
+    TASK_IDLE,
+    TASK_QUEUED,
+    TASK_RUNNING,
+    TASK_RUNNING_TRIGGERED
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+Task::Task(enum TaskPriority pPriority, string pName)
+{
+    mTaskPriority = pPriority;
+    mTaskName = pName;
+    mTaskState = TASK_DETACHED;
+    mTaskDetaching = false;
+    mTaskQueueTime = 0;
+}
+
+Task::~Task()
+{
+}
+
+enum TaskPriority Task::GetTaskPriority()
+{
+    return mTaskPriority;
+}
+
+string Task::GetTaskName()
+{
+    return mTaskName;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+class TaskWorker:
+    public Thread
+{
+public:
+    TaskWorker(TaskScheduler *pScheduler, int pIndex);
+
+    virtual ~TaskWorker();
+
+    /* queue of this worker, the owner takes the oldest entries, other workers steal the newest ones */
+    Mutex               mQueueMutex;
+    deque<Task*>        mQueues[TASK_PRIORITIES];
+    volatile int        mThreadId;
+    /* statistic, only updated by the worker itself */
+    double              mAverageLatency[TASK_PRIORITIES];
+    int64_t             mExecutedTasks;
+    int64_t             mStolenTasks;
+
+private:
+    virtual void* Run(void* pArgs = NULL);
+
+    TaskScheduler       *mScheduler;
+    int                 mIndex;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+TaskWorker::TaskWorker(TaskScheduler *pScheduler, int pIndex)
+{
+    mScheduler = pScheduler;
+    mIndex = pIndex;
+    mThreadId = 0;
+    for (int i = 0; i < TASK_PRIORITIES; i++)
+        mAverageLatency[i] = 0;
+    mExecutedTasks = 0;
+    mStolenTasks = 0;
+}
+
+TaskWorker::~TaskWorker()
+{
+}
+
+void* TaskWorker::Run(void* pArgs)
+{
+    mThreadId = GetTId();
+    LOG(LOG_VERBOSE, "Task worker %d started", mIndex);
+
+    while(mScheduler->mSchedulerNeeded)
+    {
+        Task *tTask = mScheduler->FetchTask(mIndex);
+        if (tTask == NULL)
+        {
+            mScheduler->WaitForTask();
+            continue;
+        }
+
+        mScheduler->ExecuteTask(tTask, mIndex);
+    }
+
+    LOG(LOG_VERBOSE, "Task worker %d finished", mIndex);
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TaskScheduler::TaskScheduler()
+{
+    mStarted = false;
+    mSchedulerNeeded = false;
+    mTaskCount = 0;
+    mNextWorker = 0;
+    mIdleWorkers = 0;
+    for (int i = 0; i < TASK_PRIORITIES; i++)
+        mQueuedTasks[i] = 0;
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    Stop();
+}
+
+TaskScheduler& TaskScheduler::GetInstance()
+{
+    return sTaskScheduler;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::Start()
+{
+    int tThreads = System::GetMachineCores();
+    if (tThreads < TASK_SCHEDULER_MIN_THREADS)
+        tThreads = TASK_SCHEDULER_MIN_THREADS;
+    if (tThreads > TASK_SCHEDULER_MAX_THREADS)
+        tThreads = TASK_SCHEDULER_MAX_THREADS;
+
+    LOG(LOG_VERBOSE, "Starting task scheduler with %d workers", tThreads);
+
+    mSchedulerNeeded = true;
+
+    // all workers have to exist before the first one can steal from the others
+    for (int i = 0; i < tThreads; i++)
+        mWorkers.push_back(new TaskWorker(this, i));
+    for (int i = 0; i < tThreads; i++)
+        mWorkers[i]->StartThread();
+}
+
+void TaskScheduler::Stop()
+{
+    if (!mSchedulerNeeded)
+        return;
+
+    // HINT: all tasks have to be detached before
+    mSchedulerNeeded = false;
+    for (unsigned int i = 0; i < mWorkers.size(); i++)
+    {
+        int tSignalingRound = 0;
+        do
+        {
+            if(tSignalingRound > 0)
+                LOG(LOG_WARN, "Signaling round %d to stop task worker %d, system has high load", tSignalingRound, i);
+            tSignalingRound++;
+
+            // awake the worker as long as it still waits for tasks
+            mIdleMutex.lock();
+            mIdleCondition.SignalAll();
+            mIdleMutex.unlock();
+        }while(!mWorkers[i]->StopThread(1000));
+        delete mWorkers[i];
+    }
+    mWorkers.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::Attach(Task *pTask)
+{
+    mMutex.lock();
+    if (!mStarted)
+    {
+        mStarted = true;
+        Start();
+    }
+    mMutex.unlock();
+
+    if (pTask->mTaskState != TASK_DETACHED)
+    {
+        LOG(LOG_WARN, "Task %s is already attached", pTask->mTaskName.c_str());
+        return;
+    }
+
+    pTask->mTaskDetaching = false;
+    Atomic::Barrier();
+    pTask->mTaskState = TASK_IDLE;
+    Atomic::Add(&mTaskCount, 1);
+
+    #ifdef TS_DEBUG
+        LOG(LOG_VERBOSE, "Attached task %s with priority %d, tasks: %d", pTask->mTaskName.c_str(), pTask->mTaskPriority, mTaskCount);
+    #endif
+}
+
+void TaskScheduler::Detach(Task *pTask)
+{
+    if (pTask->mTaskState == TASK_DETACHED)
+        return;
+
+    mDetachMutex.lock();
+
+    // a queued task is dropped by the worker which fetches it, a running task is finished before
+    pTask->mTaskDetaching = true;
+    Atomic::Barrier();
+    while (!Atomic::CompareAndSwap(&pTask->mTaskState, TASK_IDLE, TASK_DETACHED))
+        mDetachCondition.Wait(&mDetachMutex);
+
+    mDetachMutex.unlock();
+
+    Atomic::Add(&mTaskCount, -1);
+
+    #ifdef TS_DEBUG
+        LOG(LOG_VERBOSE, "Detached task %s, tasks: %d", pTask->mTaskName.c_str(), mTaskCount);
+    #endif
+}
+
+void TaskScheduler::Trigger(Task *pTask)
+{
+    while (!pTask->mTaskDetaching)
+    {
+        switch(pTask->mTaskState)
+        {
+            case TASK_IDLE:
+                if (Atomic::CompareAndSwap(&pTask->mTaskState, TASK_IDLE, TASK_QUEUED))
+                {
+                    Enqueue(pTask, GetCurrentWorker());
+                    return;
+                }
+                break;
+            case TASK_RUNNING:
+                // the executing worker queues the task again when it is done
+                if (Atomic::CompareAndSwap(&pTask->mTaskState, TASK_RUNNING, TASK_RUNNING_TRIGGERED))
+                    return;
+                break;
+            default:
+                // detached, already queued or already triggered
+                return;
+        }
+    }
+}
+
+void TaskScheduler::Enqueue(Task *pTask, int pWorker)
+{
+    // tasks triggered by a worker stay at its core, all others are distributed
+    if (pWorker < 0)
+        pWorker = (int)((unsigned int)(Atomic::Add(&mNextWorker, 1) - 1) % mWorkers.size());
+
+    TaskWorker *tWorker = mWorkers[pWorker];
+    pTask->mTaskQueueTime = Time::GetTimeStamp();
+
+    // the counter is incremented before the idle workers are checked, an idle worker checks them in reverse order
+    Atomic::Add(&mQueuedTasks[pTask->mTaskPriority], 1);
+
+    tWorker->mQueueMutex.lock();
+    tWorker->mQueues[pTask->mTaskPriority].push_back(pTask);
+    tWorker->mQueueMutex.unlock();
+
+    if (mIdleWorkers > 0)
+    {
+        mIdleMutex.lock();
+        mIdleCondition.SignalOne();
+        mIdleMutex.unlock();
+    }
+}
+
+int TaskScheduler::GetCurrentWorker()
+{
+    int tThreadId = Thread::GetTId();
+
+    for (unsigned int i = 0; i < mWorkers.size(); i++)
+    {
+        if (mWorkers[i]->mThreadId == tThreadId)
+            return (int)i;
+    }
+
+    return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Task* TaskScheduler::FetchTask(int pWorker)
+{
+    Task *tResult = NULL;
+    int tWorkers = (int)mWorkers.size();
+
+    // a waiting task of a higher priority is preferred even if it has to be stolen from another worker
+    for (int tPriority = 0; tPriority < TASK_PRIORITIES; tPriority++)
+    {
+        if (mQueuedTasks[tPriority] == 0)
+            continue;
+
+        for (int i = 0; (i < tWorkers) && (tResult == NULL); i++)
+        {
+            TaskWorker *tWorker = mWorkers[(pWorker + i) % tWorkers];
+            tWorker->mQueueMutex.lock();
+            if (!tWorker->mQueues[tPriority].empty())
+            {
+                if (i == 0)
+                {
+                    tResult = tWorker->mQueues[tPriority].front();
+                    tWorker->mQueues[tPriority].pop_front();
+                }else
+                {
+                    tResult = tWorker->mQueues[tPriority].back();
+                    tWorker->mQueues[tPriority].pop_back();
+                    mWorkers[pWorker]->mStolenTasks++;
+                }
+            }
+            tWorker->mQueueMutex.unlock();
+        }
+
+        if (tResult != NULL)
+        {
+            Atomic::Add(&mQueuedTasks[tPriority], -1);
+            break;
+        }
+    }
+
+    return tResult;
+}
+
+void TaskScheduler::WaitForTask()
+{
+    mIdleMutex.lock();
+
+    Atomic::Add(&mIdleWorkers, 1);
+    while ((mSchedulerNeeded) && (mQueuedTasks[TASK_PRIORITY_AUDIO] == 0) && (mQueuedTasks[TASK_PRIORITY_VIDEO] == 0) && (mQueuedTasks[TASK_PRIORITY_STATISTIC] == 0))
+        mIdleCondition.Wait(&mIdleMutex);
+    Atomic::Add(&mIdleWorkers, -1);
+
+    mIdleMutex.unlock();
+}
+
+void TaskScheduler::ExecuteTask(Task *pTask, int pWorker)
+{
+    TaskWorker *tWorker = mWorkers[pWorker];
+    bool tMoreWork = false;
+
+    if (!pTask->mTaskDetaching)
+    {
+        Atomic::Exchange(&pTask->mTaskState, TASK_RUNNING);
+
+        int64_t tLatency = Time::GetTimeStamp() - pTask->mTaskQueueTime;
+        tWorker->mAverageLatency[pTask->mTaskPriority] = (1 - TASK_SCHEDULER_LATENCY_WEIGHT) * tWorker->mAverageLatency[pTask->mTaskPriority] + TASK_SCHEDULER_LATENCY_WEIGHT * tLatency;
+        #ifdef TS_DEBUG
+            LOG(LOG_VERBOSE, "Worker %d executes task %s after %ld us in queue", pWorker, pTask->mTaskName.c_str(), tLatency);
+        #endif
+
+        tMoreWork = pTask->Execute();
+        tWorker->mExecutedTasks++;
+    }
+
+    if (!pTask->mTaskDetaching)
+    {
+        // a trigger during the execution leads to another run
+        if ((!tMoreWork) && (Atomic::CompareAndSwap(&pTask->mTaskState, TASK_RUNNING, TASK_IDLE)))
+        {
+            // a detach request could have missed the idle state
+            if (pTask->mTaskDetaching)
+            {
+                mDetachMutex.lock();
+                mDetachCondition.SignalAll();
+                mDetachMutex.unlock();
+            }
+            return;
+        }
+
+        Atomic::Exchange(&pTask->mTaskState, TASK_QUEUED);
+        Enqueue(pTask, pWorker);
+    }else
+    {
+        // release the task for the waiting detach request
+        mDetachMutex.lock();
+        Atomic::Exchange(&pTask->mTaskState, TASK_IDLE);
+        mDetachCondition.SignalAll();
+        mDetachMutex.unlock();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int TaskScheduler::GetThreadCount()
+{
+    return (int)mWorkers.size();
+}
+
+int TaskScheduler::GetTaskCount()
+{
+    return mTaskCount;
+}
+
+int TaskScheduler::GetQueuedTasks(enum TaskPriority pPriority)
+{
+    return mQueuedTasks[pPriority];
+}
+
+int TaskScheduler::GetAverageLatency(enum TaskPriority pPriority)
+{
+    double tResult = 0;
+
+    if (mWorkers.size() == 0)
+        return 0;
+
+    for (unsigned int i = 0; i < mWorkers.size(); i++)
+        tResult += mWorkers[i]->mAverageLatency[pPriority];
+
+    return (int)(tResult / mWorkers.size());
+}
+
+int64_t TaskScheduler::GetExecutedTasks()
+{
+    int64_t tResult = 0;
+
+    for (unsigned int i = 0; i < mWorkers.size(); i++)
+        tResult += mWorkers[i]->mExecutedTasks;
+
+    return tResult;
+}
+
+int64_t TaskScheduler::GetStolenTasks()
+{
+    int64_t tResult = 0;
+
+    for (unsigned int i = 0; i < mWorkers.size(); i++)
+        tResult += mWorkers[i]->mStolenTasks;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
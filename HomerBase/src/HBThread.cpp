@@ -26,6 +26,7 @@
  */
 
 #include <HBThread.h>
+#include <HBMutex.h>
 #include <HBSystem.h>
 #include <Logger.h>
 
@@ -41,6 +42,8 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
 #endif
 
 #ifdef APPLE
@@ -55,6 +58,20 @@ using namespace std;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static const char *sThreadRoleNames[THREAD_ROLES] = { "default", "audio-io", "video-codec", "network", "housekeeping" };
+
+// audio threads get the CPU before anything else, otherwise GUI repaints and statistic polling cause audio dropouts
+static ThreadPolicy sThreadPolicies[THREAD_ROLES] = {
+    /* default */       {  0, false,   0, THREAD_CORES_ALL },
+    /* audio-io */      { 70, false, -15, THREAD_CORES_AUDIO },
+    /* video-codec */   {  0, false,   0, THREAD_CORES_SHARED },
+    /* network */       { 50, true,   -5, THREAD_CORES_SHARED },
+    /* housekeeping */  {  0, false,  10, THREAD_CORES_SHARED }
+};
+static Mutex sThreadPoliciesMutex;
+
+///////////////////////////////////////////////////////////////////////////////
+
 Thread::Thread()
 {
 	mRunning = false;
@@ -892,4 +909,172 @@ bool Thread::IsRunning()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool Thread::SetScheduling(int pRealTimePriority, bool pRoundRobin, int pNice, string &pDescription)
+{
+    #if defined(LINUX) || defined(APPLE) || defined(BSD)
+        struct sched_param tParam;
+        int tRes;
+
+        memset(&tParam, 0, sizeof(tParam));
+        if (pRealTimePriority > 0)
+        {
+            tParam.sched_priority = pRealTimePriority;
+            if ((tRes = pthread_setschedparam(pthread_self(), pRoundRobin ? SCHED_RR : SCHED_FIFO, &tParam)) == 0)
+            {
+                pDescription = (pRoundRobin ? "rr(" : "fifo(") + toString(pRealTimePriority) + ")";
+                return true;
+            }
+            LOGEX(Thread, LOG_VERBOSE, "Real-time scheduling with priority %d isn't permitted because \"%s\", falling back to nice %d", pRealTimePriority, strerror(tRes), pNice);
+        }else
+        {
+            // leave a real-time class which was assigned before
+            pthread_setschedparam(pthread_self(), SCHED_OTHER, &tParam);
+        }
+
+        #if defined(LINUX)
+            // linux schedules each thread as separate task, the nice value applies only to the calling thread
+            if (setpriority(PRIO_PROCESS, GetTId(), pNice) == 0)
+            {
+                pDescription = "nice(" + toString(pNice) + ")";
+                return true;
+            }
+            LOGEX(Thread, LOG_WARN, "Failed to set nice value %d because \"%s\"", pNice, strerror(errno));
+        #endif
+
+        pDescription = "default";
+        return ((pRealTimePriority == 0) && (pNice == 0));
+    #endif
+    #ifdef WIN32
+        int tPriority = THREAD_PRIORITY_NORMAL;
+        if (pRealTimePriority >= 50)
+            tPriority = THREAD_PRIORITY_TIME_CRITICAL;
+        else if (pRealTimePriority > 0)
+            tPriority = THREAD_PRIORITY_HIGHEST;
+        else if (pNice < 0)
+            tPriority = THREAD_PRIORITY_ABOVE_NORMAL;
+        else if (pNice > 0)
+            tPriority = THREAD_PRIORITY_BELOW_NORMAL;
+
+        if (!SetThreadPriority(GetCurrentThread(), tPriority))
+        {
+            LOGEX(Thread, LOG_WARN, "Failed to set thread priority %d", tPriority);
+            pDescription = "default";
+            return false;
+        }
+        pDescription = "priority(" + toString(tPriority) + ")";
+        return true;
+    #endif
+}
+
+bool Thread::SetAffinity(enum ThreadCores pCores, string &pDescription)
+{
+    int tCores = System::GetMachineCores();
+    int tFirstCore = 0;
+    int tLastCore = tCores - 1;
+
+    // a core is reserved for audio only if enough cores are left for all other threads
+    if (tCores >= THREAD_AUDIO_CORE_MIN_CORES)
+    {
+        switch(pCores)
+        {
+            case THREAD_CORES_AUDIO:
+                tFirstCore = tLastCore;
+                break;
+            case THREAD_CORES_SHARED:
+                tLastCore--;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (tFirstCore == tLastCore)
+        pDescription = "core " + toString(tFirstCore);
+    else
+        pDescription = "cores " + toString(tFirstCore) + "-" + toString(tLastCore);
+
+    #if defined(LINUX)
+        cpu_set_t tCpuSet;
+        CPU_ZERO(&tCpuSet);
+        for (int i = tFirstCore; i <= tLastCore; i++)
+            CPU_SET(i, &tCpuSet);
+        int tRes;
+        if ((tRes = pthread_setaffinity_np(pthread_self(), sizeof(tCpuSet), &tCpuSet)) != 0)
+        {
+            LOGEX(Thread, LOG_WARN, "Failed to bind thread to %s because \"%s\"", pDescription.c_str(), strerror(tRes));
+            pDescription = "all cores";
+            return false;
+        }
+        return true;
+    #endif
+    #if defined(APPLE) || defined(BSD)
+        // no binding to cores available
+        pDescription = "all cores";
+        return (pCores == THREAD_CORES_ALL);
+    #endif
+    #ifdef WIN32
+        DWORD_PTR tMask = 0;
+        for (int i = tFirstCore; i <= tLastCore; i++)
+            tMask |= ((DWORD_PTR)1) << i;
+        if (SetThreadAffinityMask(GetCurrentThread(), tMask) == 0)
+        {
+            LOGEX(Thread, LOG_WARN, "Failed to bind thread to %s", pDescription.c_str());
+            pDescription = "all cores";
+            return false;
+        }
+        return true;
+    #endif
+}
+
+bool Thread::ApplyRole(enum ThreadRole pRole, string &pDescription)
+{
+    ThreadPolicy tPolicy = GetRolePolicy(pRole);
+    string tScheduling, tCores;
+    bool tResult = true;
+
+    if (!SetScheduling(tPolicy.RealTimePriority, tPolicy.RoundRobin, tPolicy.Nice, tScheduling))
+        tResult = false;
+    if (!SetAffinity(tPolicy.Cores, tCores))
+        tResult = false;
+
+    pDescription = GetRoleName(pRole) + ": " + tScheduling + ", " + tCores;
+    LOGEX(Thread, LOG_VERBOSE, "Thread %d got policy %s", GetTId(), pDescription.c_str());
+
+    return tResult;
+}
+
+string Thread::GetRoleName(enum ThreadRole pRole)
+{
+    if ((pRole < 0) || (pRole >= THREAD_ROLES))
+        return "unknown";
+
+    return sThreadRoleNames[pRole];
+}
+
+ThreadPolicy Thread::GetRolePolicy(enum ThreadRole pRole)
+{
+    ThreadPolicy tResult;
+
+    if ((pRole < 0) || (pRole >= THREAD_ROLES))
+        pRole = THREAD_ROLE_DEFAULT;
+
+    sThreadPoliciesMutex.lock();
+    tResult = sThreadPolicies[pRole];
+    sThreadPoliciesMutex.unlock();
+
+    return tResult;
+}
+
+void Thread::SetRolePolicy(enum ThreadRole pRole, ThreadPolicy pPolicy)
+{
+    if ((pRole < 0) || (pRole >= THREAD_ROLES))
+        return;
+
+    sThreadPoliciesMutex.lock();
+    sThreadPolicies[pRole] = pPolicy;
+    sThreadPoliciesMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} //namespace
@@ -32,11 +32,12 @@
 #include <SDP.h>
 #include <SIP.h>
 #include <MeetingEvents.h>
-#include <HBMutex.h>
+#include <HBReadWriteMutex.h>
 #include <HBSocket.h>
 
 #include <string>
 #include <list>
+#include <map>
 
 using namespace Homer::Base;
 
@@ -81,6 +82,8 @@ struct SessionInfo
 
 struct ParticipantDescriptor;
 typedef std::list<ParticipantDescriptor>  ParticipantList;
+typedef std::multimap<std::string, ParticipantList::iterator> ParticipantIndex;
+typedef std::map<nua_handle_t*, ParticipantList::iterator> NuaHandleIndex;
 typedef std::list<std::string>            LocalAddressesList;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -139,6 +142,7 @@ public:
     bool SendCallDeny(std::string pParticipant, enum TransportType pParticipantTransport);
     bool SendHangUp(std::string pParticipant, enum TransportType pParticipantTransport);
     bool SendProbe(std::string pParticipant, enum TransportType pParticipantTransport);
+    bool SendPresenceSubscription(std::string pParticipant, enum TransportType pParticipantTransport);
 
 private:
     friend class SIP;
@@ -153,12 +157,22 @@ private:
     bool SearchParticipantAndSetRemoteMediaInformation(std::string pParticipant, enum TransportType pParticipantTransport, std::string pVideoHost, unsigned int pVideoPort, std::string pVideoCodec, std::string pAudioHost, unsigned int pAudioPort, std::string pAudioCodec);
     nua_handle_t ** SearchParticipantAndGetNuaHandleForCalls(string pParticipant, enum TransportType pParticipantTransport);
     bool SearchParticipantByNuaHandleOrName(string &pUser, string &pHost, string &pPort, nua_handle_t *pNuaHandle);
+    void SetNuaHandle(nua_handle_t **pHandlePtr, nua_handle_t *pNuaHandle);
+
+    /* participant index, caller has to hold mParticipantsMutex */
+    static std::string CreateParticipantIndexKey(std::string pHost, std::string pPort);
+    ParticipantList::iterator SearchParticipant(std::string pUser, std::string pHost, std::string pPort, enum TransportType pTransport);
+    ParticipantList::iterator SearchParticipant(std::string pParticipant, enum TransportType pParticipantTransport);
+    void UpdateNuaHandleIndex(nua_handle_t **pHandlePtr, nua_handle_t *pNuaHandle, ParticipantList::iterator pParticipant);
+    void RemoveParticipantFromIndex(ParticipantList::iterator pParticipant);
 
     const char* GetSdpData(std::string pParticipant, enum TransportType pParticipantTransport);
     std::string CallStateAsString(int pCallState);
 
-    Mutex               mParticipantsMutex;
+    ReadWriteMutex      mParticipantsMutex;
     ParticipantList     mParticipants;
+    ParticipantIndex    mParticipantsIndex; // remote participants by host and port
+    NuaHandleIndex      mParticipantsByNuaHandle; // remote participants by their call/message NUA handles
     LocalAddressesList  mLocalAddresses;
     std::string         mOwnName;
     std::string         mOwnMail;
@@ -62,6 +62,9 @@ namespace Homer { namespace Conference {
 #define OPTIONS                                 500 // receive options from SIP server
 #define OPTIONS_ACCEPT                          510 // options from SIP server available
 #define OPTIONS_UNAVAILABLE                     520 // options from SIP server unavailable (server unavailable!)
+#define SUBSCRIPTION_PRESENCE                   600 // subscribe to presence state of SIP peer
+#define SUBSCRIPTION_PRESENCE_NOTIFY            610 // presence state of SIP peer was notified
+#define SUBSCRIPTION_PRESENCE_UNAVAILABLE       620 // presence subscription rejected or terminated by SIP peer
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -96,6 +99,12 @@ public:
                 return "Options from SIP peer delivered";
             case OPTIONS_UNAVAILABLE:
                 return "Options from SIP peer unavailable";
+            case SUBSCRIPTION_PRESENCE:
+                return "Presence subscription of SIP peer";
+            case SUBSCRIPTION_PRESENCE_NOTIFY:
+                return "Presence notification from SIP peer";
+            case SUBSCRIPTION_PRESENCE_UNAVAILABLE:
+                return "Presence subscription of SIP peer unavailable";
             case GENERAL_ERROR:
                 return "General Error";
             case MESSAGE:
@@ -199,6 +208,28 @@ public:
     string  Description;
 };
 
+class SubscriptionPresenceEvent:
+    public TEvent<SubscriptionPresenceEvent, SUBSCRIPTION_PRESENCE>
+{
+public:
+};
+
+class SubscriptionPresenceNotifyEvent:
+    public TEvent<SubscriptionPresenceNotifyEvent, SUBSCRIPTION_PRESENCE_NOTIFY>
+{
+public:
+    bool    Available;
+    string  StateNote;
+};
+
+class SubscriptionPresenceUnavailableEvent:
+    public TEvent<SubscriptionPresenceUnavailableEvent, SUBSCRIPTION_PRESENCE_UNAVAILABLE>
+{
+public:
+    int     StatusCode; // 0 if the peer terminated an established subscription
+    string  Description;
+};
+
 class ErrorEvent:
     public TEvent<ErrorEvent, GENERAL_ERROR>
 {
@@ -351,6 +382,19 @@ typedef std::list<GeneralEvent*>	MeetingEventList;
 
 //////////////////////////////////////////////////////////////////////////////
 
+class EventManagerObserver
+{
+public:
+    EventManagerObserver() { }
+
+    virtual ~EventManagerObserver() { }
+
+    /* called from the firing thread after a new event was queued */
+    virtual void handleEventFired() = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
 #define MEETING_EVENT_QUEUE_LENGTH    2048
 class EventManager
 {
@@ -362,9 +406,13 @@ public:
     bool Fire(GeneralEvent* pEvent); // false if queue is full
     GeneralEvent* Scan();
 
+    void AddObserver(EventManagerObserver *pObserver);
+    void DeleteObserver(EventManagerObserver *pObserver);
+
 private:
     Mutex               mEventsMutex;
     MeetingEventList    mEvents;
+    EventManagerObserver *mEventManagerObserver;
     //GeneralEvent        *mEvents[MEETING_EVENT_QUEUE_LENGTH];
     int                 mRemainingEvents;
 };
@@ -45,6 +45,7 @@ public:
 protected:
     std::string GetMimeFormatPidf();
     sip_payload_t* CreatePresenceInPidf(su_home_t* pHome, std::string pUsername, std::string pServer, std::string pStatusNote = "online", bool pAcceptInstantMessages = true);
+    bool ParsePresenceFromPidf(const char *pData, int pSize, bool &pAvailable, std::string &pStateNote);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -36,6 +36,7 @@
 #include <PIDF.h>
 
 #include <string>
+#include <list>
 
 using namespace Homer::Base;
 
@@ -65,11 +66,12 @@ enum AvailabilityState{
 };
 
 struct SipContext;
+typedef std::list<nua_handle_t*> PresenceSubscribers;
 
 ///////////////////////////////////////////////////////////////////////////////
 
 class SIP:
-    public SIP_stun, public PIDF, public Thread
+    public SIP_stun, public PIDF, public Thread, public EventManagerObserver
 {
 public:
     SIP();
@@ -101,6 +103,8 @@ public:
 
     /* SIP call back */
     void SipCallBack(int pEvent, int pStatus, char const *pPhrase, nua_t *pNua, nua_magic_t *pMagic, nua_handle_t *pNuaHandle, nua_hmagic_t *pHMagic, sip_t const *pSip, void* pTags);
+    /* SIP wake up call back, executed within the SIP main loop */
+    void SipWakeUpCallBack();
 
 private:
     /* main SIP event loop handling */
@@ -151,6 +155,12 @@ protected:
         void SipReceivedOptionsResponseAccept(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, sip_t const *pSip, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
         void SipReceivedOptionsResponseUnavailable(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
         /* */
+    void SipReceivedPresenceSubscription(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, sip_t const *pSip, void* pTags, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
+    void SipReceivedPresenceSubscriptionResponse(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, void* pTags, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
+    void SipReceivedPresenceNotify(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, sip_t const *pSip, void* pTags, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
+        /* helper for "presence subscription */
+        void SipReceivedPresenceUnavailable(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
+        /* */
     void SipReceivedShutdownResponse(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, sip_t const *pSip, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
     void SipReceivedRegisterResponse(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
     void SipReceivedPublishResponse(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport);
@@ -163,8 +173,16 @@ protected:
     void SipSendCallDeny(CallDenyEvent *pCDEvent);
     void SipSendCallHangUp(CallHangUpEvent *pCHUEvent);
     void SipSendOptionsRequest(OptionsEvent *pOEvent);
+    void SipSendPresenceSubscription(SubscriptionPresenceEvent *pSPEvent);
+    void SipSendPresenceNotify(nua_handle_t *pNuaHandle);
+    void SipSendPresenceNotifications();
     void SipProcessOutgoingEvents();
 
+    /* wake up of main loop */
+    virtual void handleEventFired();
+    void SipWakeUpMainLoop();
+    void SipDestroyRoot();
+
     /* auth support */
     string CreateAuthInfo(sip_t const *pSip);
 
@@ -173,6 +191,11 @@ protected:
     void SipLogoutAtServer();
 
     EventManager        mOutgoingEvents; // from users point of view
+    Mutex               mSipRootMutex; // protects mSipContext->Root against destruction while other threads send wake up messages
+    bool                mSipWakeUpPending;
+    bool                mSipPresenceNotificationPending; // presence subscribers have to be informed about a new availability state
+    bool                mSipPresenceNotifiedAvailable; // availability which was sent to the presence subscribers last, used only within SIP main loop
+    PresenceSubscribers mSipPresenceSubscribers; // notifier handles of remote presence subscribers, used only within SIP main loop
     enum AvailabilityState mAvailabilityState;
     SipContext          *mSipContext;
     std::string         mSipHostAdr;
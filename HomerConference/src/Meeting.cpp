@@ -347,6 +347,100 @@ string Meeting::GetServerConferenceId()
     return tResult;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+string Meeting::CreateParticipantIndexKey(string pHost, string pPort)
+{
+    // user and transport are checked by IsThisParticipant() for the few candidates with the same key
+    return pHost + "|" + pPort;
+}
+
+// caller has to hold mParticipantsMutex
+ParticipantList::iterator Meeting::SearchParticipant(string pUser, string pHost, string pPort, enum TransportType pTransport)
+{
+    pair<ParticipantIndex::iterator, ParticipantIndex::iterator> tRange = mParticipantsIndex.equal_range(CreateParticipantIndexKey(pHost, pPort));
+    for (ParticipantIndex::iterator tIndexIt = tRange.first; tIndexIt != tRange.second; tIndexIt++)
+    {
+        ParticipantList::iterator tIt = tIndexIt->second;
+        if (IsThisParticipant(pUser, pHost, pPort, pTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
+            return tIt;
+    }
+
+    return mParticipants.end();
+}
+
+// caller has to hold mParticipantsMutex
+ParticipantList::iterator Meeting::SearchParticipant(string pParticipant, enum TransportType pParticipantTransport)
+{
+    string tUser, tHost, tPort;
+    if (!SplitParticipantName(pParticipant, tUser, tHost, tPort))
+    {
+        LOG(LOG_ERROR, "Could not split participant name into its parts");
+        return mParticipants.end();
+    }
+
+    return SearchParticipant(tUser, tHost, tPort, pParticipantTransport);
+}
+
+// caller has to hold mParticipantsMutex in write mode
+void Meeting::UpdateNuaHandleIndex(nua_handle_t **pHandlePtr, nua_handle_t *pNuaHandle, ParticipantList::iterator pParticipant)
+{
+    if (*pHandlePtr != NULL)
+    {
+        NuaHandleIndex::iterator tHandleIt = mParticipantsByNuaHandle.find(*pHandlePtr);
+        if ((tHandleIt != mParticipantsByNuaHandle.end()) && (tHandleIt->second == pParticipant))
+            mParticipantsByNuaHandle.erase(tHandleIt);
+    }
+
+    *pHandlePtr = pNuaHandle;
+
+    if (pNuaHandle != NULL)
+        mParticipantsByNuaHandle[pNuaHandle] = pParticipant;
+}
+
+// caller has to hold mParticipantsMutex in write mode
+void Meeting::RemoveParticipantFromIndex(ParticipantList::iterator pParticipant)
+{
+    pair<ParticipantIndex::iterator, ParticipantIndex::iterator> tRange = mParticipantsIndex.equal_range(CreateParticipantIndexKey(pParticipant->Host, pParticipant->Port));
+    for (ParticipantIndex::iterator tIndexIt = tRange.first; tIndexIt != tRange.second; tIndexIt++)
+    {
+        if (tIndexIt->second == pParticipant)
+        {
+            mParticipantsIndex.erase(tIndexIt);
+            break;
+        }
+    }
+
+    UpdateNuaHandleIndex(&pParticipant->SipNuaHandleForCalls, NULL, pParticipant);
+    UpdateNuaHandleIndex(&pParticipant->SipNuaHandleForMsgs, NULL, pParticipant);
+}
+
+void Meeting::SetNuaHandle(nua_handle_t **pHandlePtr, nua_handle_t *pNuaHandle)
+{
+    ParticipantList::iterator tIt;
+
+    // lock
+    mParticipantsMutex.lockWrite();
+
+    // find the descriptor which owns the given handle pointer
+    for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+    {
+        if ((pHandlePtr == &tIt->SipNuaHandleForCalls) || (pHandlePtr == &tIt->SipNuaHandleForMsgs))
+        {
+            UpdateNuaHandleIndex(pHandlePtr, pNuaHandle, tIt);
+            break;
+        }
+    }
+
+    if (tIt == mParticipants.end())
+        LOG(LOG_WARN, "Given NUA handle pointer doesn't belong to a known participant");
+
+    // unlock
+    mParticipantsMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool Meeting::OpenParticipantSession(string pUser, string pHost, string pPort, enum TransportType pTransport)
 {
     bool        tFound = false;
@@ -354,17 +448,13 @@ bool Meeting::OpenParticipantSession(string pUser, string pHost, string pPort, e
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is this user already involved in the conference?
-    for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+    if (SearchParticipant(pUser, pHost, pPort, pTransport) != mParticipants.end())
     {
-        LOG(LOG_VERBOSE, "CompareForOpen: \"%s\" with \"%s\" and state: %d", (pUser + "@" + pHost + ":" + pPort).c_str(), (tIt->User + "@" + tIt->Host + ":" + tIt->Port).c_str(), tIt->CallState);
-        if (IsThisParticipant(pUser, pHost, pPort, pTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-        {
-            LOG(LOG_VERBOSE, "...found");
-            tFound = true;
-        }
+        LOG(LOG_VERBOSE, "...found %s", (pUser + "@" + pHost + ":" + pPort).c_str());
+        tFound = true;
     }
 
     if (!tFound)
@@ -475,7 +565,12 @@ bool Meeting::OpenParticipantSession(string pUser, string pHost, string pPort, e
 				mVideoAudioStartPort = tParticipantDescriptor.AudioReceiveSocket->GetLocalPort() + 2;
 		}
 
-        mParticipants.push_back(tParticipantDescriptor);
+        tParticipantDescriptor.SipNuaHandleForCalls = NULL;
+        tParticipantDescriptor.SipNuaHandleForMsgs = NULL;
+        tParticipantDescriptor.SipNuaHandleForOptions = NULL;
+
+        tIt = mParticipants.insert(mParticipants.end(), tParticipantDescriptor);
+        mParticipantsIndex.insert(ParticipantIndex::value_type(CreateParticipantIndexKey(pHost, pPort), tIt));
 
     }else
         LOG(LOG_VERBOSE, "Participant session already exists, open request ignored");
@@ -492,34 +587,32 @@ bool Meeting::CloseParticipantSession(string pParticipant, enum TransportType pP
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
-    for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+    tIt = SearchParticipant(pParticipant, pParticipantTransport);
+    if (tIt != mParticipants.end())
     {
-        if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-        {
-            // hint: the media sources are deleted within video/audio-widget
-
-            #if defined(WIN32) || defined(APPLE) || defined(BSD)
-                // delete video/audio sockets
-                delete (*tIt).VideoSendSocket;
-                delete (*tIt).AudioSendSocket;
-                delete (*tIt).VideoReceiveSocket;
-                delete (*tIt).AudioReceiveSocket;
-            #else
-                // delete video/audio sockets
-                delete (*tIt).VideoReceiveSocket;
-                delete (*tIt).AudioReceiveSocket;
-                delete (*tIt).VideoSendSocket;
-                delete (*tIt).AudioSendSocket;
-            #endif
+        // hint: the media sources are deleted within video/audio-widget
+
+        #if defined(WIN32) || defined(APPLE) || defined(BSD)
+            // delete video/audio sockets
+            delete (*tIt).VideoSendSocket;
+            delete (*tIt).AudioSendSocket;
+            delete (*tIt).VideoReceiveSocket;
+            delete (*tIt).AudioReceiveSocket;
+        #else
+            // delete video/audio sockets
+            delete (*tIt).VideoReceiveSocket;
+            delete (*tIt).AudioReceiveSocket;
+            delete (*tIt).VideoSendSocket;
+            delete (*tIt).AudioSendSocket;
+        #endif
 
-            // remove element from participants list
-            tIt = mParticipants.erase(tIt);
+        // remove element from participants list and its index entries
+        RemoveParticipantFromIndex(tIt);
+        tIt = mParticipants.erase(tIt);
 
-            tFound = true;
-            break;
-        }
+        tFound = true;
     }
 
     // unlock
@@ -542,7 +635,7 @@ int Meeting::CountParticipantSessions()
     int tResult = 0;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     tResult = mParticipants.size();
 
@@ -560,7 +653,7 @@ bool Meeting::SendBroadcastMessage(string pMessage)
     LOG(LOG_VERBOSE, "Sending broadcast message");
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (mParticipants.size() > 1)
     {
@@ -599,21 +692,18 @@ bool Meeting::SendMessage(string pParticipant, enum TransportType pParticipantTr
     LOG(LOG_VERBOSE, "Sending message to: %s[%s]", pParticipant.c_str(), Socket::TransportType2String(pParticipantTransport).c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SendMessage()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                LOG(LOG_VERBOSE, "...found");
-                tFound = true;
-                tHandlePtr = &tIt->SipNuaHandleForMsgs;
-                break;
-            }
+            LOG(LOG_VERBOSE, "...found");
+            tFound = true;
+            tHandlePtr = &tIt->SipNuaHandleForMsgs;
         }
 
         if (tFound)
@@ -647,21 +737,18 @@ bool Meeting::SendCall(string pParticipant, enum TransportType pParticipantTrans
     ParticipantList::iterator tIt;
 //TODO: support broadcast, similar to SendMessage()
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SendCall()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if ((tIt != mParticipants.end()) && (tIt->CallState == CALLSTATE_STANDBY))
         {
-            if ((IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport)) && (tIt->CallState == CALLSTATE_STANDBY))
-            {
-                LOG(LOG_VERBOSE, "...found");
-                tFound = true;
-                tHandlePtr = &tIt->SipNuaHandleForCalls;
-                break;
-            }
+            LOG(LOG_VERBOSE, "...found");
+            tFound = true;
+            tHandlePtr = &tIt->SipNuaHandleForCalls;
         }
 
         if (tFound)
@@ -694,21 +781,18 @@ bool Meeting::SendCallAcknowledge(string pParticipant, enum TransportType pParti
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SendCallAcknowledge()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if ((tIt != mParticipants.end()) && (tIt->CallState == CALLSTATE_RINGING))
         {
-            if ((IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport)) && (tIt->CallState == CALLSTATE_RINGING))
-            {
-                tFound = true;
-                tHandlePtr = &tIt->SipNuaHandleForCalls;
-                LOG(LOG_VERBOSE, "...found");
-                break;
-            }
+            tFound = true;
+            tHandlePtr = &tIt->SipNuaHandleForCalls;
+            LOG(LOG_VERBOSE, "...found");
         }
 
         if (tFound)
@@ -739,19 +823,16 @@ bool Meeting::SendCallAccept(string pParticipant, enum TransportType pParticipan
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if ((tIt != mParticipants.end()) && (tIt->CallState == CALLSTATE_RINGING))
         {
-            if ((IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport)) && (tIt->CallState == CALLSTATE_RINGING))
-            {
-                tFound = true;
-                tHandlePtr = &tIt->SipNuaHandleForCalls;
-                break;
-            }
+            tFound = true;
+            tHandlePtr = &tIt->SipNuaHandleForCalls;
         }
 
         if (tFound)
@@ -782,19 +863,16 @@ bool Meeting::SendCallCancel(string pParticipant, enum TransportType pParticipan
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if ((tIt != mParticipants.end()) && (tIt->CallState == CALLSTATE_RINGING))
         {
-            if ((IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport)) && (tIt->CallState == CALLSTATE_RINGING))
-            {
-                tFound = true;
-                tHandlePtr = &tIt->SipNuaHandleForCalls;
-                break;
-            }
+            tFound = true;
+            tHandlePtr = &tIt->SipNuaHandleForCalls;
         }
 
         if (tFound)
@@ -825,19 +903,16 @@ bool Meeting::SendCallDeny(string pParticipant, enum TransportType pParticipantT
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if ((tIt != mParticipants.end()) && (tIt->CallState == CALLSTATE_RINGING))
         {
-            if ((IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport)) && (tIt->CallState == CALLSTATE_RINGING))
-            {
-                tFound = true;
-                tHandlePtr = &tIt->SipNuaHandleForCalls;
-                break;
-            }
+            tFound = true;
+            tHandlePtr = &tIt->SipNuaHandleForCalls;
         }
 
         if (tFound)
@@ -868,22 +943,19 @@ bool Meeting::SendHangUp(string pParticipant, enum TransportType pParticipantTra
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SendHangUp()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if ((tIt != mParticipants.end()) && (tIt->CallState == CALLSTATE_RUNNING))
         {
-            if ((IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport)) && (tIt->CallState == CALLSTATE_RUNNING))
-            {
-                tFound = true;
-                tIt->CallState = CALLSTATE_STANDBY;
-                tHandlePtr = &tIt->SipNuaHandleForCalls;
-                //LOG(LOG_VERBOSE, "...found");
-                break;
-            }
+            tFound = true;
+            tIt->CallState = CALLSTATE_STANDBY;
+            tHandlePtr = &tIt->SipNuaHandleForCalls;
+            //LOG(LOG_VERBOSE, "...found");
         }
 
         if (tFound)
@@ -912,7 +984,7 @@ bool Meeting::SendProbe(std::string pParticipant, enum TransportType pParticipan
     LOG(LOG_VERBOSE, "Probing: %s[%s]", pParticipant.c_str(), Socket::TransportType2String(pParticipantTransport).c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is participant user of the registered SIP server then acknowledge directly
     if ((pParticipant.find(mSipRegisterServer) != string::npos) && (GetServerRegistrationState()))
@@ -946,6 +1018,26 @@ bool Meeting::SendProbe(std::string pParticipant, enum TransportType pParticipan
     return true;
 }
 
+bool Meeting::SendPresenceSubscription(std::string pParticipant, enum TransportType pParticipantTransport)
+{
+    LOG(LOG_VERBOSE, "Subscribing presence of: %s[%s]", pParticipant.c_str(), Socket::TransportType2String(pParticipantTransport).c_str());
+
+    // users of the registered SIP server are reported as available via SendProbe(), there is nothing to subscribe
+    if ((pParticipant.find(mSipRegisterServer) != string::npos) && (GetServerRegistrationState()))
+        return false;
+
+    SubscriptionPresenceEvent *tSPEvent = new SubscriptionPresenceEvent();
+    tSPEvent->Sender = "sip:" + GetLocalConferenceId();
+    tSPEvent->SenderName = GetLocalUserName();
+    tSPEvent->SenderComment = "";
+    tSPEvent->Receiver = "sip:" + pParticipant;
+    tSPEvent->HandlePtr = NULL; // done within SIP class
+    tSPEvent->Transport = pParticipantTransport;
+    mOutgoingEvents.Fire((GeneralEvent*) tSPEvent);
+
+    return true;
+}
+
 const char* Meeting::GetSdpData(std::string pParticipant, enum TransportType pParticipantTransport)
 {
     const char *tResult = "";
@@ -957,38 +1049,38 @@ const char* Meeting::GetSdpData(std::string pParticipant, enum TransportType pPa
     LOG(LOG_VERBOSE, "GetSdp for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for GetSdpData()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
+            LOG(LOG_VERBOSE, "...found");
+            if (tIt->VideoReceiveSocket == NULL)
             {
-                LOG(LOG_VERBOSE, "...found");
-                if (tIt->VideoReceiveSocket == NULL)
-                {
-                    LOG(LOG_ERROR, "Found video socket reference is NULL");
-                    return tResult;
-                }
-                if (tIt->AudioReceiveSocket == NULL)
-                {
-                    LOG(LOG_ERROR, "Found audio socket reference is NULL");
-                    return tResult;
-                }
-                // ####################### get ports #############################
-                tLocalVideoPort = tIt->VideoReceiveSocket->GetLocalPort();
-                tLocalAudioPort = tIt->AudioReceiveSocket->GetLocalPort();
+                LOG(LOG_ERROR, "Found video socket reference is NULL");
+                mParticipantsMutex.unlock();
+                return tResult;
+            }
+            if (tIt->AudioReceiveSocket == NULL)
+            {
+                LOG(LOG_ERROR, "Found audio socket reference is NULL");
+                mParticipantsMutex.unlock();
+                return tResult;
+            }
+            // ####################### get ports #############################
+            tLocalVideoPort = tIt->VideoReceiveSocket->GetLocalPort();
+            tLocalAudioPort = tIt->AudioReceiveSocket->GetLocalPort();
 
-                // ##################### create SDP string #######################
-                // set sdp string
-                tIt->Sdp = CreateSdpData(tLocalAudioPort, tLocalVideoPort);
+            // ##################### create SDP string #######################
+            // set sdp string
+            tIt->Sdp = CreateSdpData(tLocalAudioPort, tLocalVideoPort);
 
-                tResult = tIt->Sdp.c_str();
-                LOG(LOG_VERBOSE, "VPort: %d\n APort: %d\n SDP: %s\n", tLocalVideoPort, tLocalAudioPort, tResult);
-            }
+            tResult = tIt->Sdp.c_str();
+            LOG(LOG_VERBOSE, "VPort: %d\n APort: %d\n SDP: %s\n", tLocalVideoPort, tLocalAudioPort, tResult);
         }
     }
 
@@ -1004,21 +1096,18 @@ bool Meeting::SearchParticipantAndSetState(string pParticipant, enum TransportTy
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SearchParticipantAndSetState()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                tIt->CallState = pState;
-                tFound = true;
-                LOG(LOG_VERBOSE, "...found");
-                break;
-            }
+            tIt->CallState = pState;
+            tFound = true;
+            LOG(LOG_VERBOSE, "...found");
         }
     }
 
@@ -1035,23 +1124,20 @@ bool Meeting::SearchParticipantAndSetOwnContactAddress(string pParticipant, enum
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SearchParticipantAndSetOwnContactAddress()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                tIt->OwnIp = pOwnNatIp;
-                tIt->OwnPort = pOwnNatPort;
-                tFound = true;
-                LOG(LOG_VERBOSE, "...found");
-                LOG(LOG_VERBOSE, "...set own contact address to: %s:%u", pOwnNatIp.c_str(), pOwnNatPort);
-                break;
-            }
+            tIt->OwnIp = pOwnNatIp;
+            tIt->OwnPort = pOwnNatPort;
+            tFound = true;
+            LOG(LOG_VERBOSE, "...found");
+            LOG(LOG_VERBOSE, "...set own contact address to: %s:%u", pOwnNatIp.c_str(), pOwnNatPort);
         }
     }
 
@@ -1067,21 +1153,18 @@ bool Meeting::SearchParticipantAndSetNuaHandleForMsgs(string pParticipant, enum
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SearchParticipantAndSetNuaHandleForMsgs()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                tIt->SipNuaHandleForMsgs = pNuaHandle;
-                tFound = true;
-                LOG(LOG_VERBOSE, "...found");
-                break;
-            }
+            UpdateNuaHandleIndex(&tIt->SipNuaHandleForMsgs, pNuaHandle, tIt);
+            tFound = true;
+            LOG(LOG_VERBOSE, "...found");
         }
     }
 
@@ -1097,21 +1180,18 @@ bool Meeting::SearchParticipantAndSetNuaHandleForCalls(string pParticipant, enum
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SearchParticipantAndSetNuaHandleForCalls()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                tIt->SipNuaHandleForCalls = pNuaHandle;
-                tFound = true;
-                LOG(LOG_VERBOSE, "...found");
-                break;
-            }
+            UpdateNuaHandleIndex(&tIt->SipNuaHandleForCalls, pNuaHandle, tIt);
+            tFound = true;
+            LOG(LOG_VERBOSE, "...found");
         }
     }
 
@@ -1127,20 +1207,17 @@ nua_handle_t** Meeting::SearchParticipantAndGetNuaHandleForCalls(string pPartici
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SearchParticipantAndGetNuaHandleForCalls()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                tResult = &tIt->SipNuaHandleForCalls;
-                LOG(LOG_VERBOSE, "...found");
-                break;
-            }
+            tResult = &tIt->SipNuaHandleForCalls;
+            LOG(LOG_VERBOSE, "...found");
         }
     }
 
@@ -1156,24 +1233,38 @@ bool Meeting::SearchParticipantByNuaHandleOrName(string &pUser, string &pHost, s
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        // search by NUA handle
+        tIt = mParticipants.end();
+        NuaHandleIndex::iterator tHandleIt = mParticipantsByNuaHandle.find(pNuaHandle);
+        if (tHandleIt != mParticipantsByNuaHandle.end())
+            tIt = tHandleIt->second;
+        else
         {
-            LOG(LOG_VERBOSE, "CompareForSearchByHandle: candidate \"%s\"", SipCreateId(tIt->User, tIt->Host, tIt->Port).c_str());
-            if ((tIt->SipNuaHandleForCalls == pNuaHandle) || (tIt->SipNuaHandleForMsgs == pNuaHandle) || ((pUser == tIt->User) && (pHost == tIt->Host) && (pPort == tIt->Port)))
+            // search by name
+            pair<ParticipantIndex::iterator, ParticipantIndex::iterator> tRange = mParticipantsIndex.equal_range(CreateParticipantIndexKey(pHost, pPort));
+            for (ParticipantIndex::iterator tIndexIt = tRange.first; tIndexIt != tRange.second; tIndexIt++)
             {
-                pUser = tIt->User;
-                pHost = tIt->Host;
-                pPort = tIt->Port;
-                tFound = true;
-                LOG(LOG_VERBOSE, "...found");
-                break;
+                if (tIndexIt->second->User == pUser)
+                {
+                    tIt = tIndexIt->second;
+                    break;
+                }
             }
         }
+
+        if (tIt != mParticipants.end())
+        {
+            pUser = tIt->User;
+            pHost = tIt->Host;
+            pPort = tIt->Port;
+            tFound = true;
+            LOG(LOG_VERBOSE, "...found");
+        }
     }
 
     // unlock
@@ -1188,28 +1279,25 @@ bool Meeting::SearchParticipantAndSetRemoteMediaInformation(std::string pPartici
     ParticipantList::iterator tIt;
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockWrite();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for SearchParticipantAndSetRemoteMediaInformation()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                tIt->RemoteVideoHost = pVideoHost;
-                tIt->RemoteVideoPort = pVideoPort;
-                tIt->RemoteVideoCodec = pVideoCodec;
-                tIt->RemoteAudioHost = pAudioHost;
-                tIt->RemoteAudioPort = pAudioPort;
-                tIt->RemoteAudioCodec = pAudioCodec;
-                tFound = true;
-                LOG(LOG_VERBOSE, "...found");
-                LOG(LOG_VERBOSE, "...set remote video information to: %s:%u with codec %s", pVideoHost.c_str(), pVideoPort, pVideoCodec.c_str());
-                LOG(LOG_VERBOSE, "...set remote audio information to: %s:%u with codec %s", pAudioHost.c_str(), pAudioPort, pAudioCodec.c_str());
-                break;
-            }
+            tIt->RemoteVideoHost = pVideoHost;
+            tIt->RemoteVideoPort = pVideoPort;
+            tIt->RemoteVideoCodec = pVideoCodec;
+            tIt->RemoteAudioHost = pAudioHost;
+            tIt->RemoteAudioPort = pAudioPort;
+            tIt->RemoteAudioCodec = pAudioCodec;
+            tFound = true;
+            LOG(LOG_VERBOSE, "...found");
+            LOG(LOG_VERBOSE, "...set remote video information to: %s:%u with codec %s", pVideoHost.c_str(), pVideoPort, pVideoCodec.c_str());
+            LOG(LOG_VERBOSE, "...set remote audio information to: %s:%u with codec %s", pAudioHost.c_str(), pAudioPort, pAudioCodec.c_str());
         }
     }
 
@@ -1246,7 +1334,7 @@ Socket* Meeting::GetAudioReceiveSocket(string pParticipant, enum TransportType p
     LOG(LOG_VERBOSE, "GetAudioSocket for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (pParticipant == mBroadcastAdr)
         tResult = mParticipants.begin()->AudioReceiveSocket;
@@ -1256,13 +1344,11 @@ Socket* Meeting::GetAudioReceiveSocket(string pParticipant, enum TransportType p
         if (mParticipants.size() > 1)
         {
             LOG(LOG_VERBOSE, "Search matching database entry for GetAudioReceiveSocket()");
-            for (tIt = mParticipants.begin()++; tIt != mParticipants.end(); tIt++)
+            tIt = SearchParticipant(pParticipant, pParticipantTransport);
+            if (tIt != mParticipants.end())
             {
-                if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-                {
-                    tResult = tIt->AudioReceiveSocket;
-                    LOG(LOG_VERBOSE, "...found");
-                }
+                tResult = tIt->AudioReceiveSocket;
+                LOG(LOG_VERBOSE, "...found");
             }
         }
     }
@@ -1284,7 +1370,7 @@ Socket* Meeting::GetVideoReceiveSocket(string pParticipant, enum TransportType p
     LOG(LOG_VERBOSE, "GetVideoSocket for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (pParticipant == mBroadcastAdr)
         tResult = mParticipants.begin()->VideoReceiveSocket;
@@ -1294,13 +1380,11 @@ Socket* Meeting::GetVideoReceiveSocket(string pParticipant, enum TransportType p
         if (mParticipants.size() > 1)
         {
             LOG(LOG_VERBOSE, "Search matching database entry for GetVideoReceiveSocket()");
-            for (tIt = mParticipants.begin()++; tIt != mParticipants.end(); tIt++)
+            tIt = SearchParticipant(pParticipant, pParticipantTransport);
+            if (tIt != mParticipants.end())
             {
-                if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-                {
-                    tResult = tIt->VideoReceiveSocket;
-                    LOG(LOG_VERBOSE, "...found");
-                }
+                tResult = tIt->VideoReceiveSocket;
+                LOG(LOG_VERBOSE, "...found");
             }
         }
     }
@@ -1322,7 +1406,7 @@ Socket* Meeting::GetAudioSendSocket(string pParticipant, enum TransportType pPar
     LOG(LOG_VERBOSE, "GetAudioSocket for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (pParticipant == mBroadcastAdr)
         tResult = mParticipants.begin()->AudioSendSocket;
@@ -1332,13 +1416,11 @@ Socket* Meeting::GetAudioSendSocket(string pParticipant, enum TransportType pPar
         if (mParticipants.size() > 1)
         {
             LOG(LOG_VERBOSE, "Search matching database entry for GetAudioSendSocket()");
-            for (tIt = mParticipants.begin()++; tIt != mParticipants.end(); tIt++)
+            tIt = SearchParticipant(pParticipant, pParticipantTransport);
+            if (tIt != mParticipants.end())
             {
-                if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-                {
-                    tResult = tIt->AudioSendSocket;
-                    LOG(LOG_VERBOSE, "...found");
-                }
+                tResult = tIt->AudioSendSocket;
+                LOG(LOG_VERBOSE, "...found");
             }
         }
     }
@@ -1360,7 +1442,7 @@ Socket* Meeting::GetVideoSendSocket(string pParticipant, enum TransportType pPar
     LOG(LOG_VERBOSE, "GetVideoSocket for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (pParticipant == mBroadcastAdr)
         tResult = mParticipants.begin()->VideoSendSocket;
@@ -1370,13 +1452,11 @@ Socket* Meeting::GetVideoSendSocket(string pParticipant, enum TransportType pPar
         if (mParticipants.size() > 1)
         {
             LOG(LOG_VERBOSE, "Search matching database entry for GetVideoSendSocket()");
-            for (tIt = mParticipants.begin()++; tIt != mParticipants.end(); tIt++)
+            tIt = SearchParticipant(pParticipant, pParticipantTransport);
+            if (tIt != mParticipants.end())
             {
-                if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-                {
-                    tResult = tIt->VideoSendSocket;
-                    LOG(LOG_VERBOSE, "...found");
-                }
+                tResult = tIt->VideoSendSocket;
+                LOG(LOG_VERBOSE, "...found");
             }
         }
     }
@@ -1398,7 +1478,7 @@ int Meeting::GetCallState(string pParticipant, enum TransportType pParticipantTr
     LOG(LOG_VERBOSE, "getCallState for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (pParticipant == mBroadcastAdr)
         tResult = CALLSTATE_INVALID;
@@ -1408,13 +1488,11 @@ int Meeting::GetCallState(string pParticipant, enum TransportType pParticipantTr
         if (mParticipants.size() > 1)
         {
             LOG(LOG_VERBOSE, "Search matching database entry for GetCallState()");
-            for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+            tIt = SearchParticipant(pParticipant, pParticipantTransport);
+            if (tIt != mParticipants.end())
             {
-                if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-                {
-                    tResult = tIt->CallState;
-                    LOG(LOG_VERBOSE, "...found");
-                }
+                tResult = tIt->CallState;
+                LOG(LOG_VERBOSE, "...found");
             }
         }
     }
@@ -1433,7 +1511,7 @@ bool Meeting::GetSessionInfo(string pParticipant, enum TransportType pParticipan
     //LOG(LOG_VERBOSE, "GetSessionInfo for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     if (pParticipant == mBroadcastAdr)
     {
@@ -1459,28 +1537,26 @@ bool Meeting::GetSessionInfo(string pParticipant, enum TransportType pParticipan
         if (mParticipants.size() > 1)
         {
             //LOG(LOG_VERBOSE, "Search matching database entry for GetSessionInfo()");
-            for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+            tIt = SearchParticipant(pParticipant, pParticipantTransport);
+            if (tIt != mParticipants.end())
             {
-                if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-                {
-                    tResult = true;
-                    pInfo->User = tIt->User;
-                    pInfo->Host = tIt->Host;
-                    pInfo->Port = tIt->Port;
-                    pInfo->Transport = Socket::TransportType2String(tIt->Transport);
-                    pInfo->OwnIp = tIt->OwnIp;
-                    pInfo->OwnPort = toString(tIt->OwnPort);
-                    pInfo->RemoteVideoHost = tIt->RemoteVideoHost;
-                    pInfo->RemoteVideoPort = toString(tIt->RemoteVideoPort);
-                    pInfo->RemoteVideoCodec = tIt->RemoteVideoCodec;
-                    pInfo->RemoteAudioHost = tIt->RemoteAudioHost;
-                    pInfo->RemoteAudioPort = toString(tIt->RemoteAudioPort);
-                    pInfo->RemoteAudioCodec = tIt->RemoteAudioCodec;
-                    pInfo->LocalVideoPort = toString(tIt->VideoReceiveSocket->GetLocalPort());
-                    pInfo->LocalAudioPort = toString(tIt->AudioReceiveSocket->GetLocalPort());
-                    pInfo->CallState = CallStateAsString(tIt->CallState);
-                    //LOG(LOG_VERBOSE, "...found");
-                }
+                tResult = true;
+                pInfo->User = tIt->User;
+                pInfo->Host = tIt->Host;
+                pInfo->Port = tIt->Port;
+                pInfo->Transport = Socket::TransportType2String(tIt->Transport);
+                pInfo->OwnIp = tIt->OwnIp;
+                pInfo->OwnPort = toString(tIt->OwnPort);
+                pInfo->RemoteVideoHost = tIt->RemoteVideoHost;
+                pInfo->RemoteVideoPort = toString(tIt->RemoteVideoPort);
+                pInfo->RemoteVideoCodec = tIt->RemoteVideoCodec;
+                pInfo->RemoteAudioHost = tIt->RemoteAudioHost;
+                pInfo->RemoteAudioPort = toString(tIt->RemoteAudioPort);
+                pInfo->RemoteAudioCodec = tIt->RemoteAudioCodec;
+                pInfo->LocalVideoPort = toString(tIt->VideoReceiveSocket->GetLocalPort());
+                pInfo->LocalAudioPort = toString(tIt->AudioReceiveSocket->GetLocalPort());
+                pInfo->CallState = CallStateAsString(tIt->CallState);
+                //LOG(LOG_VERBOSE, "...found");
             }
         }
     }
@@ -1498,20 +1574,18 @@ void Meeting::GetOwnContactAddress(std::string pParticipant, enum TransportType
     LOG(LOG_VERBOSE, "getOwnContactAddress for: %s", pParticipant.c_str());
 
     // lock
-    mParticipantsMutex.lock();
+    mParticipantsMutex.lockRead();
 
     // is the recipient already involved in the conference?
     if (mParticipants.size() > 1)
     {
         LOG(LOG_VERBOSE, "Search matching database entry for GetOwnContactAddress()");
-        for (tIt = mParticipants.begin(); tIt != mParticipants.end(); tIt++)
+        tIt = SearchParticipant(pParticipant, pParticipantTransport);
+        if (tIt != mParticipants.end())
         {
-            if (IsThisParticipant(pParticipant, pParticipantTransport, tIt->User, tIt->Host, tIt->Port, tIt->Transport))
-            {
-                pIp = tIt->OwnIp;
-                pPort = tIt->OwnPort;
-                LOG(LOG_VERBOSE, "...found");
-            }
+            pIp = tIt->OwnIp;
+            pPort = tIt->OwnPort;
+            LOG(LOG_VERBOSE, "...found");
         }
     }
 
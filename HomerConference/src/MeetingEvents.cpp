@@ -65,6 +65,7 @@ void MeetingObservable::DeleteObserver(MeetingObserver *pObserver)
 
 EventManager::EventManager()
 {
+    mEventManagerObserver = NULL;
 }
 
 EventManager::~EventManager()
@@ -91,6 +92,10 @@ bool EventManager::Fire(GeneralEvent* pEvent)
 
     mEvents.push_back(pEvent);
 
+    // wake up the consumer of the event queue
+    if (mEventManagerObserver != NULL)
+        mEventManagerObserver->handleEventFired();
+
     // unlock
     mEventsMutex.unlock();
     LOG(LOG_VERBOSE, "Successful event fire");
@@ -117,6 +122,21 @@ GeneralEvent* EventManager::Scan()
     return tEvent;
 }
 
+void EventManager::AddObserver(EventManagerObserver *pObserver)
+{
+    mEventsMutex.lock();
+    mEventManagerObserver = pObserver;
+    mEventsMutex.unlock();
+}
+
+void EventManager::DeleteObserver(EventManagerObserver *pObserver)
+{
+    mEventsMutex.lock();
+    if (mEventManagerObserver == pObserver)
+        mEventManagerObserver = NULL;
+    mEventsMutex.unlock();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} //namespace
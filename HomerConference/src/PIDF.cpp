@@ -30,6 +30,7 @@
 #include <Logger.h>
 
 #include <string>
+#include <string.h>
 
 namespace Homer { namespace Conference {
 
@@ -79,6 +80,36 @@ sip_payload_t* PIDF::CreatePresenceInPidf(su_home_t* pHome, string pUsername, st
     return tResult;
 }
 
+bool PIDF::ParsePresenceFromPidf(const char *pData, int pSize, bool &pAvailable, string &pStateNote)
+{
+    if ((pData == NULL) || (pSize <= 0))
+        return false;
+
+    string tPidf = string(pData, pSize);
+    size_t tStart, tEnd;
+
+    // basic state of the first tuple
+    if (((tStart = tPidf.find("<basic>")) == string::npos) || ((tEnd = tPidf.find("</basic>", tStart)) == string::npos))
+    {
+        LOG(LOG_WARN, "Presence description without basic state");
+        return false;
+    }
+    tStart += strlen("<basic>");
+    pAvailable = (tPidf.substr(tStart, tEnd - tStart).find("open") != string::npos);
+
+    // optional note
+    pStateNote = "";
+    if (((tStart = tPidf.find("<note>")) != string::npos) && ((tEnd = tPidf.find("</note>", tStart)) != string::npos))
+    {
+        tStart += strlen("<note>");
+        pStateNote = tPidf.substr(tStart, tEnd - tStart);
+    }
+
+    LOG(LOG_VERBOSE, "PIDF based presence state: %s, note: %s", pAvailable ? "open" : "closed", pStateNote.c_str());
+
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} //namespace
@@ -27,10 +27,12 @@
  */
 
 #include <string>
+#include <algorithm>
 #include <stdlib.h>
 #include <sstream>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <HBSocket.h>
 #include <HBTime.h>
@@ -53,9 +55,11 @@ using namespace Homer::Monitor;
 #define CALL_REQUEST_RETRIES                            1
 #define MESSAGE_REQUEST_RETRIES                         1
 #define OPTIONS_REQUEST_RETRIES                         0
+#define PRESENCE_SUBSCRIPTION_EXPIRES                   "180" // seconds, the SIP stack refreshes the subscription before, hence a vanished peer is detected by a failing refresh
 
 #define CALL_REQUEST_TIMEOUT                            3 // seconds
 #define SHUTDOWN_REQUEST_TIMEOUT						3 // seconds
+#define SHUTDOWN_STEP_TIMEOUT                           100 // ms
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -96,6 +100,13 @@ SIP::SIP():
     mSipRegisterPassword = "";
     mSipPublishHandle = NULL;
     mSipRegisterHandle = NULL;
+    mSipContext->Root = NULL;
+    mSipWakeUpPending = false;
+    mSipPresenceNotificationPending = false;
+    mSipPresenceNotifiedAvailable = true;
+
+    // outgoing events wake up the SIP main loop directly
+    mOutgoingEvents.AddObserver(this);
 
     // set to localhost, will be corrected within meeting.C
     mSipHostAdr = "127.0.0.1";
@@ -103,6 +114,7 @@ SIP::SIP():
 
 SIP::~SIP()
 {
+    mOutgoingEvents.DeleteObserver(this);
     delete mSipContext;
 }
 
@@ -244,6 +256,64 @@ void GlobalSipCallBack(nua_event_t pEvent, int pStatus, char const *pPhrase, nua
     tSIP->SipCallBack((int)pEvent, pStatus, pPhrase, pNua, pMagic, pNuaHandle, pHMagic, pSip, (void*)pTags);
 }
 
+// executed within the SIP main loop, triggered via su_msg_send() from the thread which fired an outgoing event
+void GlobalSipWakeUpCallBack(su_root_magic_t *pMagic, su_msg_r pMsg, su_msg_arg_t *pArgs)
+{
+    SIP* tSIP = *(SIP**)pArgs;
+
+    tSIP->SipWakeUpCallBack();
+}
+
+void SIP::SipWakeUpCallBack()
+{
+    mSipRootMutex.lock();
+    mSipWakeUpPending = false;
+    bool tPresenceNotificationPending = mSipPresenceNotificationPending;
+    mSipPresenceNotificationPending = false;
+    mSipRootMutex.unlock();
+
+    SipProcessOutgoingEvents();
+
+    if (tPresenceNotificationPending)
+        SipSendPresenceNotifications();
+}
+
+void SIP::handleEventFired()
+{
+    SipWakeUpMainLoop();
+}
+
+void SIP::SipWakeUpMainLoop()
+{
+    mSipRootMutex.lock();
+
+    // one pending wake up message is enough to process all queued events
+    if ((mSipContext->Root != NULL) && (!mSipWakeUpPending))
+    {
+        su_msg_r tMsg = SU_MSG_R_INIT;
+        if (su_msg_create(tMsg, su_root_task(mSipContext->Root), su_task_null, GlobalSipWakeUpCallBack, sizeof(SIP*)) == 0)
+        {
+            *(SIP**)su_msg_data(tMsg) = this;
+            if (su_msg_send(tMsg) == 0)
+                mSipWakeUpPending = true;
+            else
+                LOG(LOG_ERROR, "Unable to send wake up message to SIP main loop");
+        }else
+            LOG(LOG_ERROR, "Unable to create wake up message for SIP main loop");
+    }
+
+    mSipRootMutex.unlock();
+}
+
+void SIP::SipDestroyRoot()
+{
+    mSipRootMutex.lock();
+    su_root_destroy(mSipContext->Root);
+    mSipContext->Root = NULL;
+    mSipWakeUpPending = false;
+    mSipRootMutex.unlock();
+}
+
 void* SIP::Run(void*)
 {
     string tOwnAddress;
@@ -286,7 +356,9 @@ void* SIP::Run(void*)
 
     // initialize root object
     LOG(LOG_VERBOSE, "..SU root create");
+    mSipRootMutex.lock();
     mSipContext->Root = su_root_create(&mSipContext);
+    mSipRootMutex.unlock();
 
     if (mSipContext->Root != NULL)
     {
@@ -354,7 +426,7 @@ void* SIP::Run(void*)
 
              // set necessary parameters
             LOG(LOG_VERBOSE, "..set_params");
-            nua_set_params(mSipContext->Nua, NUTAG_AUTOACK(MEETING_AUTOACK_CALLS), NUTAG_URL(URL_STRING_MAKE(tOwnAddress.c_str())), SIPTAG_USER_AGENT_STR(USER_AGENT_SIGNATURE), SIPTAG_ORGANIZATION_STR(ORGANIZATION_SIGNATURE), NUTAG_OUTBOUND(SIP_OUTBOUND_OPTIONS), NTATAG_USER_VIA(1), TAG_NULL());
+            nua_set_params(mSipContext->Nua, NUTAG_AUTOACK(MEETING_AUTOACK_CALLS), NUTAG_URL(URL_STRING_MAKE(tOwnAddress.c_str())), SIPTAG_USER_AGENT_STR(USER_AGENT_SIGNATURE), SIPTAG_ORGANIZATION_STR(ORGANIZATION_SIGNATURE), NUTAG_OUTBOUND(SIP_OUTBOUND_OPTIONS), NTATAG_USER_VIA(1), NUTAG_ALLOW("SUBSCRIBE"), NUTAG_ALLOW_EVENTS("presence"), TAG_NULL());
 
             //###################################################################
             //### STUN support
@@ -372,13 +444,13 @@ void* SIP::Run(void*)
 
             // we use one main loop for both incoming and outgoing events
             // because we arent allowed to use several threads here (limited by the SIP library concept)
+            // OUTGOING events: events which were fired before the main loop was ready
+            SipProcessOutgoingEvents();
             while (mSipListenerNeeded)
             {
-                // OUTGOING events
-                SipProcessOutgoingEvents();
-
-                // INCOMING events: one step of main loop for processing of SIP messages, timeout is set to 100 ms
-                su_root_step(mSipContext->Root, 100);
+                // INCOMING events and OUTGOING events: each fired outgoing event sends a wake up message to the root object,
+                // hence we can wait until SIP messages, timers or wake up messages have to be processed
+                su_root_step(mSipContext->Root, SU_WAIT_FOREVER);
             }
 
             LOG(LOG_VERBOSE, "Closing stack..");
@@ -401,8 +473,8 @@ void* SIP::Run(void*)
             	}
                 LOG(LOG_VERBOSE, "Wait for Shutdown-Step");
 
-                // one step of main loop for processing of messages, timeout is set to 100 ms
-                su_root_step(mSipContext->Root, 100);
+                // one step of main loop for processing of messages
+                su_root_step(mSipContext->Root, SHUTDOWN_STEP_TIMEOUT);
             }
 
             // destroy NUA stack
@@ -418,8 +490,7 @@ void* SIP::Run(void*)
 
         // deinit root object
         LOG(LOG_VERBOSE, "..SU root destroy");
-        su_root_destroy(mSipContext->Root);
-        mSipContext->Root = NULL;
+        SipDestroyRoot();
 
     }else
     {
@@ -441,6 +512,9 @@ void* SIP::Run(void*)
 void SIP::StopSipMainLoop()
 {
     mSipListenerNeeded = false;
+
+    // the main loop might sleep until the next SIP message arrives
+    SipWakeUpMainLoop();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -700,8 +774,18 @@ void SIP::SetAvailabilityState(enum AvailabilityState pState, string pStateText)
 
     LOG(LOG_VERBOSE, "Setting new availability-state: %d", pState);
 
+    bool tStateChanged = (mAvailabilityState != pState);
     mAvailabilityState = pState;
 
+    // inform presence subscribers from within the SIP main loop
+    if (tStateChanged)
+    {
+        mSipRootMutex.lock();
+        mSipPresenceNotificationPending = true;
+        mSipRootMutex.unlock();
+        SipWakeUpMainLoop();
+    }
+
     if ((mSipRegisteredAtServer <= 0) || (mAvailabilityState == pState))
         return;
 
@@ -1385,7 +1469,7 @@ void SIP::SipCallBack(int pEvent, int pStatus, char const *pPhrase, nua_t *pNua,
                 with NUTAG_SUBSTATE(nua_substate_terminated) tag.
             */
             case nua_i_subscribe:
-                LOGEX(SIP, LOG_INFO, "FUNCTION NOT IMPLEMENTED YET");
+                SipReceivedPresenceSubscription(tRemote, tLocal, pNuaHandle, pSip, pTags, tSourceIp, tSourcePort, tSourcePortTransport);
                 break;
             /*################################################################
                 Incoming subscription to be authorized.
@@ -1423,7 +1507,7 @@ void SIP::SipCallBack(int pEvent, int pStatus, char const *pPhrase, nua_t *pNua,
                                 state
             */
             case nua_i_notify:
-                LOGEX(SIP, LOG_INFO, "FUNCTION NOT IMPLEMENTED YET");
+                SipReceivedPresenceNotify(tRemote, tLocal, pNuaHandle, pSip, pTags, tSourceIp, tSourcePort, tSourcePortTransport);
                 break;
             /*################################################################
                 Incoming, unknown method.
@@ -1959,6 +2043,14 @@ void SIP::SipCallBack(int pEvent, int pStatus, char const *pPhrase, nua_t *pNua,
             case nua_r_authenticate:
                 SipReceivedAuthenticationResponse(tRemote, tLocal, pNuaHandle, pStatus, tSourceIp, tSourcePort, tSourcePortTransport);
                 break;
+            /*################################################################
+                nua_r_subscribe         Answer to outgoing SUBSCRIBE.
+
+                (see description above)
+            */
+            case nua_r_subscribe:
+                SipReceivedPresenceSubscriptionResponse(tRemote, tLocal, pNuaHandle, pStatus, pPhrase, pSip, pTags, tSourceIp, tSourcePort, tSourcePortTransport);
+                break;
 
             /*################################################################
                 nua_i_network_changed   Local IP(v6) address has changed.
@@ -2155,7 +2247,7 @@ string SIP::InitGeneralEvent_FromSipReceivedResponseEvent(const sip_to_t *pRemot
     initParticipantTriplet(pRemote, pSip, pSourceIp, pSourcePort, pSourcePortTransport, tUser, tHost, tPort);
 
     // should there be an already existing session to this participant? -> if not simply set tFound to "true"
-    if ((pEventName != "Registration") && (pEventName != "RegistrationFailed") && (pEventName != "Publication") && (pEventName != "PublicationFailed") && (pEventName != "OptionsAccept") && (pEventName != "OptionsUnavailable"))
+    if ((pEventName != "Registration") && (pEventName != "RegistrationFailed") && (pEventName != "Publication") && (pEventName != "PublicationFailed") && (pEventName != "OptionsAccept") && (pEventName != "OptionsUnavailable") && (pEventName != "PresenceNotify") && (pEventName != "PresenceUnavailable"))
         tFound = MEETING.SearchParticipantByNuaHandleOrName(tUser, tHost, tPort, pNuaHandle);
     else
         tFound = true;
@@ -2863,6 +2955,133 @@ void SIP::SipReceivedOptionsResponseUnavailable(const sip_to_t *pSipRemote, cons
     MEETING.notifyObservers(tOUAEvent);
 }
 
+///////////////// Presence Subscriptions /////////////////////////////
+
+void SIP::SipReceivedPresenceSubscription(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, sip_t const *pSip, void* pTags, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport)
+{
+    int tSubState = nua_substate_embryonic;
+    tagi_t* tTags = (tagi_t*)pTags;
+
+    tl_gets(tTags,
+            NUTAG_SUBSTATE_REF(tSubState),
+            TAG_END());
+
+    LOG(LOG_INFO, "PresenceSubscriptionState: %d", tSubState);
+
+    PresenceSubscribers::iterator tIt = find(mSipPresenceSubscribers.begin(), mSipPresenceSubscribers.end(), pNuaHandle);
+
+    if (tSubState == nua_substate_terminated)
+    {
+        LOG(LOG_VERBOSE, "Presence subscriber 0x%lx has left", (unsigned long)pNuaHandle);
+        if (tIt != mSipPresenceSubscribers.end())
+            mSipPresenceSubscribers.erase(tIt);
+        nua_handle_destroy(pNuaHandle);
+        return;
+    }
+
+    // refreshes of an existing subscription are answered by the SIP stack
+    if (tIt != mSipPresenceSubscribers.end())
+        return;
+
+    if ((pSip == NULL) || (pSip->sip_event == NULL) || (pSip->sip_event->o_type == NULL) || (strcmp(pSip->sip_event->o_type, "presence") != 0))
+    {
+        LOG(LOG_WARN, "Unsupported subscription event, will reject it");
+        nua_respond(pNuaHandle, SIP_489_BAD_EVENT, NUTAG_WITH_THIS(mSipContext->Nua), TAG_END());
+        nua_handle_destroy(pNuaHandle);
+        return;
+    }
+
+    LOG(LOG_VERBOSE, "New presence subscriber 0x%lx", (unsigned long)pNuaHandle);
+    nua_respond(pNuaHandle, SIP_202_ACCEPTED, NUTAG_WITH_THIS(mSipContext->Nua), SIPTAG_EXPIRES_STR(PRESENCE_SUBSCRIPTION_EXPIRES), TAG_END());
+    mSipPresenceSubscribers.push_back(pNuaHandle);
+
+    // the initial NOTIFY establishes the dialog
+    SipSendPresenceNotify(pNuaHandle);
+}
+
+void SIP::SipReceivedPresenceSubscriptionResponse(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, void* pTags, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport)
+{
+    switch(pStatus)
+    {
+        case SIP_STATE_OKAY:
+        case SIP_STATE_OKAY_DELAYED_DELIVERY: // the other side accepted the subscription, the state is delivered via NOTIFY
+            LOG(LOG_VERBOSE, "Presence subscription accepted");
+            break;
+        case SIP_STATE_PROXY_AUTH_REQUIRED:
+            if ((pNuaHandle != NULL) && (GetServerRegistrationState()))
+            {
+                string tAuthInfo = "Digest:\"" + mSipRegisterServer + "\":" + mSipRegisterUsername + ":" + mSipRegisterPassword;
+
+                LOG(LOG_VERBOSE, "Authentication information for presence subscription: %s", tAuthInfo.c_str());
+
+                // set auth. information
+                nua_authenticate(pNuaHandle, NUTAG_AUTH(tAuthInfo.c_str()), TAG_END());
+            }else
+                SipReceivedPresenceUnavailable(pSipRemote, pSipLocal, pNuaHandle, pStatus, pPhrase, pSip, pSourceIp, pSourcePort, pSourcePortTransport);
+            break;
+        case 100 ... 199: // provisional response or retry
+            break;
+        default:
+            //    405 = Method not allowed
+            //    489 = Bad event
+            //    501 = Not implemented
+            //    408/503 = peer unreachable
+            SipReceivedPresenceUnavailable(pSipRemote, pSipLocal, pNuaHandle, pStatus, pPhrase, pSip, pSourceIp, pSourcePort, pSourcePortTransport);
+            break;
+    }
+}
+
+void SIP::SipReceivedPresenceNotify(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, sip_t const *pSip, void* pTags, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport)
+{
+    int tSubState = nua_substate_active;
+    tagi_t* tTags = (tagi_t*)pTags;
+
+    tl_gets(tTags,
+            NUTAG_SUBSTATE_REF(tSubState),
+            TAG_END());
+
+    LOG(LOG_INFO, "PresenceNotifyState: %d", tSubState);
+
+    if (tSubState == nua_substate_terminated)
+    {
+        SipReceivedPresenceUnavailable(pSipRemote, pSipLocal, pNuaHandle, 0, "Subscription terminated", pSip, pSourceIp, pSourcePort, pSourcePortTransport);
+        return;
+    }
+
+    if ((pSip == NULL) || (pSip->sip_payload == NULL))
+    {
+        LOG(LOG_VERBOSE, "Presence notification without presence description");
+        return;
+    }
+
+    SubscriptionPresenceNotifyEvent *tSPNEvent = new SubscriptionPresenceNotifyEvent();
+    if (!ParsePresenceFromPidf(pSip->sip_payload->pl_data, (int)pSip->sip_payload->pl_len, tSPNEvent->Available, tSPNEvent->StateNote))
+    {
+        LOG(LOG_WARN, "Unable to parse presence notification");
+        delete tSPNEvent;
+        return;
+    }
+
+    InitGeneralEvent_FromSipReceivedResponseEvent(pSipRemote, pSipLocal, pNuaHandle, pSip, tSPNEvent, "PresenceNotify", pSourceIp, pSourcePort, pSourcePortTransport);
+
+    MEETING.notifyObservers(tSPNEvent);
+}
+
+void SIP::SipReceivedPresenceUnavailable(const sip_to_t *pSipRemote, const sip_to_t *pSipLocal, nua_handle_t *pNuaHandle, int pStatus, const char* pPhrase, sip_t const *pSip, std::string pSourceIp, unsigned int pSourcePort, enum TransportType pSourcePortTransport)
+{
+    SubscriptionPresenceUnavailableEvent *tSPUEvent = new SubscriptionPresenceUnavailableEvent();
+
+    InitGeneralEvent_FromSipReceivedResponseEvent(pSipRemote, pSipLocal, pNuaHandle, pSip, tSPUEvent, "PresenceUnavailable", pSourceIp, pSourcePort, pSourcePortTransport);
+
+    // store extended information
+    tSPUEvent->StatusCode = pStatus;
+    tSPUEvent->Description = toString(pPhrase);
+
+    nua_handle_destroy(pNuaHandle);
+
+    MEETING.notifyObservers(tSPUEvent);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //////////////////////// SENDING //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -2899,7 +3118,7 @@ void SIP::SipSendMessage(MessageEvent *pMEvent)
     }
 
     // set the created handle within ParticipantDescriptor
-    *pMEvent->HandlePtr = tHandle;
+    MEETING.SetNuaHandle(pMEvent->HandlePtr, tHandle);
 
     PrintOutgoingMessageInfo(tHandle, pMEvent, "Message");
     LOG(LOG_INFO, "MessageText: %s", pMEvent->Text.c_str());
@@ -2965,7 +3184,7 @@ void SIP::SipSendCall(CallEvent *pCEvent)
     }
 
     // set the created handle within ParticipantDescriptor
-    *pCEvent->HandlePtr = tHandle;
+    MEETING.SetNuaHandle(pCEvent->HandlePtr, tHandle);
 
     // initialize SDP protocol parameters
     // set SDP string
@@ -3161,6 +3380,64 @@ void SIP::SipSendOptionsRequest(OptionsEvent *pOEvent)
     //nua_handle_destroy (tHandle);
 }
 
+void SIP::SipSendPresenceSubscription(SubscriptionPresenceEvent *pSPEvent)
+{
+    string tToTransport = pSPEvent->Receiver + ";transport=" + Socket::TransportType2String(pSPEvent->Transport);
+
+    sip_to_t *tTo = sip_to_make(&mSipContext->Home, pSPEvent->Receiver.c_str());
+    if (tTo == NULL)
+    {
+        LOG(LOG_ERROR, "Can not create \"to\" handle for function \"SipSendPresenceSubscription\" and receiver \"%s\"", pSPEvent->Receiver.c_str());
+        return;
+    }
+
+    // create operation handle
+    nua_handle_t *tHandle = nua_handle(mSipContext->Nua, NULL, SIPTAG_USER_AGENT_STR(USER_AGENT_SIGNATURE), SIPTAG_TO(tTo), NUTAG_URL(URL_STRING_MAKE(tToTransport.c_str())), TAG_END());
+
+    if (tHandle == NULL)
+    {
+        LOG(LOG_INFO, "Can not create operation handle");
+        return;
+    }
+
+    PrintOutgoingMessageInfo(tHandle, pSPEvent, "PresenceSubscription");
+    nua_subscribe(tHandle, SIPTAG_EVENT_STR("presence"), SIPTAG_ACCEPT_STR(GetMimeFormatPidf().c_str()), SIPTAG_EXPIRES_STR(PRESENCE_SUBSCRIPTION_EXPIRES), TAG_END());
+
+    // don't destroy handle because the subscription lasts until the peer terminates it or rejects it
+}
+
+void SIP::SipSendPresenceNotify(nua_handle_t *pNuaHandle)
+{
+    bool tAvailable = (mAvailabilityState != AVAILABILITY_STATE_OFFLINE);
+
+    sip_payload_t *tPresenceDescription = CreatePresenceInPidf(&mSipContext->Home, MEETING.GetUserName(), MEETING.GetHostAdr(), tAvailable ? "online" : "dnd", tAvailable);
+
+    nua_notify(pNuaHandle, NUTAG_SUBSTATE(nua_substate_active), SIPTAG_EVENT_STR("presence"), TAG_IF(tPresenceDescription, SIPTAG_CONTENT_TYPE_STR(GetMimeFormatPidf().c_str())), TAG_IF(tPresenceDescription, SIPTAG_PAYLOAD(tPresenceDescription)), TAG_END());
+
+    // the SIP stack has its own copy of the payload
+    if (tPresenceDescription != NULL)
+        su_free(&mSipContext->Home, tPresenceDescription);
+}
+
+void SIP::SipSendPresenceNotifications()
+{
+    PresenceSubscribers::iterator tIt;
+    bool tAvailable = (mAvailabilityState != AVAILABILITY_STATE_OFFLINE);
+
+    // the subscribers know the published state already, e.g., after switching between two online states
+    if (tAvailable == mSipPresenceNotifiedAvailable)
+    {
+        LOG(LOG_VERBOSE, "Published presence state is unchanged, skipping notification of %d presence subscriber(s)", (int)mSipPresenceSubscribers.size());
+        return;
+    }
+    mSipPresenceNotifiedAvailable = tAvailable;
+
+    LOG(LOG_VERBOSE, "Informing %d presence subscriber(s) about new availability state", (int)mSipPresenceSubscribers.size());
+
+    for (tIt = mSipPresenceSubscribers.begin(); tIt != mSipPresenceSubscribers.end(); tIt++)
+        SipSendPresenceNotify(*tIt);
+}
+
 void SIP::SipProcessOutgoingEvents()
 {
     GeneralEvent *tEvent;
@@ -3201,6 +3478,10 @@ void SIP::SipProcessOutgoingEvents()
         {
             SipSendOptionsRequest((OptionsEvent*) tEvent);
         }
+        if (tEvent->getType() == SubscriptionPresenceEvent::type())
+        {
+            SipSendPresenceSubscription((SubscriptionPresenceEvent*) tEvent);
+        }
         if (tEvent->getType() == InternalNatDetectionEvent::type())
         {
             //###############  NAT detection with FEEDBACK  ##########################
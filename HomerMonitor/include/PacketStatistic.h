@@ -68,6 +68,8 @@ struct PacketStatisticDescriptor{
     int  AvgPacketSize;
     int  AvgDataRate;
     int  MomentAvgDataRate;
+    int  QueueDelay; // in us
+    int  MaxQueueDelay; // in us
 };
 
 struct DataRateHistoryDescriptor{
@@ -98,6 +100,8 @@ public:
     int GetMinPacketSize();
     int GetMaxPacketSize();
     uint64_t GetLostPacketCount();
+    int GetQueueDelay();
+    int GetMaxQueueDelay();
 
     /* get statistic values */
     PacketStatisticDescriptor GetPacketStatistic();
@@ -120,6 +124,7 @@ public:
     virtual void ResetPacketStatistic();
 
     void SetLostPacketCount(uint64_t pPacketCount);
+    void SetQueueDelay(int pDelay); // in us, delay caused by pacing or queuing within the transport
 
 protected:
     /* update internal states */
@@ -145,6 +150,8 @@ private:
     int64_t       mStartTimeStamp;
     int64_t       mEndTimeStamp;
     uint64_t      mLostPacketCount;
+    int           mQueueDelay;
+    int           mMaxQueueDelay;
     Time          mLastTime;
     Statistics mStatistics;
     Mutex         mStatisticsMutex;
@@ -68,6 +68,8 @@ public:
     ThreadStatisticDescriptor GetThreadStatistic();
     void AssignThreadName(std::string pName);
     std::string GetThreadName();
+    void AssignThreadPolicy(std::string pPolicy);
+    std::string GetThreadPolicy();
     int GetThreadStatisticId();
 
 private:
@@ -77,6 +79,7 @@ friend class ProcessStatisticService;
 
     int mThreadId;
     std::string mName;
+    std::string mPolicy;
     unsigned long long mLastUserTicsThread;
     unsigned long long mLastKernelTicsThread;
     unsigned long long mLastSystemTime;
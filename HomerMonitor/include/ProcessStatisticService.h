@@ -29,8 +29,10 @@
 #define _MULTIMEDIA_PROCESS_STATISTIC_SERVICE_
 
 #include <HBMutex.h>
+#include <HBThread.h>
 #include <ProcessStatistic.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -55,7 +57,8 @@ public:
 
     static ProcessStatisticService& GetInstance();
 
-    void AssignThreadName(std::string pName);
+    void AssignThreadName(std::string pName); // also applies the scheduling policy of the role which belongs to the name
+    static enum Homer::Base::ThreadRole GetThreadRole(std::string pName);
 
     /* get statistics */
     ProcessStatistics GetProcessStatistics();
@@ -72,6 +75,9 @@ private:
     ProcessStatistics mProcessStatistics;
     Homer::Base::Mutex	  mProcessStatisticsMutex;
     Homer::Base::Mutex    mUpdateThreadDataBaseMutex;
+    /* threads with a non-default role, a renamed thread falls back to the default policy */
+    std::map<int, enum Homer::Base::ThreadRole> mThreadRoles;
+    Homer::Base::Mutex    mThreadRolesMutex;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
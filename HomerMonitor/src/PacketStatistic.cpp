@@ -181,6 +181,8 @@ void PacketStatistic::ResetPacketStatistic()
     mMinPacketSize = INT_MAX;
     mMaxPacketSize = 0;
     mLostPacketCount = 0;
+    mQueueDelay = 0;
+    mMaxQueueDelay = 0;
 
     mDataRateHistoryMutex.lock();
     mDataRateHistory.clear();
@@ -199,6 +201,13 @@ void PacketStatistic::SetLostPacketCount(uint64_t pPacketCount)
     mLostPacketCount = pPacketCount;
 }
 
+void PacketStatistic::SetQueueDelay(int pDelay)
+{
+    mQueueDelay = pDelay;
+    if (pDelay > mMaxQueueDelay)
+        mMaxQueueDelay = pDelay;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 int PacketStatistic::GetAvgPacketSize()
@@ -297,6 +306,16 @@ uint64_t PacketStatistic::GetLostPacketCount()
     return mLostPacketCount;
 }
 
+int PacketStatistic::GetQueueDelay()
+{
+    return mQueueDelay;
+}
+
+int PacketStatistic::GetMaxQueueDelay()
+{
+    return mMaxQueueDelay;
+}
+
 void PacketStatistic::AssignStreamName(std::string pName)
 {
 	mName = pName;
@@ -404,6 +423,8 @@ PacketStatisticDescriptor PacketStatistic::GetPacketStatistic()
 	tStat.AvgPacketSize = GetAvgPacketSize();
 	tStat.AvgDataRate = GetAvgDataRate();
     tStat.MomentAvgDataRate = GetMomentAvgDataRate();
+    tStat.QueueDelay = GetQueueDelay();
+    tStat.MaxQueueDelay = GetMaxQueueDelay();
 
 	return tStat;
 }
@@ -67,6 +67,16 @@ string ProcessStatistic::GetThreadName()
     return mName;
 }
 
+void ProcessStatistic::AssignThreadPolicy(string pPolicy)
+{
+    mPolicy = pPolicy;
+}
+
+string ProcessStatistic::GetThreadPolicy()
+{
+    return mPolicy;
+}
+
 ThreadStatisticDescriptor ProcessStatistic::GetThreadStatistic()
 {
     ThreadStatisticDescriptor tStat;
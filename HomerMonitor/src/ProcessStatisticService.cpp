@@ -29,6 +29,7 @@
 #include <Logger.h>
 #include <HBThread.h>
 
+#include <string.h>
 #include <vector>
 
 using namespace std;
@@ -39,6 +40,32 @@ namespace Homer { namespace Monitor {
 ProcessStatisticService sProcessStatisticService;
 bool sProcessStatisticSupported = true;
 
+struct ThreadRoleEntry
+{
+    const char          *NamePrefix;
+    enum ThreadRole     Role;
+};
+
+// the roles are derived from the names of the threads, the first matching prefix wins
+static ThreadRoleEntry sThreadRoles[] = {
+    { "Audio-InputListener",    THREAD_ROLE_NETWORK },
+    { "Video-InputListener",    THREAD_ROLE_NETWORK },
+    // only the threads which talk to the sound devices, audio codec threads stay on the shared cores
+    { "Audio-Grabber(ALSA)",    THREAD_ROLE_AUDIO_IO },
+    { "Audio-Grabber(OSS)",     THREAD_ROLE_AUDIO_IO },
+    { "Audio-Grabber(MMSYS)",   THREAD_ROLE_AUDIO_IO },
+    { "Audio-Grabber(PortAudio)", THREAD_ROLE_AUDIO_IO },
+    // the device callback of PortAudio based playback, the WaveOut*-File threads decode files and stay on the shared cores
+    { "WaveOutPortAudio-",      THREAD_ROLE_AUDIO_IO },
+    { "PortAudio-",             THREAD_ROLE_AUDIO_IO },
+    { "Video-",                 THREAD_ROLE_VIDEO_CODEC },
+    { "Decoder(",               THREAD_ROLE_VIDEO_CODEC },
+    { "Encoder(",               THREAD_ROLE_VIDEO_CODEC },
+    { "SIP-",                   THREAD_ROLE_NETWORK },
+    { "FileTransfer-",          THREAD_ROLE_HOUSEKEEPING },
+    { NULL,                     THREAD_ROLE_DEFAULT }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 ProcessStatisticService::ProcessStatisticService()
@@ -167,8 +194,39 @@ void ProcessStatisticService::UpdateThreadDatabase()
     mUpdateThreadDataBaseMutex.unlock();
 }
 
+enum ThreadRole ProcessStatisticService::GetThreadRole(std::string pName)
+{
+    for (int i = 0; sThreadRoles[i].NamePrefix != NULL; i++)
+    {
+        if (pName.compare(0, strlen(sThreadRoles[i].NamePrefix), sThreadRoles[i].NamePrefix) == 0)
+            return sThreadRoles[i].Role;
+    }
+
+    return THREAD_ROLE_DEFAULT;
+}
+
 void ProcessStatisticService::AssignThreadName(std::string pName)
 {
+    string tPolicy = "";
+
+    // the policy is applied even without statistic support
+    enum ThreadRole tRole = GetThreadRole(pName);
+    enum ThreadRole tFormerRole = THREAD_ROLE_DEFAULT;
+    int tTid = Thread::GetTId();
+    mThreadRolesMutex.lock();
+    map<int, enum ThreadRole>::iterator tRoleIt = mThreadRoles.find(tTid);
+    if (tRoleIt != mThreadRoles.end())
+    {
+        tFormerRole = tRoleIt->second;
+        mThreadRoles.erase(tRoleIt);
+    }
+    if (tRole != THREAD_ROLE_DEFAULT)
+        mThreadRoles[tTid] = tRole;
+    mThreadRolesMutex.unlock();
+    // a thread which is renamed to a name without role returns to the default policy
+    if ((tRole != THREAD_ROLE_DEFAULT) || (tFormerRole != THREAD_ROLE_DEFAULT))
+        Thread::ApplyRole(tRole, tPolicy);
+
 	if (!sProcessStatisticSupported)
 		return;
 
@@ -188,6 +246,7 @@ void ProcessStatisticService::AssignThreadName(std::string pName)
         {
             tFound = true;
             (*tDbIt)->AssignThreadName(pName);
+            (*tDbIt)->AssignThreadPolicy(tPolicy);
         }
     }
     // unlock
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: A/V synchronization with audio playout as master clock
+ * Author:  Thomas Volkert
+ * Since:   2012-12-14
+ */
+
+#ifndef _MULTIMEDIA_AV_SYNCHRONIZER_
+#define _MULTIMEDIA_AV_SYNCHRONIZER_
+
+#include <HBMutex.h>
+
+#include <stdint.h>
+#include <string>
+
+using namespace Homer::Base;
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// weight of a new measurement for the smoothed audio clock
+#define AV_SYNC_AUDIO_CLOCK_WEIGHT                      0.1
+
+// audio clock jumps beyond this limit are taken over immediately (e.g., after a reset of the audio source)
+#define AV_SYNC_AUDIO_CLOCK_RESET                       100 // ms
+
+// audio clock is invalid if audio playout hasn't reported for this time (e.g., audio muted or stream broken)
+#define AV_SYNC_AUDIO_CLOCK_TIMEOUT                     500 // ms
+
+// fraction of a small drift which is corrected per video frame
+#define AV_SYNC_SLEW_WEIGHT                             0.1
+
+// limit for holding back a single video frame
+#define AV_SYNC_MAX_WAIT                                200 // ms
+
+// drifts above this limit are caused by invalid synchronization timestamps and are ignored
+#define AV_SYNC_MAX_PLAUSIBLE_DRIFT                     10 // s
+
+//#define AVS_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+enum AVSyncAction
+{
+    AV_SYNC_PRESENT = 0, // present the video frame now
+    AV_SYNC_WAIT, // video frame is early, present it after the wait time
+    AV_SYNC_DROP // video frame is too late, skip it
+};
+
+/*
+ * Per participant synchronization engine: audio playout is the master clock because gaps in audio are more
+ * obvious than repeated or dropped video frames. The audio clock is derived from the RTCP based synchronization
+ * timestamp of the last queued audio chunk minus the playout delay and the output latency. Each video frame is scheduled against this
+ * clock and the video source's real-time grabbing is shifted continuously in small steps.
+ */
+class AVSynchronizer
+{
+public:
+    AVSynchronizer(std::string pName = "");
+
+    virtual ~AVSynchronizer();
+
+    void Reset();
+
+    /* audio master clock, both values in us */
+    void UpdateAudioClock(int64_t pSynchronizationTimestamp, int64_t pPlayoutDelay);
+    bool GetAudioClock(int64_t &pClock); // sender time of the currently played audio sample, returns false if unknown
+
+    /* video scheduling: pWaitTime is valid for AV_SYNC_WAIT, pClockCorrection has to be applied to the video source via TimeShift() */
+    enum AVSyncAction ScheduleVideoFrame(int64_t pSynchronizationTimestamp, float pFrameRate, int64_t &pWaitTime, int64_t &pClockCorrection);
+
+    /* statistic */
+    bool IsSynchronizing();
+    int64_t GetDrift(); // in us, positive values mean "video before audio"
+    int64_t GetPresentedFrames();
+    int64_t GetDelayedFrames();
+    int64_t GetDroppedFrames();
+
+private:
+    std::string         mName;
+    Mutex               mMutex;
+    /* audio clock */
+    bool                mAudioClockValid;
+    int64_t             mAudioClockOffset; // sender time minus local time, in us
+    int64_t             mAudioClockUpdateTime;
+    /* video scheduling */
+    int64_t             mDrift;
+    int64_t             mLastScheduleTime;
+    int64_t             mPresentedFrames;
+    int64_t             mDelayedFrames;
+    int64_t             mDroppedFrames;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: active speaker detection and video subscription policy
+ * Author:  Thomas Volkert
+ * Since:   2012-12-16
+ */
+
+#ifndef _MULTIMEDIA_ACTIVE_SPEAKER_DETECTOR_
+#define _MULTIMEDIA_ACTIVE_SPEAKER_DETECTOR_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// audio levels (in % of the full scale) below this limit are treated as silence or background noise
+#define ACTIVE_SPEAKER_LEVEL_THRESHOLD                  10
+
+// weight of a new audio level for the smoothed level of a participant
+#define ACTIVE_SPEAKER_LEVEL_WEIGHT                     0.3
+
+// a participant has to be the loudest one for this time before the video subscriptions follow, avoids switching on short noises
+#define ACTIVE_SPEAKER_MIN_SPEAKING_TIME                1000 // ms
+
+// default number of recent speakers which get a thumbnail subscription
+#define ACTIVE_SPEAKER_THUMBNAILS                       3
+
+//#define ASD_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+enum VideoSubscription
+{
+    VIDEO_SUBSCRIPTION_FULL = 0, // current speaker: full quality
+    VIDEO_SUBSCRIPTION_THUMBNAIL, // recent speakers: reduced quality
+    VIDEO_SUBSCRIPTION_PAUSED // all others: no video processing
+};
+
+/*
+ * Derives the active speaker of a conference from the audio levels of the participants and ranks the participants
+ * by their last speaking time: the current speaker gets the full video subscription, the last K speakers get
+ * thumbnails and the video of all others is paused. Participants which haven't spoken yet are ranked in the order
+ * they joined, so small conferences don't pause anybody. An instance is used by the GUI thread and isn't thread-safe.
+ */
+class ActiveSpeakerDetector
+{
+public:
+    ActiveSpeakerDetector(int pThumbnails = ACTIVE_SPEAKER_THUMBNAILS);
+
+    virtual ~ActiveSpeakerDetector();
+
+    void Reset();
+
+    /* participants */
+    void UpdateAudioLevel(std::string pParticipant, int pLevel); // level in % of the full scale, adds unknown participants
+    void RemoveParticipant(std::string pParticipant);
+
+    /* detection, called periodically after the audio levels were updated */
+    bool Process(); // returns true if the active speaker has changed
+    std::string GetActiveSpeaker();
+
+    /* subscription policy */
+    void SetThumbnails(int pThumbnails);
+    int GetThumbnails();
+    enum VideoSubscription GetVideoSubscription(std::string pParticipant);
+
+    static std::string VideoSubscriptionToString(enum VideoSubscription pSubscription);
+
+private:
+    struct SpeakerState
+    {
+        std::string     Name;
+        float           Level; // smoothed
+        int64_t         LastSpeakingTime; // 0 if the participant hasn't spoken yet
+    };
+    typedef std::vector<SpeakerState> SpeakerStates;
+
+    int FindParticipant(std::string pParticipant);
+
+    SpeakerStates       mSpeakers; // ordered by joining time
+    std::string         mActiveSpeaker;
+    std::string         mCandidate;
+    int64_t             mCandidateSince;
+    int                 mThumbnails;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
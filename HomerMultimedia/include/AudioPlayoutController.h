@@ -0,0 +1,129 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: adaptive audio playout with jitter estimation and time-stretching
+ * Author:  Thomas Volkert
+ * Since:   2012-12-13
+ */
+
+#ifndef _MULTIMEDIA_AUDIO_PLAYOUT_CONTROLLER_
+#define _MULTIMEDIA_AUDIO_PLAYOUT_CONTROLLER_
+
+#include <stdint.h>
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// limits for the target playout delay, the minimum avoids underruns caused by differing chunk sizes of decoder and playback device
+#define AUDIO_PLAYOUT_MIN_DELAY                         25 // ms
+#define AUDIO_PLAYOUT_MAX_DELAY                         300 // ms
+
+// additional buffer on top of the measured jitter
+#define AUDIO_PLAYOUT_SAFETY_MARGIN                     10 // ms
+
+// deviation from the target delay before the playout speed is adjusted
+#define AUDIO_PLAYOUT_HYSTERESIS                        10 // ms
+
+// the target delay covers this multiple of the average jitter
+#define AUDIO_PLAYOUT_JITTER_FACTOR                     4
+
+// the largest delay spike is remembered and fades out with this half-life
+#define AUDIO_PLAYOUT_PEAK_HALF_LIFE                    5000 // ms
+
+// a gap between two chunks above this limit is a restart of the stream (e.g., after muting) and not a delay spike
+#define AUDIO_PLAYOUT_RESTART_GAP                       1000 // ms
+
+// only every n-th chunk is time-stretched or compressed to keep the speed change inaudible
+#define AUDIO_PLAYOUT_ADJUSTMENT_INTERVAL               2
+
+// search range of the pitch period which is inserted or removed
+#define AUDIO_PLAYOUT_MIN_PITCH                         100 // Hz
+#define AUDIO_PLAYOUT_MAX_PITCH                         400 // Hz
+
+// a pitch period is only inserted or removed if the signal repeats itself well enough or the chunk is nearly silent
+#define AUDIO_PLAYOUT_MIN_CORRELATION                   0.6
+#define AUDIO_PLAYOUT_QUIET_LEVEL                       300 // average amplitude of 16 bit samples
+
+//#define APC_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Controls the playout delay of 16 bit PCM audio: the jitter of the incoming chunks determines the smallest safe
+ * buffer size and the buffer is moved towards this target by inserting or removing single pitch periods with
+ * overlap-add (WSOLA like). In contrast to dropping chunks or inserting silence this is nearly inaudible.
+ */
+class AudioPlayoutController
+{
+public:
+    AudioPlayoutController();
+
+    virtual ~AudioPlayoutController();
+
+    void Reset(int pSampleRate = 44100, int pChannels = 2);
+
+    /* called for every chunk before it is queued for playback, pBufferedSize is the amount of already queued bytes,
+     * returns either the given chunk or a time-stretched/compressed copy of it */
+    void ProcessChunk(char *pChunkBuffer, int pChunkSize, int pBufferedSize, int64_t pPlaybackGaps, char *&pResultBuffer, int &pResultSize);
+
+    /* conversion helpers */
+    int64_t GetChunkDuration(int pChunkSize); // in us
+    int GetChunkSize(int64_t pDuration); // in bytes
+
+    /* statistic */
+    int GetJitter(); // in ms
+    int GetTargetDelay(); // in ms
+    int GetCurrentDelay(); // in ms
+    int64_t GetStretchedChunks();
+    int64_t GetCompressedChunks();
+
+private:
+    void MeasureJitter(int pChunkSize, int pBufferedSize, int64_t pPlaybackGaps);
+    int FindPitchPeriod(short int *pSamples, int pFrames, float &pCorrelation, int &pLevel);
+    void OverlapAdd(short int *pOutput, short int *pFadeOut, short int *pFadeIn, int pFrames);
+
+    /* format */
+    int                 mSampleRate;
+    int                 mChannels;
+    /* jitter estimation */
+    int64_t             mLastArrivalTime;
+    int64_t             mLastChunkDuration;
+    double              mJitter; // in us
+    double              mPeakDelay; // in us
+    int64_t             mLastPlaybackGaps;
+    bool                mPlaybackStarted;
+    /* playout */
+    int64_t             mTargetDelay; // in us
+    int64_t             mCurrentDelay; // in us
+    int                 mChunksSinceAdjustment;
+    char                *mStretchBuffer;
+    int                 mStretchBufferSize;
+    int64_t             mStretchedChunks;
+    int64_t             mCompressedChunks;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,149 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: registry of the available capture devices with hotplug detection
+ * Author:  Thomas Volkert
+ * Since:   2012-12-12
+ */
+
+#ifndef _MULTIMEDIA_DEVICE_REGISTRY_
+#define _MULTIMEDIA_DEVICE_REGISTRY_
+
+#include <MediaSource.h>
+#include <HBMutex.h>
+#include <HBThread.h>
+
+#include <list>
+#include <map>
+#include <stdint.h>
+#include <string>
+
+using namespace Homer::Base;
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// time to wait for further hotplug events before the devices are enumerated again, udev adjusts access rights of new device nodes shortly after their creation
+#define DEVICE_REGISTRY_HOTPLUG_SETTLE_TIME             500 // ms
+
+// period for checking if the hotplug monitor should stop
+#define DEVICE_REGISTRY_MONITOR_PERIOD                  250 // ms
+
+#define DEVICE_REGISTRY                                 DeviceRegistry::GetInstance()
+
+//#define DR_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+typedef void (*VideoDeviceEnumerator)(VideoDevices &pVList);
+typedef void (*AudioDeviceEnumerator)(AudioDevices &pAList);
+
+class DeviceRegistryObserver
+{
+public:
+    DeviceRegistryObserver() { }
+
+    virtual ~DeviceRegistryObserver() { }
+
+    /* called from the context of the hotplug monitor after the device list of an enumerator has changed */
+    virtual void handleDeviceRegistryEvent(std::string pEnumerator, enum MediaType pMediaType) = 0;
+};
+
+typedef std::list<DeviceRegistryObserver*> DeviceRegistryObservers;
+
+///////////////////////////////////////////////////////////////////////////////
+
+class DeviceRegistry:
+    public Thread
+{
+public:
+    DeviceRegistry();
+
+    virtual ~DeviceRegistry();
+
+    static DeviceRegistry& GetInstance();
+
+    /*
+     * enumerators, hotplug events for device nodes with the given prefix (e.g., "/dev/video") cause a new enumeration,
+     * a static device list (e.g., PortAudio's snapshot from its initialization) is enumerated only once
+     */
+    void RegisterVideoEnumerator(std::string pEnumerator, VideoDeviceEnumerator pFunction, std::string pDeviceNodePrefix = "", bool pStaticDeviceList = false);
+    void RegisterAudioEnumerator(std::string pEnumerator, AudioDeviceEnumerator pFunction, std::string pDeviceNodePrefix = "", bool pStaticDeviceList = false);
+
+    /* cached device lists, only the first request enumerates the devices */
+    void GetVideoDevices(std::string pEnumerator, VideoDevices &pVList);
+    void GetAudioDevices(std::string pEnumerator, AudioDevices &pAList);
+    void Rescan(enum MediaType pMediaType = MEDIA_UNKNOWN); // enumerates the devices of all enumerators again which have neither hotplug detection nor a static device list
+
+    /* change notifications */
+    void AddObserver(DeviceRegistryObserver *pObserver);
+    void DeleteObserver(DeviceRegistryObserver *pObserver);
+
+    /* statistic */
+    int64_t GetEnumerations();
+    int64_t GetCacheHits();
+
+private:
+    struct DeviceEnumerator
+    {
+        enum MediaType          Type;
+        VideoDeviceEnumerator   VideoFunction;
+        AudioDeviceEnumerator   AudioFunction;
+        std::string             DeviceNodePrefix;
+        bool                    Hotplug;
+        bool                    Static;
+        bool                    Valid;
+        VideoDevices            VideoList;
+        AudioDevices            AudioList;
+    };
+    typedef std::map<std::string, DeviceEnumerator> DeviceEnumerators;
+
+    void RegisterEnumerator(std::string pEnumerator, DeviceEnumerator &pEntry);
+    bool Enumerate(std::string pEnumerator, bool pForce); // returns true if a formerly known device list has changed
+    void NotifyObservers(std::string pEnumerator, enum MediaType pMediaType);
+
+    /* hotplug monitor */
+    void StartMonitor();
+    void StopMonitor();
+    bool WatchDeviceNodes(std::string pDeviceNodePrefix);
+    virtual void* Run(void* pArgs = NULL);
+
+    Mutex               mMutex;
+    DeviceEnumerators   mEnumerators;
+    Mutex               mEnumerationMutex;
+    Mutex               mObserversMutex;
+    DeviceRegistryObservers mObservers;
+    int64_t             mEnumerations;
+    int64_t             mCacheHits;
+    /* hotplug monitor */
+    bool                mMonitorRunning;
+    volatile bool       mMonitorNeeded;
+    int                 mMonitorFd;
+    std::map<int, std::string> mWatchedDirectories;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace
+
+#endif
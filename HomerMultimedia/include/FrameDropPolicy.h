@@ -0,0 +1,117 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: frame dropping policy for overloaded processing stages
+ * Author:  Thomas Volkert
+ * Since:   2012-12-15
+ */
+
+#ifndef _MULTIMEDIA_FRAME_DROP_POLICY_
+#define _MULTIMEDIA_FRAME_DROP_POLICY_
+
+#include <stdint.h>
+#include <string>
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// fill levels of the queue in front of a stage where the drop levels start, each level is left again below its threshold minus the hysteresis
+#define FRAME_DROP_NON_REFERENCE_THRESHOLD              0.5
+#define FRAME_DROP_KEY_FRAMES_ONLY_THRESHOLD            0.75
+#define FRAME_DROP_HYSTERESIS                           0.1
+
+// independent frames are thinned out with a rate which grows with the fill level, at least every n-th frame survives to avoid a frozen picture
+#define FRAME_DROP_MAX_RATE                             0.9
+
+// waiting for a key frame is given up after this time, e.g., if the sender uses a very long GOP
+#define FRAME_DROP_KEY_FRAME_TIMEOUT                    5000 // ms
+
+//#define FDP_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+enum FrameDropLevel
+{
+    FRAME_DROP_LEVEL_NONE = 0, // no overload, all frames are processed
+    FRAME_DROP_LEVEL_NON_REFERENCE, // drop B-frames and other non-reference frames, independent frames are thinned out
+    FRAME_DROP_LEVEL_KEY_FRAMES_ONLY // skip to the next key frame, independent frames are thinned out further
+};
+
+/*
+ * Common backpressure handling for all stages of the media pipeline: each stage derives its overload level from the
+ * fill state of its input queue and asks the policy for every frame. In contrast to flushing a whole queue near
+ * its limit this reduces the frame rate step by step and avoids long freezes followed by bursts. The decisions
+ * are reported per stage. An instance is used by one stage and isn't thread-safe.
+ */
+class FrameDropPolicy
+{
+public:
+    FrameDropPolicy(std::string pStageName = "");
+
+    virtual ~FrameDropPolicy();
+
+    void Reset();
+
+    /* overload detection, called for each frame with the fill state of the queue in front of the stage */
+    enum FrameDropLevel Update(int pQueueUsage, int pQueueSize);
+    enum FrameDropLevel GetLevel();
+
+    /* decision for encoded frames with dependencies, key frames are never dropped */
+    bool DropEncodedFrame(bool pIsKeyFrame, bool pIsReference = true);
+    void WaitForKeyFrame(); // e.g., after the stage lost data
+    bool IsWaitingForKeyFrame(); // gives up waiting after FRAME_DROP_KEY_FRAME_TIMEOUT
+
+    /* decision for independent frames (e.g., decoded pictures), spreads the dropped frames evenly */
+    bool DropDecodedFrame();
+
+    void ReportDroppedFrame(); // for frames which the stage dropped on its own, e.g., the decoder skipped them
+
+    /* statistic */
+    std::string GetStageName();
+    int64_t GetDroppedFrames();
+    int64_t GetDroppedNonReferenceFrames();
+    int64_t GetDroppedFramesUntilKeyFrame();
+
+    static std::string LevelToString(enum FrameDropLevel pLevel);
+
+private:
+    void SetLevel(enum FrameDropLevel pLevel, int pQueueUsage, int pQueueSize);
+
+    std::string         mStageName;
+    enum FrameDropLevel mLevel;
+    float               mFillLevel;
+    float               mDropCredit;
+    bool                mWaitingForKeyFrame;
+    int64_t             mWaitingForKeyFrameStart;
+    /* statistic */
+    int64_t             mDroppedFrames;
+    int64_t             mDroppedNonReferenceFrames;
+    int64_t             mDroppedFramesUntilKeyFrame;
+    int64_t             mDroppedFramesAtLevelChange;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -30,6 +30,7 @@
 
 #include <HBCondition.h>
 #include <HBMutex.h>
+#include <HBTaskScheduler.h>
 
 #include <string>
 
@@ -73,7 +74,13 @@ public:
     virtual int GetUsage();
     virtual int GetSize();
 
+    /* readiness: the consumer task is triggered each time new data was written, it reads without blocking */
+    void SetConsumerTask(Task *pTask);
+    int TryReadFifoExclusive(char **pBuffer, int &pBufferSize); // returns -1 if the FIFO is empty
+
 protected:
+    int TakeFifoEntry(char **pBuffer, int &pBufferSize); // FIFO mutex has to be locked, it is released afterwards
+
     std::string			mName;
     MediaFifoEntry      *mFifo;
 	int					mFifoWritePtr;
@@ -83,6 +90,7 @@ protected:
 	int 				mFifoEntrySize;
     Mutex				mFifoMutex;
     Condition			mFifoDataInputCondition;
+    Task                *mConsumerTask;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
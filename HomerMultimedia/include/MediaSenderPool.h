@@ -0,0 +1,113 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: sends the queued packets of all network sinks with the tasks of the shared scheduler
+ * Author:  Thomas Volkert
+ * Since:   2012-12-09
+ */
+
+#ifndef _MULTIMEDIA_MEDIA_SENDER_POOL_
+#define _MULTIMEDIA_MEDIA_SENDER_POOL_
+
+#include <HBMutex.h>
+#include <HBTaskScheduler.h>
+
+#include <map>
+#include <stdint.h>
+
+using namespace Homer::Base;
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// packets a worker sends for one source before it serves the next one in the queue
+#define MEDIA_SENDER_POOL_QUANTUM                       32
+
+// weight of a new measurement for the average scheduling latency
+#define MEDIA_SENDER_POOL_LATENCY_WEIGHT                0.05
+
+#define MEDIA_SENDER_POOL                               MediaSenderPool::GetInstance()
+
+//#define MSP_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+// interface of a work source, e.g., a network sink with its FIFO
+class MediaSenderSource
+{
+public:
+    MediaSenderSource() { }
+    virtual ~MediaSenderSource() { }
+
+    /* sends up to the given number of queued packets, returns true if further packets are waiting */
+    virtual bool SendQueuedPackets(int pMaxPackets) = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class MediaSenderTask;
+
+class MediaSenderPool
+{
+public:
+    MediaSenderPool();
+
+    virtual ~MediaSenderPool();
+
+    static MediaSenderPool& GetInstance();
+
+    /* work sources, audio sources are served before all video sources */
+    void RegisterSource(MediaSenderSource *pSource, enum TaskPriority pPriority = TASK_PRIORITY_VIDEO);
+    void UnregisterSource(MediaSenderSource *pSource); // waits until no worker serves the source anymore
+    void NotifySource(MediaSenderSource *pSource); // the source has new packets
+
+    /* statistic */
+    int GetThreadCount();
+    int GetSourceCount();
+    int GetQueueDepth(); // sender tasks which wait for a worker
+    int GetAverageLatency(); // in us, time between the notification of a source and its service
+    int GetMaxLatency(); // in us
+    int64_t GetServedSources();
+
+private:
+    friend class MediaSenderTask;
+
+    typedef std::map<MediaSenderSource*, MediaSenderTask*> SenderTasks;
+
+    void ReportService(int64_t pLatency);
+
+    Mutex               mMutex;
+    SenderTasks         mSources;
+    /* own workers: a slow peer blocks the socket sends, this mustn't delay the tasks of the other media stages */
+    TaskScheduler       mScheduler;
+    /* statistic */
+    double              mAverageLatency;
+    int64_t             mMaxLatency;
+    int64_t             mServedSources;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace
+
+#endif
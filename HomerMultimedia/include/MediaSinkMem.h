@@ -30,6 +30,7 @@
 
 #include <string>
 
+#include <FrameDropPolicy.h>
 #include <MediaFifo.h>
 #include <MediaSink.h>
 #include <RTP.h>
@@ -88,6 +89,7 @@ protected:
     bool                mWaitUntillFirstKeyFrame;
     /* queue handling */
     MediaFifo       	*mSinkFifo;
+    FrameDropPolicy     mDropPolicy; // backpressure of the sink FIFO, only key/non-key frames are distinguishable at this point
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -31,8 +31,8 @@
 #include <Header_Ffmpeg.h>
 #include <NAPI.h>
 #include <HBSocket.h>
-#include <HBThread.h>
 #include <MediaSinkMem.h>
+#include <MediaSenderPool.h>
 
 #include <string>
 
@@ -50,7 +50,7 @@ namespace Homer { namespace Multimedia {
 ///////////////////////////////////////////////////////////////////////////////
 
 class MediaSinkNet:
-    public MediaSinkMem, public Thread
+    public MediaSinkMem, public MediaSenderSource
 {
 
 public:
@@ -72,8 +72,8 @@ protected:
     virtual void WriteFragment(char* pData, unsigned int pSize);
 
 private:
-    /* sender thread */
-    virtual void* Run(void* pArgs = NULL);
+    /* sending via the shared sender pool */
+    virtual bool SendQueuedPackets(int pMaxPackets);
     void StartSender();
     void StopSender();
 
@@ -53,6 +53,7 @@ namespace Homer { namespace Multimedia {
 
 // video/audio processing
 #define MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE                         16 * 1000 * 1000 // HDTV RGB32 picture: 1920*1080*4 = ca. 7,9 MB
+#define MEDIA_SOURCE_VIDEO_CHUNK_BUFFER_SIZE(ResX, ResY)          ((ResX) * (ResY) * 4 + FF_MIN_BUFFER_SIZE) // an encoded frame never exceeds the RGB32 picture
 
 // audio processing
 #define MEDIA_SOURCE_SAMPLES_CAPTURE_FIFO_SIZE                    64 // amount of capture buffers within the FIFO
@@ -145,6 +146,15 @@ struct ChunkDescriptor
     int64_t     Pts;
 };
 
+// format of a grabbed RGB32 video frame
+struct VideoFrameFormat
+{
+    int         ResX;
+    int         ResY;
+    bool        MirroredHorizontal;
+    bool        MirroredVertical;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // possible GrabChunk results
@@ -243,6 +253,8 @@ public:
     virtual int64_t DecodedSIFrames();
     virtual int64_t DecodedSPFrames();
     virtual int64_t DecodedBIFrames();
+    virtual int64_t DroppedFrames(); // frames which were skipped by the frame dropping policy of the decoding stages because of overload
+    virtual int64_t GetTimeToFirstFrame(); // in ms, time from the first received packet to the first output frame, 0 if not available
 
     /* end-to-end delay */
     virtual int64_t GetEndToEndDelay(); // in us
@@ -253,6 +265,16 @@ public:
     virtual GrabResolutions GetSupportedVideoGrabResolutions();
     virtual void GetVideoSourceResolution(int &pResX, int &pResY);
 
+    /* video output: scaling and mirroring for the video widget are done during decoding, returns false if the source doesn't support this */
+    virtual bool SetVideoOutputFormat(int pResX, int pResY, bool pMirrorHorizontal = false, bool pMirrorVertical = false);
+    virtual struct VideoFrameFormat GetVideoFrameFormat(); // format of the last grabbed frame
+
+    /* decoder suspension: an invisible stream is only parsed, decoding continues at the next key frame, returns false if the source doesn't support this */
+    virtual bool SetDecoderSuspended(bool pSuspended);
+    virtual bool IsDecoderSuspended();
+    /* thumbnail mode: the decoder scales and delivers only a reduced frame rate, returns false if the source doesn't support this */
+    virtual bool SetDecoderThumbnailMode(bool pActive);
+
     /* grabbing control */
     virtual void StopGrabbing();
     virtual bool Reset(enum MediaType = MEDIA_UNKNOWN);
@@ -260,6 +282,9 @@ public:
     virtual std::string GetCodecName();
     virtual std::string GetCodecLongName();
     virtual bool SetInputStreamPreferences(std::string pStreamCodec, bool pDoReset = false);
+    virtual bool RequestKeyFrame(); // the next encoded frame should be a key frame, returns false if the source doesn't encode
+    void SetPeerName(std::string pPeerName); // the peer which sends the stream, streams of known peers are opened without probing
+    std::string GetPeerName();
     virtual int GetChunkDropCounter(); // how many chunks were dropped?
     virtual int GetFragmentBufferCounter(); // how many fragments are currently buffered?
     virtual int GetFragmentBufferSize(); // how many fragments can be buffered?
@@ -472,6 +497,7 @@ protected:
     std::string         mDesiredDevice;
     std::string         mCurrentDevice;
     std::string			mCurrentDeviceName;
+    std::string         mPeerName;
     /* event handling */
     bool                mLastGrabResultWasError;
     std::string         mLastGrabFailureReason;
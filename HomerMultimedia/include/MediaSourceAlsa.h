@@ -63,6 +63,9 @@ public:
     virtual std::string GetCodecName();
     virtual std::string GetCodecLongName();
 
+private:
+    static void EnumerateAudioDevices(AudioDevices &pAList);
+
 public:
     virtual bool OpenVideoGrabDevice(int pResX = 352, int pResY = 288, float pFps = 29.97);
     virtual bool OpenAudioGrabDevice(int pSampleRate = 44100, int pChannels = 2);
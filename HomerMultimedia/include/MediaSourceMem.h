@@ -29,6 +29,7 @@
 #define _MULTIMEDIA_MEDIA_SOURCE_MEM_
 
 #include <Header_Ffmpeg.h>
+#include <FrameDropPolicy.h>
 #include <MediaFifo.h>
 #include <MediaSource.h>
 #include <RTP.h>
@@ -69,6 +70,12 @@ namespace Homer { namespace Multimedia {
 // size of one single fragment of a frame packet
 #define MEDIA_SOURCE_MEM_FRAGMENT_BUFFER_SIZE                8*1024 // 8 KB (for jumbo packets!)
 
+// time from the first received packet to the first output frame which should be reached, e.g., for incoming calls
+#define MEDIA_SOURCE_MEM_TIME_TO_FIRST_FRAME_TARGET          1500 // ms
+
+// frame rate of decoded video streams which are presented as thumbnails
+#define MEDIA_SOURCE_MEM_THUMBNAIL_FPS                       5
+
 #define MEDIA_SOURCE_MEM_FRAGMENT_INPUT_QUEUE_SIZE_LIMIT 	 ((System::GetTargetMachineType() != "x86") ? 2048 : 256) //  8 KB: 256 buffers for 32 bit targets with limit of 4 GB ram, 2*1024 buffers for 64 bit targets
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -102,6 +109,8 @@ public:
 
     /* frame stats */
     virtual bool SupportsDecoderFrameStatistics();
+    virtual int64_t DroppedFrames();
+    virtual int64_t GetTimeToFirstFrame();
 
     /* A/V sync. */
     virtual int64_t GetSynchronizationTimestamp(); // in us
@@ -110,6 +119,13 @@ public:
     /* video grabbing control */
     virtual GrabResolutions GetSupportedVideoGrabResolutions();
 
+    /* video output */
+    virtual bool SetVideoOutputFormat(int pResX, int pResY, bool pMirrorHorizontal = false, bool pMirrorVertical = false);
+    virtual struct VideoFrameFormat GetVideoFrameFormat();
+    virtual bool SetDecoderSuspended(bool pSuspended);
+    virtual bool IsDecoderSuspended();
+    virtual bool SetDecoderThumbnailMode(bool pActive);
+
     /* fps */
     virtual void SetFrameRate(float pFps);
 
@@ -151,6 +167,11 @@ protected:
     /* buffering */
     void UpdateBufferTime();
 
+    /* stream buffer */
+    void AllocateStreamPacketBuffer(unsigned int pSize);
+    void StorePendingStreamData(char *pData, int pDataSize);
+    int ReadPendingStreamData(char *pBuffer, int pBufferSize);
+
     /* FIFO helpers */
     void WriteFrameOutputBuffer(char* pBuffer, int pBufferSize, int64_t pPts);
     void ReadFrameOutputBuffer(char *pBuffer, int &pBufferSize, int64_t &pPts);
@@ -165,6 +186,9 @@ protected:
 
     unsigned long       mFragmentNumber;
     char                *mStreamPacketBuffer;
+    char                *mStreamPacketPending; // remainder of a frame which didn't fit into mStreamPacketBuffer
+    int                 mStreamPacketPendingSize;
+    int                 mStreamPacketPendingOffset;
     char                *mFragmentBuffer;
     int					mResXLastGrabbedFrame, mResYLastGrabbedFrame;
     bool                mRtpActivated;
@@ -192,12 +216,29 @@ protected:
     bool                mDecoderRecalibrateRTGrabbingAfterSeeking;
     bool                mDecoderFlushBuffersAfterSeeking;
     bool                mDecoderWaitForNextKeyFrame; // after seeking we wait for next i -frames
+    /* decoder suspension for invisible streams */
+    bool                mDecoderSuspended;
+    bool                mDecoderThumbnailMode;
+    /* time to first frame */
+    int64_t             mFirstFragmentTime;
+    int64_t             mTimeToFirstFrame;
     /* picture grabbing */
     bool                mDecoderSinglePictureGrabbed;
     int                 mDecoderSinglePictureResX;
     int                 mDecoderSinglePictureResY;
     uint8_t             *mDecoderSinglePictureData[AV_NUM_DATA_POINTERS];
     int                 mDecoderSinglePictureLineSize[AV_NUM_DATA_POINTERS];
+    /* video output format */
+    Mutex               mDecoderOutputFormatMutex;
+    VideoScaler         *mDecoderVideoScaler;
+    int                 mDecoderOutputResX;
+    int                 mDecoderOutputResY;
+    bool                mDecoderOutputMirrorHorizontal;
+    bool                mDecoderOutputMirrorVertical;
+    struct VideoFrameFormat mLastGrabbedFrameFormat;
+    /* overload handling of the decoder */
+    FrameDropPolicy     mDecoderDropPolicy;
+    volatile bool       mDecoderFragmentFifoOverflow; // set by the network thread, the decoder thread waits for the next key frame afterwards
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -116,6 +116,8 @@ public:
     virtual int64_t DecodedSIFrames();
     virtual int64_t DecodedSPFrames();
     virtual int64_t DecodedBIFrames();
+    virtual int64_t DroppedFrames();
+    virtual int64_t GetTimeToFirstFrame();
 
     /* end-to-end delay */
     virtual int64_t GetEndToEndDelay();
@@ -134,6 +136,7 @@ public:
     virtual std::string GetCodecName();
     virtual std::string GetCodecLongName();
     virtual bool SetInputStreamPreferences(std::string pStreamCodec, bool pDoReset = false);
+    virtual bool RequestKeyFrame();
     virtual int GetChunkDropCounter();
     virtual int GetChunkBufferCounter();
 
@@ -226,6 +229,8 @@ private:
     MediaFifo           *mEncoderFifo;
     Mutex				mEncoderFifoState;
     bool				mEncoderHasKeyFrame;
+    volatile bool       mEncoderForceKeyFrame;
+    int64_t             mEncoderStartTime; // time of the first encoded video frame, base for the frame numbers
     Mutex               mEncoderFifoAvailableMutex;
     AVStream            *mEncoderStream;
     /* device control */
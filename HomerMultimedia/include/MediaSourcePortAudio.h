@@ -77,6 +77,7 @@ public:
     virtual int GrabChunk(void* pChunkBuffer, int& pChunkSize, bool pDropFrame = false);
 
 private:
+    static void EnumerateAudioDevices(AudioDevices &pAList);
     static int RecordedAudioHandler(const void *pInputBuffer, void *pOutputBuffer, unsigned long pInputSize, const PaStreamCallbackTimeInfo* pTimeInfo, unsigned long pStatus, void *pUserData);
     void AssignThreadName();
 
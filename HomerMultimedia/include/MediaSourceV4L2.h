@@ -71,6 +71,9 @@ public:
     virtual std::string CurrentInputStream();
     virtual std::vector<std::string> GetInputStreams();
 
+private:
+    static void EnumerateVideoDevices(VideoDevices &pVList);
+
 public:
     virtual bool OpenVideoGrabDevice(int pResX = 352, int pResY = 288, float pFps = 30);
     virtual bool OpenAudioGrabDevice(int pSampleRate = 44100, int pChannels = 2);
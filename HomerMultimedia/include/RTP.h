@@ -33,6 +33,7 @@
 
 #include <sys/types.h>
 #include <string>
+#include <vector>
 
 namespace Homer { namespace Multimedia {
 
@@ -55,6 +56,17 @@ namespace Homer { namespace Multimedia {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// initial size of the memory for the stream of RTP packets per encoded frame, it grows if a larger frame has to be packetized
+#define RTP_PACKET_STREAM_MIN_SIZE          (64 * 1024)
+
+// use the internal RTP packetizers for H.264 (RFC 6184) and VP8 (RFC 7741) instead of the RTP muxer of ffmpeg
+#define RTP_NATIVE_PACKETIZERS
+
+// period for sending RTCP sender reports within the RTP stream of the internal packetizers
+#define RTCP_SENDER_REPORT_PERIOD           5000 // ms
+
+///////////////////////////////////////////////////////////////////////////////
+
 // from libavformat/internal.h
 #define NTP_OFFSET                          2208988800ULL
 #define NTP_OFFSET_US                       (NTP_OFFSET * 1000000ULL)
@@ -121,6 +133,31 @@ union RtpHeader{
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// NAL unit (H.264) or partition (VP8) of the last packetized frame and the RTP packets which transport it
+struct RtpNalUnit
+{
+    unsigned int    Offset; // position within the codec frame
+    unsigned int    Size;
+    int             Type; // NAL unit type for H.264, partition index for VP8
+    int             FirstPacket; // index within the RTP packet slots
+    int             LastPacket;
+};
+
+typedef std::vector<RtpNalUnit> RtpNalUnits;
+
+// RTP packet of the last packetized frame, the payload is described by its position within the codec frame
+struct RtpPacketSlot
+{
+    unsigned int    Offset; // position of the RTP packet within the packet stream
+    unsigned int    Size; // size of the entire RTP packet
+    unsigned int    PayloadOffset; // position of the transported slice within the codec frame
+    unsigned int    PayloadSize;
+};
+
+typedef std::vector<RtpPacketSlot> RtpPacketSlots;
+
+///////////////////////////////////////////////////////////////////////////////
+
 class RTP
 {
 public:
@@ -145,6 +182,8 @@ public:
     bool OpenRtpEncoder(std::string pTargetHost, unsigned int pTargetPort, AVStream *pInnerStream);
     bool CloseRtpEncoder();
 
+    /* internal H.264/VP8 packetizers: NAL units and RTP packets of the last frame given to RtpCreate */
+
     void RTPRegisterPacketStatistic(Homer::Monitor::PacketStatistic *pStatistic);
 
     /* RTCP packetizing/parsing */
@@ -168,6 +207,14 @@ private:
     bool OpenRtpEncoderH261(std::string pTargetHost, unsigned int pTargetPort, AVStream *pInnerStream);
     bool RtpCreateH261(char *&pData, unsigned int &pDataSize, int64_t pPacketPts);
 
+    /* internal RTP packetizers for h.264 and vp8 */
+    bool OpenRtpEncoderNative(std::string pTargetHost, unsigned int pTargetPort, AVStream *pInnerStream);
+    bool RtpCreateH264(char *&pData, unsigned int &pDataSize, int64_t pPacketPts);
+    bool RtpCreateVP8(char *&pData, unsigned int &pDataSize, int64_t pPacketPts);
+    bool ReserveRtpPacketSlots(unsigned int pFrameSize, unsigned int pPacketOverhead);
+    char* AddRtpPacketSlot(unsigned int pSize, bool pMarked, unsigned int pTimestamp, unsigned int pPayloadOffset, unsigned int pPayloadSize); // returns the start of the payload
+    void RtcpCreateSenderReport(unsigned int pTimestamp);
+
     /* RTP packet stream */
     static int StoreRtpPacket(void *pOpaque, uint8_t *pBuffer, int pBufferSize);
     void OpenRtpPacketStream();
@@ -208,7 +255,16 @@ private:
     /* H261 RTP encoder */
     static unsigned int mH261PayloadSizeMax;
     bool                mH261UseInternalEncoder;
-    unsigned short int  mH261LocalSequenceNumber;
+    unsigned short int  mLocalSequenceNumber;
+    /* H264/VP8 RTP encoder */
+    bool                mUseNativePacketizer;
+    unsigned int        mMaxRtpPacketSize;
+    unsigned char       mVP8PictureId;
+    unsigned int        mLocalPacketCount;
+    unsigned int        mLocalOctetCount;
+    int64_t             mLocalLastSenderReport;
+    RtpNalUnits         mNalUnits;
+    RtpPacketSlots      mPacketSlots;
     /* RTCP */
     Mutex               mSynchDataMutex;
     uint64_t            mRtcpLastRemoteNtpTime; // (NTP timestamp)
@@ -0,0 +1,106 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: cache for the parameters of known input streams
+ * Author:  Thomas Volkert
+ * Since:   2012-12-17
+ */
+
+#ifndef _MULTIMEDIA_STREAM_PARAMETER_CACHE_
+#define _MULTIMEDIA_STREAM_PARAMETER_CACHE_
+
+#include <Header_Ffmpeg.h>
+#include <MediaSource.h>
+#include <HBMutex.h>
+
+#include <map>
+#include <stdint.h>
+#include <string>
+
+namespace Homer { namespace Multimedia {
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define STREAM_PARAMETER_CACHE                          StreamParameterCache::GetInstance()
+
+//#define SPC_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Remembers the stream parameters which ffmpeg detected by probing an input stream (avformat_find_stream_info). If
+ * a stream with the same media type and codec is received again from the same peer, the parameters are applied
+ * to the new input and the probing, which reads and buffers a lot of data before the first frame can be decoded,
+ * is skipped. Resolution changes are still detected by the decoder. Entries which lead to a failed decoder
+ * setup are invalidated, so the next attempt probes the stream again.
+ */
+class StreamParameterCache
+{
+public:
+    StreamParameterCache();
+
+    virtual ~StreamParameterCache();
+
+    static StreamParameterCache& GetInstance();
+
+    static std::string CreateKey(enum MediaType pMediaType, enum CodecID pCodecId, std::string pPeerName);
+
+    /* cache access, returns true if the matching stream of the input was described by the cached parameters */
+    bool Apply(std::string pKey, AVFormatContext *pFormatContext);
+    void Store(std::string pKey, AVStream *pStream);
+    void Invalidate(std::string pKey);
+
+    /* statistic */
+    int64_t GetHits();
+    int64_t GetMisses();
+
+private:
+    struct StreamParameters
+    {
+        enum AVMediaType        Type;
+        enum CodecID            CodecId;
+        /* video */
+        int                     Width;
+        int                     Height;
+        enum PixelFormat        PixFmt;
+        AVRational              RealFrameRate;
+        /* audio */
+        int                     SampleRate;
+        int                     Channels;
+        enum AVSampleFormat     SampleFmt;
+        /* timing */
+        AVRational              StreamTimeBase;
+        AVRational              CodecTimeBase;
+    };
+    typedef std::map<std::string, StreamParameters> StreamParametersMap;
+
+    Mutex               mMutex;
+    StreamParametersMap mEntries;
+    int64_t             mHits;
+    int64_t             mMisses;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -29,9 +29,11 @@
 #define _MULTIMEDIA_VIDEO_SCALER_
 
 #include <Header_Ffmpeg.h>
+#include <FrameDropPolicy.h>
 #include <HBMutex.h>
-#include <HBThread.h>
+#include <HBTaskScheduler.h>
 #include <MediaFifo.h>
+#include <MediaSource.h>
 #include <RTP.h>
 
 #include <vector>
@@ -48,8 +50,9 @@ namespace Homer { namespace Multimedia {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// a pipeline stage which is executed by the task scheduler each time a new frame was written to its input FIFO
 class VideoScaler:
-    public Thread, public MediaFifo
+    public Task, public MediaFifo
 {
 public:
     VideoScaler(std::string pName);
@@ -73,12 +76,21 @@ public:
 
     virtual void ChangeInputResolution(int pResX, int pResY);
 
+    /* scales directly to the size of the video output instead of the target resolution, the output is limited to the buffer size of the target resolution,
+     * a resolution of 0*0 selects the target resolution again, mirroring is only supported for RGB32 output */
+    void SetOutputFormat(int pResX, int pResY, bool pMirrorHorizontal = false, bool pMirrorVertical = false);
+    struct VideoFrameFormat GetLastFrameFormat(); // format of the last frame which was read from the output FIFO
+
+    int64_t GetDroppedFrames(); // frames which were skipped because the input FIFO was overloaded
+
 private:
-    virtual void* Run(void* pArgs = NULL); // video scaler main loop
+    virtual bool Execute(); // scales one frame of the input FIFO
+    void UpdateOutputFormat();
+    void MirrorOutputFrame();
 
     std::string			mName;
     MediaFifo           *mInputFifo;
-    Mutex               mScalingThreadMutex; // we use this to avoid concurrent access to input FIFO/scaler context by ChangeInputResolution() and scaler-thread
+    Mutex               mScalingThreadMutex; // we use this to avoid concurrent access to input FIFO/scaler context by ChangeInputResolution() and the scheduler
     MediaFifo           *mOutputFifo;
     bool                mScalerNeeded;
     int                 mSourceResX;
@@ -87,9 +99,20 @@ private:
     int                 mTargetResX;
     int                 mTargetResY;
     enum PixelFormat    mTargetPixelFormat;
+    /* output format, each output FIFO entry carries its VideoFrameFormat behind the picture data */
+    int                 mRequestedOutputResX;
+    int                 mRequestedOutputResY;
+    bool                mRequestedMirrorHorizontal;
+    bool                mRequestedMirrorVertical;
+    struct VideoFrameFormat mOutputFormat;
+    struct VideoFrameFormat mLastFrameFormat;
     int                 mQueueSize;
     int                 mChunkNumber;
+    FrameDropPolicy     mDropPolicy;
     SwsContext          *mScalerContext;
+    AVFrame             *mInputFrame;
+    AVFrame             *mOutputFrame;
+    uint8_t             *mOutputBuffer;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -28,6 +28,7 @@
 #ifndef _MULTIMEDIA_WAVE_OUT_
 #define _MULTIMEDIA_WAVE_OUT_
 
+#include <AudioPlayoutController.h>
 #include <MediaSource.h>
 #include <MediaFifo.h>
 #include <MediaSourceFile.h>
@@ -69,6 +70,14 @@ public:
     virtual void LimitQueue(int pNewSize);
     virtual int64_t GetPlaybackGapsCounter();
 
+    /* adaptive playout: the buffer size follows the jitter of the incoming chunks */
+    virtual void SetAdaptivePlayout(bool pActive);
+    virtual bool GetAdaptivePlayout();
+    virtual int GetPlayoutDelay(); // in ms
+    virtual int GetPlayoutTargetDelay(); // in ms
+    virtual int GetPlayoutJitter(); // in ms
+    virtual int GetOutputLatency(); // in ms, queue and buffers behind the playout buffer up to the device, -1 if unknown
+
     /* volume control */
     virtual int GetVolume(); // range: 0-200 %
     virtual void SetVolume(int pValue);
@@ -96,6 +105,7 @@ protected:
     virtual void AdjustVolume(void *pBuffer, int pBufferSize);
     virtual void StopFilePlayback();
     virtual void AssignThreadName();
+    virtual int GetPlayoutBufferSize(); // in bytes
 
     /* file based playback - thread naming */
     bool                mHaveToAssignThreadName;
@@ -114,6 +124,9 @@ protected:
     AVFifoBuffer        *mSampleFifo; // needed to create audio buffers of fixed size (4096 bytes)
     MediaFifo           *mPlaybackFifo; // needed as FIFO buffer with prepared audio buffers for playback, avoid expensive operations like malloc/free (used when using AVFifoBuffer)
     int64_t             mPlaybackGaps;
+    /* adaptive playout */
+    bool                mAdaptivePlayout;
+    AudioPlayoutController mPlayoutController;
     /* playback of file */
     std::string         mFilePlaybackFileName;
     bool                mOpenNewFileAsap;
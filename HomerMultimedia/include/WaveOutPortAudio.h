@@ -55,6 +55,9 @@ public:
     virtual bool Play();
     virtual void Stop();
 
+    /* playback queue */
+    virtual int GetOutputLatency();
+
 public:
     /* open/close */
     virtual bool OpenWaveOutDevice(int pSampleRate = 44100, int pOutputChannels = 2);
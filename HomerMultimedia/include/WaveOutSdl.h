@@ -55,6 +55,11 @@ public:
     /* volume control */
     virtual void SetVolume(int pValue);
 
+    /* playback queue */
+    virtual int64_t GetPlaybackGapsCounter();
+    virtual void SetAdaptivePlayout(bool pActive);
+    virtual int GetOutputLatency();
+
 public:
     /* open/close */
     virtual bool OpenWaveOutDevice(int pSampleRate = 44100, int pOutputChannels = 2);
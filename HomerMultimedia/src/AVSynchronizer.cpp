@@ -0,0 +1,216 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the audio master clock A/V synchronization
+ * Author:  Thomas Volkert
+ * Since:   2012-12-14
+ */
+
+#include <AVSynchronizer.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+AVSynchronizer::AVSynchronizer(string pName)
+{
+    mName = pName;
+    Reset();
+}
+
+AVSynchronizer::~AVSynchronizer()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AVSynchronizer::Reset()
+{
+    mMutex.lock();
+
+    mAudioClockValid = false;
+    mAudioClockOffset = 0;
+    mAudioClockUpdateTime = 0;
+    mDrift = 0;
+    mLastScheduleTime = 0;
+    mPresentedFrames = 0;
+    mDelayedFrames = 0;
+    mDroppedFrames = 0;
+
+    mMutex.unlock();
+}
+
+void AVSynchronizer::UpdateAudioClock(int64_t pSynchronizationTimestamp, int64_t pPlayoutDelay)
+{
+    // no RTCP reference available yet
+    if (pSynchronizationTimestamp == 0)
+        return;
+
+    int64_t tCurrentTime = Time::GetTimeStamp();
+
+    // the sample which is played now was sent pPlayoutDelay before the last queued one
+    int64_t tOffset = pSynchronizationTimestamp - pPlayoutDelay - tCurrentTime;
+
+    mMutex.lock();
+
+    if ((!mAudioClockValid) || (tCurrentTime - mAudioClockUpdateTime > AV_SYNC_AUDIO_CLOCK_TIMEOUT * 1000) || (tOffset - mAudioClockOffset > AV_SYNC_AUDIO_CLOCK_RESET * 1000) || (mAudioClockOffset - tOffset > AV_SYNC_AUDIO_CLOCK_RESET * 1000))
+    {
+        if (mAudioClockValid)
+            LOG(LOG_VERBOSE, "Audio clock of %s jumped by %ld ms", mName.c_str(), (tOffset - mAudioClockOffset) / 1000);
+        mAudioClockOffset = tOffset;
+        mAudioClockValid = true;
+    }else
+    {
+        // smooth the jitter of chunk arrival and playout delay measurement
+        mAudioClockOffset += (int64_t)((tOffset - mAudioClockOffset) * AV_SYNC_AUDIO_CLOCK_WEIGHT);
+    }
+    mAudioClockUpdateTime = tCurrentTime;
+
+    mMutex.unlock();
+}
+
+bool AVSynchronizer::GetAudioClock(int64_t &pClock)
+{
+    bool tResult = false;
+    int64_t tCurrentTime = Time::GetTimeStamp();
+
+    mMutex.lock();
+
+    if ((mAudioClockValid) && (tCurrentTime - mAudioClockUpdateTime <= AV_SYNC_AUDIO_CLOCK_TIMEOUT * 1000))
+    {
+        pClock = tCurrentTime + mAudioClockOffset;
+        tResult = true;
+    }
+
+    mMutex.unlock();
+
+    return tResult;
+}
+
+enum AVSyncAction AVSynchronizer::ScheduleVideoFrame(int64_t pSynchronizationTimestamp, float pFrameRate, int64_t &pWaitTime, int64_t &pClockCorrection)
+{
+    enum AVSyncAction tResult = AV_SYNC_PRESENT;
+    int64_t tAudioClock;
+
+    pWaitTime = 0;
+    pClockCorrection = 0;
+
+    // without audio clock or RTCP reference the video source plays on its own
+    if ((pSynchronizationTimestamp == 0) || (!GetAudioClock(tAudioClock)))
+    {
+        mMutex.lock();
+        mDrift = 0;
+        mLastScheduleTime = 0;
+        mPresentedFrames++;
+        mMutex.unlock();
+        return AV_SYNC_PRESENT;
+    }
+
+    int64_t tDrift = pSynchronizationTimestamp - tAudioClock;
+    if ((tDrift > AV_SYNC_MAX_PLAUSIBLE_DRIFT * 1000 * 1000) || (tDrift < -AV_SYNC_MAX_PLAUSIBLE_DRIFT * 1000 * 1000))
+    {
+        #ifdef AVS_DEBUG
+            LOG(LOG_WARN, "Ignoring implausible A/V drift of %ld ms for %s", tDrift / 1000, mName.c_str());
+        #endif
+        mMutex.lock();
+        mPresentedFrames++;
+        mMutex.unlock();
+        return AV_SYNC_PRESENT;
+    }
+
+    int64_t tFramePeriod = (pFrameRate >= 1.0) ? (int64_t)(1000 * 1000 / pFrameRate) : 40 * 1000;
+
+    mMutex.lock();
+
+    if (tDrift > tFramePeriod / 2)
+    {// video is early: hold the frame back, the last one stays visible, and move the video schedule backwards
+        pWaitTime = (tDrift < AV_SYNC_MAX_WAIT * 1000) ? tDrift : AV_SYNC_MAX_WAIT * 1000;
+        pClockCorrection = -tDrift;
+        tResult = AV_SYNC_WAIT;
+        mDelayedFrames++;
+    }else if (tDrift < -tFramePeriod)
+    {// video is late by more than one frame: skip the frame and move the video schedule forwards to catch up
+        pClockCorrection = -tDrift;
+        tResult = AV_SYNC_DROP;
+        mDroppedFrames++;
+    }else if (tDrift < -tFramePeriod / 2)
+    {// video is slightly late: present it and catch up with the next frames
+        pClockCorrection = -tDrift;
+        mPresentedFrames++;
+    }else
+    {// in sync: compensate the remaining drift in small steps to avoid visible jumps
+        pClockCorrection = (int64_t)(-tDrift * AV_SYNC_SLEW_WEIGHT);
+        mPresentedFrames++;
+    }
+
+    mDrift = tDrift;
+    mLastScheduleTime = Time::GetTimeStamp();
+
+    mMutex.unlock();
+
+    #ifdef AVS_DEBUG
+        LOG(LOG_VERBOSE, "Video frame of %s has drift of %ld ms, action: %d, wait: %ld ms, correction: %ld us", mName.c_str(), tDrift / 1000, tResult, pWaitTime / 1000, pClockCorrection);
+    #endif
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AVSynchronizer::IsSynchronizing()
+{
+    bool tResult;
+
+    mMutex.lock();
+    tResult = ((mLastScheduleTime != 0) && (Time::GetTimeStamp() - mLastScheduleTime <= AV_SYNC_AUDIO_CLOCK_TIMEOUT * 1000));
+    mMutex.unlock();
+
+    return tResult;
+}
+
+int64_t AVSynchronizer::GetDrift()
+{
+    return mDrift;
+}
+
+int64_t AVSynchronizer::GetPresentedFrames()
+{
+    return mPresentedFrames;
+}
+
+int64_t AVSynchronizer::GetDelayedFrames()
+{
+    return mDelayedFrames;
+}
+
+int64_t AVSynchronizer::GetDroppedFrames()
+{
+    return mDroppedFrames;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
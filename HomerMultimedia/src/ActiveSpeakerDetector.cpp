@@ -0,0 +1,214 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the active speaker detection and video subscription policy
+ * Author:  Thomas Volkert
+ * Since:   2012-12-16
+ */
+
+#include <ActiveSpeakerDetector.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+using namespace Homer::Base;
+
+///////////////////////////////////////////////////////////////////////////////
+
+ActiveSpeakerDetector::ActiveSpeakerDetector(int pThumbnails)
+{
+    mThumbnails = pThumbnails;
+    Reset();
+}
+
+ActiveSpeakerDetector::~ActiveSpeakerDetector()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ActiveSpeakerDetector::Reset()
+{
+    mSpeakers.clear();
+    mActiveSpeaker = "";
+    mCandidate = "";
+    mCandidateSince = 0;
+}
+
+int ActiveSpeakerDetector::FindParticipant(string pParticipant)
+{
+    for (int i = 0; i < (int)mSpeakers.size(); i++)
+    {
+        if (mSpeakers[i].Name == pParticipant)
+            return i;
+    }
+
+    return -1;
+}
+
+void ActiveSpeakerDetector::UpdateAudioLevel(string pParticipant, int pLevel)
+{
+    int tIndex = FindParticipant(pParticipant);
+
+    if (tIndex < 0)
+    {
+        LOG(LOG_VERBOSE, "Adding participant %s to active speaker detection", pParticipant.c_str());
+        SpeakerState tState;
+        tState.Name = pParticipant;
+        tState.Level = 0;
+        tState.LastSpeakingTime = 0;
+        mSpeakers.push_back(tState);
+        tIndex = (int)mSpeakers.size() - 1;
+    }
+
+    mSpeakers[tIndex].Level += (pLevel - mSpeakers[tIndex].Level) * ACTIVE_SPEAKER_LEVEL_WEIGHT;
+}
+
+void ActiveSpeakerDetector::RemoveParticipant(string pParticipant)
+{
+    int tIndex = FindParticipant(pParticipant);
+
+    if (tIndex < 0)
+        return;
+
+    LOG(LOG_VERBOSE, "Removing participant %s from active speaker detection", pParticipant.c_str());
+    mSpeakers.erase(mSpeakers.begin() + tIndex);
+    if (mActiveSpeaker == pParticipant)
+        mActiveSpeaker = "";
+    if (mCandidate == pParticipant)
+        mCandidate = "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ActiveSpeakerDetector::Process()
+{
+    bool tResult = false;
+    int64_t tCurrentTime = Time::GetTimeStamp();
+    int tLoudest = -1;
+    float tLoudestLevel = ACTIVE_SPEAKER_LEVEL_THRESHOLD;
+
+    for (int i = 0; i < (int)mSpeakers.size(); i++)
+    {
+        if (mSpeakers[i].Level >= tLoudestLevel)
+        {
+            tLoudest = i;
+            tLoudestLevel = mSpeakers[i].Level;
+        }
+    }
+
+    if ((tLoudest < 0) || (mSpeakers[tLoudest].Name == mActiveSpeaker))
+    {// silence or the active speaker continues: the active speaker stays
+        mCandidate = "";
+    }else if (mSpeakers[tLoudest].Name != mCandidate)
+    {// somebody else starts to speak
+        mCandidate = mSpeakers[tLoudest].Name;
+        mCandidateSince = tCurrentTime;
+        #ifdef ASD_DEBUG
+            LOG(LOG_VERBOSE, "New speaker candidate %s with level %.1f", mCandidate.c_str(), tLoudestLevel);
+        #endif
+    }else if (tCurrentTime - mCandidateSince >= ACTIVE_SPEAKER_MIN_SPEAKING_TIME * 1000)
+    {// the candidate has dominated long enough
+        LOG(LOG_VERBOSE, "Active speaker changed from \"%s\" to \"%s\"", mActiveSpeaker.c_str(), mCandidate.c_str());
+        mActiveSpeaker = mCandidate;
+        mCandidate = "";
+        tResult = true;
+    }
+
+    // the ranking of the recent speakers is based on the time they were the active speaker
+    int tActiveSpeaker = FindParticipant(mActiveSpeaker);
+    if (tActiveSpeaker >= 0)
+        mSpeakers[tActiveSpeaker].LastSpeakingTime = tCurrentTime;
+
+    return tResult;
+}
+
+string ActiveSpeakerDetector::GetActiveSpeaker()
+{
+    return mActiveSpeaker;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ActiveSpeakerDetector::SetThumbnails(int pThumbnails)
+{
+    if (pThumbnails < 0)
+        pThumbnails = 0;
+    mThumbnails = pThumbnails;
+}
+
+int ActiveSpeakerDetector::GetThumbnails()
+{
+    return mThumbnails;
+}
+
+enum VideoSubscription ActiveSpeakerDetector::GetVideoSubscription(string pParticipant)
+{
+    int tIndex = FindParticipant(pParticipant);
+
+    // unknown participants aren't restricted
+    if (tIndex < 0)
+        return VIDEO_SUBSCRIPTION_FULL;
+
+    // rank: the active speaker first, then the most recent speakers, then the silent participants in joining order
+    const SpeakerState &tState = mSpeakers[tIndex];
+    int tRank = 0;
+    if (tState.Name != mActiveSpeaker)
+    {
+        for (int i = 0; i < (int)mSpeakers.size(); i++)
+        {
+            if (i == tIndex)
+                continue;
+            if ((mSpeakers[i].Name == mActiveSpeaker) ||
+                (mSpeakers[i].LastSpeakingTime > tState.LastSpeakingTime) ||
+                ((mSpeakers[i].LastSpeakingTime == tState.LastSpeakingTime) && (i < tIndex)))
+                tRank++;
+        }
+    }
+
+    if (tRank == 0)
+        return VIDEO_SUBSCRIPTION_FULL;
+    if (tRank <= mThumbnails)
+        return VIDEO_SUBSCRIPTION_THUMBNAIL;
+    return VIDEO_SUBSCRIPTION_PAUSED;
+}
+
+string ActiveSpeakerDetector::VideoSubscriptionToString(enum VideoSubscription pSubscription)
+{
+    switch(pSubscription)
+    {
+        case VIDEO_SUBSCRIPTION_FULL:
+            return "full";
+        case VIDEO_SUBSCRIPTION_THUMBNAIL:
+            return "thumbnail";
+        case VIDEO_SUBSCRIPTION_PAUSED:
+            return "paused";
+        default:
+            return "unknown";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -0,0 +1,321 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the adaptive audio playout
+ * Author:  Thomas Volkert
+ * Since:   2012-12-13
+ */
+
+#include <AudioPlayoutController.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+using namespace Homer::Base;
+
+///////////////////////////////////////////////////////////////////////////////
+
+AudioPlayoutController::AudioPlayoutController()
+{
+    mStretchBuffer = NULL;
+    mStretchBufferSize = 0;
+    Reset();
+}
+
+AudioPlayoutController::~AudioPlayoutController()
+{
+    free(mStretchBuffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AudioPlayoutController::Reset(int pSampleRate, int pChannels)
+{
+    mSampleRate = pSampleRate;
+    mChannels = pChannels;
+    mLastArrivalTime = 0;
+    mLastChunkDuration = 0;
+    mJitter = 0;
+    mPeakDelay = 0;
+    mLastPlaybackGaps = -1;
+    mPlaybackStarted = false;
+    mTargetDelay = AUDIO_PLAYOUT_MIN_DELAY * 1000;
+    mCurrentDelay = 0;
+    mChunksSinceAdjustment = 0;
+    mStretchedChunks = 0;
+    mCompressedChunks = 0;
+}
+
+int64_t AudioPlayoutController::GetChunkDuration(int pChunkSize)
+{
+    if ((mSampleRate <= 0) || (mChannels <= 0))
+        return 0;
+
+    return (int64_t)pChunkSize / (2 /* 16 bits per sample */ * mChannels) * 1000 * 1000 / mSampleRate;
+}
+
+int AudioPlayoutController::GetChunkSize(int64_t pDuration)
+{
+    return (int)(pDuration * mSampleRate / (1000 * 1000)) * 2 /* 16 bits per sample */ * mChannels;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AudioPlayoutController::MeasureJitter(int pChunkSize, int pBufferedSize, int64_t pPlaybackGaps)
+{
+    int64_t tArrivalTime = Time::GetTimeStamp();
+    int64_t tChunkDuration = GetChunkDuration(pChunkSize);
+
+    if (mLastArrivalTime != 0)
+    {
+        // deviation of the arrival time from the one the previous chunk's duration promised
+        int64_t tDelay = tArrivalTime - mLastArrivalTime - mLastChunkDuration;
+        if (tDelay > AUDIO_PLAYOUT_RESTART_GAP * 1000)
+        {
+            LOG(LOG_VERBOSE, "Audio stream restarted after %ld ms, restarting playout measurement", tDelay / 1000);
+            mPlaybackStarted = false;
+        }else
+        {
+            // jitter estimation as in RFC 3550
+            mJitter += ((double)(tDelay < 0 ? -tDelay : tDelay) - mJitter) / 16;
+            if (tDelay > mPeakDelay)
+                mPeakDelay = tDelay;
+        }
+    }
+
+    // the remembered delay spike fades out slowly
+    mPeakDelay *= pow(0.5, (double)tChunkDuration / (AUDIO_PLAYOUT_PEAK_HALF_LIFE * 1000));
+
+    // the device ran dry: the target was too small, grow it by one chunk
+    if ((mPlaybackStarted) && ((pBufferedSize == 0) || ((mLastPlaybackGaps >= 0) && (pPlaybackGaps > mLastPlaybackGaps))))
+    {
+        if (mPeakDelay < mTargetDelay)
+            mPeakDelay = mTargetDelay;
+        mPeakDelay += tChunkDuration;
+        #ifdef APC_DEBUG
+            LOG(LOG_VERBOSE, "Playback underrun detected, growing peak delay to %.1f ms", mPeakDelay / 1000);
+        #endif
+    }
+
+    mLastArrivalTime = tArrivalTime;
+    mLastChunkDuration = tChunkDuration;
+    mLastPlaybackGaps = pPlaybackGaps;
+    mPlaybackStarted = true;
+
+    // derive the smallest safe playout delay
+    double tTargetDelay = AUDIO_PLAYOUT_JITTER_FACTOR * mJitter;
+    if (mPeakDelay > tTargetDelay)
+        tTargetDelay = mPeakDelay;
+    tTargetDelay += AUDIO_PLAYOUT_SAFETY_MARGIN * 1000;
+    if (tTargetDelay < AUDIO_PLAYOUT_MIN_DELAY * 1000)
+        tTargetDelay = AUDIO_PLAYOUT_MIN_DELAY * 1000;
+    if (tTargetDelay > AUDIO_PLAYOUT_MAX_DELAY * 1000)
+        tTargetDelay = AUDIO_PLAYOUT_MAX_DELAY * 1000;
+    mTargetDelay = (int64_t)tTargetDelay;
+}
+
+int AudioPlayoutController::FindPitchPeriod(short int *pSamples, int pFrames, float &pCorrelation, int &pLevel)
+{
+    int tMinPeriod = mSampleRate / AUDIO_PLAYOUT_MAX_PITCH;
+    int tMaxPeriod = mSampleRate / AUDIO_PLAYOUT_MIN_PITCH;
+
+    // two periods have to fit into the chunk
+    if (tMaxPeriod > pFrames / 2)
+        tMaxPeriod = pFrames / 2;
+    if ((tMinPeriod < 1) || (tMaxPeriod < tMinPeriod))
+        return 0;
+
+    int tWindow = tMaxPeriod;
+
+    // average amplitude of the mono signal
+    int64_t tLevel = 0;
+    for (int i = 0; i < 2 * tMaxPeriod; i++)
+    {
+        int tMono = 0;
+        for (int c = 0; c < mChannels; c++)
+            tMono += pSamples[i * mChannels + c];
+        tMono /= mChannels;
+        tLevel += (tMono < 0 ? -tMono : tMono);
+    }
+    pLevel = (int)(tLevel / (2 * tMaxPeriod));
+
+    // normalized cross correlation between the signal and its shifted version, every second frame is enough for the estimation
+    int tBestPeriod = tMaxPeriod;
+    double tBestCorrelation = 0;
+    for (int tPeriod = tMinPeriod; tPeriod <= tMaxPeriod; tPeriod++)
+    {
+        int64_t tCross = 0, tEnergy1 = 0, tEnergy2 = 0;
+        for (int i = 0; i < tWindow; i += 2)
+        {
+            int tMono1 = 0, tMono2 = 0;
+            for (int c = 0; c < mChannels; c++)
+            {
+                tMono1 += pSamples[i * mChannels + c];
+                tMono2 += pSamples[(i + tPeriod) * mChannels + c];
+            }
+            tMono1 /= mChannels;
+            tMono2 /= mChannels;
+            tCross += (int64_t)tMono1 * tMono2;
+            tEnergy1 += (int64_t)tMono1 * tMono1;
+            tEnergy2 += (int64_t)tMono2 * tMono2;
+        }
+        if ((tEnergy1 == 0) || (tEnergy2 == 0))
+            continue;
+        double tCorrelation = (double)tCross / sqrt((double)tEnergy1 * (double)tEnergy2);
+        if (tCorrelation > tBestCorrelation)
+        {
+            tBestCorrelation = tCorrelation;
+            tBestPeriod = tPeriod;
+        }
+    }
+
+    pCorrelation = (float)tBestCorrelation;
+
+    return tBestPeriod;
+}
+
+void AudioPlayoutController::OverlapAdd(short int *pOutput, short int *pFadeOut, short int *pFadeIn, int pFrames)
+{
+    for (int i = 0; i < pFrames; i++)
+    {
+        for (int c = 0; c < mChannels; c++)
+        {
+            int tIndex = i * mChannels + c;
+            pOutput[tIndex] = (short int)(((int)pFadeOut[tIndex] * (pFrames - i) + (int)pFadeIn[tIndex] * i) / pFrames);
+        }
+    }
+}
+
+void AudioPlayoutController::ProcessChunk(char *pChunkBuffer, int pChunkSize, int pBufferedSize, int64_t pPlaybackGaps, char *&pResultBuffer, int &pResultSize)
+{
+    pResultBuffer = pChunkBuffer;
+    pResultSize = pChunkSize;
+
+    if ((mChannels <= 0) || (pChunkSize <= 0))
+        return;
+
+    MeasureJitter(pChunkSize, pBufferedSize, pPlaybackGaps);
+
+    mCurrentDelay = GetChunkDuration(pBufferedSize);
+
+    mChunksSinceAdjustment++;
+    if (mChunksSinceAdjustment < AUDIO_PLAYOUT_ADJUSTMENT_INTERVAL)
+        return;
+
+    bool tCompress = (mCurrentDelay > mTargetDelay + AUDIO_PLAYOUT_HYSTERESIS * 1000);
+    bool tStretch = (mCurrentDelay < mTargetDelay - AUDIO_PLAYOUT_HYSTERESIS * 1000);
+    if ((!tCompress) && (!tStretch))
+        return;
+
+    int tFrameSize = 2 /* 16 bits per sample */ * mChannels;
+    int tFrames = pChunkSize / tFrameSize;
+    short int *tInput = (short int*)pChunkBuffer;
+
+    float tCorrelation = 0;
+    int tLevel = 0;
+    int tPeriod = FindPitchPeriod(tInput, tFrames, tCorrelation, tLevel);
+    if (tPeriod <= 0)
+        return;
+
+    // avoid audible artifacts: signal doesn't repeat itself and isn't quiet, try again with the next chunk
+    if ((tCorrelation < AUDIO_PLAYOUT_MIN_CORRELATION) && (tLevel > AUDIO_PLAYOUT_QUIET_LEVEL))
+    {
+        #ifdef APC_DEBUG
+            LOG(LOG_VERBOSE, "Skipping playout adjustment, correlation: %.2f, level: %d", tCorrelation, tLevel);
+        #endif
+        return;
+    }
+
+    int tNeededSize = (tFrames + tPeriod) * tFrameSize;
+    if (tNeededSize > mStretchBufferSize)
+    {
+        char *tBuffer = (char*)realloc(mStretchBuffer, tNeededSize);
+        if (tBuffer == NULL)
+        {
+            LOG(LOG_ERROR, "Failed to allocate time-stretching buffer of %d bytes", tNeededSize);
+            return;
+        }
+        mStretchBuffer = tBuffer;
+        mStretchBufferSize = tNeededSize;
+    }
+    short int *tOutput = (short int*)mStretchBuffer;
+
+    if (tCompress)
+    {
+        // remove one period: the first two periods are merged into one
+        OverlapAdd(tOutput, tInput, tInput + tPeriod * mChannels, tPeriod);
+        memcpy(tOutput + tPeriod * mChannels, tInput + 2 * tPeriod * mChannels, (tFrames - 2 * tPeriod) * tFrameSize);
+        pResultSize = (tFrames - tPeriod) * tFrameSize;
+        mCompressedChunks++;
+    }else
+    {
+        // insert one period: the second period is faded over into a repetition of the first one
+        memcpy(tOutput, tInput, tPeriod * tFrameSize);
+        OverlapAdd(tOutput + tPeriod * mChannels, tInput + tPeriod * mChannels, tInput, tPeriod);
+        memcpy(tOutput + 2 * tPeriod * mChannels, tInput + tPeriod * mChannels, (tFrames - tPeriod) * tFrameSize);
+        pResultSize = (tFrames + tPeriod) * tFrameSize;
+        mStretchedChunks++;
+    }
+    pResultBuffer = mStretchBuffer;
+    mChunksSinceAdjustment = 0;
+
+    #ifdef APC_DEBUG
+        LOG(LOG_VERBOSE, "%s chunk by %d frames (correlation: %.2f), delay: %ld ms, target: %ld ms, jitter: %.1f ms", tCompress ? "Compressed" : "Stretched", tPeriod, tCorrelation, mCurrentDelay / 1000, mTargetDelay / 1000, mJitter / 1000);
+    #endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int AudioPlayoutController::GetJitter()
+{
+    return (int)(mJitter / 1000);
+}
+
+int AudioPlayoutController::GetTargetDelay()
+{
+    return (int)(mTargetDelay / 1000);
+}
+
+int AudioPlayoutController::GetCurrentDelay()
+{
+    return (int)(mCurrentDelay / 1000);
+}
+
+int64_t AudioPlayoutController::GetStretchedChunks()
+{
+    return mStretchedChunks;
+}
+
+int64_t AudioPlayoutController::GetCompressedChunks()
+{
+    return mCompressedChunks;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -0,0 +1,473 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the device registry
+ * Author:  Thomas Volkert
+ * Since:   2012-12-12
+ */
+
+#include <DeviceRegistry.h>
+#include <ProcessStatisticService.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+#include <set>
+
+#if defined(LINUX)
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+using namespace Homer::Monitor;
+
+static DeviceRegistry sDeviceRegistry;
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool EqualVideoDevices(VideoDevices &pList1, VideoDevices &pList2)
+{
+    if (pList1.size() != pList2.size())
+        return false;
+
+    for (unsigned int i = 0; i < pList1.size(); i++)
+    {
+        if ((pList1[i].Name != pList2[i].Name) || (pList1[i].Card != pList2[i].Card) || (pList1[i].Type != pList2[i].Type))
+            return false;
+    }
+
+    return true;
+}
+
+static bool EqualAudioDevices(AudioDevices &pList1, AudioDevices &pList2)
+{
+    if (pList1.size() != pList2.size())
+        return false;
+
+    for (unsigned int i = 0; i < pList1.size(); i++)
+    {
+        if ((pList1[i].Name != pList2[i].Name) || (pList1[i].Card != pList2[i].Card) || (pList1[i].IoType != pList2[i].IoType))
+            return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+DeviceRegistry::DeviceRegistry()
+{
+    mEnumerations = 0;
+    mCacheHits = 0;
+    mMonitorRunning = false;
+    mMonitorNeeded = false;
+    mMonitorFd = -1;
+}
+
+DeviceRegistry::~DeviceRegistry()
+{
+    StopMonitor();
+}
+
+DeviceRegistry& DeviceRegistry::GetInstance()
+{
+    return sDeviceRegistry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeviceRegistry::RegisterVideoEnumerator(string pEnumerator, VideoDeviceEnumerator pFunction, string pDeviceNodePrefix, bool pStaticDeviceList)
+{
+    DeviceEnumerator tEntry;
+
+    tEntry.Type = MEDIA_VIDEO;
+    tEntry.VideoFunction = pFunction;
+    tEntry.AudioFunction = NULL;
+    tEntry.DeviceNodePrefix = pDeviceNodePrefix;
+    tEntry.Hotplug = false;
+    tEntry.Static = pStaticDeviceList;
+    tEntry.Valid = false;
+
+    RegisterEnumerator(pEnumerator, tEntry);
+}
+
+void DeviceRegistry::RegisterAudioEnumerator(string pEnumerator, AudioDeviceEnumerator pFunction, string pDeviceNodePrefix, bool pStaticDeviceList)
+{
+    DeviceEnumerator tEntry;
+
+    tEntry.Type = MEDIA_AUDIO;
+    tEntry.VideoFunction = NULL;
+    tEntry.AudioFunction = pFunction;
+    tEntry.DeviceNodePrefix = pDeviceNodePrefix;
+    tEntry.Hotplug = false;
+    tEntry.Static = pStaticDeviceList;
+    tEntry.Valid = false;
+
+    RegisterEnumerator(pEnumerator, tEntry);
+}
+
+void DeviceRegistry::RegisterEnumerator(string pEnumerator, DeviceEnumerator &pEntry)
+{
+    mMutex.lock();
+
+    // each media source instance registers its enumerator, only the first registration is stored
+    if (mEnumerators.find(pEnumerator) != mEnumerators.end())
+    {
+        mMutex.unlock();
+        return;
+    }
+
+    mEnumerators[pEnumerator] = pEntry;
+    LOG(LOG_VERBOSE, "Registered %s device enumerator \"%s\"", (pEntry.Type == MEDIA_VIDEO) ? "video" : "audio", pEnumerator.c_str());
+
+    if (pEntry.DeviceNodePrefix != "")
+    {
+        StartMonitor();
+        if (WatchDeviceNodes(pEntry.DeviceNodePrefix))
+            mEnumerators[pEnumerator].Hotplug = true;
+        else
+            LOG(LOG_WARN, "Hotplug detection for \"%s\" isn't available, its devices are only updated by an explicit rescan", pEnumerator.c_str());
+    }
+
+    mMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool DeviceRegistry::Enumerate(string pEnumerator, bool pForce)
+{
+    bool tResult = false;
+    VideoDevices tVList;
+    AudioDevices tAList;
+
+    // only one enumeration at the same time, the registry itself stays available for cache requests
+    mEnumerationMutex.lock();
+
+    mMutex.lock();
+    DeviceEnumerators::iterator tIt = mEnumerators.find(pEnumerator);
+    if ((tIt == mEnumerators.end()) || ((!pForce) && (tIt->second.Valid)))
+    {
+        // unknown enumerator or another thread has enumerated the devices in the meantime
+        mMutex.unlock();
+        mEnumerationMutex.unlock();
+        return false;
+    }
+    DeviceEnumerator tEntry = tIt->second;
+    mMutex.unlock();
+
+    int64_t tStartTime = Time::GetTimeStamp();
+    if (tEntry.Type == MEDIA_VIDEO)
+        tEntry.VideoFunction(tVList);
+    else
+        tEntry.AudioFunction(tAList);
+    LOG(LOG_VERBOSE, "Enumerated devices of \"%s\" within %ld us", pEnumerator.c_str(), Time::GetTimeStamp() - tStartTime);
+
+    mMutex.lock();
+    tIt = mEnumerators.find(pEnumerator);
+    if (tEntry.Type == MEDIA_VIDEO)
+    {
+        tResult = ((tIt->second.Valid) && (!EqualVideoDevices(tIt->second.VideoList, tVList)));
+        tIt->second.VideoList = tVList;
+    }else
+    {
+        tResult = ((tIt->second.Valid) && (!EqualAudioDevices(tIt->second.AudioList, tAList)));
+        tIt->second.AudioList = tAList;
+    }
+    tIt->second.Valid = true;
+    mEnumerations++;
+    mMutex.unlock();
+
+    mEnumerationMutex.unlock();
+
+    return tResult;
+}
+
+void DeviceRegistry::GetVideoDevices(string pEnumerator, VideoDevices &pVList)
+{
+    mMutex.lock();
+
+    DeviceEnumerators::iterator tIt = mEnumerators.find(pEnumerator);
+    if (tIt == mEnumerators.end())
+    {
+        mMutex.unlock();
+        LOG(LOG_ERROR, "Unknown video device enumerator \"%s\"", pEnumerator.c_str());
+        return;
+    }
+
+    if (!tIt->second.Valid)
+    {
+        mMutex.unlock();
+        Enumerate(pEnumerator, false);
+        mMutex.lock();
+        tIt = mEnumerators.find(pEnumerator);
+    }else
+        mCacheHits++;
+
+    pVList.insert(pVList.end(), tIt->second.VideoList.begin(), tIt->second.VideoList.end());
+
+    mMutex.unlock();
+}
+
+void DeviceRegistry::GetAudioDevices(string pEnumerator, AudioDevices &pAList)
+{
+    mMutex.lock();
+
+    DeviceEnumerators::iterator tIt = mEnumerators.find(pEnumerator);
+    if (tIt == mEnumerators.end())
+    {
+        mMutex.unlock();
+        LOG(LOG_ERROR, "Unknown audio device enumerator \"%s\"", pEnumerator.c_str());
+        return;
+    }
+
+    if (!tIt->second.Valid)
+    {
+        mMutex.unlock();
+        Enumerate(pEnumerator, false);
+        mMutex.lock();
+        tIt = mEnumerators.find(pEnumerator);
+    }else
+        mCacheHits++;
+
+    pAList.insert(pAList.end(), tIt->second.AudioList.begin(), tIt->second.AudioList.end());
+
+    mMutex.unlock();
+}
+
+void DeviceRegistry::Rescan(enum MediaType pMediaType)
+{
+    map<string, enum MediaType> tEnumerators;
+
+    // hotplug events keep the device lists of the other enumerators up to date, static device lists never change
+    mMutex.lock();
+    DeviceEnumerators::iterator tIt;
+    for (tIt = mEnumerators.begin(); tIt != mEnumerators.end(); tIt++)
+    {
+        if ((!tIt->second.Hotplug) && (!tIt->second.Static) && ((pMediaType == MEDIA_UNKNOWN) || (pMediaType == tIt->second.Type)))
+            tEnumerators[tIt->first] = tIt->second.Type;
+    }
+    mMutex.unlock();
+
+    if (tEnumerators.empty())
+        return;
+
+    LOG(LOG_VERBOSE, "Rescanning devices of %d enumerators", (int)tEnumerators.size());
+
+    map<string, enum MediaType>::iterator tEnumIt;
+    for (tEnumIt = tEnumerators.begin(); tEnumIt != tEnumerators.end(); tEnumIt++)
+    {
+        if (Enumerate(tEnumIt->first, true))
+            NotifyObservers(tEnumIt->first, tEnumIt->second);
+    }
+
+    LOG(LOG_VERBOSE, "Device registry has enumerated %ld times and answered %ld requests from its cache", GetEnumerations(), GetCacheHits());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeviceRegistry::AddObserver(DeviceRegistryObserver *pObserver)
+{
+    mObserversMutex.lock();
+    mObservers.push_back(pObserver);
+    mObserversMutex.unlock();
+}
+
+void DeviceRegistry::DeleteObserver(DeviceRegistryObserver *pObserver)
+{
+    mObserversMutex.lock();
+    mObservers.remove(pObserver);
+    mObserversMutex.unlock();
+}
+
+void DeviceRegistry::NotifyObservers(string pEnumerator, enum MediaType pMediaType)
+{
+    LOG(LOG_INFO, "Available %s devices of \"%s\" have changed", (pMediaType == MEDIA_VIDEO) ? "video" : "audio", pEnumerator.c_str());
+
+    mObserversMutex.lock();
+    DeviceRegistryObservers::iterator tIt;
+    for (tIt = mObservers.begin(); tIt != mObservers.end(); tIt++)
+        (*tIt)->handleDeviceRegistryEvent(pEnumerator, pMediaType);
+    mObserversMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int64_t DeviceRegistry::GetEnumerations()
+{
+    return mEnumerations;
+}
+
+int64_t DeviceRegistry::GetCacheHits()
+{
+    return mCacheHits;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeviceRegistry::StartMonitor()
+{
+    if (mMonitorRunning)
+        return;
+
+    #if defined(LINUX)
+        mMonitorFd = inotify_init();
+        if (mMonitorFd < 0)
+        {
+            LOG(LOG_ERROR, "Failed to create inotify instance because of \"%s\"", strerror(errno));
+            return;
+        }
+        mMonitorNeeded = true;
+        if (!StartThread())
+        {
+            LOG(LOG_ERROR, "Failed to start hotplug monitor");
+            mMonitorNeeded = false;
+            close(mMonitorFd);
+            mMonitorFd = -1;
+            return;
+        }
+        mMonitorRunning = true;
+    #endif
+}
+
+void DeviceRegistry::StopMonitor()
+{
+    if (!mMonitorRunning)
+        return;
+
+    mMonitorNeeded = false;
+    StopThread(DEVICE_REGISTRY_MONITOR_PERIOD * 4);
+    mMonitorRunning = false;
+
+    #if defined(LINUX)
+        close(mMonitorFd);
+        mMonitorFd = -1;
+    #endif
+}
+
+bool DeviceRegistry::WatchDeviceNodes(string pDeviceNodePrefix)
+{
+    #if defined(LINUX)
+        if (mMonitorFd < 0)
+            return false;
+
+        size_t tPos = pDeviceNodePrefix.rfind('/');
+        if (tPos == string::npos)
+            return false;
+        string tDirectory = pDeviceNodePrefix.substr(0, tPos);
+
+        map<int, string>::iterator tIt;
+        for (tIt = mWatchedDirectories.begin(); tIt != mWatchedDirectories.end(); tIt++)
+        {
+            if (tIt->second == tDirectory)
+                return true;
+        }
+
+        int tWatch = inotify_add_watch(mMonitorFd, tDirectory.c_str(), IN_CREATE | IN_DELETE | IN_ATTRIB);
+        if (tWatch < 0)
+        {
+            LOG(LOG_ERROR, "Failed to watch %s because of \"%s\"", tDirectory.c_str(), strerror(errno));
+            return false;
+        }
+        mWatchedDirectories[tWatch] = tDirectory;
+        LOG(LOG_VERBOSE, "Watching %s for hotplug events", tDirectory.c_str());
+
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+void* DeviceRegistry::Run(void* pArgs)
+{
+    SVC_PROCESS_STATISTIC.AssignThreadName("Device-Monitor");
+
+    #if defined(LINUX)
+        char tBuffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        set<string> tPendingEnumerators;
+        int64_t tLastEventTime = 0;
+
+        while (mMonitorNeeded)
+        {
+            struct pollfd tPollFd;
+            tPollFd.fd = mMonitorFd;
+            tPollFd.events = POLLIN;
+            tPollFd.revents = 0;
+
+            if ((poll(&tPollFd, 1, DEVICE_REGISTRY_MONITOR_PERIOD) > 0) && (tPollFd.revents & POLLIN))
+            {
+                ssize_t tLength = read(mMonitorFd, tBuffer, sizeof(tBuffer));
+                ssize_t tOffset = 0;
+                while (tOffset < tLength)
+                {
+                    struct inotify_event *tEvent = (struct inotify_event*)(tBuffer + tOffset);
+                    tOffset += sizeof(struct inotify_event) + tEvent->len;
+                    if (tEvent->len == 0)
+                        continue;
+
+                    mMutex.lock();
+                    string tDeviceNode = mWatchedDirectories[tEvent->wd] + "/" + string(tEvent->name);
+                    DeviceEnumerators::iterator tIt;
+                    for (tIt = mEnumerators.begin(); tIt != mEnumerators.end(); tIt++)
+                    {
+                        if ((tIt->second.DeviceNodePrefix != "") && (tDeviceNode.compare(0, tIt->second.DeviceNodePrefix.size(), tIt->second.DeviceNodePrefix) == 0))
+                        {
+                            #ifdef DR_DEBUG
+                                LOG(LOG_VERBOSE, "Hotplug event 0x%x for %s, affects \"%s\"", tEvent->mask, tDeviceNode.c_str(), tIt->first.c_str());
+                            #endif
+                            tPendingEnumerators.insert(tIt->first);
+                            tLastEventTime = Time::GetTimeStamp();
+                        }
+                    }
+                    mMutex.unlock();
+                }
+            }
+
+            // enumerate again after the device nodes have settled
+            if ((tPendingEnumerators.size()) && (Time::GetTimeStamp() - tLastEventTime > DEVICE_REGISTRY_HOTPLUG_SETTLE_TIME * 1000))
+            {
+                set<string>::iterator tIt;
+                for (tIt = tPendingEnumerators.begin(); tIt != tPendingEnumerators.end(); tIt++)
+                {
+                    if (Enumerate(*tIt, true))
+                    {
+                        mMutex.lock();
+                        enum MediaType tMediaType = mEnumerators[*tIt].Type;
+                        mMutex.unlock();
+                        NotifyObservers(*tIt, tMediaType);
+                    }
+                }
+                tPendingEnumerators.clear();
+            }
+        }
+    #endif
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
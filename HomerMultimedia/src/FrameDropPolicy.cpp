@@ -0,0 +1,250 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the frame dropping policy for overloaded processing stages
+ * Author:  Thomas Volkert
+ * Since:   2012-12-15
+ */
+
+#include <FrameDropPolicy.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+using namespace Homer::Base;
+
+///////////////////////////////////////////////////////////////////////////////
+
+FrameDropPolicy::FrameDropPolicy(string pStageName)
+{
+    mStageName = pStageName;
+    Reset();
+}
+
+FrameDropPolicy::~FrameDropPolicy()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FrameDropPolicy::Reset()
+{
+    mLevel = FRAME_DROP_LEVEL_NONE;
+    mFillLevel = 0;
+    mDropCredit = 0;
+    mWaitingForKeyFrame = false;
+    mWaitingForKeyFrameStart = 0;
+    mDroppedFrames = 0;
+    mDroppedNonReferenceFrames = 0;
+    mDroppedFramesUntilKeyFrame = 0;
+    mDroppedFramesAtLevelChange = 0;
+}
+
+enum FrameDropLevel FrameDropPolicy::Update(int pQueueUsage, int pQueueSize)
+{
+    if (pQueueSize <= 0)
+        return mLevel;
+
+    mFillLevel = (float)pQueueUsage / pQueueSize;
+
+    switch(mLevel)
+    {
+        case FRAME_DROP_LEVEL_NONE:
+            if (mFillLevel >= FRAME_DROP_KEY_FRAMES_ONLY_THRESHOLD)
+                SetLevel(FRAME_DROP_LEVEL_KEY_FRAMES_ONLY, pQueueUsage, pQueueSize);
+            else if (mFillLevel >= FRAME_DROP_NON_REFERENCE_THRESHOLD)
+                SetLevel(FRAME_DROP_LEVEL_NON_REFERENCE, pQueueUsage, pQueueSize);
+            break;
+        case FRAME_DROP_LEVEL_NON_REFERENCE:
+            if (mFillLevel >= FRAME_DROP_KEY_FRAMES_ONLY_THRESHOLD)
+                SetLevel(FRAME_DROP_LEVEL_KEY_FRAMES_ONLY, pQueueUsage, pQueueSize);
+            else if (mFillLevel < FRAME_DROP_NON_REFERENCE_THRESHOLD - FRAME_DROP_HYSTERESIS)
+                SetLevel(FRAME_DROP_LEVEL_NONE, pQueueUsage, pQueueSize);
+            break;
+        case FRAME_DROP_LEVEL_KEY_FRAMES_ONLY:
+            if (mFillLevel < FRAME_DROP_NON_REFERENCE_THRESHOLD - FRAME_DROP_HYSTERESIS)
+                SetLevel(FRAME_DROP_LEVEL_NONE, pQueueUsage, pQueueSize);
+            else if (mFillLevel < FRAME_DROP_KEY_FRAMES_ONLY_THRESHOLD - FRAME_DROP_HYSTERESIS)
+                SetLevel(FRAME_DROP_LEVEL_NON_REFERENCE, pQueueUsage, pQueueSize);
+            break;
+    }
+
+    return mLevel;
+}
+
+void FrameDropPolicy::SetLevel(enum FrameDropLevel pLevel, int pQueueUsage, int pQueueSize)
+{
+    if (pLevel > mLevel)
+        LOG(LOG_WARN, "%s is overloaded (queue: %d/%d), switching from \"%s\" to \"%s\" frame dropping", mStageName.c_str(), pQueueUsage, pQueueSize, LevelToString(mLevel).c_str(), LevelToString(pLevel).c_str());
+    else
+        LOG(LOG_INFO, "%s recovers (queue: %d/%d), switching from \"%s\" to \"%s\" frame dropping, dropped %ld frames in the meantime", mStageName.c_str(), pQueueUsage, pQueueSize, LevelToString(mLevel).c_str(), LevelToString(pLevel).c_str(), mDroppedFrames - mDroppedFramesAtLevelChange);
+
+    // the references of the following frames are lost as soon as the first reference frame is dropped
+    if (pLevel == FRAME_DROP_LEVEL_KEY_FRAMES_ONLY)
+        WaitForKeyFrame();
+
+    if (pLevel == FRAME_DROP_LEVEL_NONE)
+        mDropCredit = 0;
+
+    mLevel = pLevel;
+    mDroppedFramesAtLevelChange = mDroppedFrames;
+}
+
+enum FrameDropLevel FrameDropPolicy::GetLevel()
+{
+    return mLevel;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FrameDropPolicy::DropEncodedFrame(bool pIsKeyFrame, bool pIsReference)
+{
+    if (pIsKeyFrame)
+    {
+        // a key frame resolves all dependencies, but only key frames pass as long as the heavy overload lasts
+        if ((mWaitingForKeyFrame) && (mLevel != FRAME_DROP_LEVEL_KEY_FRAMES_ONLY))
+        {
+            LOG(LOG_VERBOSE, "%s got a key frame after dropping %ld frames", mStageName.c_str(), mDroppedFramesUntilKeyFrame);
+            mWaitingForKeyFrame = false;
+        }
+        return false;
+    }
+
+    if (IsWaitingForKeyFrame())
+    {
+        #ifdef FDP_DEBUG
+            LOG(LOG_VERBOSE, "%s drops frame because it waits for a key frame", mStageName.c_str());
+        #endif
+        mDroppedFramesUntilKeyFrame++;
+        mDroppedFrames++;
+        return true;
+    }
+
+    if ((mLevel >= FRAME_DROP_LEVEL_NON_REFERENCE) && (!pIsReference))
+    {
+        #ifdef FDP_DEBUG
+            LOG(LOG_VERBOSE, "%s drops non-reference frame", mStageName.c_str());
+        #endif
+        mDroppedNonReferenceFrames++;
+        mDroppedFrames++;
+        return true;
+    }
+
+    return false;
+}
+
+void FrameDropPolicy::WaitForKeyFrame()
+{
+    if (!mWaitingForKeyFrame)
+    {
+        mWaitingForKeyFrame = true;
+        mWaitingForKeyFrameStart = Time::GetTimeStamp();
+    }
+}
+
+bool FrameDropPolicy::IsWaitingForKeyFrame()
+{
+    // checked here because a stage which lets the codec skip the non-key frames never asks for them
+    if ((mWaitingForKeyFrame) && (Time::GetTimeStamp() - mWaitingForKeyFrameStart > FRAME_DROP_KEY_FRAME_TIMEOUT * 1000))
+    {
+        LOG(LOG_WARN, "%s hasn't got a key frame within %d ms, continuing without it", mStageName.c_str(), FRAME_DROP_KEY_FRAME_TIMEOUT);
+        mWaitingForKeyFrame = false;
+    }
+
+    return mWaitingForKeyFrame;
+}
+
+bool FrameDropPolicy::DropDecodedFrame()
+{
+    if (mLevel == FRAME_DROP_LEVEL_NONE)
+        return false;
+
+    // the drop rate starts with 0 where the overload level would be left again and grows linearly up to a full queue
+    float tLowerLimit = FRAME_DROP_NON_REFERENCE_THRESHOLD - FRAME_DROP_HYSTERESIS;
+    float tRate = (mFillLevel - tLowerLimit) / (1.0 - tLowerLimit);
+    if (tRate < 0)
+        tRate = 0;
+    if (tRate > FRAME_DROP_MAX_RATE)
+        tRate = FRAME_DROP_MAX_RATE;
+
+    // error diffusion: distribute the dropped frames evenly instead of dropping bursts
+    mDropCredit += tRate;
+    if (mDropCredit >= 1.0)
+    {
+        mDropCredit -= 1.0;
+        #ifdef FDP_DEBUG
+            LOG(LOG_VERBOSE, "%s drops frame with rate %.2f", mStageName.c_str(), tRate);
+        #endif
+        mDroppedFrames++;
+        return true;
+    }
+
+    return false;
+}
+
+void FrameDropPolicy::ReportDroppedFrame()
+{
+    mDroppedFrames++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+string FrameDropPolicy::GetStageName()
+{
+    return mStageName;
+}
+
+int64_t FrameDropPolicy::GetDroppedFrames()
+{
+    return mDroppedFrames;
+}
+
+int64_t FrameDropPolicy::GetDroppedNonReferenceFrames()
+{
+    return mDroppedNonReferenceFrames;
+}
+
+int64_t FrameDropPolicy::GetDroppedFramesUntilKeyFrame()
+{
+    return mDroppedFramesUntilKeyFrame;
+}
+
+string FrameDropPolicy::LevelToString(enum FrameDropLevel pLevel)
+{
+    switch(pLevel)
+    {
+        case FRAME_DROP_LEVEL_NONE:
+            return "none";
+        case FRAME_DROP_LEVEL_NON_REFERENCE:
+            return "non-reference frames";
+        case FRAME_DROP_LEVEL_KEY_FRAMES_ONLY:
+            return "key frames only";
+        default:
+            return "unknown";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -46,6 +46,7 @@ MediaFifo::MediaFifo(std::string pName)
     mFifoReadPtr = 0;
     mFifoAvailableEntries = 0;
     mFifo = NULL;
+    mConsumerTask = NULL;
     LOG(LOG_VERBOSE, "Created abstract FIFO for %s with %d entries of %d bytes", pName.c_str(), mFifoSize, mFifoEntrySize);
 }
 
@@ -57,6 +58,7 @@ MediaFifo::MediaFifo(int pFifoSize, int pFifoEntrySize, string pName)
     mFifoWritePtr = 0;
     mFifoReadPtr = 0;
     mFifoAvailableEntries = 0;
+    mConsumerTask = NULL;
     mFifo = new MediaFifoEntry[mFifoSize];
     for (int i = 0; i < mFifoSize; i++)
 	{
@@ -208,8 +210,6 @@ int MediaFifo::GetSize()
 
 int MediaFifo::ReadFifoExclusive(char **pBuffer, int &pBufferSize)
 {
-    int tCurrentFifoReadPtr;
-
     #ifdef MF_DEBUG
         LOG(LOG_VERBOSE, "%s-FIFO: ReadFifoExclusive() START", mName.c_str());
     #endif
@@ -232,6 +232,26 @@ int MediaFifo::ReadFifoExclusive(char **pBuffer, int &pBufferSize)
         tRounds++;
     }
 
+    return TakeFifoEntry(pBuffer, pBufferSize);
+}
+
+int MediaFifo::TryReadFifoExclusive(char **pBuffer, int &pBufferSize)
+{
+    mFifoMutex.lock();
+    if (mFifoAvailableEntries < 1)
+    {
+        mFifoMutex.unlock();
+        pBufferSize = 0;
+        return -1;
+    }
+
+    return TakeFifoEntry(pBuffer, pBufferSize);
+}
+
+int MediaFifo::TakeFifoEntry(char **pBuffer, int &pBufferSize)
+{
+    int tCurrentFifoReadPtr;
+
     tCurrentFifoReadPtr = mFifoReadPtr;
 
     #ifdef MF_DEBUG
@@ -343,6 +363,15 @@ void MediaFifo::WriteFifo(char* pBuffer, int pBufferSize)
     mFifoMutex.unlock();
 	if (pBufferSize == 0)
 	    LOG(LOG_VERBOSE, "%s-FIFO: released lock after writing empty chunk", mName.c_str());
+
+	// wake up the consumer stage
+	if (mConsumerTask != NULL)
+	    TASK_SCHEDULER.Trigger(mConsumerTask);
+}
+
+void MediaFifo::SetConsumerTask(Task *pTask)
+{
+    mConsumerTask = pTask;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of a shared sender pool for network sinks
+ * Author:  Thomas Volkert
+ * Since:   2012-12-09
+ */
+
+#include <MediaSenderPool.h>
+#include <HBAtomic.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+
+static MediaSenderPool sMediaSenderPool;
+
+///////////////////////////////////////////////////////////////////////////////
+
+class MediaSenderTask:
+    public Task
+{
+public:
+    MediaSenderTask(MediaSenderPool *pPool, MediaSenderSource *pSource, enum TaskPriority pPriority);
+
+    virtual ~MediaSenderTask();
+
+    void Notify();
+
+private:
+    virtual bool Execute();
+
+    MediaSenderPool     *mPool;
+    MediaSenderSource   *mSource;
+    volatile int64_t    mNotifyTime;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+MediaSenderTask::MediaSenderTask(MediaSenderPool *pPool, MediaSenderSource *pSource, enum TaskPriority pPriority):
+    Task(pPriority, "Media-Sender")
+{
+    mPool = pPool;
+    mSource = pSource;
+    mNotifyTime = 0;
+}
+
+MediaSenderTask::~MediaSenderTask()
+{
+}
+
+void MediaSenderTask::Notify()
+{
+    // the oldest waiting notification determines the scheduling latency
+    Atomic::CompareAndSwap(&mNotifyTime, (int64_t)0, Time::GetTimeStamp());
+
+    mPool->mScheduler.Trigger(this);
+}
+
+bool MediaSenderTask::Execute()
+{
+    int64_t tNotifyTime = Atomic::Exchange(&mNotifyTime, (int64_t)0);
+    if (tNotifyTime != 0)
+        mPool->ReportService(Time::GetTimeStamp() - tNotifyTime);
+
+    // serve the source only for a limited number of packets, afterwards it has to queue up again
+    return mSource->SendQueuedPackets(MEDIA_SENDER_POOL_QUANTUM);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MediaSenderPool::MediaSenderPool()
+{
+    mAverageLatency = 0;
+    mMaxLatency = 0;
+    mServedSources = 0;
+}
+
+MediaSenderPool::~MediaSenderPool()
+{
+}
+
+MediaSenderPool& MediaSenderPool::GetInstance()
+{
+    return sMediaSenderPool;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MediaSenderPool::RegisterSource(MediaSenderSource *pSource, enum TaskPriority pPriority)
+{
+    mMutex.lock();
+
+    if (mSources.find(pSource) == mSources.end())
+    {
+        MediaSenderTask *tTask = new MediaSenderTask(this, pSource, pPriority);
+        mScheduler.Attach(tTask);
+        mSources[pSource] = tTask;
+        #ifdef MSP_DEBUG
+            LOG(LOG_VERBOSE, "Registered source %p with priority %d, sources: %d", pSource, pPriority, (int)mSources.size());
+        #endif
+    }
+
+    mMutex.unlock();
+}
+
+void MediaSenderPool::UnregisterSource(MediaSenderSource *pSource)
+{
+    MediaSenderTask *tTask = NULL;
+
+    mMutex.lock();
+
+    SenderTasks::iterator tIt = mSources.find(pSource);
+    if (tIt != mSources.end())
+    {
+        tTask = tIt->second;
+        mSources.erase(tIt);
+        #ifdef MSP_DEBUG
+            LOG(LOG_VERBOSE, "Unregistered source %p, sources: %d", pSource, (int)mSources.size());
+        #endif
+    }
+
+    mMutex.unlock();
+
+    // wait until no worker serves the source anymore
+    if (tTask != NULL)
+    {
+        mScheduler.Detach(tTask);
+        delete tTask;
+    }
+}
+
+void MediaSenderPool::NotifySource(MediaSenderSource *pSource)
+{
+    mMutex.lock();
+
+    SenderTasks::iterator tIt = mSources.find(pSource);
+    if (tIt != mSources.end())
+        tIt->second->Notify();
+
+    mMutex.unlock();
+}
+
+void MediaSenderPool::ReportService(int64_t pLatency)
+{
+    mMutex.lock();
+
+    mAverageLatency = (1 - MEDIA_SENDER_POOL_LATENCY_WEIGHT) * mAverageLatency + MEDIA_SENDER_POOL_LATENCY_WEIGHT * pLatency;
+    if (pLatency > mMaxLatency)
+        mMaxLatency = pLatency;
+    mServedSources++;
+
+    #ifdef MSP_DEBUG
+        LOG(LOG_VERBOSE, "Serving source after %ld us in queue", pLatency);
+    #endif
+
+    mMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int MediaSenderPool::GetThreadCount()
+{
+    return mScheduler.GetThreadCount();
+}
+
+int MediaSenderPool::GetSourceCount()
+{
+    int tResult;
+
+    mMutex.lock();
+    tResult = (int)mSources.size();
+    mMutex.unlock();
+
+    return tResult;
+}
+
+int MediaSenderPool::GetQueueDepth()
+{
+    return mScheduler.GetQueuedTasks(TASK_PRIORITY_AUDIO) + mScheduler.GetQueuedTasks(TASK_PRIORITY_VIDEO);
+}
+
+int MediaSenderPool::GetAverageLatency()
+{
+    return (int)mAverageLatency;
+}
+
+int MediaSenderPool::GetMaxLatency()
+{
+    return (int)mMaxLatency;
+}
+
+int64_t MediaSenderPool::GetServedSources()
+{
+    return mServedSources;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -50,7 +50,7 @@ using namespace Homer::Monitor;
 ///////////////////////////////////////////////////////////////////////////////
 
 MediaSinkMem::MediaSinkMem(string pMediaId, enum MediaSinkType pType, bool pRtpActivated):
-    MediaSink(pType), RTP()
+    MediaSink(pType), RTP(), mDropPolicy("Media sink " + pMediaId)
 {
     mLastPacketPts = 0;
     mMediaId = pMediaId;
@@ -107,11 +107,24 @@ void MediaSinkMem::ProcessPacket(char* pPacketData, unsigned int pPacketSize, AV
             return;
         }else
         {
-            LOG(LOG_VERBOSE, "Sending frame as first key frame to network sink");
+            LOG(LOG_VERBOSE, "Sending key frame to network sink, following frames are sent again");
             mWaitUntillFirstKeyFrame = false;
         }
     }
 
+    // overload: the receiver side can't keep up, skip to the next key frame instead of queuing frames which are dropped later anyway
+    if (GetDataType() == DATA_TYPE_VIDEO)
+    {
+        mDropPolicy.Update(mSinkFifo->GetUsage(), mSinkFifo->GetSize());
+        if (mDropPolicy.DropEncodedFrame(pIsKeyFrame))
+        {
+            #ifdef MSIM_DEBUG_PACKETS
+                LOG(LOG_VERBOSE, "Packet skipped because of overloaded sink FIFO");
+            #endif
+            return;
+        }
+    }
+
     if (mRtpActivated)
     {
         //###################################
@@ -180,6 +193,10 @@ void MediaSinkMem::ProcessPacket(char* pPacketData, unsigned int pPacketSize, AV
         		LOG(LOG_VERBOSE, "Max. FPS reached, packet skipped");
 			#endif
 
+            // the following frames might reference the skipped one, skip everything until the next key frame
+            if (GetDataType() == DATA_TYPE_VIDEO)
+                mWaitUntillFirstKeyFrame = true;
+
         	return;
         }
 
@@ -297,15 +314,6 @@ void MediaSinkMem::ReadFragment(char *pData, int &pDataSize)
             LOG(LOG_VERBOSE, "Delivered packet at %p with size: %5d", pData, (int)pDataSize);
         #endif
     }
-
-    // is FIFO near overload situation?
-    if (mSinkFifo->GetUsage() >= mSinkFifo->GetSize() - 4)
-    {
-        LOG(LOG_WARN, "Decoder FIFO is near overload situation, deleting all stored frames");
-
-        // delete all stored frames: it is a better for the decoding!
-        mSinkFifo->ClearFifo();
-    }
 }
 
 void MediaSinkMem::StopProcessing()
@@ -26,7 +26,6 @@
  */
 
 #include <Header_Ffmpeg.h>
-#include <ProcessStatisticService.h>
 #include <MediaSinkNet.h>
 #include <MediaSinkMem.h>
 #include <MediaSourceMem.h>
@@ -34,6 +33,7 @@
 #include <PacketStatistic.h>
 #include <RTP.h>
 #include <HBSocket.h>
+#include <HBIoEngine.h>
 #include <HBTime.h>
 #include <Logger.h>
 #include <Berkeley/SocketName.h>
@@ -185,6 +185,9 @@ MediaSinkNet::~MediaSinkNet()
 			delete mNAPIDataSocket;
     }else
     {
+        // packets in flight refer to the socket
+        if (mDataSocket != NULL)
+            IO_ENGINE.Drain(mDataSocket);
     	//HINT: socket object has to be deleted outside
     }
     free(mStreamFragmentCopyBuffer);
@@ -285,10 +288,13 @@ void MediaSinkNet::WriteFragment(char* pData, unsigned int pSize)
             if ((tFragmentData > (pData + pSize)) && (tFragmentCount))
             {
                 LOG(LOG_ERROR, "Something went wrong, we have too many fragments and would read over the last byte of the fragment buffer");
-                return;
+                break;
             }
         }
     }
+
+    // wake up the sender pool
+    MEDIA_SENDER_POOL.NotifySource(this);
 }
 
 void MediaSinkNet::StartSender()
@@ -297,113 +303,60 @@ void MediaSinkNet::StartSender()
 
 	mSenderNeeded = true;
 
-	// start sender main loop
-	StartThread();
+	// the packets are sent by the workers of the shared task scheduler, audio before video
+	MEDIA_SENDER_POOL.RegisterSource(this, (GetDataType() == DATA_TYPE_AUDIO) ? TASK_PRIORITY_AUDIO : TASK_PRIORITY_VIDEO);
 
     LOG(LOG_VERBOSE, "Sender for target %s:%u started", mTargetHost.c_str(), mTargetPort);
 }
 
 void MediaSinkNet::StopSender()
 {
-    int tSignalingRound = 0;
-    char tTmp[4];
-
     LOG(LOG_VERBOSE, "Stopping sender");
 
-    if (mSinkFifo != NULL)
-    {
-        // tell sender thread it isn't needed anymore
-    	mSenderNeeded = false;
-
-        // wait for termination of sender thread
-        do
-        {
-            if(tSignalingRound > 0)
-                LOG(LOG_WARN, "Signaling round %d to stop sender, system has high load", tSignalingRound);
-            tSignalingRound++;
-
-            // write fake data to awake sender thread as long as it still runs
-            mSinkFifo->WriteFifo(tTmp, 0);
-        }while(!StopThread(1000));
-    }
+    // tell the sender pool it isn't needed anymore, this waits until no worker is using this sink
+	mSenderNeeded = false;
+	MEDIA_SENDER_POOL.UnregisterSource(this);
 
-    LOG(LOG_VERBOSE, "Encoder stopped");
+    LOG(LOG_VERBOSE, "Sender stopped");
 }
 
-void* MediaSinkNet::Run(void* pArgs)
+bool MediaSinkNet::SendQueuedPackets(int pMaxPackets)
 {
     int tFifoEntry = 0;
     char *tBuffer;
     int tBufferSize;
+    int tSentPackets = 0;
 
-    LOG(LOG_VERBOSE, "%s Stream relay for target %s:%u started", GetDataTypeStr().c_str(), mTargetHost.c_str(), mTargetPort);
-    if (mNAPIUsed)
-    {
-        switch(GetDataType())
-        {
-            case DATA_TYPE_VIDEO:
-                SVC_PROCESS_STATISTIC.AssignThreadName("Video-Relay(NAPI," + mCodec + ")");
-                break;
-            case DATA_TYPE_AUDIO:
-                SVC_PROCESS_STATISTIC.AssignThreadName("Audio-Relay(NAPI," + mCodec + ")");
-                break;
-            default:
-                LOG(LOG_ERROR, "Unknown media type");
-                break;
-        }
-    }else
-    {
-        switch(GetDataType())
-        {
-            case MEDIA_VIDEO:
-                SVC_PROCESS_STATISTIC.AssignThreadName("Video-Relay(NET," + mCodec + ")");
-                break;
-            case MEDIA_AUDIO:
-                SVC_PROCESS_STATISTIC.AssignThreadName("Audio-Relay(NET," + mCodec + ")");
-                break;
-            default:
-                LOG(LOG_ERROR, "Unknown media type");
-                break;
-        }
-    }
+    if ((!mSenderNeeded) || (mSinkFifo == NULL))
+        return false;
 
-    while(mSenderNeeded)
+    // only one sender thread serves this sink at the same time, so the FIFO order is kept and reading can't block
+    while ((mSenderNeeded) && (tSentPackets < pMaxPackets) && (mSinkFifo->GetUsage() > 0))
     {
-    	if (mSinkFifo != NULL)
-    	{
-            tFifoEntry = mSinkFifo->ReadFifoExclusive(&tBuffer, tBufferSize);
+        tFifoEntry = mSinkFifo->ReadFifoExclusive(&tBuffer, tBufferSize);
 
-            if ((tBufferSize > 0) && (mSenderNeeded))
-            {
-            	SendPacket(tBuffer, tBufferSize);
-            }
-
-            // release FIFO entry lock
-            mSinkFifo->ReadFifoExclusiveFinished(tFifoEntry);
-
-			if (tBufferSize == 0)
-			{
-				LOG(LOG_VERBOSE, "Zero byte %s packet in relay thread detected", GetDataTypeStr().c_str());
-			}
+        if ((tBufferSize > 0) && (mSenderNeeded))
+        {
+            SendPacket(tBuffer, tBufferSize);
+            tSentPackets++;
+        }
 
-			// is FIFO near overload situation?
-            if (mSinkFifo->GetUsage() >= mSinkFifo->GetSize() - 4)
-            {
-                LOG(LOG_WARN, "Relay FIFO is near overload situation, deleting all stored frames");
+        // release FIFO entry lock
+        mSinkFifo->ReadFifoExclusiveFinished(tFifoEntry);
 
-                // delete all stored frames: it is a better for the encoding to have a gap instead of frames which have high picture differences
-                mSinkFifo->ClearFifo();
-            }
-    	}else
+        if (tBufferSize == 0)
         {
-            LOG(LOG_VERBOSE, "Suspending the sender thread for 10 ms");
-            Suspend(10 * 1000); // check every 1/100 seconds the state of the FIFO
+            LOG(LOG_VERBOSE, "Zero byte %s packet in relay thread detected", GetDataTypeStr().c_str());
         }
     }
 
-    LOG(LOG_VERBOSE, "%s Socket-Listener for target %s:%u finished", GetDataTypeStr().c_str(), mTargetHost.c_str(), mTargetPort);
+    bool tResult = ((mSenderNeeded) && (mSinkFifo->GetUsage() > 0));
+
+    // the last packet was deferred as part of a batch but other sinks are served first
+    if ((tResult) && (tSentPackets > 0) && (!mNAPIUsed) && (mDataSocket != NULL))
+        IO_ENGINE.Flush(mDataSocket);
 
-    return NULL;
+    return tResult;
 }
 
 void MediaSinkNet::SendPacket(char* pData, unsigned int pSize)
@@ -457,6 +410,7 @@ void MediaSinkNet::SendPacket(char* pData, unsigned int pSize)
         if (mNAPIDataSocket != NULL)
         {
             mNAPIDataSocket->write(pData, (int)pSize);
+            SetQueueDelay(mNAPIDataSocket->getQueueDelay());
             if (mNAPIDataSocket->isClosed())
             {
                 LOG(LOG_ERROR, "Error when sending data through NAPI connection to %s:%u, will skip further transmissions", mTargetHost.c_str(), mTargetPort);
@@ -467,7 +421,9 @@ void MediaSinkNet::SendPacket(char* pData, unsigned int pSize)
     {
         if (mDataSocket != NULL)
         {
-            if (!mDataSocket->Send(mTargetHost, mTargetPort, pData, (ssize_t)pSize))
+            // further packets of the same frame are waiting: let the I/O engine submit them as one batch
+            bool tMorePackets = ((mSinkFifo != NULL) && (mSinkFifo->GetUsage() > 0));
+            if (!IO_ENGINE.Send(mDataSocket, mTargetHost, mTargetPort, pData, (ssize_t)pSize, tMorePackets))
             {
                 LOG(LOG_ERROR, "Error when sending data through %s socket to %s:%u, will skip further transmissions", GetTransportTypeStr().c_str(), mTargetHost.c_str(), mTargetPort);
                 mBrokenPipe = true;
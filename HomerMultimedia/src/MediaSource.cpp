@@ -52,6 +52,7 @@
 #include <Header_Ffmpeg.h>
 #include <MediaSource.h>
 #include <Logger.h>
+#include <HBMemoryPool.h>
 
 #include <string>
 #include <string.h>
@@ -108,6 +109,7 @@ MediaSource::MediaSource(string pName):
     mDesiredDevice = "";
     mCurrentDevice = "";
     mCurrentDeviceName = "";
+    mPeerName = "";
     mRecorderRealTime = true;
     mLastGrabResultWasError = false;
     mNumberOfFrames = 0;
@@ -973,6 +975,16 @@ int64_t MediaSource::DecodedBIFrames()
     return mDecodedBIFrames;
 }
 
+int64_t MediaSource::DroppedFrames()
+{
+    return 0;
+}
+
+int64_t MediaSource::GetTimeToFirstFrame()
+{
+    return 0;
+}
+
 int64_t MediaSource::GetEndToEndDelay()
 {
     return mEndToEndDelay;
@@ -1082,6 +1094,38 @@ void MediaSource::GetVideoSourceResolution(int &pResX, int &pResY)
     pResY = mSourceResY;
 }
 
+bool MediaSource::SetVideoOutputFormat(int pResX, int pResY, bool pMirrorHorizontal, bool pMirrorVertical)
+{
+    return false;
+}
+
+struct VideoFrameFormat MediaSource::GetVideoFrameFormat()
+{
+    struct VideoFrameFormat tResult;
+
+    tResult.ResX = mTargetResX;
+    tResult.ResY = mTargetResY;
+    tResult.MirroredHorizontal = false;
+    tResult.MirroredVertical = false;
+
+    return tResult;
+}
+
+bool MediaSource::SetDecoderSuspended(bool pSuspended)
+{
+    return false;
+}
+
+bool MediaSource::IsDecoderSuspended()
+{
+    return false;
+}
+
+bool MediaSource::SetDecoderThumbnailMode(bool pActive)
+{
+    return false;
+}
+
 GrabResolutions MediaSource::GetSupportedVideoGrabResolutions()
 {
     if (mMediaType == MEDIA_AUDIO)
@@ -1179,6 +1223,21 @@ bool MediaSource::SetInputStreamPreferences(std::string pStreamCodec, bool pDoRe
     return false;
 }
 
+bool MediaSource::RequestKeyFrame()
+{
+    return false;
+}
+
+void MediaSource::SetPeerName(string pPeerName)
+{
+    mPeerName = pPeerName;
+}
+
+string MediaSource::GetPeerName()
+{
+    return mPeerName;
+}
+
 void MediaSource::ResetPacketStatistic()
 {
     PacketStatistic::ResetPacketStatistic();
@@ -1239,6 +1298,10 @@ MediaSinkNet* MediaSource::RegisterMediaSink(string pTarget, Requirements *pTran
     // unlock
     mMediaSinksMutex.unlock();
 
+    // the new receiver shouldn't wait an entire GOP for its first key frame
+    if ((tResult != NULL) && (mMediaType == MEDIA_VIDEO))
+        RequestKeyFrame();
+
     return tResult;
 }
 
@@ -1321,6 +1384,10 @@ MediaSinkNet* MediaSource::RegisterMediaSink(string pTargetHost, unsigned int pT
     // unlock
     mMediaSinksMutex.unlock();
 
+    // the new receiver shouldn't wait an entire GOP for its first key frame
+    if ((tResult != NULL) && (mMediaType == MEDIA_VIDEO))
+        RequestKeyFrame();
+
     return tResult;
 }
 
@@ -1950,7 +2017,10 @@ bool MediaSource::StartRecording(std::string pSaveFileName, int pSaveFileQuality
 
     // allocate all needed buffers
     LOG(LOG_VERBOSE, "Allocating needed recorder buffers");
-    mRecorderEncoderChunkBuffer = (char*)malloc(MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE);
+    if (mMediaType == MEDIA_VIDEO)
+        mRecorderEncoderChunkBuffer = (char*)MEMORY_POOL.Alloc("Recorder", MEDIA_SOURCE_VIDEO_CHUNK_BUFFER_SIZE(mRecorderCodecContext->width, mRecorderCodecContext->height));
+    else
+        mRecorderEncoderChunkBuffer = (char*)MEMORY_POOL.Alloc("Recorder", MEDIA_SOURCE_SAMPLES_MULTI_BUFFER_SIZE);
     if (mMediaType == MEDIA_AUDIO)
         mRecorderSamplesTempBuffer = (char*)malloc(MEDIA_SOURCE_SAMPLES_MULTI_BUFFER_SIZE);
 
@@ -2011,7 +2081,7 @@ void MediaSource::StopRecording()
         LOG(LOG_VERBOSE, "Releasing recorder buffers");
         if (mMediaType == MEDIA_AUDIO)
             free(mRecorderSamplesTempBuffer);
-        free(mRecorderEncoderChunkBuffer);
+        MEMORY_POOL.Free(mRecorderEncoderChunkBuffer);
 
         // unlock grabbing
         mGrabMutex.unlock();
@@ -2089,6 +2159,9 @@ void MediaSource::RecordFrame(AVFrame *pSourceFrame)
         mRecorderCodecContext->width = mSourceResY;
         mRecorderCodecContext->height = mSourceResY;
 
+        // the encoded frame has to fit into the chunk buffer
+        mRecorderEncoderChunkBuffer = (char*)MEMORY_POOL.Grow(mRecorderEncoderChunkBuffer, MEDIA_SOURCE_VIDEO_CHUNK_BUFFER_SIZE(mSourceResX, mSourceResY));
+
         // allocate software scaler context
 		if (mCodecContext != NULL)
         	mRecorderScalerContext = sws_getContext(mSourceResX, mSourceResY, mCodecContext->pix_fmt, mSourceResX, mSourceResY, mRecorderCodecContext->pix_fmt, SWS_BICUBIC, NULL, NULL, NULL);
@@ -2136,7 +2209,7 @@ void MediaSource::RecordFrame(AVFrame *pSourceFrame)
     // #########################################
     // re-encode the frame
     // #########################################
-    tFrameSize = avcodec_encode_video(mRecorderCodecContext, (uint8_t *)mRecorderEncoderChunkBuffer, MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE, mRecorderFinalFrame);
+    tFrameSize = avcodec_encode_video(mRecorderCodecContext, (uint8_t *)mRecorderEncoderChunkBuffer, MemoryPool::GetCapacity(mRecorderEncoderChunkBuffer), mRecorderFinalFrame);
 
     if (tFrameSize > 0)
     {
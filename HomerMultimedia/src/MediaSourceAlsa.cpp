@@ -29,6 +29,7 @@
 //HINT: documentation: http://www.alsa-project.org/alsa-doc/alsa-lib/group___p_c_m.html
 
 #include <MediaSourceAlsa.h>
+#include <DeviceRegistry.h>
 #include <ProcessStatisticService.h>
 #include <Logger.h>
 
@@ -48,6 +49,9 @@ MediaSourceAlsa::MediaSourceAlsa(string pDesiredDevice):
     mSampleBufferSize = MEDIA_SOURCE_SAMPLES_PER_BUFFER * 2 /* SND_PCM_FORMAT_S16_LE */ * mOutputAudioChannels;
     mCaptureHandle = NULL;
 
+    // the registry caches the device list and enumerates again after hotplug events
+    DEVICE_REGISTRY.RegisterAudioEnumerator("ALSA", EnumerateAudioDevices, "/dev/snd/pcmC");
+
     bool tNewDeviceSelected = false;
     SelectDevice(pDesiredDevice, MEDIA_AUDIO, tNewDeviceSelected);
     if (!tNewDeviceSelected)
@@ -67,6 +71,11 @@ MediaSourceAlsa::~MediaSourceAlsa()
 }
 
 void MediaSourceAlsa::getAudioDevices(AudioDevices &pAList)
+{
+    DEVICE_REGISTRY.GetAudioDevices("ALSA", pAList);
+}
+
+void MediaSourceAlsa::EnumerateAudioDevices(AudioDevices &pAList)
 {
     static bool tFirstCall = true;
     AudioDeviceDescriptor tDevice;
@@ -78,7 +87,7 @@ void MediaSourceAlsa::getAudioDevices(AudioDevices &pAList)
     #endif
 
     if (tFirstCall)
-        LOG(LOG_VERBOSE, "Enumerating hardware..");
+        LOGEX(MediaSourceAlsa, LOG_VERBOSE, "Enumerating hardware..");
 
     // query all pcm playback devices
     if (snd_device_name_hint(-1, "pcm", &tDeviceNames) < 0)
@@ -89,7 +98,7 @@ void MediaSourceAlsa::getAudioDevices(AudioDevices &pAList)
     {
         char* tName = snd_device_name_get_hint(*tDeviceNamesIt, "NAME");
         if (tFirstCall)
-            LOG(LOG_VERBOSE, "Got sound device entry: %s", tName);
+            LOGEX(MediaSourceAlsa, LOG_VERBOSE, "Got sound device entry: %s", tName);
 
         string tNameStr = "";
         if (tName != NULL)
@@ -124,10 +133,10 @@ void MediaSourceAlsa::getAudioDevices(AudioDevices &pAList)
             {
                 if (tDevice.Name.size())
                 {
-                    LOG(LOG_VERBOSE, "Found matching audio capture device: %s", tDevice.Name.c_str());
-                    LOG(LOG_VERBOSE, "   ..card: %s", tDevice.Card.c_str());
-                    LOG(LOG_VERBOSE, "   ..desc.: %s", tDevice.Desc.c_str());
-                    LOG(LOG_VERBOSE, "   ..i/o-type: %s", tDevice.IoType.c_str());
+                    LOGEX(MediaSourceAlsa, LOG_VERBOSE, "Found matching audio capture device: %s", tDevice.Name.c_str());
+                    LOGEX(MediaSourceAlsa, LOG_VERBOSE, "   ..card: %s", tDevice.Card.c_str());
+                    LOGEX(MediaSourceAlsa, LOG_VERBOSE, "   ..desc.: %s", tDevice.Desc.c_str());
+                    LOGEX(MediaSourceAlsa, LOG_VERBOSE, "   ..i/o-type: %s", tDevice.IoType.c_str());
                 }
             }
 
@@ -32,9 +32,12 @@
 #include <MediaSource.h>
 #include <ProcessStatisticService.h>
 #include <RTP.h>
+#include <StreamParameterCache.h>
 
 #include <Logger.h>
 #include <HBSystem.h>
+#include <HBMemoryPool.h>
+#include <HBTime.h>
 
 #include <string>
 #include <stdint.h>
@@ -48,8 +51,8 @@ using namespace Homer::Base;
 
 ///////////////////////////////////////////////////////////////////////////////
 
-// maximum packet size, including encoded data and RTP/TS
-#define MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE                          MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE
+// minimum size of the stream buffer, frames which are bigger than the stream buffer are delivered to ffmpeg in several parts
+#define MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE                          (64 * 1024)
 
 // seeking: expected maximum GOP size, used if frames are dropped after seeking to find the next key frame close to the target frame
 #define MEDIA_SOURCE_MEM_SEEK_MAX_EXPECTED_GOP_SIZE                         30 // every x frames a key frame
@@ -70,7 +73,7 @@ using namespace Homer::Base;
 ///////////////////////////////////////////////////////////////////////////////
 
 MediaSourceMem::MediaSourceMem(string pName, bool pRtpActivated):
-    MediaSource(pName), RTP()
+    MediaSource(pName), RTP(), mDecoderDropPolicy("Video decoder " + pName)
 {
     mDecoderFrameBufferTimeMax = MEDIA_SOURCE_MEM_FRAME_INPUT_QUEUE_MAX_TIME;
     mDecoderFramePreBufferTime = MEDIA_SOURCE_MEM_PRE_BUFFER_TIME;
@@ -81,6 +84,20 @@ MediaSourceMem::MediaSourceMem(string pName, bool pRtpActivated):
     mDecoderFifo = NULL;
     mDecoderMetaDataFifo = NULL;
     mDecoderFragmentFifo = NULL;
+    mDecoderVideoScaler = NULL;
+    mDecoderSuspended = false;
+    mDecoderThumbnailMode = false;
+    mDecoderFragmentFifoOverflow = false;
+    mFirstFragmentTime = 0;
+    mTimeToFirstFrame = 0;
+    mDecoderOutputResX = 0;
+    mDecoderOutputResY = 0;
+    mDecoderOutputMirrorHorizontal = false;
+    mDecoderOutputMirrorVertical = false;
+    mLastGrabbedFrameFormat.ResX = 0;
+    mLastGrabbedFrameFormat.ResY = 0;
+    mLastGrabbedFrameFormat.MirroredHorizontal = false;
+    mLastGrabbedFrameFormat.MirroredVertical = false;
 	mResXLastGrabbedFrame = 0;
 	mResYLastGrabbedFrame = 0;
     mDecoderSinglePictureResX = 0;
@@ -90,7 +107,10 @@ MediaSourceMem::MediaSourceMem(string pName, bool pRtpActivated):
 	mWrappingHeaderSize= 0;
     mGrabberProvidesRTGrabbing = true;
     mSourceType = SOURCE_MEMORY;
-    mStreamPacketBuffer = (char*)malloc(MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE);
+    mStreamPacketBuffer = NULL;
+    mStreamPacketPending = NULL;
+    mStreamPacketPendingSize = 0;
+    mStreamPacketPendingOffset = 0;
     mFragmentBuffer = (char*)malloc(MEDIA_SOURCE_MEM_FRAGMENT_BUFFER_SIZE);
     mFragmentNumber = 0;
     mPacketStatAdditionalFragmentSize = 0;
@@ -118,7 +138,8 @@ MediaSourceMem::~MediaSourceMem()
         mDecoderFragmentFifo = NULL;
     }
     mDecoderFragmentFifoDestructionMutex.unlock();
-	free(mStreamPacketBuffer);
+    MEMORY_POOL.Free(mStreamPacketBuffer);
+    MEMORY_POOL.Free(mStreamPacketPending);
     free(mFragmentBuffer);
 }
 
@@ -145,7 +166,10 @@ int MediaSourceMem::GetNextPacket(void *pOpaque, uint8_t *pBuffer, int pBufferSi
         bool tFragmentIsOkay;
         bool tFragmentIsSenderReport;
 
-        tBufferSize = 0;
+        // deliver the remainder of the last frame first
+        tBufferSize = tMediaSourceMemInstance->ReadPendingStreamData(tBuffer, pBufferSize);
+        if (tBufferSize > 0)
+            return tBufferSize;
 
         do{
             tLastFragment = false;
@@ -188,25 +212,26 @@ int MediaSourceMem::GetNextPacket(void *pOpaque, uint8_t *pBuffer, int pBufferSi
 
             if ((tFragmentIsOkay) && (!tFragmentIsSenderReport))
             {
-                if (tBufferSize + tFragmentDataSize < pBufferSize)
+                if (tFragmentDataSize > 0)
                 {
-                    if (tFragmentDataSize > 0)
+                    // copy the fragment to the final buffer
+                    int tCopySize = pBufferSize - tBufferSize;
+                    if (tCopySize > tFragmentDataSize)
+                        tCopySize = tFragmentDataSize;
+                    if (tCopySize > 0)
                     {
-                        // copy the fragment to the final buffer
-                        memcpy(tBuffer, tFragmentData, tFragmentDataSize);
-                        tBuffer += tFragmentDataSize;
-                        tBufferSize += tFragmentDataSize;
+                        memcpy(tBuffer, tFragmentData, tCopySize);
+                        tBuffer += tCopySize;
+                        tBufferSize += tCopySize;
                     }
-                    #ifdef MSMEM_DEBUG_PACKETS
-                        LOGEX(MediaSourceMem, LOG_VERBOSE, "Resulting temporary buffer size: %d", tBufferSize);
-                    #endif
-                }else
-                {
-                    tLastFragment = false;
-                    tBuffer = (char*)pBuffer;
-                    tBufferSize = pBufferSize;
-                    LOGEX(MediaSourceMem, LOG_ERROR, "Stream buffer of %d bytes too small for input, dropping received stream", pBufferSize);
+
+                    // the frame is bigger than the stream buffer: keep the rest for the next calls
+                    if (tCopySize < tFragmentDataSize)
+                        tMediaSourceMemInstance->StorePendingStreamData(tFragmentData + tCopySize, tFragmentDataSize - tCopySize);
                 }
+                #ifdef MSMEM_DEBUG_PACKETS
+                    LOGEX(MediaSourceMem, LOG_VERBOSE, "Resulting temporary buffer size: %d", tBufferSize);
+                #endif
             }else
             {
                 if (!tFragmentIsSenderReport)
@@ -252,6 +277,62 @@ int MediaSourceMem::GetNextPacket(void *pOpaque, uint8_t *pBuffer, int pBufferSi
     return tBufferSize;
 }
 
+void MediaSourceMem::AllocateStreamPacketBuffer(unsigned int pSize)
+{
+    if (pSize < MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE)
+        pSize = MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE;
+
+    // the I/O context of a former session was already released
+    MEMORY_POOL.Free(mStreamPacketBuffer);
+    mStreamPacketBuffer = (char*)MEMORY_POOL.Alloc("MediaSourceMem", pSize);
+    mStreamPacketPendingSize = 0;
+    mStreamPacketPendingOffset = 0;
+
+    LOG(LOG_VERBOSE, "Allocated stream buffer of %u bytes", MemoryPool::GetCapacity(mStreamPacketBuffer));
+}
+
+void MediaSourceMem::StorePendingStreamData(char *pData, int pDataSize)
+{
+    if (mStreamPacketPendingSize + pDataSize > (int)MemoryPool::GetCapacity(mStreamPacketPending))
+    {
+        if (mStreamPacketPending == NULL)
+            mStreamPacketPending = (char*)MEMORY_POOL.Alloc("MediaSourceMem", mStreamPacketPendingSize + pDataSize);
+        else
+            mStreamPacketPending = (char*)MEMORY_POOL.Grow(mStreamPacketPending, mStreamPacketPendingSize + pDataSize);
+        if (mStreamPacketPending == NULL)
+        {
+            LOG(LOG_ERROR, "Unable to store %d bytes of the current frame, dropping data", pDataSize);
+            mStreamPacketPendingSize = 0;
+            mStreamPacketPendingOffset = 0;
+            return;
+        }
+    }
+
+    memcpy(mStreamPacketPending + mStreamPacketPendingSize, pData, pDataSize);
+    mStreamPacketPendingSize += pDataSize;
+}
+
+int MediaSourceMem::ReadPendingStreamData(char *pBuffer, int pBufferSize)
+{
+    int tResult = mStreamPacketPendingSize - mStreamPacketPendingOffset;
+
+    if (tResult <= 0)
+        return 0;
+
+    if (tResult > pBufferSize)
+        tResult = pBufferSize;
+
+    memcpy(pBuffer, mStreamPacketPending + mStreamPacketPendingOffset, tResult);
+    mStreamPacketPendingOffset += tResult;
+    if (mStreamPacketPendingOffset >= mStreamPacketPendingSize)
+    {
+        mStreamPacketPendingSize = 0;
+        mStreamPacketPendingOffset = 0;
+    }
+
+    return tResult;
+}
+
 void MediaSourceMem::WriteFragment(char *pBuffer, int pBufferSize)
 {
     if (mDecoderFragmentFifo == NULL)
@@ -264,14 +345,19 @@ void MediaSourceMem::WriteFragment(char *pBuffer, int pBufferSize)
         // log statistics
         // mFragmentHeaderSize to add additional TCPFragmentHeader to the statistic if TCP is used, this is triggered by MediaSourceNet
         AnnouncePacket((int)pBufferSize + mPacketStatAdditionalFragmentSize);
+
+        if (mFirstFragmentTime == 0)
+            mFirstFragmentTime = Time::GetTimeStamp();
 	}
 	
-    if (mDecoderFragmentFifo->GetUsage() >= mDecoderFragmentFifo->GetSize() - 4)
+    // a full FIFO drops its oldest entry: the following frames would reference lost data, the decoder has to wait for the next key frame
+    //HINT: the drop policy belongs to the decoder thread, we only signal the overflow here
+    //HINT: received streams have no feedback channel to request a key frame from the remote encoder
+    if ((mMediaType == MEDIA_VIDEO) && (mDecoderFragmentFifo->GetUsage() >= mDecoderFragmentFifo->GetSize()))
     {
-        LOG(LOG_WARN, "Decoder packet FIFO is near overload situation in WriteFragmet(), deleting all stored frames");
-
-        // delete all stored frames: it is a better for the decoding!
-        mDecoderFragmentFifo->ClearFifo();
+        if (!mDecoderFragmentFifoOverflow)
+            LOG(LOG_WARN, "Fragment FIFO of %s source overflowed, decoder will wait for the next key frame", GetSourceTypeStr().c_str());
+        mDecoderFragmentFifoOverflow = true;
     }
 
     mDecoderFragmentFifo->WriteFifo(pBuffer, pBufferSize);
@@ -292,15 +378,6 @@ void MediaSourceMem::ReadFragment(char *pData, int &pDataSize)
             LOG(LOG_VERBOSE, "Read fragment with number %5u at %p with size %5d towards decoder", (unsigned int)++mFragmentNumber, pData, pDataSize);
         #endif
     }
-
-    // is FIFO near overload situation?
-    if (mDecoderFragmentFifo->GetUsage() >= mDecoderFragmentFifo->GetSize() - 4)
-    {
-        LOG(LOG_WARN, "Decoder packet FIFO is near overload situation in ReadFragment(), deleting all stored frames");
-
-        // delete all stored frames: it is a better for the decoding!
-        mDecoderFragmentFifo->ClearFifo();
-    }
 }
 
 bool MediaSourceMem::SupportsDecoderFrameStatistics()
@@ -308,6 +385,23 @@ bool MediaSourceMem::SupportsDecoderFrameStatistics()
     return (mMediaType == MEDIA_VIDEO);
 }
 
+int64_t MediaSourceMem::DroppedFrames()
+{
+    int64_t tResult = mDecoderDropPolicy.GetDroppedFrames();
+
+    mDecoderOutputFormatMutex.lock();
+    if (mDecoderVideoScaler != NULL)
+        tResult += mDecoderVideoScaler->GetDroppedFrames();
+    mDecoderOutputFormatMutex.unlock();
+
+    return tResult;
+}
+
+int64_t MediaSourceMem::GetTimeToFirstFrame()
+{
+    return mTimeToFirstFrame;
+}
+
 GrabResolutions MediaSourceMem::GetSupportedVideoGrabResolutions()
 {
     VideoFormatDescriptor tFormat;
@@ -513,6 +607,80 @@ void MediaSourceMem::DoSetVideoGrabResolution(int pResX, int pResY)
     LOG(LOG_VERBOSE, "DoSetVideoGrabResolution() finished");
 }
 
+bool MediaSourceMem::SetVideoOutputFormat(int pResX, int pResY, bool pMirrorHorizontal, bool pMirrorVertical)
+{
+    if (mMediaType == MEDIA_AUDIO)
+    {
+        LOG(LOG_ERROR, "Wrong media type detected");
+        return false;
+    }
+
+    mDecoderOutputFormatMutex.lock();
+
+    if ((pResX != mDecoderOutputResX) || (pResY != mDecoderOutputResY) || (pMirrorHorizontal != mDecoderOutputMirrorHorizontal) || (pMirrorVertical != mDecoderOutputMirrorVertical))
+    {
+        LOG(LOG_VERBOSE, "Setting video output format of %s source to %d*%d, mirroring: %d/%d", GetSourceTypeStr().c_str(), pResX, pResY, pMirrorHorizontal, pMirrorVertical);
+
+        mDecoderOutputResX = pResX;
+        mDecoderOutputResY = pResY;
+        mDecoderOutputMirrorHorizontal = pMirrorHorizontal;
+        mDecoderOutputMirrorVertical = pMirrorVertical;
+
+        // the scaler adapts its output without restarting the decoder, a new scaler gets the format during its creation
+        if (mDecoderVideoScaler != NULL)
+            mDecoderVideoScaler->SetOutputFormat(mDecoderOutputResX, mDecoderOutputResY, mDecoderOutputMirrorHorizontal, mDecoderOutputMirrorVertical);
+    }
+
+    mDecoderOutputFormatMutex.unlock();
+
+    return true;
+}
+
+bool MediaSourceMem::SetDecoderSuspended(bool pSuspended)
+{
+    // only the decoding of received video streams can be skipped, files and local captures are needed for recording and streaming
+    if ((mMediaType != MEDIA_VIDEO) || (mSourceType != SOURCE_NETWORK))
+        return false;
+
+    // the recorder needs the decoded frames
+    if ((pSuspended) && (mRecording))
+        return false;
+
+    if (mDecoderSuspended != pSuspended)
+    {
+        LOG(LOG_VERBOSE, "%s video decoding of %s source", pSuspended ? "Suspending" : "Resuming", GetSourceTypeStr().c_str());
+        //HINT: the decoder thread checks this flag for each packet
+        mDecoderSuspended = pSuspended;
+    }
+
+    return true;
+}
+
+bool MediaSourceMem::IsDecoderSuspended()
+{
+    return mDecoderSuspended;
+}
+
+bool MediaSourceMem::SetDecoderThumbnailMode(bool pActive)
+{
+    if ((mMediaType != MEDIA_VIDEO) || (mSourceType != SOURCE_NETWORK))
+        return false;
+
+    if (mDecoderThumbnailMode != pActive)
+    {
+        LOG(LOG_VERBOSE, "%s thumbnail mode for video decoding of %s source", pActive ? "Activating" : "Deactivating", GetSourceTypeStr().c_str());
+        //HINT: the decoder thread checks this flag for each packet
+        mDecoderThumbnailMode = pActive;
+    }
+
+    return true;
+}
+
+struct VideoFrameFormat MediaSourceMem::GetVideoFrameFormat()
+{
+    return mLastGrabbedFrameFormat;
+}
+
 bool MediaSourceMem::SetInputStreamPreferences(std::string pStreamCodec, bool pDoReset)
 {
     bool tResult = false;
@@ -581,8 +749,9 @@ bool MediaSourceMem::OpenVideoGrabDevice(int pResX, int pResY, float pFps)
     if (!DescribeInput(mSourceCodecId, &tFormat))
     	return false;
 
-	// build corresponding "AVIOContext"
-    CreateIOContext(mStreamPacketBuffer, MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE, GetNextPacket, NULL, this, &tIoContext);
+	// build corresponding "AVIOContext", one byte per pixel is enough for nearly every compressed frame
+    AllocateStreamPacketBuffer(pResX * pResY);
+    CreateIOContext(mStreamPacketBuffer, MemoryPool::GetCapacity(mStreamPacketBuffer), GetNextPacket, NULL, this, &tIoContext);
 
     // open the input for the described format and via the provided I/O control
     mOpenInputStream = true;
@@ -591,8 +760,12 @@ bool MediaSourceMem::OpenVideoGrabDevice(int pResX, int pResY, float pFps)
     if (!tRes)
     	return false;
 
-    // detect all available video/audio streams in the input
-    if (!DetectAllStreams())
+    // detect all available video/audio streams in the input, a known stream is described by the cached parameters instead
+    string tCacheKey = StreamParameterCache::CreateKey(mMediaType, mSourceCodecId, mPeerName);
+    bool tCachedParameters = STREAM_PARAMETER_CACHE.Apply(tCacheKey, mFormatContext);
+    if (tCachedParameters)
+        LOG(LOG_VERBOSE, "Using cached parameters for video stream, skipping the stream probing");
+    else if (!DetectAllStreams())
     	return false;
 
     // select the first matching stream according to mMediaType
@@ -601,10 +774,21 @@ bool MediaSourceMem::OpenVideoGrabDevice(int pResX, int pResY, float pFps)
 
     // finds and opens the correct decoder
     if (!OpenDecoder())
+    {
+        if (tCachedParameters)
+            STREAM_PARAMETER_CACHE.Invalidate(tCacheKey);
     	return false;
+    }
 
 	if (!OpenFormatConverter())
+	{
+        if (tCachedParameters)
+            STREAM_PARAMETER_CACHE.Invalidate(tCacheKey);
 		return false;
+	}
+
+    if (!tCachedParameters)
+        STREAM_PARAMETER_CACHE.Store(tCacheKey, mFormatContext->streams[mMediaStreamIndex]);
 
     // overwrite FPS by the playout FPS value
     mFrameRate = mRealFrameRate;
@@ -642,7 +826,8 @@ bool MediaSourceMem::OpenAudioGrabDevice(int pSampleRate, int pChannels)
     	return false;
 
 	// build corresponding "AVIOContext"
-    CreateIOContext(mStreamPacketBuffer, MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE, GetNextPacket, NULL, this, &tIoContext);
+    AllocateStreamPacketBuffer(MEDIA_SOURCE_MEM_STREAM_PACKET_BUFFER_SIZE);
+    CreateIOContext(mStreamPacketBuffer, MemoryPool::GetCapacity(mStreamPacketBuffer), GetNextPacket, NULL, this, &tIoContext);
 
     // open the input for the described format and via the provided I/O control
     mOpenInputStream = true;
@@ -651,8 +836,12 @@ bool MediaSourceMem::OpenAudioGrabDevice(int pSampleRate, int pChannels)
     if (!tRes)
     	return false;
 
-    // detect all available video/audio streams in the input
-    if (!DetectAllStreams())
+    // detect all available video/audio streams in the input, a known stream is described by the cached parameters instead
+    string tCacheKey = StreamParameterCache::CreateKey(mMediaType, mSourceCodecId, mPeerName);
+    bool tCachedParameters = STREAM_PARAMETER_CACHE.Apply(tCacheKey, mFormatContext);
+    if (tCachedParameters)
+        LOG(LOG_VERBOSE, "Using cached parameters for audio stream, skipping the stream probing");
+    else if (!DetectAllStreams())
     	return false;
 
     // select the first matching stream according to mMediaType
@@ -683,10 +872,21 @@ bool MediaSourceMem::OpenAudioGrabDevice(int pSampleRate, int pChannels)
 
     // finds and opens the correct decoder
     if (!OpenDecoder())
+    {
+        if (tCachedParameters)
+            STREAM_PARAMETER_CACHE.Invalidate(tCacheKey);
     	return false;
+    }
 
     if (!OpenFormatConverter())
+    {
+        if (tCachedParameters)
+            STREAM_PARAMETER_CACHE.Invalidate(tCacheKey);
 		return false;
+    }
+
+    if (!tCachedParameters)
+        STREAM_PARAMETER_CACHE.Store(tCacheKey, mFormatContext->streams[mMediaStreamIndex]);
 
     // overwrite FPS by the playout FPS value
     mFrameRate = mRealFrameRate;
@@ -735,6 +935,8 @@ bool MediaSourceMem::CloseGrabDevice()
     mResXLastGrabbedFrame = 0;
     mResYLastGrabbedFrame = 0;
     mDecoderSynchPoints = 0;
+    mFirstFragmentTime = 0;
+    mTimeToFirstFrame = 0;
 
     return tResult;
 }
@@ -845,6 +1047,23 @@ int MediaSourceMem::GrabChunk(void* pChunkBuffer, int& pChunkSize, bool pDropChu
             }
 
             ReadFrameOutputBuffer((char*)pChunkBuffer, pChunkSize, tCurrentFramePts);
+
+            // the video scaler might have scaled and mirrored the frame for the video output
+            if (mMediaType == MEDIA_VIDEO)
+            {
+                mDecoderOutputFormatMutex.lock();
+                if (mDecoderVideoScaler != NULL)
+                {
+                    mLastGrabbedFrameFormat = mDecoderVideoScaler->GetLastFrameFormat();
+                }else
+                {// picture input
+                    mLastGrabbedFrameFormat.ResX = mDecoderTargetResX;
+                    mLastGrabbedFrameFormat.ResY = mDecoderTargetResY;
+                    mLastGrabbedFrameFormat.MirroredHorizontal = false;
+                    mLastGrabbedFrameFormat.MirroredVertical = false;
+                }
+                mDecoderOutputFormatMutex.unlock();
+            }
             #ifdef MSMEM_DEBUG_PACKETS
                 LOG(LOG_VERBOSE, "Remaining buffered frames in decoder FIFO: %d", tAvailableFrames);
             #endif
@@ -937,6 +1156,18 @@ int MediaSourceMem::GrabChunk(void* pChunkBuffer, int& pChunkSize, bool pDropChu
         WaitForRTGrabbing();
     }
 
+    // time to first frame: includes opening the input, waiting for a key frame and pre-buffering
+    if ((mTimeToFirstFrame == 0) && (mFirstFragmentTime != 0))
+    {
+        mTimeToFirstFrame = (Time::GetTimeStamp() - mFirstFragmentTime) / 1000;
+        if (mTimeToFirstFrame == 0)
+            mTimeToFirstFrame = 1;
+        if (mTimeToFirstFrame > MEDIA_SOURCE_MEM_TIME_TO_FIRST_FRAME_TARGET)
+            LOG(LOG_WARN, "First %s frame was available %ld ms after the first packet, target is %d ms", GetMediaTypeStr().c_str(), mTimeToFirstFrame, MEDIA_SOURCE_MEM_TIME_TO_FIRST_FRAME_TARGET);
+        else
+            LOG(LOG_INFO, "First %s frame was available %ld ms after the first packet", GetMediaTypeStr().c_str(), mTimeToFirstFrame);
+    }
+
     // acknowledge success
     MarkGrabChunkSuccessful(mFrameNumber);
 
@@ -1066,6 +1297,9 @@ void* MediaSourceMem::Run(void* pArgs)
     /* picture as input */
     AVFrame             *tRGBFrame = NULL;
     bool                tInputIsPicture = false;
+    bool                tFrameDropped = false;
+    bool                tDecoderSuspended = false;
+    int64_t             tLastThumbnailTime = 0;
     /* audio */
     AVFifoBuffer        *tSampleFifo = NULL;
 
@@ -1074,6 +1308,9 @@ void* MediaSourceMem::Run(void* pArgs)
 
     tInputIsPicture = InputIsPicture();
 
+    mDecoderDropPolicy.Reset();
+    mDecoderFragmentFifoOverflow = false;
+
     LOG(LOG_WARN, ">>>>>>>>>>>>>>>> %s-Decoding thread for %s media source started", GetMediaTypeStr().c_str(), GetSourceTypeStr().c_str());
     switch(mMediaType)
     {
@@ -1093,8 +1330,12 @@ void* MediaSourceMem::Run(void* pArgs)
                 // allocate chunk buffer
                 tChunkBuffer = (uint8_t*)malloc(tChunkBufferSize);
 
-                // create video scaler
+                // create video scaler and let it scale directly to the format of the video output if this is already known
+                mDecoderOutputFormatMutex.lock();
                 tVideoScaler = CreateVideoScaler();
+                tVideoScaler->SetOutputFormat(mDecoderOutputResX, mDecoderOutputResY, mDecoderOutputMirrorHorizontal, mDecoderOutputMirrorVertical);
+                mDecoderVideoScaler = tVideoScaler;
+                mDecoderOutputFormatMutex.unlock();
 
                 // set the video scaler as FIFO for the decoder
                 mDecoderFifo = tVideoScaler;
@@ -1402,9 +1643,67 @@ void* MediaSourceMem::Run(void* pArgs)
                                     mEOFReached = false;
                                 }
 
+                                // invisible stream: the packets are still parsed, but decoding and scaling are skipped, after resuming the decoder waits for the next key frame
+                                if (tDecoderSuspended != ((mDecoderSuspended) && (!mRecording)))
+                                {// a recording started in the meantime needs the decoded frames
+                                    tDecoderSuspended = ((mDecoderSuspended) && (!mRecording));
+                                    if (tDecoderSuspended)
+                                        LOG(LOG_VERBOSE, "Video decoder of %s source suspended", GetSourceTypeStr().c_str());
+                                    else
+                                    {
+                                        LOG(LOG_VERBOSE, "Video decoder of %s source resumed, waiting for next key frame", GetSourceTypeStr().c_str());
+                                        mDecoderDropPolicy.WaitForKeyFrame();
+                                    }
+                                }
+
+                                // overload: let the codec skip frames which aren't referenced by others, later skip everything until the next key frame
+                                tFrameDropped = false;
+                                if ((!tInputIsPicture) && (mDecoderFragmentFifo != NULL))
+                                {
+                                    if (mDecoderFragmentFifoOverflow)
+                                    {// fragments were lost in the FIFO
+                                        mDecoderFragmentFifoOverflow = false;
+                                        mDecoderDropPolicy.WaitForKeyFrame();
+                                    }
+                                    mDecoderDropPolicy.Update(mDecoderFragmentFifo->GetUsage(), mDecoderFragmentFifo->GetSize());
+                                    if (mDecoderDropPolicy.IsWaitingForKeyFrame())
+                                        mCodecContext->skip_frame = AVDISCARD_NONKEY;
+                                    else if (mDecoderDropPolicy.GetLevel() >= FRAME_DROP_LEVEL_NON_REFERENCE)
+                                        mCodecContext->skip_frame = AVDISCARD_NONREF;
+                                    else
+                                        mCodecContext->skip_frame = AVDISCARD_DEFAULT;
+                                }
+
                                 // Decode the next chunk of data
                                 tFrameFinished = 0;
-                                tBytesDecoded = HM_avcodec_decode_video(mCodecContext, tSourceFrame, &tFrameFinished, tPacket);
+                                if (!tDecoderSuspended)
+                                    tBytesDecoded = HM_avcodec_decode_video(mCodecContext, tSourceFrame, &tFrameFinished, tPacket);
+                                else
+                                {
+                                    tBytesDecoded = tPacket->size;
+                                    tFrameDropped = true;
+                                }
+
+                                if ((!tInputIsPicture) && (!tDecoderSuspended) && (tBytesDecoded >= 0))
+                                {
+                                    if (tFrameFinished != 0)
+                                        tFrameDropped = mDecoderDropPolicy.DropEncodedFrame(tSourceFrame->key_frame, (tSourceFrame->pict_type != AV_PICTURE_TYPE_B));
+                                    else if (mCodecContext->skip_frame != AVDISCARD_DEFAULT)
+                                    {// the codec has skipped the frame
+                                        mDecoderDropPolicy.ReportDroppedFrame();
+                                        tFrameDropped = true;
+                                    }
+
+                                    // thumbnail: every frame has to be decoded because the following ones reference it, but only the thinned out ones are scaled and delivered
+                                    if ((tFrameFinished != 0) && (!tFrameDropped) && (mDecoderThumbnailMode) && (!mRecording))
+                                    {
+                                        int64_t tCurrentTime = Time::GetTimeStamp();
+                                        if (tCurrentTime - tLastThumbnailTime < 1000 * 1000 / MEDIA_SOURCE_MEM_THUMBNAIL_FPS)
+                                            tFrameDropped = true;
+                                        else
+                                            tLastThumbnailTime = tCurrentTime;
+                                    }
+                                }
 
                                 #ifdef MSMEM_DEBUG_VIDEO_FRAME_RECEIVER
                                     LOG(LOG_VERBOSE, "New video frame before PTS adaption..");
@@ -1471,7 +1770,9 @@ void* MediaSourceMem::Run(void* pArgs)
                                         mSourceResY = mCodecContext->height;
 
                                         // let the video scaler update the (ffmpeg based) scaler context
+                                        mDecoderOutputFormatMutex.lock();
                                         tVideoScaler->ChangeInputResolution(mSourceResX, mSourceResY);
+                                        mDecoderOutputFormatMutex.unlock();
 
                                         // free the old chunk buffer
                                         free(tChunkBuffer);
@@ -1585,7 +1886,7 @@ void* MediaSourceMem::Run(void* pArgs)
                             }else
                             {// we are not waiting for next key frame and can proceed as usual
                                 // do we have valid input from the video decoder?
-                                if ((tFrameFinished != 0) && (tBytesDecoded >= 0))
+                                if ((tFrameFinished != 0) && (tBytesDecoded >= 0) && (!tFrameDropped))
                                 {
                                     // ############################
                                     // ### ANNOUNCE FRAME (statistics)
@@ -1651,6 +1952,12 @@ void* MediaSourceMem::Run(void* pArgs)
                                     #ifdef MSMEM_DEBUG_PACKETS
                                         LOG(LOG_VERBOSE, "Resulting frame size is %d bytes", tCurrentChunkSize);
                                     #endif
+                                }else if (tFrameDropped)
+                                {
+                                    #ifdef MSMEM_DEBUG_PACKETS
+                                        LOG(LOG_VERBOSE, "Video frame %ld dropped because of decoder overload", tCurPacketPts);
+                                    #endif
+                                    tCurrentChunkSize = 0;
                                 }else
                                 {
                                     if(tBytesDecoded != 0)
@@ -1902,6 +2209,9 @@ void* MediaSourceMem::Run(void* pArgs)
                 if (!tInputIsPicture)
                 {
                     LOG(LOG_WARN, "VIDEO decoder thread stops scaler thread..");
+                    mDecoderOutputFormatMutex.lock();
+                    mDecoderVideoScaler = NULL;
+                    mDecoderOutputFormatMutex.unlock();
                     tVideoScaler->StopScaler();
                     LOG(LOG_VERBOSE, "..VIDEO decoder thread stopped scaler thread");
                 }else
@@ -2129,7 +2439,10 @@ int64_t MediaSourceMem::GetSynchronizationTimestamp()
 
 bool MediaSourceMem::TimeShift(int64_t pOffset)
 {
-    LOG(LOG_VERBOSE, "Shifting %s time by: %ld", GetMediaTypeStr().c_str(), pOffset);
+    // the A/V synchronizer shifts video sources for every frame
+    #ifdef MSMEM_DEBUG_AV_SYNC
+        LOG(LOG_VERBOSE, "Shifting %s time by: %ld", GetMediaTypeStr().c_str(), pOffset);
+    #endif
     mSourceStartTimeForRTGrabbing -= pOffset;
     return true;
 }
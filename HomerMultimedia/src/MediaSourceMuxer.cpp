@@ -33,6 +33,7 @@
 #include <ProcessStatisticService.h>
 #include <HBSocket.h>
 #include <HBSystem.h>
+#include <HBMemoryPool.h>
 #include <RTP.h>
 #include <Logger.h>
 
@@ -46,9 +47,6 @@ namespace Homer { namespace Multimedia {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-// maximum packet size of a reeencoded frame, must not be more than 64 kB - otherwise it can't be used via networks!
-#define MEDIA_SOURCE_MUX_STREAM_PACKET_BUFFER_SIZE               MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE
-
 // de/activate MT support during video encoding: ffmpeg supports MT only for encoding
 #define MEDIA_SOURCE_MUX_MULTI_THREADED_VIDEO_ENCODING
 
@@ -64,7 +62,8 @@ MediaSourceMuxer::MediaSourceMuxer(MediaSource *pMediaSource):
     MediaSource("Muxer: encoder output")
 {
     mSourceType = SOURCE_MUXER;
-    mStreamPacketBuffer = (char*)malloc(MEDIA_SOURCE_MUX_STREAM_PACKET_BUFFER_SIZE);
+    mStreamPacketBuffer = NULL;
+    mEncoderChunkBuffer = NULL;
     SetOutgoingStream();
     mStreamCodecId = CODEC_ID_NONE;
     mStreamMaxPacketSize = 500;
@@ -85,6 +84,8 @@ MediaSourceMuxer::MediaSourceMuxer(MediaSource *pMediaSource):
     mSkippedSilenceChunks = 0;
     mEncoderNeeded = true;
     mEncoderHasKeyFrame = false;
+    mEncoderForceKeyFrame = false;
+    mEncoderStartTime = 0;
     mEncoderFifo = NULL;
     mAudioResampleContext = NULL;
 }
@@ -100,7 +101,7 @@ MediaSourceMuxer::~MediaSourceMuxer()
     StopEncoder();
 
 	LOG(LOG_VERBOSE, "..freeing stream packet buffer");
-    free(mStreamPacketBuffer);
+    MEMORY_POOL.Free(mStreamPacketBuffer);
     LOG(LOG_VERBOSE, "Destroyed");
 }
 
@@ -390,8 +391,15 @@ bool MediaSourceMuxer::OpenVideoMuxer(int pResX, int pResY, float pFps)
     // set category for packet statistics
     ClassifyStream(DATA_TYPE_VIDEO, SOCKET_RAW);
 
+    // the I/O buffer has to take an entire encoded frame, otherwise ffmpeg would split it
+    MEMORY_POOL.Free(mStreamPacketBuffer);
+    if (pResX * pResY > mRequestedStreamingResX * mRequestedStreamingResY)
+        mStreamPacketBuffer = (char*)MEMORY_POOL.Alloc("MediaSourceMuxer", MEDIA_SOURCE_VIDEO_CHUNK_BUFFER_SIZE(pResX, pResY));
+    else
+        mStreamPacketBuffer = (char*)MEMORY_POOL.Alloc("MediaSourceMuxer", MEDIA_SOURCE_VIDEO_CHUNK_BUFFER_SIZE(mRequestedStreamingResX, mRequestedStreamingResY));
+
     // build correct IO-context
-    if (!CreateIOContext(mStreamPacketBuffer, MEDIA_SOURCE_MUX_STREAM_PACKET_BUFFER_SIZE, NULL, DistributePacket, this, &tIoContext))
+    if (!CreateIOContext(mStreamPacketBuffer, MemoryPool::GetCapacity(mStreamPacketBuffer), NULL, DistributePacket, this, &tIoContext))
     {
     	LOG(LOG_ERROR, "Error during I/O context creation");
     	return false;
@@ -681,8 +689,12 @@ bool MediaSourceMuxer::OpenAudioMuxer(int pSampleRate, int pChannels)
     // set category for packet statistics
     ClassifyStream(DATA_TYPE_AUDIO, SOCKET_RAW);
 
+    // the I/O buffer has to take an entire encoded frame, otherwise ffmpeg would split it
+    MEMORY_POOL.Free(mStreamPacketBuffer);
+    mStreamPacketBuffer = (char*)MEMORY_POOL.Alloc("MediaSourceMuxer", MEDIA_SOURCE_SAMPLES_MULTI_BUFFER_SIZE);
+
     // build correct IO-context
-    if (!CreateIOContext(mStreamPacketBuffer, MEDIA_SOURCE_MUX_STREAM_PACKET_BUFFER_SIZE, NULL, DistributePacket, this, &tIoContext))
+    if (!CreateIOContext(mStreamPacketBuffer, MemoryPool::GetCapacity(mStreamPacketBuffer), NULL, DistributePacket, this, &tIoContext))
     {
     	LOG(LOG_ERROR, "Error during I/O context creation");
     	return false;
@@ -937,6 +949,7 @@ bool MediaSourceMuxer::CloseMuxer()
     ResetPacketStatistic();
 
     mFrameNumber = 0;
+    mEncoderStartTime = 0;
 
     return tResult;
 }
@@ -1231,6 +1244,10 @@ bool MediaSourceMuxer::BelowMaxFps(int pFrameNumber)
         {
             mStreamMaxFps_LastFrame_Timestamp = tCurrentTime;
 
+            // don't carry over longer pauses of the source, e.g., of an unchanged desktop, otherwise the following frames would pass unlimited
+            if (tTimeDiffForNextFrame > tTimeDiffTreshold)
+                tTimeDiffForNextFrame = 0;
+
             //LOG(LOG_VERBOSE, "Last frame timestamp: %lld(%lld) , %lld, %lld", tCurrentTime, mStreamMaxFps_LastFrame_Timestamp, tTimeDiffForNextFrame, mStreamMaxFps_LastFrame_Timestamp - tTimeDiffForNextFrame);
 
             // correct reference timestamp for last frame by the already passed time for the next frame
@@ -1324,7 +1341,7 @@ void* MediaSourceMuxer::Run(void* pArgs)
             if ((tYUVFrame = avcodec_alloc_frame()) == NULL)
                 LOG(LOG_ERROR, "Out of video memory in avcodec_alloc_frame()");
 
-            mEncoderChunkBuffer = (char*)malloc(MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE);
+            mEncoderChunkBuffer = (char*)MEMORY_POOL.Alloc("MediaSourceMuxer", MEDIA_SOURCE_VIDEO_CHUNK_BUFFER_SIZE(mCurrentStreamingResX, mCurrentStreamingResY));
             if (mEncoderChunkBuffer == NULL)
                 LOG(LOG_ERROR, "Out of video memory for encoder chunk buffer");
 
@@ -1352,7 +1369,7 @@ void* MediaSourceMuxer::Run(void* pArgs)
             if (mSamplesTempBuffer == NULL)
                 LOG(LOG_ERROR, "Out of memory for sample buffer");
 
-            mEncoderChunkBuffer = (char*)malloc(MEDIA_SOURCE_SAMPLES_MULTI_BUFFER_SIZE);
+            mEncoderChunkBuffer = (char*)MEMORY_POOL.Alloc("MediaSourceMuxer", MEDIA_SOURCE_SAMPLES_MULTI_BUFFER_SIZE);
             if (mEncoderChunkBuffer == NULL)
                 LOG(LOG_ERROR, "Out of memory for encoder chunk buffer");
 
@@ -1416,6 +1433,22 @@ void* MediaSourceMuxer::Run(void* pArgs)
                             {
                                 mFrameNumber++;
                                 int64_t tTime3 = Time::GetTimeStamp();
+
+                                // frames which the source has skipped, e.g., of an unchanged desktop, still count for the PTS values, otherwise the timeline is squeezed:
+                                // the frame number follows the elapsed stream time, hence a late frame and a quick successor don't shift the timeline ahead
+                                if (mEncoderStartTime == 0)
+                                    mEncoderStartTime = tTime3;
+                                else if (GetFrameRatePlayout() > 0)
+                                {
+                                    int tStreamFrameNumber = 1 + (int)((float)(tTime3 - mEncoderStartTime) * GetFrameRatePlayout() / 1000000 + 0.5);
+                                    if (tStreamFrameNumber > mFrameNumber)
+                                    {
+                                        #ifdef MSM_DEBUG_PACKETS
+                                            LOG(LOG_VERBOSE, "Source has skipped %d video frames", tStreamFrameNumber - mFrameNumber);
+                                        #endif
+                                        mFrameNumber = tStreamFrameNumber;
+                                    }
+                                }
                                 // ####################################################################
                                 // ### PREPARE YUV FRAME from SCALER
                                 // ###################################################################
@@ -1434,6 +1467,15 @@ void* MediaSourceMuxer::Run(void* pArgs)
                                 tYUVFrame->display_picture_number = mFrameNumber;
                                 tYUVFrame->pts = tPacketPts;
 
+                                // a new receiver needs a key frame to start decoding
+                                if (mEncoderForceKeyFrame)
+                                {
+                                    LOG(LOG_VERBOSE, "Forcing key frame for video frame %d", mFrameNumber);
+                                    mEncoderForceKeyFrame = false;
+                                    tYUVFrame->pict_type = AV_PICTURE_TYPE_I;
+                                }else
+                                    tYUVFrame->pict_type = AV_PICTURE_TYPE_NONE;
+
                                 #ifdef MSM_DEBUG_PACKETS
                                     LOG(LOG_VERBOSE, "Scaler returned video frame..");
                                     LOG(LOG_VERBOSE, "      ..key frame: %d", tYUVFrame->key_frame);
@@ -1447,7 +1489,7 @@ void* MediaSourceMuxer::Run(void* pArgs)
                                 // ### ENCODE FRAME
                                 // #########################################
                                 int64_t tTime = Time::GetTimeStamp();
-                                tSizeEncodedFrame = avcodec_encode_video(mCodecContext, (uint8_t *)mEncoderChunkBuffer, MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE, tYUVFrame);
+                                tSizeEncodedFrame = avcodec_encode_video(mCodecContext, (uint8_t *)mEncoderChunkBuffer, MemoryPool::GetCapacity(mEncoderChunkBuffer), tYUVFrame);
                                 #ifdef MSM_DEBUG_TIMING
                                     int64_t tTime2 = Time::GetTimeStamp();
                                     LOG(LOG_VERBOSE, "     encoding video frame took %ld us", tTime2 - tTime);
@@ -1460,12 +1502,10 @@ void* MediaSourceMuxer::Run(void* pArgs)
                                 {
                                     av_init_packet(tPacket);
 
-                                    // mark i-frame
-                                    if (mCodecContext->coded_frame->key_frame)
-                                    {
-                                        mEncoderHasKeyFrame = true;
+                                    // mark i-frame, the sinks start with the first key frame
+                                    mEncoderHasKeyFrame = (mCodecContext->coded_frame->key_frame != 0);
+                                    if (mEncoderHasKeyFrame)
                                         tPacket->flags |= AV_PKT_FLAG_KEY;
-                                    }
 
                                     // we only have one stream per audio stream
                                     tPacket->stream_index = 0;
@@ -1683,7 +1723,8 @@ void* MediaSourceMuxer::Run(void* pArgs)
             break;
     }
 
-    free(mEncoderChunkBuffer);
+    MEMORY_POOL.Free(mEncoderChunkBuffer);
+    mEncoderChunkBuffer = NULL;
 
     mEncoderFifoState.lock();
     delete mEncoderFifo;
@@ -1762,6 +1803,22 @@ int64_t MediaSourceMuxer::DecodedBIFrames()
         return mDecodedBIFrames;
 }
 
+int64_t MediaSourceMuxer::DroppedFrames()
+{
+    if (mMediaSource != NULL)
+        return mMediaSource->DroppedFrames();
+    else
+        return 0;
+}
+
+int64_t MediaSourceMuxer::GetTimeToFirstFrame()
+{
+    if (mMediaSource != NULL)
+        return mMediaSource->GetTimeToFirstFrame();
+    else
+        return 0;
+}
+
 int64_t MediaSourceMuxer::GetEndToEndDelay()
 {
     if (mMediaSource != NULL)
@@ -2036,6 +2093,17 @@ bool MediaSourceMuxer::SetInputStreamPreferences(std::string pStreamCodec, bool
         return 0;
 }
 
+bool MediaSourceMuxer::RequestKeyFrame()
+{
+    if (mMediaType != MEDIA_VIDEO)
+        return false;
+
+    LOG(LOG_VERBOSE, "Key frame requested for video stream");
+    mEncoderForceKeyFrame = true;
+
+    return true;
+}
+
 int MediaSourceMuxer::GetChunkDropCounter()
 {
     if (mMediaSource != NULL)
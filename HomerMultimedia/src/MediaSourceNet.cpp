@@ -32,6 +32,7 @@
 #include <ProcessStatisticService.h>
 #include <RequirementTransmitBitErrors.h>
 #include <RTP.h>
+#include <HBIoEngine.h>
 #include <Logger.h>
 
 #include <string>
@@ -52,7 +53,7 @@ using namespace Homer::Base;
 ///////////////////////////////////////////////////////////////////////////////
 
 class NetworkListener :
-    public Thread
+    public Thread, public IoReceiver
 {
 public:
     NetworkListener(MediaSourceNet *pMediaSourceNet, Socket *pDataSocket, bool pRtpActivated = true);
@@ -75,9 +76,12 @@ private:
 
     void Init(Socket *pDataSocket, unsigned int pLocalPort, bool pRtpActivated = true);
     bool ReceivePacket(std::string &pSourceHost, unsigned int &pSourcePort, char* pData, int &pSize);
+    void HandlePacket(std::string pSourceHost, unsigned int pSourcePort, char *pData, int pSize);
 
     /* network listener */
     virtual void* Run(void* pArgs = NULL);
+    /* asynchronous reception via I/O engine, replaces the listener thread for datagram sockets */
+    virtual bool OnReceive(std::string pSourceHost, unsigned int pSourcePort, char *pData, int pSize);
 
     MediaSourceNet      *mMediaSourceNet;
     bool                mRtpActivated;
@@ -89,6 +93,7 @@ private:
     bool				mListenerStopped;
     bool                mListenerSocketCreatedOutside;
     bool                mStreamedTransport;
+    bool                mAsyncReception;
     /* Berkeley sockets based transport */
     std::string         mPeerHost;
     unsigned int        mPeerPort;
@@ -111,6 +116,7 @@ void NetworkListener::Init(Socket *pDataSocket, unsigned int pLocalPort, bool pR
     mReceiveErrors = 0;
     mListenerPort = pLocalPort;
     mRtpActivated = pRtpActivated;
+    mAsyncReception = false;
 
     mDataSocket = pDataSocket;
 
@@ -245,6 +251,30 @@ void NetworkListener::StartListener()
 {
     LOG(LOG_VERBOSE, "Starting network listener for local port %u", GetListenerPort());
 
+    if ((mAsyncReception) && (!mListenerStopped))
+        return;
+
+    // datagram sockets are served by the completion threads of the I/O engine instead of an own listener thread
+    if ((!mNAPIUsed) && (!IsRunning()) && (IO_ENGINE.IsSupported(mDataSocket)))
+    {
+        if (mAsyncReception)
+            IO_ENGINE.UnregisterReceiver(mDataSocket);
+
+        mMediaSourceNet->mCurrentDeviceName = "NET-IN: " + MediaSinkNet::CreateId(mDataSocket->GetLocalHost(), toString(mDataSocket->GetLocalPort()), mDataSocket->GetTransportType(), mRtpActivated);
+        mMediaSourceNet->ClassifyStream(mMediaSourceNet->GetDataType(), mDataSocket->GetTransportType(), mDataSocket->GetNetworkType());
+        mMediaSourceNet->AssignStreamName(mMediaSourceNet->mCurrentDeviceName);
+
+        mListenerStopped = false;
+        mListenerNeeded = true;
+        mAsyncReception = IO_ENGINE.RegisterReceiver(mDataSocket, this);
+        if (mAsyncReception)
+        {
+            LOG(LOG_VERBOSE, "%s network listener for local port %u uses asynchronous reception", mMediaSourceNet->GetMediaTypeStr().c_str(), GetListenerPort());
+            return;
+        }
+        mListenerNeeded = false;
+    }
+
     if (!IsRunning())
     {
         // start decoder main loop
@@ -271,6 +301,15 @@ void NetworkListener::StopListener()
 	// tell network listener thread: it isn't needed anymore
 	mListenerNeeded = false;
 
+    if (mAsyncReception)
+    {
+        IO_ENGINE.UnregisterReceiver(mDataSocket);
+        mAsyncReception = false;
+        mListenerStopped = true;
+        LOG(LOG_VERBOSE, "%s network listener stopped", mMediaSourceNet->GetMediaTypeStr().c_str());
+        return;
+    }
+
 	if (mNAPIUsed)
 	{
 		mNAPIDataSocket->cancel();
@@ -393,6 +432,117 @@ string NetworkListener::GetCurrentDevicePeerName()
     }
 }
 
+void NetworkListener::HandlePacket(string pSourceHost, unsigned int pSourcePort, char *pData, int pSize)
+{
+    if ((pSize > 0) && (pSourceHost != "") && (pSourcePort != 0))
+    {
+        // some news about the peer?
+        if ((mPeerHost != pSourceHost) || (mPeerPort != pSourcePort))
+        {
+            if (mNAPIUsed)
+            {
+                // assume Berkeley-Socket implementation behind NAPI interface => therefore we can easily conclude on "UDP/TCP/UDP-Lite"
+                mMediaSourceNet->mCurrentDeviceName = "NET-IN: " + mNAPIDataSocket->getName()->toString() + "(" + (mStreamedTransport ? "TCP" : (mNAPIDataSocket->getRequirements()->contains(RequirementTransmitBitErrors::type()) ? "UDP-Lite" : "UDP")) + (mRtpActivated ? "/RTP" : "") + ")";
+
+                enum TransportType tTransportType = (mStreamedTransport ? SOCKET_TCP : (mNAPIDataSocket->getRequirements()->contains(RequirementTransmitBitErrors::type()) ? SOCKET_UDP_LITE : SOCKET_UDP));
+                // update category for packet statistics
+                enum NetworkType tNetworkType = (IS_IPV6_ADDRESS(mNAPIDataSocket->getName()->toString())) ? SOCKET_IPv6 : SOCKET_IPv4;
+                mMediaSourceNet->ClassifyStream(mMediaSourceNet->GetDataType(), tTransportType, tNetworkType);
+            }else
+            {
+                mMediaSourceNet->mCurrentDeviceName = "NET-IN: " + MediaSinkNet::CreateId(mDataSocket->GetLocalHost(), toString(mDataSocket->GetLocalPort()), mDataSocket->GetTransportType(), mRtpActivated);
+
+                // update category for packet statistics
+                mMediaSourceNet->ClassifyStream(mMediaSourceNet->GetDataType(), mDataSocket->GetTransportType(), mDataSocket->GetNetworkType());
+            }
+            LOG(LOG_VERBOSE, "Setting device name to %s", mMediaSourceNet->mCurrentDeviceName.c_str());
+            mPeerHost = pSourceHost;
+            mPeerPort = pSourcePort;
+        }
+
+        #ifdef MSN_DEBUG_PACKETS
+            LOG(LOG_VERBOSE, "Received packet number %5d at %p with size: %5d from %s:%u", (int)++mPacketNumber, pData, (int)pSize, pSourceHost.c_str(), pSourcePort);
+        #endif
+
+        // for TCP-like transport we have to use a special fragment header!
+        if (mStreamedTransport)
+        {
+            TCPFragmentHeader *tHeader;
+            char *tData = pData;
+            char *tDataEnd = pData + pSize;
+
+            while(pSize > 0)
+            {
+                if (tData > tDataEnd)
+                {
+                    LOG(LOG_ERROR, "Have found an invalid data position at %p while the data ends at %p", tData, tDataEnd);
+                    break;
+                }
+                #ifdef MSN_DEBUG_PACKETS
+                    LOG(LOG_VERBOSE, "Extracting a fragment from TCP stream");
+                #endif
+
+                tHeader = (TCPFragmentHeader*)tData;
+
+                if (tData + tHeader->FragmentSize > tDataEnd)
+                {
+                    LOG(LOG_ERROR, "Have found an invalid fragment size of %u bytes which is beyond the reported packet reception size", tHeader->FragmentSize);
+                    break;
+                }
+                //TODO: detect packet boundaries: maybe we get the last part of a former packet and the first part of the next packet -> this results in an error message at the moment, however, we could compensate this by a fragment buffer
+                //       -> picture errors occur if the video quality is high enough and causes a high data rate
+                tData += TCP_FRAGMENT_HEADER_SIZE;
+                pSize -= TCP_FRAGMENT_HEADER_SIZE;
+                mMediaSourceNet->WriteFragment(tData, (int)tHeader->FragmentSize);
+                tData += tHeader->FragmentSize;
+                pSize -= tHeader->FragmentSize;
+            }
+        }else
+        {
+            mMediaSourceNet->WriteFragment(pData, (int)pSize);
+        }
+    }else
+    {
+        if (pSize == 0)
+        {
+            LOG(LOG_VERBOSE, "Zero byte %s packet received", mMediaSourceNet->GetMediaTypeStr().c_str());
+
+            // add also a zero byte packet to enable early thread termination
+            mMediaSourceNet->WriteFragment(pData, 0);
+        }else
+        {
+            LOG(LOG_VERBOSE, "Got faulty %s packet", mMediaSourceNet->GetMediaTypeStr().c_str());
+        }
+    }
+}
+
+bool NetworkListener::OnReceive(string pSourceHost, unsigned int pSourcePort, char *pData, int pSize)
+{
+    if ((!mListenerNeeded) || (mMediaSourceNet->mGrabbingStopped))
+    {
+        mListenerStopped = true;
+        return false;
+    }
+
+    if (pSize < 0)
+    {
+        if (mReceiveErrors == MEDIA_SOURCE_NET_MAX_RECEIVE_ERRORS)
+        {
+            LOG(LOG_ERROR, "Maximum number of continuous receive errors(%d) is exceeded, will stop network listener", MEDIA_SOURCE_NET_MAX_RECEIVE_ERRORS);
+            mListenerNeeded = false;
+            mListenerStopped = true;
+            return false;
+        }else
+            mReceiveErrors++;
+        return true;
+    }
+    mReceiveErrors = 0;
+
+    HandlePacket(pSourceHost, pSourcePort, pData, pSize);
+
+    return true;
+}
+
 void* NetworkListener::Run(void* pArgs)
 {
     char                *tPacketBuffer = NULL;
@@ -484,87 +634,7 @@ void* NetworkListener::Run(void* pArgs)
 //      LOG(LOG_ERROR, "Port: %u", tSourcePort);
 //      LOG(LOG_ERROR, "Host: %s", tSourceHost.c_str());
 
-        if ((tDataSize > 0) && (tSourceHost != "") && (tSourcePort != 0))
-        {
-            // some news about the peer?
-            if ((mPeerHost != tSourceHost) || (mPeerPort != tSourcePort))
-            {
-                if (mNAPIUsed)
-                {
-                    // assume Berkeley-Socket implementation behind NAPI interface => therefore we can easily conclude on "UDP/TCP/UDP-Lite"
-                    mMediaSourceNet->mCurrentDeviceName = "NET-IN: " + mNAPIDataSocket->getName()->toString() + "(" + (mStreamedTransport ? "TCP" : (mNAPIDataSocket->getRequirements()->contains(RequirementTransmitBitErrors::type()) ? "UDP-Lite" : "UDP")) + (mRtpActivated ? "/RTP" : "") + ")";
-
-                    enum TransportType tTransportType = (mStreamedTransport ? SOCKET_TCP : (mNAPIDataSocket->getRequirements()->contains(RequirementTransmitBitErrors::type()) ? SOCKET_UDP_LITE : SOCKET_UDP));
-                    // update category for packet statistics
-                    enum NetworkType tNetworkType = (IS_IPV6_ADDRESS(mNAPIDataSocket->getName()->toString())) ? SOCKET_IPv6 : SOCKET_IPv4;
-                    mMediaSourceNet->ClassifyStream(mMediaSourceNet->GetDataType(), tTransportType, tNetworkType);
-                }else
-                {
-                    mMediaSourceNet->mCurrentDeviceName = "NET-IN: " + MediaSinkNet::CreateId(mDataSocket->GetLocalHost(), toString(mDataSocket->GetLocalPort()), mDataSocket->GetTransportType(), mRtpActivated);
-
-                    // update category for packet statistics
-                    mMediaSourceNet->ClassifyStream(mMediaSourceNet->GetDataType(), mDataSocket->GetTransportType(), mDataSocket->GetNetworkType());
-                }
-                LOG(LOG_VERBOSE, "Setting device name to %s", mMediaSourceNet->mCurrentDeviceName.c_str());
-                mPeerHost = tSourceHost;
-                mPeerPort = tSourcePort;
-            }
-
-            #ifdef MSN_DEBUG_PACKETS
-                LOG(LOG_VERBOSE, "Received packet number %5d at %p with size: %5d from %s:%u", (int)++mPacketNumber, tPacketBuffer, (int)tDataSize, tSourceHost.c_str(), tSourcePort);
-            #endif
-
-            // for TCP-like transport we have to use a special fragment header!
-            if (mStreamedTransport)
-            {
-                TCPFragmentHeader *tHeader;
-                char *tData = tPacketBuffer;
-                char *tDataEnd = tPacketBuffer + tDataSize;
-
-                while(tDataSize > 0)
-                {
-                    if (tData > tDataEnd)
-                    {
-                        LOG(LOG_ERROR, "Have found an invalid data position at %p while the data ends at %p", tData, tDataEnd);
-                        break;
-                    }
-                    #ifdef MSN_DEBUG_PACKETS
-                        LOG(LOG_VERBOSE, "Extracting a fragment from TCP stream");
-                    #endif
-
-                    tHeader = (TCPFragmentHeader*)tData;
-
-                    if (tData + tHeader->FragmentSize > tDataEnd)
-                    {
-                        LOG(LOG_ERROR, "Have found an invalid fragment size of %u bytes which is beyond the reported packet reception size", tHeader->FragmentSize);
-                        break;
-                    }
-                    //TODO: detect packet boundaries: maybe we get the last part of a former packet and the first part of the next packet -> this results in an error message at the moment, however, we could compensate this by a fragment buffer
-                    //       -> picture errors occur if the video quality is high enough and causes a high data rate
-                    tData += TCP_FRAGMENT_HEADER_SIZE;
-                    tDataSize -= TCP_FRAGMENT_HEADER_SIZE;
-                    mMediaSourceNet->WriteFragment(tData, (int)tHeader->FragmentSize);
-                    tData += tHeader->FragmentSize;
-                    tDataSize -= tHeader->FragmentSize;
-                }
-            }else
-            {
-                mMediaSourceNet->WriteFragment(tPacketBuffer, (int)tDataSize);
-            }
-        }else
-        {
-            if (tDataSize == 0)
-            {
-                LOG(LOG_VERBOSE, "Zero byte %s packet received", mMediaSourceNet->GetMediaTypeStr().c_str());
-
-                // add also a zero byte packet to enable early thread termination
-                mMediaSourceNet->WriteFragment(tPacketBuffer, 0);
-            }else
-            {
-                LOG(LOG_VERBOSE, "Got faulty %s packet", mMediaSourceNet->GetMediaTypeStr().c_str());
-                tDataSize = -1;
-            }
-        }
+        HandlePacket(tSourceHost, tSourcePort, tPacketBuffer, tDataSize);
     }
 
     LOG(LOG_VERBOSE, "%s Socket-Listener for port %u finished", mMediaSourceNet->GetMediaTypeStr().c_str(), GetListenerPort());
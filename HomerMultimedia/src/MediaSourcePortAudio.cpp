@@ -28,6 +28,7 @@
 #include <Header_PortAudio.h>
 #include <MediaFifo.h>
 #include <MediaSourcePortAudio.h>
+#include <DeviceRegistry.h>
 #include <ProcessStatisticService.h>
 #include <Logger.h>
 #include <HBThread.h>
@@ -78,6 +79,8 @@ MediaSourcePortAudio::MediaSourcePortAudio(string pDesiredDevice):
     mCaptureFifo = new MediaFifo(MEDIA_SOURCE_SAMPLES_CAPTURE_FIFO_SIZE, MEDIA_SOURCE_SAMPLES_BUFFER_SIZE, "MediaSourcePortAudio");
 
     PortAudioInit();
+    // PortAudio takes a snapshot of the available devices during its initialization, hence the cached list needs neither hotplug detection nor a rescan
+    DEVICE_REGISTRY.RegisterAudioEnumerator("PortAudio", EnumerateAudioDevices, "", true);
     if (pDesiredDevice != "")
     {
         bool tNewDeviceSelected = false;
@@ -104,6 +107,11 @@ MediaSourcePortAudio::~MediaSourcePortAudio()
 }
 
 void MediaSourcePortAudio::getAudioDevices(AudioDevices &pAList)
+{
+    DEVICE_REGISTRY.GetAudioDevices("PortAudio", pAList);
+}
+
+void MediaSourcePortAudio::EnumerateAudioDevices(AudioDevices &pAList)
 {
     static bool tFirstCall = true;
     AudioDeviceDescriptor tDevice;
@@ -116,9 +124,9 @@ void MediaSourcePortAudio::getAudioDevices(AudioDevices &pAList)
     int tDevCount = Pa_GetDeviceCount();
     if (tFirstCall)
     {
-        LOG(LOG_VERBOSE, "Enumerating hardware..");
-        LOG(LOG_VERBOSE, "PortAudio version \"%s\"(%d)", Pa_GetVersionText(), Pa_GetVersion());
-        LOG(LOG_VERBOSE, "Detected %d audio devices", tDevCount);
+        LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "Enumerating hardware..");
+        LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "PortAudio version \"%s\"(%d)", Pa_GetVersionText(), Pa_GetVersion());
+        LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "Detected %d audio devices", tDevCount);
     }
 
     for (int i = 0; i < tDevCount; i++)
@@ -143,43 +151,43 @@ void MediaSourcePortAudio::getAudioDevices(AudioDevices &pAList)
 
         if (tFirstCall)
         {
-            LOG(LOG_VERBOSE, "Device %d.. %s", i, (tDeviceInfo->defaultSampleRate == 44100.0) ? " " : "[unsupported, sample rate must be 44.1 kHz]");
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "Device %d.. %s", i, (tDeviceInfo->defaultSampleRate == 44100.0) ? " " : "[unsupported, sample rate must be 44.1 kHz]");
 
             // mark global and API specific default devices
             if (i == Pa_GetDefaultInputDevice())
             {
-                LOG(LOG_VERBOSE, "..is DEFAULT INPUT device");
+                LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..is DEFAULT INPUT device");
             } else
             {
                 if (i == Pa_GetHostApiInfo(tDeviceInfo->hostApi)->defaultInputDevice)
                 {
                     const PaHostApiInfo *tHostApiInfo = Pa_GetHostApiInfo(tDeviceInfo->hostApi);
-                    LOG(LOG_VERBOSE, "..default %s input", tHostApiInfo->name );
+                    LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default %s input", tHostApiInfo->name );
                 }
             }
 
             if (i == Pa_GetDefaultOutputDevice())
             {
-                LOG(LOG_VERBOSE, "..is DEFAULT OUTPUT device");
+                LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..is DEFAULT OUTPUT device");
             } else
             {
                 if (i == Pa_GetHostApiInfo(tDeviceInfo->hostApi)->defaultOutputDevice)
                 {
                     const PaHostApiInfo *tHostApiInfo = Pa_GetHostApiInfo(tDeviceInfo->hostApi);
-                    LOG(LOG_VERBOSE, "..default %s output", tHostApiInfo->name );
+                    LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default %s output", tHostApiInfo->name );
                 }
             }
 
             // print device info fields
-            LOG(LOG_VERBOSE, "..name: \"%s\"", tDeviceInfo->name);
-            LOG(LOG_VERBOSE, "..host API: \"%s\"", Pa_GetHostApiInfo( tDeviceInfo->hostApi)->name);
-            LOG(LOG_VERBOSE, "..max. inputs channels: %d", tDeviceInfo->maxInputChannels);
-            LOG(LOG_VERBOSE, "..max. outputs channels: %d", tDeviceInfo->maxOutputChannels);
-            LOG(LOG_VERBOSE, "..default low input latency  : %8.4f seconds", tDeviceInfo->defaultLowInputLatency);
-            LOG(LOG_VERBOSE, "..default low output latency : %8.4f seconds", tDeviceInfo->defaultLowOutputLatency);
-            LOG(LOG_VERBOSE, "..default high input latency : %8.4f seconds", tDeviceInfo->defaultHighInputLatency);
-            LOG(LOG_VERBOSE, "..default high output latency: %8.4f seconds", tDeviceInfo->defaultHighOutputLatency);
-            LOG(LOG_VERBOSE, "..default sample rate: %8.0f Hz", tDeviceInfo->defaultSampleRate);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..name: \"%s\"", tDeviceInfo->name);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..host API: \"%s\"", Pa_GetHostApiInfo( tDeviceInfo->hostApi)->name);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..max. inputs channels: %d", tDeviceInfo->maxInputChannels);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..max. outputs channels: %d", tDeviceInfo->maxOutputChannels);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default low input latency  : %8.4f seconds", tDeviceInfo->defaultLowInputLatency);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default low output latency : %8.4f seconds", tDeviceInfo->defaultLowOutputLatency);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default high input latency : %8.4f seconds", tDeviceInfo->defaultHighInputLatency);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default high output latency: %8.4f seconds", tDeviceInfo->defaultHighOutputLatency);
+            LOGEX(MediaSourcePortAudio, LOG_VERBOSE, "..default sample rate: %8.0f Hz", tDeviceInfo->defaultSampleRate);
         }
     }
 
@@ -27,6 +27,7 @@
 
 #include <MediaSourceV4L2.h>
 #include <MediaSource.h>
+#include <DeviceRegistry.h>
 #include <ProcessStatisticService.h>
 #include <Logger.h>
 #include <Header_Ffmpeg.h>
@@ -56,6 +57,9 @@ MediaSourceV4L2::MediaSourceV4L2(string pDesiredDevice):
 
     mCurrentInputChannelName = "";
 
+    // the registry caches the device list and enumerates again after hotplug events
+    DEVICE_REGISTRY.RegisterVideoEnumerator("V4L2", EnumerateVideoDevices, "/dev/video");
+
     bool tNewDeviceSelected = false;
     SelectDevice(pDesiredDevice, MEDIA_VIDEO, tNewDeviceSelected);
     if (!tNewDeviceSelected)
@@ -71,6 +75,11 @@ MediaSourceV4L2::~MediaSourceV4L2()
 }
 
 void MediaSourceV4L2::getVideoDevices(VideoDevices &pVList)
+{
+    DEVICE_REGISTRY.GetVideoDevices("V4L2", pVList);
+}
+
+void MediaSourceV4L2::EnumerateVideoDevices(VideoDevices &pVList)
 {
     static bool tFirstCall = true;
     struct v4l2_capability tV4L2Caps;
@@ -86,7 +95,7 @@ void MediaSourceV4L2::getVideoDevices(VideoDevices &pVList)
     #endif
 
     if (tFirstCall)
-        LOG(LOG_VERBOSE, "Enumerating hardware..");
+        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "Enumerating hardware..");
 
     for (int tDeviceId = 0; tDeviceId != 10; tDeviceId++)
     {
@@ -102,36 +111,36 @@ void MediaSourceV4L2::getVideoDevices(VideoDevices &pVList)
 
             if (tFirstCall)
                 if (tDevice.Name.size())
-                    LOG(LOG_VERBOSE, "Found video device: %s (device file: %s)", tDevice.Name.c_str(), tDeviceFile.c_str());
+                    LOGEX(MediaSourceV4L2, LOG_VERBOSE, "Found video device: %s (device file: %s)", tDevice.Name.c_str(), tDeviceFile.c_str());
 
             if ((tFd = open(tDeviceFile.c_str(), O_RDONLY)) >= 0)
             {
                 if (ioctl(tFd, VIDIOC_QUERYCAP, &tV4L2Caps) < 0)
-                    LOG(LOG_ERROR, "Can't get device capabilities for \"%s\" because of \"%s\"", tDeviceFile.c_str(), strerror(errno));
+                    LOGEX(MediaSourceV4L2, LOG_ERROR, "Can't get device capabilities for \"%s\" because of \"%s\"", tDeviceFile.c_str(), strerror(errno));
                 else
                 {
                     tDevice.Name = toString(tV4L2Caps.card);
                     tDevice.Desc += " \"" + toString(tV4L2Caps.card) + "\"";
                     if (tFirstCall)
                     {
-                        LOG(LOG_VERBOSE, "..driver name: %s", tV4L2Caps.driver);
-                        LOG(LOG_VERBOSE, "..card name: %s", tV4L2Caps.card);
-                        LOG(LOG_VERBOSE, "..connected at: %s", tV4L2Caps.bus_info);
-                        LOG(LOG_VERBOSE, "..driver version: %u.%u.%u", (tV4L2Caps.version >> 16) & 0xFF, (tV4L2Caps.version >> 8) & 0xFF, tV4L2Caps.version & 0xFF);
+                        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..driver name: %s", tV4L2Caps.driver);
+                        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..card name: %s", tV4L2Caps.card);
+                        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..connected at: %s", tV4L2Caps.bus_info);
+                        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..driver version: %u.%u.%u", (tV4L2Caps.version >> 16) & 0xFF, (tV4L2Caps.version >> 8) & 0xFF, tV4L2Caps.version & 0xFF);
                         if (tV4L2Caps.capabilities & V4L2_CAP_VIDEO_CAPTURE)
-                            LOG(LOG_VERBOSE, "supporting video capture interface");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "supporting video capture interface");
                         if (tV4L2Caps.capabilities & V4L2_CAP_VIDEO_OUTPUT)
-                            LOG(LOG_VERBOSE, "supporting video output interface");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "supporting video output interface");
                         if (tV4L2Caps.capabilities & V4L2_CAP_VIDEO_OVERLAY)
-                            LOG(LOG_VERBOSE, "supporting video overlay interface");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "supporting video overlay interface");
                         if (tV4L2Caps.capabilities & V4L2_CAP_TUNER)
-                            LOG(LOG_VERBOSE, "..onboard tuner");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..onboard tuner");
                         if (tV4L2Caps.capabilities & V4L2_CAP_AUDIO)
-                            LOG(LOG_VERBOSE, "..onboard audio");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..onboard audio");
                         if (tV4L2Caps.capabilities & V4L2_CAP_RDS_CAPTURE)
-                            LOG(LOG_VERBOSE, "..onboard RDS");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..onboard RDS");
                         if (tV4L2Caps.capabilities & V4L2_CAP_VIDEO_OUTPUT_OVERLAY)
-                            LOG(LOG_VERBOSE, "..supporting OnScreenDisplay (OSD)");
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..supporting OnScreenDisplay (OSD)");
                     }
                 }
 
@@ -158,21 +167,21 @@ void MediaSourceV4L2::getVideoDevices(VideoDevices &pVList)
 
                         if (tFirstCall)
                         {
-                            LOG(LOG_VERBOSE, "..input index: %u", tV4L2Input.index);
-                            LOG(LOG_VERBOSE, "..input name: %u", tV4L2Input.name);
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..input index: %u", tV4L2Input.index);
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..input name: %u", tV4L2Input.name);
                             switch(tV4L2Input.type)
                             {
                                 case V4L2_INPUT_TYPE_TUNER:
-                                        LOG(LOG_VERBOSE, "..input type: tuner");
+                                        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..input type: tuner");
                                         break;
                                 case V4L2_INPUT_TYPE_CAMERA:
-                                        LOG(LOG_VERBOSE, "..input type: camera");
+                                        LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..input type: camera");
                                         break;
                             }
                             // audioset
                             // tuner
                             // std
-                            LOG(LOG_VERBOSE, "..input status: 0x%x", tV4L2Input.status);
+                            LOGEX(MediaSourceV4L2, LOG_VERBOSE, "..input status: 0x%x", tV4L2Input.status);
                         }
                     }
                     tIndex++;
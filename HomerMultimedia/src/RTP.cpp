@@ -64,6 +64,7 @@
 #include <Header_Ffmpeg.h>
 #include <PacketStatistic.h>
 #include <HBSocket.h>
+#include <HBMemoryPool.h>
 #include <MediaSourceNet.h>
 #include <Logger.h>
 
@@ -412,12 +413,15 @@ union VP8ExtendedHeader{
 RTP::RTP()
 {
     LOG(LOG_VERBOSE, "Created");
-    mH261LocalSequenceNumber = 0;
+    mLocalSequenceNumber = 0;
     mIntermediateFragment = 0;
     mPacketStatistic = NULL;
     mRtpFormatContext = NULL;
     mEncoderOpened = false;
     mH261UseInternalEncoder = false;
+    mUseNativePacketizer = false;
+    mMaxRtpPacketSize = 0;
+    mVP8PictureId = 0;
     mRtpPacketStream = NULL;
     mRtpPacketBuffer = NULL;
     mTargetHost = "";
@@ -506,6 +510,41 @@ bool RTP::OpenRtpEncoderH261(string pTargetHost, unsigned int pTargetPort, AVStr
     return true;
 }
 
+bool RTP::OpenRtpEncoderNative(string pTargetHost, unsigned int pTargetPort, AVStream *pInnerStream)
+{
+    LOG(LOG_VERBOSE, "Using lib internal rtp packetizer for %s codec", pInnerStream->codec->codec->name);
+
+    mMaxRtpPacketSize = pInnerStream->codec->rtp_payload_size;
+    if (mMaxRtpPacketSize < RTP_HEADER_SIZE + 64)
+    {
+        LOG(LOG_ERROR, "RTP packet size of %u bytes is too small", mMaxRtpPacketSize);
+        return false;
+    }
+    mLocalPacketCount = 0;
+    mLocalOctetCount = 0;
+    mLocalLastSenderReport = 0;
+    mVP8PictureId = 0;
+
+    // Init() has reset the payload type
+    mPayloadId = CodecToPayloadId(pInnerStream->codec->codec->name);
+
+    // preallocate the descriptions of NAL units and RTP packets, they are reused for every frame
+    mNalUnits.reserve(64);
+    mPacketSlots.reserve(256);
+
+    LOG(LOG_INFO, "Opened...");
+    LOG(LOG_INFO, "    ..rtp target: %s:%u", pTargetHost.c_str(), pTargetPort);
+    LOG(LOG_INFO, "    ..rtp header size: %d", RTP_HEADER_SIZE);
+    LOG(LOG_INFO, "    ..rtp SRC: %u", mLocalSourceIdentifier);
+    LOG(LOG_INFO, "  Wrapping following codec...");
+    LOG(LOG_INFO, "    ..codec name: %s", pInnerStream->codec->codec->name);
+    LOG(LOG_INFO, "    ..resolution: %d * %d pixels", pInnerStream->codec->width, pInnerStream->codec->height);
+    LOG(LOG_INFO, "    ..rtp payload size: %d bytes", pInnerStream->codec->rtp_payload_size);
+    mEncoderOpened = true;
+    mUseNativePacketizer = true;
+    return true;
+}
+
 bool RTP::OpenRtpEncoder(string pTargetHost, unsigned int pTargetPort, AVStream *pInnerStream)
 {
     AVDictionary        *tOptions = NULL;
@@ -513,16 +552,20 @@ bool RTP::OpenRtpEncoder(string pTargetHost, unsigned int pTargetPort, AVStream
     if (mEncoderOpened)
         return false;
 
-    mRtpPacketStream = (char*)malloc(MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE);
+    // size the packet stream according to the resolution, a frame which doesn't fit lets the buffer grow later
+    unsigned int tRtpPacketStreamSize = RTP_PACKET_STREAM_MIN_SIZE;
+    if (pInnerStream->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+        tRtpPacketStreamSize += pInnerStream->codec->width * pInnerStream->codec->height;
+    mRtpPacketStream = (char*)MEMORY_POOL.Alloc("RTP", tRtpPacketStreamSize);
     if (mRtpPacketStream == NULL)
         LOG(LOG_ERROR, "Error when allocating memory for RTP packet stream");
     else
-        LOG(LOG_VERBOSE, "Created RTP packet stream memory of %d bytes at %p", MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE, mRtpPacketStream);
+        LOG(LOG_VERBOSE, "Created RTP packet stream memory of %u bytes at %p", MemoryPool::GetCapacity(mRtpPacketStream), mRtpPacketStream);
     mRtpPacketBuffer = (char*)malloc(pInnerStream->codec->rtp_payload_size);
     if (mRtpPacketBuffer == NULL)
         LOG(LOG_ERROR, "Error when allocating memory for RTP packet buffer");
     else
-        LOG(LOG_VERBOSE, "Created RTP packet buffer memory of %d bytes at %p", MEDIA_SOURCE_AV_CHUNK_BUFFER_SIZE, mRtpPacketBuffer);
+        LOG(LOG_VERBOSE, "Created RTP packet buffer memory of %d bytes at %p", pInnerStream->codec->rtp_payload_size, mRtpPacketBuffer);
 
     const char *tCodecName = pInnerStream->codec->codec->name;
     mPayloadId = CodecToPayloadId(tCodecName);
@@ -540,6 +583,11 @@ bool RTP::OpenRtpEncoder(string pTargetHost, unsigned int pTargetPort, AVStream
     if (mStreamCodecID == CODEC_ID_H261)
     	return OpenRtpEncoderH261(pTargetHost, pTargetPort, pInnerStream);
 
+    #ifdef RTP_NATIVE_PACKETIZERS
+        if ((mStreamCodecID == CODEC_ID_H264) || (mStreamCodecID == CODEC_ID_VP8))
+            return OpenRtpEncoderNative(pTargetHost, pTargetPort, pInnerStream);
+    #endif
+
     int                 tResult;
     AVOutputFormat      *tFormat;
     AVStream            *tOuterStream;
@@ -661,7 +709,7 @@ bool RTP::CloseRtpEncoder()
 
     if (mEncoderOpened)
     {
-        if (!mH261UseInternalEncoder /* h261 */)
+        if ((!mH261UseInternalEncoder /* h261 */) && (!mUseNativePacketizer /* h264, vp8 */))
         {
             // write the trailer, if any
             av_write_trailer(mRtpFormatContext);
@@ -678,9 +726,9 @@ bool RTP::CloseRtpEncoder()
 
         if (mRtpPacketStream != NULL)
         {
-            delete mRtpPacketBuffer;
+            free(mRtpPacketBuffer);
             mRtpPacketBuffer = NULL;
-            delete mRtpPacketStream;
+            MEMORY_POOL.Free(mRtpPacketStream);
             mRtpPacketStream = NULL;
         }
         LOG(LOG_INFO, "...closed");
@@ -689,6 +737,7 @@ bool RTP::CloseRtpEncoder()
 
     mEncoderOpened = false;
     mH261UseInternalEncoder = false;
+    mUseNativePacketizer = false;
 
     return true;
 }
@@ -840,6 +889,20 @@ int RTP::StoreRtpPacket(void *pOpaque, uint8_t *pBuffer, int pBufferSize)
     if (!tRTPInstance->mEncoderOpened)
         LOGEX(RTP, LOG_ERROR, "RTP instance wasn't opened yet, RTP packetizing not available");
 
+    // grow the packet stream if the current frame doesn't fit
+    unsigned int tRtpPacketStreamSize = tRTPInstance->mRtpPacketStreamPos - tRTPInstance->mRtpPacketStream;
+    if (tRtpPacketStreamSize + 4 + pBufferSize > MemoryPool::GetCapacity(tRTPInstance->mRtpPacketStream))
+    {
+        char *tRtpPacketStream = (char*)MEMORY_POOL.Grow(tRTPInstance->mRtpPacketStream, 2 * (tRtpPacketStreamSize + 4 + pBufferSize));
+        if (tRtpPacketStream == NULL)
+        {
+            LOGEX(RTP, LOG_ERROR, "Unable to grow RTP packet stream, dropping RTP packet of %d bytes", pBufferSize);
+            return pBufferSize;
+        }
+        tRTPInstance->mRtpPacketStream = tRtpPacketStream;
+        tRTPInstance->mRtpPacketStreamPos = tRtpPacketStream + tRtpPacketStreamSize;
+    }
+
     // write RTP packet size
     unsigned int *tRtpPacketSize = (unsigned int*)tRTPInstance->mRtpPacketStreamPos;
 
@@ -880,6 +943,14 @@ bool RTP::RtpCreate(char *&pData, unsigned int &pDataSize, int64_t pPacketPts)
     if (mH261UseInternalEncoder)
         return RtpCreateH261(pData, pDataSize, pPacketPts);
 
+    if (mUseNativePacketizer)
+    {
+        if (mStreamCodecID == CODEC_ID_H264)
+            return RtpCreateH264(pData, pDataSize, pPacketPts);
+        else
+            return RtpCreateVP8(pData, pDataSize, pPacketPts);
+    }
+
     //####################################################################
     // for all non H261 codec use the ffmpeg RTP implementation
     //####################################################################
@@ -1151,6 +1222,15 @@ bool RTP::RtpCreateH261(char *&pData, unsigned int &pDataSize, int64_t pPacketPt
     // HINT: the size of memory for storing the stream of RTP packets is rounded to multiples of (RTP_MAX_PACKET_SIZE + 4)
     unsigned int tRtpStreamDataMaxSize = tPacketCount * (RTP_MAX_H261_PAYLOAD_SIZE + H261_HEADER_SIZE + RTP_HEADER_SIZE + 4 /* overhead for packet length field */);
     unsigned int tRtpStreamDataSize = 0;
+    if (mRtpPacketStream == NULL)
+        mRtpPacketStream = (char*)MEMORY_POOL.Alloc("RTP", tRtpStreamDataMaxSize);
+    else
+        mRtpPacketStream = (char*)MEMORY_POOL.Grow(mRtpPacketStream, tRtpStreamDataMaxSize);
+    if (mRtpPacketStream == NULL)
+    {
+        LOG(LOG_ERROR, "Error when allocating memory for RTP packet stream");
+        return false;
+    }
 
     // get pointer to the current working address inside rtp packet stream
     char *tCurrentRtpStreamData = mRtpPacketStream;
@@ -1194,7 +1274,7 @@ bool RTP::RtpCreateH261(char *&pData, unsigned int &pDataSize, int64_t pPacketPt
         tRtpHeader->CsrcCount = 0; // no usage of CSRCs
         tRtpHeader->Marked = (tPacketIndex == tPacketCount - 1)? 1 : 0; // 1 = last fragment, 0 = intermediate fragment
         tRtpHeader->PayloadType = 31; // 31 = h261
-        tRtpHeader->SequenceNumber = ++mH261LocalSequenceNumber; // monotonous growing
+        tRtpHeader->SequenceNumber = ++mLocalSequenceNumber; // monotonous growing
         tRtpHeader->Timestamp = pPacketPts * CalculateClockRateFactor() /* 90 kHz clock rate */;
         tRtpHeader->Ssrc = mLocalSourceIdentifier; // use the initially computed unique ID
 
@@ -1244,6 +1324,263 @@ bool RTP::RtpCreateH261(char *&pData, unsigned int &pDataSize, int64_t pPacketPt
     return true;
 }
 
+bool RTP::ReserveRtpPacketSlots(unsigned int pFrameSize, unsigned int pPacketOverhead)
+{
+    // worst case: every NAL unit/partition starts a new packet, a sender report precedes the packets
+    unsigned int tMaxPayloadSize = mMaxRtpPacketSize - RTP_HEADER_SIZE - pPacketOverhead;
+    unsigned int tMaxPackets = pFrameSize / tMaxPayloadSize + mNalUnits.size() + 1;
+    unsigned int tMaxStreamSize = pFrameSize + tMaxPackets * (4 + RTP_HEADER_SIZE + pPacketOverhead) + 4 + RTCP_HEADER_SIZE;
+
+    if (tMaxStreamSize > MemoryPool::GetCapacity(mRtpPacketStream))
+    {
+        char *tRtpPacketStream = (char*)MEMORY_POOL.Grow(mRtpPacketStream, tMaxStreamSize);
+        if (tRtpPacketStream == NULL)
+        {
+            LOG(LOG_ERROR, "Unable to allocate %u bytes for RTP packet stream", tMaxStreamSize);
+            return false;
+        }
+        mRtpPacketStream = tRtpPacketStream;
+    }
+
+    OpenRtpPacketStream();
+    mPacketSlots.clear();
+
+    return true;
+}
+
+char* RTP::AddRtpPacketSlot(unsigned int pSize, bool pMarked, unsigned int pTimestamp, unsigned int pPayloadOffset, unsigned int pPayloadSize)
+{
+    RtpPacketSlot tSlot;
+    tSlot.Offset = mRtpPacketStreamPos + 4 - mRtpPacketStream;
+    tSlot.Size = RTP_HEADER_SIZE + pSize;
+    tSlot.PayloadOffset = pPayloadOffset;
+    tSlot.PayloadSize = pPayloadSize;
+    mPacketSlots.push_back(tSlot);
+
+    // set the current rtp packet's size within the resulting packet buffer
+    // HINT: convert from host to network byte order to pretend ffmpeg behavior
+    unsigned int *tRtpPacketSize = (unsigned int*)mRtpPacketStreamPos;
+    *tRtpPacketSize = htonl((uint32_t)tSlot.Size);
+    mRtpPacketStreamPos += 4;
+
+    RtpHeader* tRtpHeader = (RtpHeader*)mRtpPacketStreamPos;
+    tRtpHeader->Version = 2; // current RTP-rfc 3550 defines version 2
+    tRtpHeader->Padding = 0; // no padding octets
+    tRtpHeader->Extension = 0; // no extension header used
+    tRtpHeader->CsrcCount = 0; // no usage of CSRCs
+    tRtpHeader->Marked = pMarked; // 1 = last packet of the frame
+    tRtpHeader->PayloadType = mPayloadId;
+    tRtpHeader->SequenceNumber = ++mLocalSequenceNumber; // monotonous growing
+    tRtpHeader->Timestamp = pTimestamp;
+    tRtpHeader->Ssrc = mLocalSourceIdentifier; // use the initially computed unique ID
+
+    // convert from host to network byte order
+    for (int i = 0; i < 3; i++)
+        tRtpHeader->Data[i] = htonl(tRtpHeader->Data[i]);
+
+    mRtpPacketStreamPos += tSlot.Size;
+    mLocalPacketCount++;
+    mLocalOctetCount += pSize;
+
+    return (char*)tRtpHeader + RTP_HEADER_SIZE;
+}
+
+// HINT: RFC 6184, packetization mode 1 (single NAL unit and FU-A packets, STAP-A isn't sent), the encoder delivers a byte stream with start codes
+bool RTP::RtpCreateH264(char *&pData, unsigned int &pDataSize, int64_t pPacketPts)
+{
+    unsigned char *tFrame = (unsigned char*)pData;
+    unsigned int tFrameSize = pDataSize;
+    unsigned int tTimestamp = pPacketPts * CalculateClockRateFactor();
+    unsigned int tMaxPayloadSize = mMaxRtpPacketSize - RTP_HEADER_SIZE;
+
+    //####################################################################
+    // find the NAL unit boundaries
+    //####################################################################
+    mNalUnits.clear();
+    unsigned int tPos = 0;
+    while (tPos + 3 <= tFrameSize)
+    {
+        if (tFrame[tPos + 2] > 1)
+        {// no start code can begin at tPos, tPos + 1 or tPos + 2
+            tPos += 3;
+            continue;
+        }
+        if ((tFrame[tPos] == 0) && (tFrame[tPos + 1] == 0) && (tFrame[tPos + 2] == 1))
+        {
+            // the previous NAL unit ends before the start code, the leading zero of a 4 byte start code doesn't belong to it
+            if (!mNalUnits.empty())
+                mNalUnits.back().Size = ((tFrame[tPos - 1] == 0) ? tPos - 1 : tPos) - mNalUnits.back().Offset;
+            RtpNalUnit tNalUnit;
+            tNalUnit.Offset = tPos + 3;
+            tNalUnit.Size = 0;
+            tNalUnit.FirstPacket = -1;
+            tNalUnit.LastPacket = -1;
+            mNalUnits.push_back(tNalUnit);
+            tPos += 3;
+        }else
+            tPos++;
+    }
+    if (mNalUnits.empty())
+    {
+        LOG(LOG_WARN, "H.264 frame of %u bytes without start code, sending it as one NAL unit", tFrameSize);
+        RtpNalUnit tNalUnit;
+        tNalUnit.Offset = 0;
+        mNalUnits.push_back(tNalUnit);
+    }
+    mNalUnits.back().Size = tFrameSize - mNalUnits.back().Offset;
+
+    // drop empty NAL units
+    for (RtpNalUnits::iterator tIt = mNalUnits.begin(); tIt != mNalUnits.end();)
+    {
+        if (tIt->Size == 0)
+            tIt = mNalUnits.erase(tIt);
+        else
+        {
+            tIt->Type = tFrame[tIt->Offset] & 0x1F;
+            tIt->FirstPacket = -1;
+            tIt->LastPacket = -1;
+            tIt++;
+        }
+    }
+    if (mNalUnits.empty())
+    {
+        pDataSize = 0;
+        return false;
+    }
+
+    if (!ReserveRtpPacketSlots(tFrameSize, 2 /* FU indicator + FU header */))
+        return false;
+
+    if ((mLocalLastSenderReport == 0) || (av_gettime() - mLocalLastSenderReport > RTCP_SENDER_REPORT_PERIOD * 1000))
+        RtcpCreateSenderReport(tTimestamp);
+
+    //####################################################################
+    // create the RTP packets
+    //####################################################################
+    unsigned int tNalUnitCount = mNalUnits.size();
+    for (unsigned int i = 0; i < tNalUnitCount; i++)
+    {
+        RtpNalUnit &tNalUnit = mNalUnits[i];
+        unsigned char tNalHeader = tFrame[tNalUnit.Offset];
+
+        if (tNalUnit.Size <= tMaxPayloadSize)
+        {
+            // single NAL unit packet: the NAL header co-serves as payload header
+            char *tPayload = AddRtpPacketSlot(tNalUnit.Size, (i == tNalUnitCount - 1), tTimestamp, tNalUnit.Offset, tNalUnit.Size);
+            memcpy(tPayload, tFrame + tNalUnit.Offset, tNalUnit.Size);
+            tNalUnit.FirstPacket = tNalUnit.LastPacket = mPacketSlots.size() - 1;
+        }else
+        {// FU-A: the NAL header is split into FU indicator and FU header
+            unsigned int tOffset = tNalUnit.Offset + 1;
+            unsigned int tRemainingSize = tNalUnit.Size - 1;
+            tNalUnit.FirstPacket = mPacketSlots.size();
+            while (tRemainingSize > 0)
+            {
+                unsigned int tChunkSize = (tRemainingSize > tMaxPayloadSize - 2) ? tMaxPayloadSize - 2 : tRemainingSize;
+                bool tStart = (tOffset == tNalUnit.Offset + 1);
+                bool tEnd = (tChunkSize == tRemainingSize);
+
+                char *tPayload = AddRtpPacketSlot(2 + tChunkSize, (tEnd) && (i == tNalUnitCount - 1), tTimestamp, tOffset, tChunkSize);
+                tPayload[0] = (tNalHeader & 0xE0 /* F + NRI */) | 28;
+                tPayload[1] = (tStart ? 0x80 : 0) | (tEnd ? 0x40 : 0) | (tNalHeader & 0x1F /* TYPE */);
+                memcpy(tPayload + 2, tFrame + tOffset, tChunkSize);
+
+                tOffset += tChunkSize;
+                tRemainingSize -= tChunkSize;
+            }
+            tNalUnit.LastPacket = mPacketSlots.size() - 1;
+        }
+    }
+
+    pDataSize = CloseRtpPacketStream(&pData);
+
+    #ifdef RTP_DEBUG_PACKET_ENCODER
+        LOG(LOG_VERBOSE, "Packetized H.264 frame of %u bytes with %u NAL units into %u RTP packets", tFrameSize, tNalUnitCount, (unsigned int)mPacketSlots.size());
+    #endif
+
+    return true;
+}
+
+// HINT: RFC 7741, the payload descriptor always includes a 7 bit picture ID, all DCT token partitions are transported as one unit
+bool RTP::RtpCreateVP8(char *&pData, unsigned int &pDataSize, int64_t pPacketPts)
+{
+    unsigned char *tFrame = (unsigned char*)pData;
+    unsigned int tFrameSize = pDataSize;
+    unsigned int tTimestamp = pPacketPts * CalculateClockRateFactor();
+    unsigned int tMaxPayloadSize = mMaxRtpPacketSize - RTP_HEADER_SIZE - 3 /* payload descriptor */;
+
+    if (tFrameSize < 3)
+    {
+        pDataSize = 0;
+        return false;
+    }
+
+    //####################################################################
+    // find the partition boundary: frame tag and first partition form partition 0
+    //####################################################################
+    bool tKeyFrame = ((tFrame[0] & 0x01) == 0);
+    unsigned int tFirstPartitionSize = (tFrame[0] | (tFrame[1] << 8) | (tFrame[2] << 16)) >> 5;
+    unsigned int tPartition0Size = (tKeyFrame ? 10 : 3) + tFirstPartitionSize;
+    if (tPartition0Size > tFrameSize)
+        tPartition0Size = tFrameSize;
+
+    mNalUnits.clear();
+    RtpNalUnit tPartition;
+    tPartition.Offset = 0;
+    tPartition.Size = tPartition0Size;
+    tPartition.Type = 0;
+    mNalUnits.push_back(tPartition);
+    if (tPartition0Size < tFrameSize)
+    {
+        tPartition.Offset = tPartition0Size;
+        tPartition.Size = tFrameSize - tPartition0Size;
+        tPartition.Type = 1;
+        mNalUnits.push_back(tPartition);
+    }
+
+    if (!ReserveRtpPacketSlots(tFrameSize, 3 /* payload descriptor */))
+        return false;
+
+    if ((mLocalLastSenderReport == 0) || (av_gettime() - mLocalLastSenderReport > RTCP_SENDER_REPORT_PERIOD * 1000))
+        RtcpCreateSenderReport(tTimestamp);
+
+    //####################################################################
+    // create the RTP packets
+    //####################################################################
+    unsigned char tPictureId = mVP8PictureId++ & 0x7F;
+    for (unsigned int i = 0; i < mNalUnits.size(); i++)
+    {
+        RtpNalUnit &tNalUnit = mNalUnits[i];
+        unsigned int tOffset = tNalUnit.Offset;
+        unsigned int tRemainingSize = tNalUnit.Size;
+        tNalUnit.FirstPacket = mPacketSlots.size();
+        while (tRemainingSize > 0)
+        {
+            unsigned int tChunkSize = (tRemainingSize > tMaxPayloadSize) ? tMaxPayloadSize : tRemainingSize;
+            bool tStart = (tOffset == tNalUnit.Offset);
+            bool tLast = (tChunkSize == tRemainingSize) && (i == mNalUnits.size() - 1);
+
+            char *tPayload = AddRtpPacketSlot(3 + tChunkSize, tLast, tTimestamp, tOffset, tChunkSize);
+            tPayload[0] = 0x80 /* X */ | (tStart ? 0x10 /* S */ : 0) | (tNalUnit.Type & 0x0F /* PID */);
+            tPayload[1] = 0x80; /* I: picture ID present */
+            tPayload[2] = tPictureId; /* M = 0: 7 bit picture ID */
+            memcpy(tPayload + 3, tFrame + tOffset, tChunkSize);
+
+            tOffset += tChunkSize;
+            tRemainingSize -= tChunkSize;
+        }
+        tNalUnit.LastPacket = mPacketSlots.size() - 1;
+    }
+
+    pDataSize = CloseRtpPacketStream(&pData);
+
+    #ifdef RTP_DEBUG_PACKET_ENCODER
+        LOG(LOG_VERBOSE, "Packetized VP8 %s of %u bytes into %u RTP packets", tKeyFrame ? "key frame" : "frame", tFrameSize, (unsigned int)mPacketSlots.size());
+    #endif
+
+    return true;
+}
+
 unsigned int RTP::GetLostPacketsFromRTP()
 {
     return mLostPackets;
@@ -2043,6 +2380,36 @@ bool RTP::RtpParse(char *&pData, int &pDataSize, bool &pIsLastFragment, bool &pI
                                         // STAP-A    Single-time aggregation packet
                                         case 24:
                                                 pData += 1;
+                                                // replace the 2 byte size fields by start codes, the additional byte per NAL unit is taken from the consumed headers
+                                                if (!pReadOnly)
+                                                {
+                                                    char *tDataEnd = tDataOriginal + pDataSize;
+                                                    int tNalUnitCount = 0;
+                                                    char *tNalUnit = pData;
+                                                    while (tNalUnit + 2 <= tDataEnd)
+                                                    {
+                                                        tNalUnit += 2 + ((((unsigned char)tNalUnit[0]) << 8) | (unsigned char)tNalUnit[1]);
+                                                        tNalUnitCount++;
+                                                    }
+                                                    if ((tNalUnit != tDataEnd) || (pData - tNalUnitCount < tDataOriginal + 1))
+                                                    {
+                                                        LOG(LOG_ERROR, "Invalid STAP-A packet with %d NAL units", tNalUnitCount);
+                                                        break;
+                                                    }
+                                                    char *tSource = pData;
+                                                    char *tTarget = pData - tNalUnitCount;
+                                                    pData = tTarget;
+                                                    for (int i = 0; i < tNalUnitCount; i++)
+                                                    {
+                                                        int tNalUnitSize = (((unsigned char)tSource[0]) << 8) | (unsigned char)tSource[1];
+                                                        tTarget[0] = 0;
+                                                        tTarget[1] = 0;
+                                                        tTarget[2] = 1;
+                                                        memmove(tTarget + 3, tSource + 2, tNalUnitSize);
+                                                        tTarget += 3 + tNalUnitSize;
+                                                        tSource += 2 + tNalUnitSize;
+                                                    }
+                                                }
                                                 break;
                                         // STAP-B    Single-time aggregation packet
                                         case 25:
@@ -2094,7 +2461,8 @@ bool RTP::RtpParse(char *&pData, int &pDataSize, bool &pIsLastFragment, bool &pI
                             // in case it is no FU or it is one AND it is the start fragment:
                             //      create start sequence of [0, 0, 1]
                             // HINT: inspired by "h264_handle_packet" from rtp_h264.c from ffmpeg package
-                            if (((tH264HeaderType != 28) && (tH264HeaderType != 29)) || (tH264HeaderFragmentStart))
+                            // HINT: STAP-A packets already got their start codes
+                            if (((tH264HeaderType != 24) && (tH264HeaderType != 28) && (tH264HeaderType != 29)) || (tH264HeaderFragmentStart))
                             {
                             	#ifdef RTP_DEBUG_PACKET_DECODER
 								#endif
@@ -2312,13 +2680,13 @@ unsigned int RTP::CodecToPayloadId(std::string pName)
         tResult = 34;
     if (pName == "h263+")
         tResult = 119;
-    if (pName == "h264")
+    if ((pName == "h264") || (pName == "libx264") /* delivered from AVCodec->name */)
         tResult = 120;
     if (pName == "mpeg4")
         tResult = 121;
     if ((pName == "theora") || (pName == "libtheora") /* delivered from AVCodec->name */)
         tResult = 122;
-    if (pName == "vp8")
+    if ((pName == "vp8") || (pName == "libvpx") /* delivered from AVCodec->name */)
         tResult = 123;
 
     //audio
@@ -2563,6 +2931,46 @@ bool RTP::RtcpParseSenderReport(char *&pData, int &pDataSize, int64_t &pEndToEnd
     return tResult;
 }
 
+// HINT: creates the same sender report as the RTP muxer of ffmpeg within the RTP packet stream
+void RTP::RtcpCreateSenderReport(unsigned int pTimestamp)
+{
+    int64_t tLocalTime = av_gettime();
+    uint64_t tNtpTime = tLocalTime + NTP_OFFSET_US;
+
+    // set the size of the RTCP packet within the resulting packet buffer
+    unsigned int *tRtcpPacketSize = (unsigned int*)mRtpPacketStreamPos;
+    *tRtcpPacketSize = htonl((uint32_t)RTCP_HEADER_SIZE);
+    mRtpPacketStreamPos += 4;
+
+    RtcpHeader* tRtcpHeader = (RtcpHeader*)mRtpPacketStreamPos;
+    tRtcpHeader->Feedback.Version = 2;
+    tRtcpHeader->Feedback.Padding = 0;
+    tRtcpHeader->Feedback.Fmt = 0; // no reception report blocks
+    tRtcpHeader->Feedback.Type = RTCP_SENDER_REPORT;
+    tRtcpHeader->Feedback.Length = RTCP_HEADER_SIZE / 4 - 1;
+    tRtcpHeader->Feedback.Ssrc = mLocalSourceIdentifier;
+    tRtcpHeader->Feedback.TimestampHigh = tNtpTime / 1000000;
+    tRtcpHeader->Feedback.TimestampLow = ((tNtpTime % 1000000) << 32) / 1000000;
+    tRtcpHeader->Feedback.RtpTimestamp = pTimestamp;
+    tRtcpHeader->Feedback.Packets = mLocalPacketCount;
+    tRtcpHeader->Feedback.Octets = mLocalOctetCount;
+
+    #ifdef RTCP_DEBUG_PACKETS_ENCODER
+        for (unsigned int i = 0; i < RTCP_HEADER_SIZE / 4; i++)
+            tRtcpHeader->Data[i] = htonl(tRtcpHeader->Data[i]);
+        LogRtcpHeader(tRtcpHeader);
+        for (unsigned int i = 0; i < RTCP_HEADER_SIZE / 4; i++)
+            tRtcpHeader->Data[i] = ntohl(tRtcpHeader->Data[i]);
+    #endif
+
+    // convert from host to network byte order
+    for (unsigned int i = 0; i < RTCP_HEADER_SIZE / 4; i++)
+        tRtcpHeader->Data[i] = htonl(tRtcpHeader->Data[i]);
+
+    mRtpPacketStreamPos += RTCP_HEADER_SIZE;
+    mLocalLastSenderReport = tLocalTime;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} //namespace
@@ -0,0 +1,186 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of the cache for the parameters of known input streams
+ * Author:  Thomas Volkert
+ * Since:   2012-12-17
+ */
+
+#include <StreamParameterCache.h>
+#include <Logger.h>
+
+namespace Homer { namespace Multimedia {
+
+using namespace std;
+using namespace Homer::Base;
+
+static StreamParameterCache sStreamParameterCache;
+
+///////////////////////////////////////////////////////////////////////////////
+
+StreamParameterCache::StreamParameterCache()
+{
+    mHits = 0;
+    mMisses = 0;
+}
+
+StreamParameterCache::~StreamParameterCache()
+{
+}
+
+StreamParameterCache& StreamParameterCache::GetInstance()
+{
+    return sStreamParameterCache;
+}
+
+string StreamParameterCache::CreateKey(enum MediaType pMediaType, enum CodecID pCodecId, string pPeerName)
+{
+    return toString(pMediaType) + ":" + toString(pCodecId) + ":" + pPeerName;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool StreamParameterCache::Apply(string pKey, AVFormatContext *pFormatContext)
+{
+    bool tResult = false;
+
+    if (pFormatContext == NULL)
+        return false;
+
+    mMutex.lock();
+
+    StreamParametersMap::iterator tIt = mEntries.find(pKey);
+    if (tIt != mEntries.end())
+    {
+        StreamParameters &tEntry = tIt->second;
+
+        // the demuxer has to provide the stream already after reading the header, otherwise the input has to be probed
+        for (int i = 0; i < (int)pFormatContext->nb_streams; i++)
+        {
+            AVStream *tStream = pFormatContext->streams[i];
+            AVCodecContext *tCodecContext = tStream->codec;
+            if ((tCodecContext->codec_type != tEntry.Type) || (tCodecContext->codec_id != tEntry.CodecId))
+                continue;
+
+            switch(tEntry.Type)
+            {
+                case AVMEDIA_TYPE_VIDEO:
+                    tCodecContext->width = tEntry.Width;
+                    tCodecContext->height = tEntry.Height;
+                    tCodecContext->pix_fmt = tEntry.PixFmt;
+                    tStream->r_frame_rate = tEntry.RealFrameRate;
+                    break;
+                case AVMEDIA_TYPE_AUDIO:
+                    tCodecContext->sample_rate = tEntry.SampleRate;
+                    tCodecContext->channels = tEntry.Channels;
+                    tCodecContext->sample_fmt = tEntry.SampleFmt;
+                    break;
+                default:
+                    break;
+            }
+            tStream->time_base = tEntry.StreamTimeBase;
+            tCodecContext->time_base = tEntry.CodecTimeBase;
+
+            tResult = true;
+            break;
+        }
+    }
+
+    if (tResult)
+        mHits++;
+    else
+        mMisses++;
+
+    mMutex.unlock();
+
+    #ifdef SPC_DEBUG
+        LOG(LOG_VERBOSE, "Stream parameter cache %s for %s", tResult ? "hit" : "miss", pKey.c_str());
+    #endif
+
+    return tResult;
+}
+
+void StreamParameterCache::Store(string pKey, AVStream *pStream)
+{
+    StreamParameters tEntry;
+
+    if (pStream == NULL)
+        return;
+
+    AVCodecContext *tCodecContext = pStream->codec;
+    tEntry.Type = tCodecContext->codec_type;
+    tEntry.CodecId = tCodecContext->codec_id;
+    tEntry.Width = tCodecContext->width;
+    tEntry.Height = tCodecContext->height;
+    tEntry.PixFmt = tCodecContext->pix_fmt;
+    tEntry.RealFrameRate = pStream->r_frame_rate;
+    tEntry.SampleRate = tCodecContext->sample_rate;
+    tEntry.Channels = tCodecContext->channels;
+    tEntry.SampleFmt = tCodecContext->sample_fmt;
+    tEntry.StreamTimeBase = pStream->time_base;
+    tEntry.CodecTimeBase = tCodecContext->time_base;
+
+    // incomplete probing results would break the next decoder setup
+    if ((tEntry.StreamTimeBase.num == 0) || (tEntry.StreamTimeBase.den == 0) ||
+        ((tEntry.Type == AVMEDIA_TYPE_VIDEO) && ((tEntry.Width == 0) || (tEntry.Height == 0) || (tEntry.PixFmt == PIX_FMT_NONE) || (tEntry.RealFrameRate.num == 0) || (tEntry.RealFrameRate.den == 0))) ||
+        ((tEntry.Type == AVMEDIA_TYPE_AUDIO) && ((tEntry.SampleRate == 0) || (tEntry.Channels == 0) || (tEntry.SampleFmt == AV_SAMPLE_FMT_NONE))))
+    {
+        LOG(LOG_VERBOSE, "Incomplete stream parameters for %s, won't cache them", pKey.c_str());
+        return;
+    }
+
+    LOG(LOG_VERBOSE, "Caching stream parameters for %s", pKey.c_str());
+
+    mMutex.lock();
+    mEntries[pKey] = tEntry;
+    mMutex.unlock();
+}
+
+void StreamParameterCache::Invalidate(string pKey)
+{
+    mMutex.lock();
+
+    StreamParametersMap::iterator tIt = mEntries.find(pKey);
+    if (tIt != mEntries.end())
+    {
+        LOG(LOG_WARN, "Invalidating cached stream parameters for %s", pKey.c_str());
+        mEntries.erase(tIt);
+    }
+
+    mMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int64_t StreamParameterCache::GetHits()
+{
+    return mHits;
+}
+
+int64_t StreamParameterCache::GetMisses()
+{
+    return mMisses;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -27,29 +27,40 @@
 
 #include <VideoScaler.h>
 #include <MediaSourceMuxer.h>
-#include <ProcessStatisticService.h>
 #include <HBSocket.h>
 #include <RTP.h>
 #include <Logger.h>
 
 #include <string>
+#include <math.h>
 #include <stdint.h>
 
 using namespace std;
-using namespace Homer::Monitor;
 
 namespace Homer { namespace Multimedia {
 
 ///////////////////////////////////////////////////////////////////////////////
 
 VideoScaler::VideoScaler(string pName):
-    MediaFifo("VideoScaler")
+    Task(TASK_PRIORITY_VIDEO, "Video-Scaler/" + pName), MediaFifo("VideoScaler"), mDropPolicy("Video scaler " + pName)
 {
 	mName = pName;
     mScalerNeeded = false;
     mInputFifo = NULL;
     mOutputFifo = NULL;
     mScalerContext = NULL;
+    mInputFrame = NULL;
+    mOutputFrame = NULL;
+    mOutputBuffer = NULL;
+    mRequestedOutputResX = 0;
+    mRequestedOutputResY = 0;
+    mRequestedMirrorHorizontal = false;
+    mRequestedMirrorVertical = false;
+    mOutputFormat.ResX = 0;
+    mOutputFormat.ResY = 0;
+    mOutputFormat.MirroredHorizontal = false;
+    mOutputFormat.MirroredVertical = false;
+    mLastFrameFormat = mOutputFormat;
 }
 
 VideoScaler::~VideoScaler()
@@ -71,44 +82,82 @@ void VideoScaler::StartScaler(int pInputQueueSize, int pSourceResX, int pSourceR
     LOG(LOG_WARN, "Starting %s video scaler, converting resolution %d*%d (fmt: %d) to %d*%d (fmt: %d), queue size: %d", mName.c_str(), pSourceResX, pSourceResY, mSourcePixelFormat, pTargetResX, pTargetResY, mTargetPixelFormat, mQueueSize);
 
     int tInputBufferSize = avpicture_get_size(mSourcePixelFormat, mSourceResX, mSourceResY) + FF_INPUT_BUFFER_PADDING_SIZE;
-    //HINT: we have to allocate input FIFO here to make sure we can force a return from a read request inside StopScaler(), StartScaler() and StopScaler() should be called from the same thread/context!
+    //HINT: StartScaler() and StopScaler() should be called from the same thread/context!
     mInputFifo = new MediaFifo(mQueueSize, tInputBufferSize, "VIDEO-ScalerInput/" + mName);
 
-    // start scaler main loop
-    StartThread();
+    // the format of each output frame is stored behind its picture data
+    int tOutputBufferSize = avpicture_get_size(mTargetPixelFormat, mTargetResX, mTargetResY) + sizeof(struct VideoFrameFormat) + FF_INPUT_BUFFER_PADDING_SIZE;
 
-    while(!mScalerNeeded)
+    // allocate chunk buffer
+    mOutputBuffer = (uint8_t*)malloc(tOutputBufferSize);
+
+    // Allocate video frame
+    LOG(LOG_VERBOSE, "..allocating memory for output frame");
+    if ((mOutputFrame = avcodec_alloc_frame()) == NULL)
+    {
+        // acknowledge failed"
+        LOG(LOG_ERROR, "Out of video memory in avcodec_alloc_frame()");
+    }
+
+    // Allocate video frame for format
+    LOG(LOG_VERBOSE, "..allocating memory for %s input frame", mName.c_str());
+    if ((mInputFrame = avcodec_alloc_frame()) == NULL)
     {
-        LOG(LOG_VERBOSE, "Waiting for the start of %s VIDEO scaling thread", mName.c_str());
-        Thread::Suspend(100 * 1000);
+        // acknowledge failed"
+        LOG(LOG_ERROR, "Out of video memory in avcodec_alloc_frame()");
     }
 
+    // allocate software scaler context, input/output FIFO
+    LOG(LOG_VERBOSE, "..allocating %s video scaler context", mName.c_str());
+    UpdateOutputFormat();
+    mLastFrameFormat = mOutputFormat;
+
+    LOG(LOG_VERBOSE, "..creating %s video scaler output FIFO", mName.c_str());
+    mOutputFifo = new MediaFifo(mQueueSize, tOutputBufferSize, "VIDEO-ScalerOutput/" + mName);
+
+    mChunkNumber = 0;
+    mDropPolicy.Reset();
+    mScalerNeeded = true;
+
+    // the scheduler executes the scaler each time a new frame is written to the input FIFO
+    TASK_SCHEDULER.Attach(this);
+    mInputFifo->SetConsumerTask(this);
 }
 
 void VideoScaler::StopScaler()
 {
-    int tSignalingRound = 0;
     char tTmp[4];
 
     LOG(LOG_VERBOSE, "Stopping scaler");
 
     if (mInputFifo != NULL)
     {
-        // tell scaler thread it isn't needed anymore
+        // tell the scheduler the scaler isn't needed anymore, this waits until no worker scales a frame
         mScalerNeeded = false;
+        mInputFifo->SetConsumerTask(NULL);
+        TASK_SCHEDULER.Detach(this);
 
-        // wait for termination of scaler thread
-        do
-        {
-            if(tSignalingRound > 0)
-                LOG(LOG_WARN, "Signaling round %d to stop scaler, system has high load", tSignalingRound);
-            tSignalingRound++;
+        // forward an empty packet to awake the reader of the output FIFO
+        mOutputFifo->WriteFifo(tTmp, 0);
 
-            // write fake data to awake scaler thread as long as it still runs
-            mInputFifo->WriteFifo(tTmp, 0);
+        delete mOutputFifo;
+        mOutputFifo = NULL;
 
-            Suspend(100 * 1000);
-        }while(IsRunning());
+        // free the software scaler context
+        sws_freeContext(mScalerContext);
+        mScalerContext = NULL;
+
+        // Free the frame
+        av_free(mInputFrame);
+        mInputFrame = NULL;
+
+        // Free the frame
+        av_free(mOutputFrame);
+        mOutputFrame = NULL;
+
+        // free the output buffer
+        free(mOutputBuffer);
+        mOutputBuffer = NULL;
     }
 
     delete mInputFifo;
@@ -130,10 +179,37 @@ void VideoScaler::WriteFifo(char* pBuffer, int pBufferSize)
 
 void VideoScaler::ReadFifo(char *pBuffer, int &pBufferSize)
 {
-    if (mOutputFifo != NULL)
-        mOutputFifo->ReadFifo(pBuffer, pBufferSize);
-    else
+    char *tEntry;
+    int tEntrySize;
+
+    if (mOutputFifo == NULL)
+    {
+        pBufferSize = 0;
+        return;
+    }
+
+    int tFifoEntry = mOutputFifo->ReadFifoExclusive(&tEntry, tEntrySize);
+
+    // copy only the picture data and keep the frame format which is stored behind it
+    if (tEntrySize >= (int)sizeof(struct VideoFrameFormat))
+    {
+        tEntrySize -= sizeof(struct VideoFrameFormat);
+        if (pBufferSize >= tEntrySize)
+        {
+            memcpy(pBuffer, tEntry, tEntrySize);
+            memcpy(&mLastFrameFormat, tEntry + tEntrySize, sizeof(struct VideoFrameFormat));
+            pBufferSize = tEntrySize;
+        }else
+        {
+            LOG(LOG_ERROR, "Given read buffer is too small (%d bytes) for the current frame of %d bytes from video scaler %s, dropping data", pBufferSize, tEntrySize, mName.c_str());
+            pBufferSize = 0;
+        }
+    }else
+    {// empty packet to wake up the reader
         pBufferSize = 0;
+    }
+
+    mOutputFifo->ReadFifoExclusiveFinished(tFifoEntry);
 }
 
 void VideoScaler::ClearFifo()
@@ -147,8 +223,18 @@ void VideoScaler::ClearFifo()
 int VideoScaler::ReadFifoExclusive(char **pBuffer, int &pBufferSize)
 {
     if ((mInputFifo != NULL) && (mOutputFifo != NULL))
-        return mOutputFifo->ReadFifoExclusive(pBuffer, pBufferSize);
-    else
+    {
+        int tResult = mOutputFifo->ReadFifoExclusive(pBuffer, pBufferSize);
+
+        // hide the frame format which is stored behind the picture data
+        if (pBufferSize >= (int)sizeof(struct VideoFrameFormat))
+        {
+            pBufferSize -= sizeof(struct VideoFrameFormat);
+            memcpy(&mLastFrameFormat, *pBuffer + pBufferSize, sizeof(struct VideoFrameFormat));
+        }
+
+        return tResult;
+    }else
     {
     	LOG(LOG_WARN, "Video scaler not ready yet");
         pBufferSize = 0;
@@ -182,6 +268,11 @@ int VideoScaler::GetUsage()
     return tResult;
 }
 
+int64_t VideoScaler::GetDroppedFrames()
+{
+    return mDropPolicy.GetDroppedFrames();
+}
+
 int VideoScaler::GetSize()
 {
     if (mInputFifo != NULL)
@@ -206,235 +297,281 @@ void VideoScaler::ChangeInputResolution(int pResX, int pResY)
     LOG(LOG_VERBOSE, "Input resolution changed");
 }
 
-void* VideoScaler::Run(void* pArgs)
+void VideoScaler::SetOutputFormat(int pResX, int pResY, bool pMirrorHorizontal, bool pMirrorVertical)
 {
-    char                *tBuffer;
-    int                 tBufferSize;
-    int                 tFifoEntry = 0;
-    AVFrame             *tInputFrame;
-    AVFrame             *tOutputFrame;
-    uint8_t             *tOutputBuffer;
-    /* current chunk */
-    int                 tCurrentChunkSize = 0;
+    mScalingThreadMutex.lock();
 
-    LOG(LOG_VERBOSE, "%s video scaling thread started", mName.c_str());
+    mRequestedOutputResX = pResX;
+    mRequestedOutputResY = pResY;
+    mRequestedMirrorHorizontal = pMirrorHorizontal;
+    mRequestedMirrorVertical = pMirrorVertical;
 
-    SVC_PROCESS_STATISTIC.AssignThreadName("Video-Scaler(" + toString(mSourceResX) + "*" + toString(mSourceResY) + ")");
-    int tOutputBufferSize = avpicture_get_size(mTargetPixelFormat, mTargetResX, mTargetResY) + FF_INPUT_BUFFER_PADDING_SIZE;
+    // a stopped scaler applies the requested format during the next StartScaler()
+    if (mOutputFrame != NULL)
+        UpdateOutputFormat();
 
-    // allocate chunk buffer
-    tOutputBuffer = (uint8_t*)malloc(tOutputBufferSize);
+    mScalingThreadMutex.unlock();
+}
 
-    // Allocate video frame
-    LOG(LOG_VERBOSE, "..allocating memory for output frame");
-    if ((tOutputFrame = avcodec_alloc_frame()) == NULL)
-    {
-        // acknowledge failed"
-        LOG(LOG_ERROR, "Out of video memory in avcodec_alloc_frame()");
-    }
+struct VideoFrameFormat VideoScaler::GetLastFrameFormat()
+{
+    return mLastFrameFormat;
+}
 
-    // Assign appropriate parts of buffer to image planes in frame
-    avpicture_fill((AVPicture *)tOutputFrame, (uint8_t *)tOutputBuffer, mTargetPixelFormat, mTargetResX, mTargetResY);
+void VideoScaler::UpdateOutputFormat()
+{
+    int tResX = mTargetResX;
+    int tResY = mTargetResY;
 
-    // Allocate video frame for format
-    LOG(LOG_VERBOSE, "..allocating memory for %s input frame", mName.c_str());
-    if ((tInputFrame = avcodec_alloc_frame()) == NULL)
+    if ((mRequestedOutputResX > 0) && (mRequestedOutputResY > 0))
     {
-        // acknowledge failed"
-        LOG(LOG_ERROR, "Out of video memory in avcodec_alloc_frame()");
+        tResX = mRequestedOutputResX;
+        tResY = mRequestedOutputResY;
+
+        // the output FIFO entries are allocated for the target resolution, a bigger output is limited to this size and keeps its aspect ratio
+        if ((int64_t)tResX * tResY > (int64_t)mTargetResX * mTargetResY)
+        {
+            float tFactor = sqrt((float)mTargetResX * mTargetResY / ((float)tResX * tResY));
+            tResX = (int)(tResX * tFactor);
+            tResY = (int)(tResY * tFactor);
+            if (tResX < 1)
+                tResX = 1;
+            if (tResY < 1)
+                tResY = 1;
+        }
     }
 
-    // allocate software scaler context, input/output FIFO
-    LOG(LOG_VERBOSE, "..allocating %s video scaler context", mName.c_str());
-    mScalerContext = sws_getCachedContext(mScalerContext, mSourceResX, mSourceResY, mSourcePixelFormat, mTargetResX, mTargetResY, mTargetPixelFormat, SWS_BICUBIC, NULL, NULL, NULL);
-    if (mScalerContext == NULL)
+    if ((tResX != mOutputFormat.ResX) || (tResY != mOutputFormat.ResY) || (mScalerContext == NULL))
     {
-    	LOG(LOG_ERROR, "Got invalid video scaler context");
+        LOG(LOG_VERBOSE, "Setting output resolution of %s video scaler to %d*%d", mName.c_str(), tResX, tResY);
+
+        mScalerContext = sws_getCachedContext(mScalerContext, mSourceResX, mSourceResY, mSourcePixelFormat, tResX, tResY, mTargetPixelFormat, SWS_BICUBIC, NULL, NULL, NULL);
+        if (mScalerContext == NULL)
+        {
+            LOG(LOG_ERROR, "Got invalid video scaler context");
+        }
+
+        // Assign appropriate parts of buffer to image planes in frame
+        avpicture_fill((AVPicture *)mOutputFrame, (uint8_t *)mOutputBuffer, mTargetPixelFormat, tResX, tResY);
+
+        mOutputFormat.ResX = tResX;
+        mOutputFormat.ResY = tResY;
     }
 
-    LOG(LOG_VERBOSE, "..creating %s video scaler output FIFO", mName.c_str());
-    mOutputFifo = new MediaFifo(mQueueSize, tOutputBufferSize, "VIDEO-ScalerOutput/" + mName);
+    // mirroring works on whole pixels and is only implemented for packed 32 bit output
+    if (((mRequestedMirrorHorizontal) || (mRequestedMirrorVertical)) && (mTargetPixelFormat != PIX_FMT_RGB32))
+        LOG(LOG_WARN, "Mirroring isn't supported for output format %d of %s video scaler", mTargetPixelFormat, mName.c_str());
+    mOutputFormat.MirroredHorizontal = ((mRequestedMirrorHorizontal) && (mTargetPixelFormat == PIX_FMT_RGB32));
+    mOutputFormat.MirroredVertical = ((mRequestedMirrorVertical) && (mTargetPixelFormat == PIX_FMT_RGB32));
+}
 
-    mChunkNumber = 0;
-    mScalerNeeded = true;
+void VideoScaler::MirrorOutputFrame()
+{
+    uint32_t *tPixels = (uint32_t*)mOutputFrame->data[0];
+    int tLineSize = mOutputFrame->linesize[0] / 4;
+    int tResX = mOutputFormat.ResX;
+    int tResY = mOutputFormat.ResY;
+    uint32_t tPixel;
 
-    LOG(LOG_VERBOSE, "..entering %s video scaler main loop", mName.c_str());
-    while(mScalerNeeded)
+    if (mOutputFormat.MirroredVertical)
     {
-        mScalingThreadMutex.lock();
-        if (mInputFifo != NULL)
+        for (int y = 0; y < tResY / 2; y++)
         {
-			#ifdef VS_DEBUG_PACKETS
-        		LOG(LOG_VERBOSE, "Waiting for new input for scaling");
-			#endif
-            tFifoEntry = mInputFifo->ReadFifoExclusive(&tBuffer, tBufferSize);
-			#ifdef VS_DEBUG_PACKETS
-	            LOG(LOG_VERBOSE, "Got new input of %d bytes for scaling", tBufferSize);
-			#endif
-            if ((tBufferSize > 0) && (mScalerNeeded))
+            uint32_t *tTopLine = tPixels + y * tLineSize;
+            uint32_t *tBottomLine = tPixels + (tResY - 1 - y) * tLineSize;
+            for (int x = 0; x < tResX; x++)
             {
-            	mChunkNumber++;
-                //HINT: we only get input if mStreamActivated is set and we have some registered media sinks
+                tPixel = tTopLine[x];
+                tTopLine[x] = tBottomLine[x];
+                tBottomLine[x] = tPixel;
+            }
+        }
+    }
 
-                tCurrentChunkSize = 0;
-                //HINT: media type is always MEDIA_VIDEO here
+    if (mOutputFormat.MirroredHorizontal)
+    {
+        for (int y = 0; y < tResY; y++)
+        {
+            uint32_t *tLine = tPixels + y * tLineSize;
+            for (int x = 0; x < tResX / 2; x++)
+            {
+                tPixel = tLine[x];
+                tLine[x] = tLine[tResX - 1 - x];
+                tLine[tResX - 1 - x] = tPixel;
+            }
+        }
+    }
+}
 
-                // ####################################################################
-                // ### PREPARE INPUT FRAME
-                // ###################################################################
-                // Assign appropriate parts of buffer to image planes in tInputFrame
-                avpicture_fill((AVPicture *)tInputFrame, (uint8_t *)tBuffer, mSourcePixelFormat, mSourceResX, mSourceResY);
+bool VideoScaler::Execute()
+{
+    char                *tBuffer;
+    int                 tBufferSize;
+    int                 tFifoEntry = 0;
+    /* current chunk */
+    int                 tCurrentChunkSize = 0;
+    bool                tResult;
 
-                // set frame number in corresponding entries within AVFrame structure
-                tInputFrame->pts = mChunkNumber;
-                tInputFrame->coded_picture_number = mChunkNumber;
-                tInputFrame->display_picture_number = mChunkNumber;
+    mScalingThreadMutex.lock();
 
-                #ifdef VS_DEBUG_PACKETS
-                    LOG(LOG_VERBOSE, "SCALER-new input video frame..");
-                    LOG(LOG_VERBOSE, "      ..key frame: %d", tInputFrame->key_frame);
-                    switch(tInputFrame->pict_type)
-                    {
-                            case AV_PICTURE_TYPE_I:
-                                LOG(LOG_VERBOSE, "      ..picture type: i-frame");
-                                break;
-                            case AV_PICTURE_TYPE_P:
-                                LOG(LOG_VERBOSE, "      ..picture type: p-frame");
-                                break;
-                            case AV_PICTURE_TYPE_B:
-                                LOG(LOG_VERBOSE, "      ..picture type: b-frame");
-                                break;
-                            default:
-                                LOG(LOG_VERBOSE, "      ..picture type: %d", tInputFrame->pict_type);
-                                break;
-                    }
-                    LOG(LOG_VERBOSE, "      ..pts: %ld", tInputFrame->pts);
-                    LOG(LOG_VERBOSE, "      ..coded pic number: %d", tInputFrame->coded_picture_number);
-                    LOG(LOG_VERBOSE, "      ..display pic number: %d", tInputFrame->display_picture_number);
-                #endif
+    if ((mInputFifo == NULL) || (!mScalerNeeded))
+    {
+        mScalingThreadMutex.unlock();
+        return false;
+    }
 
-                // ####################################################################
-                // ### SCALE FRAME (CONVERT)
-                // ###################################################################
-                int64_t tTime = Time::GetTimeStamp();
-                // convert
+    tFifoEntry = mInputFifo->TryReadFifoExclusive(&tBuffer, tBufferSize);
+    if (tFifoEntry < 0)
+    {
+        mScalingThreadMutex.unlock();
+        return false;
+    }
+    #ifdef VS_DEBUG_PACKETS
+        LOG(LOG_VERBOSE, "Got new input of %d bytes for scaling", tBufferSize);
+    #endif
+    // overload: thin out the frames evenly instead of scaling them all and running full
+    mDropPolicy.Update(mInputFifo->GetUsage(), mInputFifo->GetSize());
+    if ((tBufferSize > 0) && (mScalerNeeded) && (mDropPolicy.DropDecodedFrame()))
+    {
+        #ifdef VS_DEBUG_PACKETS
+            LOG(LOG_VERBOSE, "Skipping input frame of %s because of overload", mName.c_str());
+        #endif
+    }else if ((tBufferSize > 0) && (mScalerNeeded))
+    {
+    	mChunkNumber++;
+        //HINT: we only get input if mStreamActivated is set and we have some registered media sinks
+
+        tCurrentChunkSize = 0;
+        //HINT: media type is always MEDIA_VIDEO here
+
+        // ####################################################################
+        // ### PREPARE INPUT FRAME
+        // ###################################################################
+        // Assign appropriate parts of buffer to image planes in mInputFrame
+        avpicture_fill((AVPicture *)mInputFrame, (uint8_t *)tBuffer, mSourcePixelFormat, mSourceResX, mSourceResY);
+
+        // set frame number in corresponding entries within AVFrame structure
+        mInputFrame->pts = mChunkNumber;
+        mInputFrame->coded_picture_number = mChunkNumber;
+        mInputFrame->display_picture_number = mChunkNumber;
+
+        #ifdef VS_DEBUG_PACKETS
+            LOG(LOG_VERBOSE, "SCALER-new input video frame..");
+            LOG(LOG_VERBOSE, "      ..key frame: %d", mInputFrame->key_frame);
+            switch(mInputFrame->pict_type)
+            {
+                    case AV_PICTURE_TYPE_I:
+                        LOG(LOG_VERBOSE, "      ..picture type: i-frame");
+                        break;
+                    case AV_PICTURE_TYPE_P:
+                        LOG(LOG_VERBOSE, "      ..picture type: p-frame");
+                        break;
+                    case AV_PICTURE_TYPE_B:
+                        LOG(LOG_VERBOSE, "      ..picture type: b-frame");
+                        break;
+                    default:
+                        LOG(LOG_VERBOSE, "      ..picture type: %d", mInputFrame->pict_type);
+                        break;
+            }
+            LOG(LOG_VERBOSE, "      ..pts: %ld", mInputFrame->pts);
+            LOG(LOG_VERBOSE, "      ..coded pic number: %d", mInputFrame->coded_picture_number);
+            LOG(LOG_VERBOSE, "      ..display pic number: %d", mInputFrame->display_picture_number);
+        #endif
+
+        // ####################################################################
+        // ### SCALE FRAME (CONVERT)
+        // ###################################################################
+        int64_t tTime = Time::GetTimeStamp();
+        // convert
 
 				#ifdef VS_DEBUG_PACKETS
 					LOG(LOG_VERBOSE, "%s-scaling frame %d, source res: %d*%d (fmt: %d) to %d*%d, scaler context at %p", mName.c_str(), mChunkNumber, mSourceResX, mSourceResY, (int)mSourcePixelFormat, mTargetResX, mTargetResY, mScalerContext);
-					LOG(LOG_VERBOSE, "Video input frame data: %p, %p, %p, %p", tInputFrame->data[0], tInputFrame->data[1], tInputFrame->data[2], tInputFrame->data[3]);
-					LOG(LOG_VERBOSE, "Video input frame line size: %d, %d, %d, %d", tInputFrame->linesize[0], tInputFrame->linesize[1], tInputFrame->linesize[2], tInputFrame->linesize[3]);
-					LOG(LOG_VERBOSE, "Video output frame data: %p, %p, %p, %p", tOutputFrame->data[0], tOutputFrame->data[1], tOutputFrame->data[2], tOutputFrame->data[3]);
-					LOG(LOG_VERBOSE, "Video output frame line size: %d, %d, %d, %d", tOutputFrame->linesize[0], tOutputFrame->linesize[1], tOutputFrame->linesize[2], tOutputFrame->linesize[3]);
+					LOG(LOG_VERBOSE, "Video input frame data: %p, %p, %p, %p", mInputFrame->data[0], mInputFrame->data[1], mInputFrame->data[2], mInputFrame->data[3]);
+					LOG(LOG_VERBOSE, "Video input frame line size: %d, %d, %d, %d", mInputFrame->linesize[0], mInputFrame->linesize[1], mInputFrame->linesize[2], mInputFrame->linesize[3]);
+					LOG(LOG_VERBOSE, "Video output frame data: %p, %p, %p, %p", mOutputFrame->data[0], mOutputFrame->data[1], mOutputFrame->data[2], mOutputFrame->data[3]);
+					LOG(LOG_VERBOSE, "Video output frame line size: %d, %d, %d, %d", mOutputFrame->linesize[0], mOutputFrame->linesize[1], mOutputFrame->linesize[2], mOutputFrame->linesize[3]);
 				#endif
-                HM_sws_scale(mScalerContext, tInputFrame->data, tInputFrame->linesize, 0, mSourceResY, tOutputFrame->data, tOutputFrame->linesize);
+        HM_sws_scale(mScalerContext, mInputFrame->data, mInputFrame->linesize, 0, mSourceResY, mOutputFrame->data, mOutputFrame->linesize);
+        if ((mOutputFormat.MirroredHorizontal) || (mOutputFormat.MirroredVertical))
+            MirrorOutputFrame();
 				#ifdef VS_DEBUG_PACKETS
-                	LOG(LOG_VERBOSE, "..video scaling for %s finished", mName.c_str());
-                    int64_t tTime2 = Time::GetTimeStamp();
-                    LOG(LOG_VERBOSE, "SCALER-scaling video frame took %ld us", tTime2 - tTime);
-                #endif
-
-                // size of scaled output frame
-                tCurrentChunkSize = avpicture_get_size(mTargetPixelFormat, mTargetResX, mTargetResY);
-
-                #ifdef VS_DEBUG_PACKETS
-                    LOG(LOG_VERBOSE, "SCALER-new output video frame..");
-                    LOG(LOG_VERBOSE, "      ..key frame: %d", tOutputFrame->key_frame);
-                    switch(tOutputFrame->pict_type)
-                    {
-                            case AV_PICTURE_TYPE_I:
-                                LOG(LOG_VERBOSE, "      ..picture type: i-frame");
-                                break;
-                            case AV_PICTURE_TYPE_P:
-                                LOG(LOG_VERBOSE, "      ..picture type: p-frame");
-                                break;
-                            case AV_PICTURE_TYPE_B:
-                                LOG(LOG_VERBOSE, "      ..picture type: b-frame");
-                                break;
-                            default:
-                                LOG(LOG_VERBOSE, "      ..picture type: %d", tOutputFrame->pict_type);
-                                break;
-                    }
-                    LOG(LOG_VERBOSE, "      ..pts: %ld", tOutputFrame->pts);
-                    LOG(LOG_VERBOSE, "      ..coded pic number: %d", tOutputFrame->coded_picture_number);
-                    LOG(LOG_VERBOSE, "      ..display pic number: %d", tOutputFrame->display_picture_number);
-                #endif
-
-                // was there an error during decoding process?
-                if (tCurrentChunkSize > 0)
-                {// no error
-                    // add new chunk to FIFO
-                    #ifdef VS_DEBUG_PACKETS
-                        LOG(LOG_VERBOSE, "SCALER-writing %d bytes to output FIFO", tCurrentChunkSize);
-                    #endif
-                    if (tCurrentChunkSize <= mOutputFifo->GetEntrySize())
-                    {
-                        mOutputFifo->WriteFifo((char*)tOutputBuffer, tCurrentChunkSize);
-                        // add meta description about current chunk to different FIFO
-                        struct ChunkDescriptor tChunkDesc;
+        	LOG(LOG_VERBOSE, "..video scaling for %s finished", mName.c_str());
+            int64_t tTime2 = Time::GetTimeStamp();
+            LOG(LOG_VERBOSE, "SCALER-scaling video frame took %ld us", tTime2 - tTime);
+        #endif
+
+        // size of scaled output frame
+        tCurrentChunkSize = avpicture_get_size(mTargetPixelFormat, mOutputFormat.ResX, mOutputFormat.ResY);
+
+        #ifdef VS_DEBUG_PACKETS
+            LOG(LOG_VERBOSE, "SCALER-new output video frame..");
+            LOG(LOG_VERBOSE, "      ..key frame: %d", mOutputFrame->key_frame);
+            switch(mOutputFrame->pict_type)
+            {
+                    case AV_PICTURE_TYPE_I:
+                        LOG(LOG_VERBOSE, "      ..picture type: i-frame");
+                        break;
+                    case AV_PICTURE_TYPE_P:
+                        LOG(LOG_VERBOSE, "      ..picture type: p-frame");
+                        break;
+                    case AV_PICTURE_TYPE_B:
+                        LOG(LOG_VERBOSE, "      ..picture type: b-frame");
+                        break;
+                    default:
+                        LOG(LOG_VERBOSE, "      ..picture type: %d", mOutputFrame->pict_type);
+                        break;
+            }
+            LOG(LOG_VERBOSE, "      ..pts: %ld", mOutputFrame->pts);
+            LOG(LOG_VERBOSE, "      ..coded pic number: %d", mOutputFrame->coded_picture_number);
+            LOG(LOG_VERBOSE, "      ..display pic number: %d", mOutputFrame->display_picture_number);
+        #endif
+
+        // was there an error during decoding process?
+        if (tCurrentChunkSize > 0)
+        {// no error
+            // add new chunk to FIFO
+            #ifdef VS_DEBUG_PACKETS
+                LOG(LOG_VERBOSE, "SCALER-writing %d bytes to output FIFO", tCurrentChunkSize);
+            #endif
+            if (tCurrentChunkSize + (int)sizeof(struct VideoFrameFormat) <= mOutputFifo->GetEntrySize())
+            {
+                // store the frame format behind the picture data
+                memcpy(mOutputBuffer + tCurrentChunkSize, &mOutputFormat, sizeof(struct VideoFrameFormat));
+                mOutputFifo->WriteFifo((char*)mOutputBuffer, tCurrentChunkSize + sizeof(struct VideoFrameFormat));
+                // add meta description about current chunk to different FIFO
+                struct ChunkDescriptor tChunkDesc;
 //TODO                            tChunkDesc.Pts = tCurFramePts;
 //TODO                            mMetaDataOutputFifo->WriteFifo((char*) &tChunkDesc, sizeof(tChunkDesc));
-                        #ifdef VS_DEBUG_PACKETS
-                            LOG(LOG_VERBOSE, "SCALER-successful scaler loop");
-                        #endif
-                    }else
-                    {
-                        LOG(LOG_ERROR, "Cannot write a VIDEO chunk of %d bytes to the encoder FIFO with %d bytes slots", tCurrentChunkSize, mOutputFifo->GetEntrySize());
-                    }
-                }
+                #ifdef VS_DEBUG_PACKETS
+                    LOG(LOG_VERBOSE, "SCALER-successful scaler loop");
+                #endif
             }else
             {
-                // got a message to stop the encoder pipe?
-                if (tBufferSize == 0)
-                {
-                    LOG(LOG_VERBOSE, "Forwarding the empty packet from the scaler input FIFO to the scaler output FIFO");
-
-                    // forward the empty packet to the output FIFO
-                    mOutputFifo->WriteFifo(tBuffer, 0);
-                }
+                LOG(LOG_ERROR, "Cannot write a VIDEO chunk of %d bytes to the encoder FIFO with %d bytes slots", tCurrentChunkSize, mOutputFifo->GetEntrySize());
             }
-
-            // release FIFO entry lock
-            if (tFifoEntry >= 0)
-                mInputFifo->ReadFifoExclusiveFinished(tFifoEntry);
-
-            // is FIFO near overload situation?
-            if (mInputFifo->GetUsage() >= MEDIA_SOURCE_MUX_INPUT_QUEUE_SIZE_LIMIT - 4)
-            {
-                LOG(LOG_WARN, "Encoder (scaler) FIFO is near overload situation, deleting all stored frames");
-
-                // delete all stored frames: it is a better for the encoding to have a gap instead of frames which have high picture differences
-                mInputFifo->ClearFifo();
-            }
-            mScalingThreadMutex.unlock();
-        }else
+        }
+    }else
+    {
+        // got a message to stop the encoder pipe?
+        if (tBufferSize == 0)
         {
-            mScalingThreadMutex.unlock();
-            LOG(LOG_VERBOSE, "Suspending the scaler thread for 10 ms");
-            Suspend(10 * 1000); // check every 1/100 seconds the state of the FIFO
+            LOG(LOG_VERBOSE, "Forwarding the empty packet from the scaler input FIFO to the scaler output FIFO");
+
+            // forward the empty packet to the output FIFO
+            mOutputFifo->WriteFifo(tBuffer, 0);
         }
     }
 
-    LOG(LOG_VERBOSE, "Video scaler left thread main loop");
-
-    delete mOutputFifo;
-    mOutputFifo = NULL;
-
-    // free the software scaler context
-    sws_freeContext(mScalerContext);
-    mScalerContext = NULL;
-
-    // Free the frame
-    av_free(tInputFrame);
+    // release FIFO entry lock
+    if (tFifoEntry >= 0)
+        mInputFifo->ReadFifoExclusiveFinished(tFifoEntry);
 
-    // Free the frame
-    av_free(tOutputFrame);
+    // scale further frames in the next run, the scheduler can serve other stages in between
+    tResult = (mInputFifo->GetUsage() > 0);
 
-    // free the output buffer
-    free(tOutputBuffer);
+    mScalingThreadMutex.unlock();
 
-    LOG(LOG_WARN, "Video scaler thread finished");
-
-    return NULL;
+    return tResult;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -43,11 +43,13 @@ WaveOut::WaveOut(string pName):
     mWaveOutOpened = false;
     mDesiredDevice = "";
     mCurrentDevice = "";
+    mSampleRate = 44100;
     mAudioChannels = 2;
     mVolume = 100;
     mFilePlaybackSource = NULL;
     mSampleFifo = NULL;
     mPlaybackGaps = 0;
+    mAdaptivePlayout = false;
     mFilePlaybackNeeded = false;
 
     LOG(LOG_VERBOSE, "Going to allocate playback FIFO");
@@ -128,6 +130,7 @@ bool WaveOut::Play()
 	LOG(LOG_VERBOSE, "Mark stream as started");
     mPlaybackStopped = false;
     mHaveToAssignThreadName = true;
+    mPlayoutController.Reset(mSampleRate, mAudioChannels);
 
     return true;
 }
@@ -243,6 +246,59 @@ int64_t WaveOut::GetPlaybackGapsCounter()
     return mPlaybackGaps;
 }
 
+void WaveOut::SetAdaptivePlayout(bool pActive)
+{
+    if (mAdaptivePlayout != pActive)
+    {
+        LOG(LOG_VERBOSE, "Setting adaptive playout to %d", pActive);
+        mPlayMutex.lock();
+        mPlayoutController.Reset(mSampleRate, mAudioChannels);
+        mAdaptivePlayout = pActive;
+        mPlayMutex.unlock();
+    }
+}
+
+bool WaveOut::GetAdaptivePlayout()
+{
+    return mAdaptivePlayout;
+}
+
+int WaveOut::GetPlayoutDelay()
+{
+    if (mAdaptivePlayout)
+        return mPlayoutController.GetCurrentDelay();
+    else
+        return (int)(mPlayoutController.GetChunkDuration(GetPlayoutBufferSize()) / 1000);
+}
+
+int WaveOut::GetPlayoutTargetDelay()
+{
+    return mAdaptivePlayout ? mPlayoutController.GetTargetDelay() : 0;
+}
+
+int WaveOut::GetPlayoutJitter()
+{
+    return mAdaptivePlayout ? mPlayoutController.GetJitter() : 0;
+}
+
+int WaveOut::GetOutputLatency()
+{
+    // has to be reported by the audio backend
+    return -1;
+}
+
+int WaveOut::GetPlayoutBufferSize()
+{
+    int tResult = 0;
+
+    if (mSampleFifo != NULL)
+        tResult += av_fifo_size(mSampleFifo);
+    if (mPlaybackFifo != NULL)
+        tResult += mPlaybackFifo->GetUsage() * MEDIA_SOURCE_SAMPLES_BUFFER_SIZE;
+
+    return tResult;
+}
+
 void WaveOut::AdjustVolume(void *pBuffer, int pBufferSize)
 {
     if (mVolume != 100)
@@ -355,6 +411,16 @@ bool WaveOut::WriteChunk(void* pChunkBuffer, int pChunkSize)
 
     AdjustVolume(pChunkBuffer, pChunkSize);
 
+    if (mAdaptivePlayout)
+    {
+        // shrink or grow the playout buffer towards the delay the current jitter needs
+        char *tChunkBuffer;
+        int tChunkSize;
+        mPlayoutController.ProcessChunk((char*)pChunkBuffer, pChunkSize, GetPlayoutBufferSize(), GetPlaybackGapsCounter(), tChunkBuffer, tChunkSize);
+        pChunkBuffer = tChunkBuffer;
+        pChunkSize = tChunkSize;
+    }
+
     #ifdef WOPA_DEBUG_PACKETS
         LOG(LOG_VERBOSE, "Got %d samples for audio output stream", pChunkSize / 4);
     #endif
@@ -403,6 +469,13 @@ bool WaveOut::WriteChunk(void* pChunkBuffer, int pChunkSize)
         AnnouncePacket(pChunkSize);
     }
 
+    // delay bursts beyond what time-stretching can compensate are dropped
+    if ((mAdaptivePlayout) && (mPlaybackFifo != NULL) && (mPlayoutController.GetChunkDuration(GetPlayoutBufferSize()) > 2 * AUDIO_PLAYOUT_MAX_DELAY * 1000))
+    {
+        LOG(LOG_WARN, "Playout buffer exceeds %d ms, dropping the oldest chunks", 2 * AUDIO_PLAYOUT_MAX_DELAY);
+        LimitQueue(mPlayoutController.GetChunkSize(AUDIO_PLAYOUT_MAX_DELAY * 1000) / MEDIA_SOURCE_SAMPLES_BUFFER_SIZE);
+    }
+
     mPlayMutex.unlock();
     return true;
 }
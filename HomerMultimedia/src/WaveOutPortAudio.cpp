@@ -259,6 +259,19 @@ bool WaveOutPortAudio::OpenWaveOutDevice(int pSampleRate, int pOutputChannels)
     return true;
 }
 
+int WaveOutPortAudio::GetOutputLatency()
+{
+    if ((!mWaveOutOpened) || (mStream == NULL))
+        return -1;
+
+    // the latency of the device's buffers as reported by the host API
+    const PaStreamInfo *tStreamInfo = Pa_GetStreamInfo(mStream);
+    if (tStreamInfo == NULL)
+        return -1;
+
+    return (int)(tStreamInfo->outputLatency * 1000);
+}
+
 bool WaveOutPortAudio::CloseWaveOutDevice()
 {
     bool tResult = false;
@@ -244,6 +244,28 @@ void WaveOutSdl::SetVolume(int pValue)
 	WaveOut::SetVolume(pValue);
 }
 
+int64_t WaveOutSdl::GetPlaybackGapsCounter()
+{
+    // gaps are detected within SDL's audio thread when the channel's chunk queue runs empty
+    return mPlaybackGaps + AUDIOOUTSDL.GetUnderrunCounter(mAudioChannel);
+}
+
+int WaveOutSdl::GetOutputLatency()
+{
+    if (!mWaveOutOpened)
+        return -1;
+
+    // chunks within SDL's queue plus the mixer's device buffer
+    return AUDIOOUTSDL.GetPlaybackLatency(mAudioChannel);
+}
+
+void WaveOutSdl::SetAdaptivePlayout(bool pActive)
+{
+    // SDL's chunk queue doesn't report its fill level, hence the playout delay can't be controlled
+    if (pActive)
+        LOG(LOG_VERBOSE, "Adaptive playout isn't supported for SDL based playback");
+}
+
 bool WaveOutSdl::Play()
 {
     LOG(LOG_VERBOSE, "Starting playback stream..");
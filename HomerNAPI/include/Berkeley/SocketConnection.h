@@ -31,6 +31,7 @@
 #include <HBSocket.h>
 
 #include <Requirements.h>
+#include <Berkeley/SocketPacer.h>
 
 namespace Homer { namespace Base {
 
@@ -48,6 +49,7 @@ public:
     virtual int availableBytes();
     virtual void read(char* pBuffer, int &pBufferSize); //TODO: support non blocking mode
     virtual void write(char* pBuffer, int pBufferSize);
+    virtual int getQueueDelay();
     virtual bool getBlocking();
     virtual void setBlocking(bool pState);
     virtual void cancel();
@@ -61,6 +63,7 @@ private:
     bool		    mBlockingMode;
     Requirements    *mRequirements;
     Socket		    *mSocket;
+    SocketPacer     *mPacer;
     bool            mIsClosed;
     std::string     mPeerHost;
     unsigned int    mPeerPort;
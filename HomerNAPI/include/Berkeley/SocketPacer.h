@@ -0,0 +1,117 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: token bucket based pacer for outgoing packets of a socket connection
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#ifndef _NAPI_SOCKET_PACER_
+#define _NAPI_SOCKET_PACER_
+
+#include <HBSocket.h>
+#include <HBThread.h>
+#include <HBMutex.h>
+#include <HBCondition.h>
+
+#include <list>
+#include <string>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// bytes which may leave the pacer back to back if the application didn't request a burst size
+#define SOCKET_PACER_DEFAULT_BURST_SIZE                 (2 * 1500)
+
+// the bucket holds at least the tokens of this period to compensate the granularity of OS timers
+#define SOCKET_PACER_MIN_BURST_PERIOD                   2 // ms
+
+// upper limit for queued bytes, further packets are dropped
+#define SOCKET_PACER_QUEUE_LIMIT                        (2 * 1024 * 1024)
+
+//#define SOCKET_PACER_DEBUG
+
+///////////////////////////////////////////////////////////////////////////////
+
+class SocketPacer:
+    public Thread
+{
+public:
+    SocketPacer(Socket *pSocket);
+
+    virtual ~SocketPacer();
+
+    /* configuration: data rates in KB/s, burst size in bytes, delay in ms, a rate of 0 disables pacing */
+    void SetLimits(int pMinDataRate, int pMaxDataRate, int pMaxBurstSize, int pMaxDelay);
+
+    /* sending */
+    bool Send(std::string pTargetHost, unsigned int pTargetPort, char *pData, int pSize); // returns false if the socket failed before
+    void Stop();
+
+    /* statistic */
+    int GetQueueDelay(); // in us, expected waiting time of a packet which is queued now
+    int GetQueueSize(); // in bytes
+    int64_t GetDroppedPackets();
+
+private:
+    struct PacedPacket
+    {
+        char            *Data;
+        int             Size;
+        std::string     TargetHost;
+        unsigned int    TargetPort;
+        int64_t         EnqueueTime;
+    };
+
+    typedef std::list<PacedPacket> PacedPackets;
+
+    /* pacer thread */
+    virtual void* Run(void* pArgs = NULL);
+
+    int64_t GetDrainRate(int64_t pNow); // in bytes/s, 0 if packets shouldn't wait
+    void RefillTokens(int64_t pNow);
+
+    Socket              *mSocket;
+    bool                mPacerNeeded;
+    bool                mBrokenSocket;
+    /* limits */
+    int64_t             mDataRate; // in bytes/s
+    int64_t             mMaxDataRate; // in bytes/s, 0 if unlimited
+    int                 mMaxBurstSize;
+    int                 mMaxDelay;
+    /* token bucket */
+    double              mTokens;
+    int64_t             mLastRefill;
+    /* queue */
+    PacedPackets        mQueue;
+    int                 mQueueSize;
+    int64_t             mDroppedPackets;
+    Mutex               mQueueMutex;
+    Condition           mQueueCondition;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
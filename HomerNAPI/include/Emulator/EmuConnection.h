@@ -0,0 +1,122 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: EmuConnection
+ * Author:  Thomas Volkert
+ * Since:   2012-12-07
+ */
+
+#ifndef _NAPI_EMU_CONNECTION_
+#define _NAPI_EMU_CONNECTION_
+
+#include <HBThread.h>
+#include <HBMutex.h>
+#include <HBCondition.h>
+
+#include <Requirements.h>
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// packets which would wait longer than this for the emulated link are dropped
+#define EMU_RATE_QUEUE_LIMIT                    500 // ms
+
+//#define EMU_DEBUG_PACKETS
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct EmuSettings
+{
+    int             Delay; // in ms
+    int             Jitter; // in ms, uniformly distributed around the delay
+    float           Loss; // in percent
+    float           Reordering; // in percent, reordered packets skip the delay
+    int             DataRate; // in KB/s, 0 if unlimited
+    double          BitErrorRate; // per bit
+    unsigned int    Seed;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class EmuConnection:
+    public IConnection, public Thread
+{
+public:
+    EmuConnection(IConnection *pConnection, EmuSettings pSettings, std::string pTarget, unsigned int pTargetPort);
+    virtual ~EmuConnection( );
+
+    virtual bool isClosed();
+    virtual int availableBytes();
+    virtual void read(char* pBuffer, int &pBufferSize);
+    virtual void write(char* pBuffer, int pBufferSize);
+    virtual int getQueueDelay();
+    virtual bool getBlocking();
+    virtual void setBlocking(bool pState);
+    virtual void cancel();
+    virtual Name* getName();
+    virtual Name* getRemoteName();
+    virtual bool changeRequirements(Requirements *pRequirements);
+    virtual Requirements* getRequirements();
+    virtual Events getEvents();
+
+private:
+    struct EmuPacket
+    {
+        char            *Data;
+        int             Size;
+    };
+
+    typedef std::multimap<int64_t, EmuPacket> EmuPackets; // sorted by delivery time
+
+    /* delivery thread */
+    virtual void* Run(void* pArgs = NULL);
+    void StopEmulator();
+
+    /* deterministic random numbers */
+    double GetRandom(); // in [0, 1)
+    void ApplyBitErrors(char *pData, int pSize);
+
+    IConnection         *mConnection;
+    EmuSettings         mSettings;
+    uint64_t            mRandomState;
+    bool                mEmulatorNeeded;
+    int64_t             mLinkFreeTime;
+    EmuPackets          mQueue;
+    Mutex               mQueueMutex;
+    Condition           mQueueCondition;
+    /* statistic */
+    int64_t             mPackets;
+    int64_t             mLostPackets;
+    int64_t             mReorderedPackets;
+    int64_t             mCorruptedPackets;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,68 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: EmuSetup
+ * Author:  Thomas Volkert
+ * Since:   2012-12-07
+ */
+
+#ifndef _NAPI_EMU_SETUP_
+#define _NAPI_EMU_SETUP_
+
+#include <Name.h>
+#include <ISetup.h>
+#include <Emulator/EmuConnection.h>
+
+#include <string>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define NETWORK_EMULATOR            "Network Emulator"
+
+///////////////////////////////////////////////////////////////////////////////
+
+class EmuSetup:
+    public ISetup
+{
+public:
+    EmuSetup();
+    virtual ~EmuSetup();
+
+    virtual IConnection* connect(Name *pName, Requirements *pRequirements = 0);
+    virtual IBinding* bind(Name *pName, Requirements *pRequirements = 0);
+    virtual Requirements getCapabilities(Name *pName, Requirements *pImportantRequirements = 0);
+
+    /* emulated network conditions, applied to connections which are created afterwards */
+    static void setDefaultSettings(EmuSettings pSettings);
+    static EmuSettings getDefaultSettings();
+    static void setSettings(unsigned int pTargetPort, EmuSettings pSettings); // overrides the default settings for one target port
+    static EmuSettings getSettings(unsigned int pTargetPort);
+    static bool parseSettings(std::string pDescription, EmuSettings &pSettings); // e.g., "delay=50,jitter=10,loss=1,reorder=0.5,rate=500,ber=0.000001,seed=7"
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -47,6 +47,7 @@ public:
     virtual int availableBytes() = 0;
     virtual void read(char* pBuffer, int &pBufferize) = 0;
     virtual void write(char* pBuffer, int pBufferSize) = 0;
+    virtual int getQueueDelay() = 0; // in us, time which written data waits within the connection before it is sent
     virtual bool getBlocking() = 0;
     virtual void setBlocking(bool pState) = 0;
     virtual Name* getRemoteName() = 0;
@@ -78,6 +78,7 @@ public:
 
 private:
     ISetup						*mSetupInterface;
+    ISetup                      *mLocalSetupInterface; // for local peers
     std::string                 mSetupInterfaceName;
     SetupInterfacesPool			mSetupInterfacesPool;
     Mutex						mSetupInterfacesPoolMutex;
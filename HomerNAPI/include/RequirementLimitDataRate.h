@@ -38,14 +38,15 @@ class RequirementLimitDataRate:
     public TRequirement<RequirementLimitDataRate, REQUIREMENT_LIMIT_DATARATE>
 {
 public:
-    RequirementLimitDataRate(int pMinDataRate, int pMaxDataRate):mMinDataRate(pMinDataRate), mMaxDataRate(pMaxDataRate){}
+    RequirementLimitDataRate(int pMinDataRate, int pMaxDataRate, int pMaxBurstSize = 0):mMinDataRate(pMinDataRate), mMaxDataRate(pMaxDataRate), mMaxBurstSize(pMaxBurstSize){}
 
-    virtual std::string getDescription(){ return "Requ(LimitDataRate[" + toString(mMinDataRate) + "," + toString(mMaxDataRate) + "])"; }
+    virtual std::string getDescription(){ return "Requ(LimitDataRate[" + toString(mMinDataRate) + "," + toString(mMaxDataRate) + (mMaxBurstSize > 0 ? "," + toString(mMaxBurstSize) : "") + "])"; }
 
     int getMinDataRate(){ return mMinDataRate; }
     int getMaxDataRate(){ return mMaxDataRate; }
+    int getMaxBurstSize(){ return mMaxBurstSize; } // in bytes, 0 selects the default of the transport
 private:
-    int     mMinDataRate, mMaxDataRate;
+    int     mMinDataRate, mMaxDataRate, mMaxBurstSize;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: ShmBinding
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#ifndef _NAPI_SHM_BINDING_
+#define _NAPI_SHM_BINDING_
+
+#include <Requirements.h>
+#include <SharedMemory/ShmRing.h>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+// local ports are searched from here on if the application didn't request a port
+#define SHM_BINDING_AUTO_PORT_BASE              5000
+#define SHM_BINDING_AUTO_PORT_RANGE             1000
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ShmBinding:
+    public IBinding
+{
+public:
+    ShmBinding(std::string pLocalName, Requirements *pRequirements);
+    virtual ~ShmBinding( );
+
+    virtual bool isClosed();
+    virtual IConnection* readConnection();
+    virtual Name* getName();
+    virtual void cancel();
+    virtual bool changeRequirements(Requirements *pRequirements);
+    virtual Requirements* getRequirements();
+    virtual Events getEvents();
+
+private:
+    IConnection*    mConnection; // we support only one association
+    Requirements    *mRequirements;
+    ShmRing         *mRing;
+    bool            mIsClosed;
+    unsigned int    mLocalPort;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,79 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: ShmConnection
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#ifndef _NAPI_SHM_CONNECTION_
+#define _NAPI_SHM_CONNECTION_
+
+#include <Requirements.h>
+#include <SharedMemory/ShmRing.h>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ShmConnection:
+    public IConnection
+{
+public:
+    // writer side: opens the ring of a local binding
+    ShmConnection(std::string pRingName, unsigned int pPeerPort, Requirements *pRequirements);
+    // reader side: uses the ring of a binding
+    ShmConnection(ShmRing *pRing, unsigned int pLocalPort, Requirements *pRequirements);
+    virtual ~ShmConnection( );
+
+    virtual bool isClosed();
+    virtual int availableBytes();
+    virtual void read(char* pBuffer, int &pBufferSize);
+    virtual void write(char* pBuffer, int pBufferSize);
+    virtual int getQueueDelay();
+    virtual bool getBlocking();
+    virtual void setBlocking(bool pState);
+    virtual void cancel();
+    virtual Name* getName();
+    virtual Name* getRemoteName();
+    virtual bool changeRequirements(Requirements *pRequirements);
+    virtual Requirements* getRequirements();
+    virtual Events getEvents();
+
+private:
+    static bool isReliable(Requirements *pRequirements);
+
+    bool            mBlockingMode;
+    bool            mReliable; // lossless or stream transfer, a full ring blocks instead of dropping
+    Requirements    *mRequirements;
+    ShmRing         *mRing;
+    bool            mOwnRing;
+    bool            mIsClosed;
+    unsigned int    mLocalPort;
+    unsigned int    mPeerPort;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,121 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: packet ring in shared memory for local peers
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#ifndef _NAPI_SHM_RING_
+#define _NAPI_SHM_RING_
+
+#include <stdint.h>
+#include <string>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define SHM_RING_MAGIC                          0x484D5247 // "HMRG"
+#define SHM_RING_VERSION                        1
+
+// size of the data area, has to be a power of 2
+#define SHM_RING_SIZE                           (4 * 1024 * 1024)
+
+// packets are stored as 8 byte aligned records with a record header in front
+#define SHM_RING_RECORD_HEADER_SIZE             8
+#define SHM_RING_WRAP_MARKER                    0xFFFFFFFF
+
+// the reader rechecks the ring state periodically, e.g., to detect a closed ring
+#define SHM_RING_WAIT_TIMEOUT                   500 // ms
+
+// a reliable writer polls a full ring with this period until the reader has freed enough space
+#define SHM_RING_WRITER_WAIT_TIME               1 // ms
+
+// a writer waiting for the writer lock checks every n-th turn if the lock owner is still alive
+#define SHM_RING_WRITER_LOCK_CHECK_PERIOD       64
+
+//#define SHM_RING_DEBUG_PACKETS
+
+///////////////////////////////////////////////////////////////////////////////
+
+// control block at the beginning of the shared memory segment
+struct ShmRingHeader
+{
+    uint32_t            Magic;
+    uint32_t            Version;
+    uint32_t            Size; // size of the data area
+    int32_t             OwnerPid;
+    volatile int32_t    Closed;
+    volatile int32_t    WriterLock; // 0 or the PID of the writer which holds the lock
+    volatile int32_t    ReaderWaiting;
+    volatile int32_t    Sequence; // incremented for every packet, used as futex for wake ups
+    volatile uint32_t   WriteIndex; // free running, the position within the data area is the index modulo Size
+    volatile uint32_t   ReadIndex;
+    volatile uint32_t   DroppedPackets;
+    uint32_t            Reserved;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ShmRing
+{
+public:
+    ShmRing();
+
+    virtual ~ShmRing();
+
+    static std::string GetRingName(std::string pTransport, unsigned int pPort);
+    static bool IsListening(std::string pRingName); // true if the ring exists and its owner is alive
+
+    /* setup */
+    bool Create(std::string pRingName); // reader side, fails if a living reader owns the ring
+    bool Open(std::string pRingName); // writer side
+    void Close();
+
+    /* transfer */
+    bool Write(const char *pData, int pSize, bool pReliable = false); // returns false if the ring is closed, a full ring drops the packet unless it is a reliable transfer which waits for the reader
+    bool Read(char *pBuffer, int &pBufferSize); // blocks until a packet is available, returns false if the ring was closed or canceled
+    void Cancel();
+
+    /* state */
+    bool IsClosed();
+    int GetUsage(); // in bytes
+    int64_t GetDroppedPackets();
+
+private:
+    void LockWriter();
+    void UnlockWriter();
+
+    std::string         mRingName;
+    bool                mOwner;
+    bool                mCanceled;
+    ShmRingHeader       *mHeader;
+    char                *mData;
+    int                 mSegmentSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: ShmSetup
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#ifndef _NAPI_SHM_SETUP_
+#define _NAPI_SHM_SETUP_
+
+#include <Name.h>
+#include <ISetup.h>
+
+namespace Homer { namespace Base {
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define SHARED_MEMORY               "Shared Memory"
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ShmSetup:
+    public ISetup
+{
+public:
+    ShmSetup();
+    virtual ~ShmSetup();
+
+    virtual IConnection* connect(Name *pName, Requirements *pRequirements = 0);
+    virtual IBinding* bind(Name *pName, Requirements *pRequirements = 0);
+    virtual Requirements getCapabilities(Name *pName, Requirements *pImportantRequirements = 0);
+
+    /* helpers for the selection of the transport */
+    static bool isLocalName(std::string pName);
+    static bool isListening(Name *pName, Requirements *pRequirements); // true if a local binding waits for data
+    static std::string getRingName(Requirements *pRequirements, unsigned int pPort);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespaces
+
+#endif
@@ -41,6 +41,7 @@
 
 #include <Logger.h>
 
+#include <limits.h>
 #include <string>
 
 namespace Homer { namespace Base {
@@ -53,6 +54,7 @@ SocketConnection::SocketConnection(std::string pTarget, Requirements *pRequireme
 {
     bool tFoundTransport = false;
     mSocket = NULL;
+    mPacer = NULL;
 
     mBlockingMode = true;
     mPeerHost = pTarget;
@@ -128,6 +130,7 @@ SocketConnection::SocketConnection(Socket *pSocket)
 {
     mIsClosed = false;
     mSocket = pSocket;
+    mPacer = NULL;
     mBlockingMode = true;
     mPeerHost = "";
     mPeerPort = 0;
@@ -147,6 +150,13 @@ SocketConnection::~SocketConnection()
 		cancel();
 	}
 
+	if (mPacer != NULL)
+	{
+		LOG(LOG_VERBOSE, "..destroying the pacer");
+		delete mPacer;
+		mPacer = NULL;
+	}
+
 	LOG(LOG_VERBOSE, "..destroying the Berkeley socket");
     delete mSocket;
     mSocket = NULL;
@@ -192,7 +202,12 @@ void SocketConnection::write(char* pBuffer, int pBufferSize)
     if (mSocket != NULL)
     {
         if ((mPeerHost != "") && (mPeerPort != 0))
-        mIsClosed = !mSocket->Send(mPeerHost, mPeerPort, (void*)pBuffer, (ssize_t) pBufferSize);
+        {
+            if (mPacer != NULL)
+                mIsClosed = !mPacer->Send(mPeerHost, mPeerPort, pBuffer, pBufferSize);
+            else
+                mIsClosed = !mSocket->Send(mPeerHost, mPeerPort, (void*)pBuffer, (ssize_t) pBufferSize);
+        }
         if (mIsClosed)
         	LOG(LOG_ERROR, "NAPI connection marked as closed");
         //TODO: extended error signaling
@@ -200,6 +215,14 @@ void SocketConnection::write(char* pBuffer, int pBufferSize)
         LOG(LOG_ERROR, "Invalid socket");
 }
 
+int SocketConnection::getQueueDelay()
+{
+    if (mPacer != NULL)
+        return mPacer->GetQueueDelay();
+    else
+        return 0;
+}
+
 bool SocketConnection::getBlocking()
 {
 	return mBlockingMode;
@@ -260,6 +283,7 @@ bool SocketConnection::changeRequirements(Requirements *pRequirements)
     int tMaxDelay = 0;
     int tMinDataRate = 0;
     int tMaxDataRate = 0;
+    int tMaxBurstSize = 0;
     // get lossless transmission activation
     bool tLossless = pRequirements->contains(RequirementTransmitLossless::type());
     // get delay values
@@ -274,6 +298,7 @@ bool SocketConnection::changeRequirements(Requirements *pRequirements)
         RequirementLimitDataRate* tReqDataRate = (RequirementLimitDataRate*)pRequirements->get(RequirementLimitDataRate::type());
         tMinDataRate = tReqDataRate->getMinDataRate();
         tMaxDataRate = tReqDataRate->getMaxDataRate();
+        tMaxBurstSize = tReqDataRate->getMaxBurstSize();
     }
 
     if((tLossless) || (tMaxDelay) || (tMinDataRate))
@@ -285,6 +310,18 @@ bool SocketConnection::changeRequirements(Requirements *pRequirements)
         tResult = mSocket->SetQoS(tQoSSettings);
     }
 
+    /* pacing: spread bursts (e.g., fragments of a key frame) according to the data rate limits */
+    if ((tMinDataRate > 0) || ((tMaxDataRate > 0) && (tMaxDataRate < INT_MAX)))
+    {
+        if (mPacer == NULL)
+            mPacer = new SocketPacer(mSocket);
+        mPacer->SetLimits(tMinDataRate, tMaxDataRate, tMaxBurstSize, tMaxDelay);
+    }else
+    {
+        if (mPacer != NULL)
+            mPacer->SetLimits(0, 0, 0, 0);
+    }
+
     mRequirements = pRequirements; //TODO: maybe some requirements were dropped?
 
     return tResult;
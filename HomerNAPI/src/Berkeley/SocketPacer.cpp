@@ -0,0 +1,314 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of a token bucket based pacer for outgoing packets
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#include <Berkeley/SocketPacer.h>
+
+#include <HBMemoryPool.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+#include <limits.h>
+#include <string.h>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+SocketPacer::SocketPacer(Socket *pSocket)
+{
+    mSocket = pSocket;
+    mPacerNeeded = false;
+    mBrokenSocket = false;
+    mDataRate = 0;
+    mMaxDataRate = 0;
+    mMaxBurstSize = SOCKET_PACER_DEFAULT_BURST_SIZE;
+    mMaxDelay = 0;
+    mTokens = 0;
+    mLastRefill = 0;
+    mQueueSize = 0;
+    mDroppedPackets = 0;
+}
+
+SocketPacer::~SocketPacer()
+{
+    Stop();
+
+    mQueueMutex.lock();
+    if (mQueue.size() > 0)
+        LOG(LOG_WARN, "Dropping %d queued packets with %d bytes", (int)mQueue.size(), mQueueSize);
+    while (!mQueue.empty())
+    {
+        MEMORY_POOL.Free(mQueue.front().Data);
+        mQueue.pop_front();
+    }
+    mQueueSize = 0;
+    mQueueMutex.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SocketPacer::SetLimits(int pMinDataRate, int pMaxDataRate, int pMaxBurstSize, int pMaxDelay)
+{
+    mQueueMutex.lock();
+
+    // INT_MAX is used by the applications as "unlimited"
+    if ((pMaxDataRate > 0) && (pMaxDataRate < INT_MAX))
+        mMaxDataRate = (int64_t)pMaxDataRate * 1024;
+    else
+        mMaxDataRate = 0;
+
+    // the guaranteed data rate is the pacing rate, otherwise we pace with the upper limit
+    if (pMinDataRate > 0)
+        mDataRate = (int64_t)pMinDataRate * 1024;
+    else
+        mDataRate = mMaxDataRate;
+    if ((mMaxDataRate > 0) && (mDataRate > mMaxDataRate))
+        mDataRate = mMaxDataRate;
+
+    mMaxBurstSize = (pMaxBurstSize > 0) ? pMaxBurstSize : SOCKET_PACER_DEFAULT_BURST_SIZE;
+    mMaxDelay = (pMaxDelay > 0) ? pMaxDelay : 0;
+
+    // start with a full bucket
+    mTokens = mMaxBurstSize;
+    mLastRefill = Time::GetTimeStamp();
+
+    LOG(LOG_VERBOSE, "Pacing with %ld bytes/s (limit: %ld bytes/s), burst size: %d bytes, max. delay: %d ms", mDataRate, mMaxDataRate, mMaxBurstSize, mMaxDelay);
+
+    mQueueMutex.unlock();
+
+    if ((mDataRate > 0) && (!mPacerNeeded))
+    {
+        mPacerNeeded = true;
+        StartThread();
+    }
+}
+
+bool SocketPacer::Send(string pTargetHost, unsigned int pTargetPort, char *pData, int pSize)
+{
+    if (mBrokenSocket)
+        return false;
+
+    // pacer isn't running: send directly
+    if (!mPacerNeeded)
+    {
+        mBrokenSocket = !mSocket->Send(pTargetHost, pTargetPort, (void*)pData, (ssize_t)pSize);
+        return !mBrokenSocket;
+    }
+
+    mQueueMutex.lock();
+
+    if (mQueueSize + pSize > SOCKET_PACER_QUEUE_LIMIT)
+    {
+        mDroppedPackets++;
+        mQueueMutex.unlock();
+        LOG(LOG_WARN, "Pacer queue is full (%d bytes), dropping packet of %d bytes", mQueueSize, pSize);
+        return true;
+    }
+
+    PacedPacket tPacket;
+    tPacket.Data = (char*)MEMORY_POOL.Alloc("Pacer", (unsigned int)pSize);
+    if (tPacket.Data == NULL)
+    {
+        mQueueMutex.unlock();
+        return true;
+    }
+    memcpy(tPacket.Data, pData, pSize);
+    tPacket.Size = pSize;
+    tPacket.TargetHost = pTargetHost;
+    tPacket.TargetPort = pTargetPort;
+    tPacket.EnqueueTime = Time::GetTimeStamp();
+    mQueue.push_back(tPacket);
+    mQueueSize += pSize;
+
+    mQueueCondition.SignalOne();
+
+    mQueueMutex.unlock();
+
+    return true;
+}
+
+void SocketPacer::Stop()
+{
+    int tSignalingRound = 0;
+
+    if (!mPacerNeeded)
+        return;
+
+    LOG(LOG_VERBOSE, "Stopping pacer");
+
+    mPacerNeeded = false;
+    do
+    {
+        if(tSignalingRound > 0)
+            LOG(LOG_WARN, "Signaling round %d to stop pacer, system has high load", tSignalingRound);
+        tSignalingRound++;
+
+        // awake the pacer thread as long as it still runs
+        mQueueMutex.lock();
+        mQueueCondition.SignalAll();
+        mQueueMutex.unlock();
+    }while(!StopThread(1000));
+
+    LOG(LOG_VERBOSE, "Pacer stopped");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int SocketPacer::GetQueueDelay()
+{
+    int tResult = 0;
+
+    mQueueMutex.lock();
+    int64_t tDrainRate = GetDrainRate(Time::GetTimeStamp());
+    if (tDrainRate > 0)
+        tResult = (int)((int64_t)mQueueSize * 1000 * 1000 / tDrainRate);
+    mQueueMutex.unlock();
+
+    return tResult;
+}
+
+int SocketPacer::GetQueueSize()
+{
+    return mQueueSize;
+}
+
+int64_t SocketPacer::GetDroppedPackets()
+{
+    return mDroppedPackets;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int64_t SocketPacer::GetDrainRate(int64_t pNow)
+{
+    int64_t tResult = mDataRate;
+
+    // never hold queued data longer than the delay bound: drain faster if a burst (e.g., a key frame) was queued
+    if ((tResult > 0) && (mMaxDelay > 0) && (!mQueue.empty()))
+    {
+        // the last packet has to leave before its deadline and all packets in front of it as well
+        int64_t tTimeLeft = mQueue.back().EnqueueTime + (int64_t)mMaxDelay * 1000 - pNow;
+        int64_t tHeadTimeLeft = mQueue.front().EnqueueTime + (int64_t)mMaxDelay * 1000 - pNow;
+        if ((tTimeLeft > 0) && (tHeadTimeLeft > 0))
+        {
+            int64_t tDelayRate = (int64_t)mQueueSize * 1000 * 1000 / tTimeLeft;
+            if (tDelayRate > tResult)
+                tResult = tDelayRate;
+            tDelayRate = (int64_t)mQueue.front().Size * 1000 * 1000 / tHeadTimeLeft;
+            if (tDelayRate > tResult)
+                tResult = tDelayRate;
+        }else
+        {// deadline missed: send as fast as allowed
+            tResult = (mMaxDataRate > 0) ? mMaxDataRate : 0;
+        }
+    }
+
+    // .. but stay below the upper limit
+    if ((mMaxDataRate > 0) && (tResult > mMaxDataRate))
+        tResult = mMaxDataRate;
+
+    return tResult;
+}
+
+void SocketPacer::RefillTokens(int64_t pNow)
+{
+    int64_t tDrainRate = GetDrainRate(pNow);
+
+    // the bucket has to hold at least the tokens of one timer period, otherwise we lose tokens between two wake ups
+    double tBucketSize = mMaxBurstSize;
+    double tMinBucketSize = (double)tDrainRate * SOCKET_PACER_MIN_BURST_PERIOD / 1000;
+    if (tBucketSize < tMinBucketSize)
+        tBucketSize = tMinBucketSize;
+
+    mTokens += (double)tDrainRate * (pNow - mLastRefill) / 1000 / 1000;
+    // no pacing at the moment: don't accumulate a token debt
+    if ((mTokens > tBucketSize) || (tDrainRate == 0))
+        mTokens = tBucketSize;
+    mLastRefill = pNow;
+}
+
+void* SocketPacer::Run(void* pArgs)
+{
+    LOG(LOG_VERBOSE, "Pacer for local port %u started", mSocket->GetLocalPort());
+
+    mQueueMutex.lock();
+    while(mPacerNeeded)
+    {
+        if (mQueue.empty())
+        {
+            mQueueCondition.Wait(&mQueueMutex);
+            continue;
+        }
+
+        int64_t tNow = Time::GetTimeStamp();
+        RefillTokens(tNow);
+
+        // wait until the bucket has enough tokens for the next packet, a packet larger than the bucket needs a full bucket
+        PacedPacket tPacket = mQueue.front();
+        double tNeededTokens = tPacket.Size;
+        if (tNeededTokens > mMaxBurstSize)
+            tNeededTokens = mMaxBurstSize;
+        int64_t tDrainRate = GetDrainRate(tNow);
+        if ((tDrainRate > 0) && (mTokens < tNeededTokens))
+        {
+            unsigned int tWaitTime = (unsigned int)((tNeededTokens - mTokens) * 1000 * 1000 / tDrainRate) + 1;
+            mQueueMutex.unlock();
+            Suspend(tWaitTime);
+            mQueueMutex.lock();
+            continue;
+        }
+
+        mQueue.pop_front();
+        mQueueSize -= tPacket.Size;
+        mTokens -= tPacket.Size;
+        mQueueMutex.unlock();
+
+        #ifdef SOCKET_PACER_DEBUG
+            LOG(LOG_VERBOSE, "Sending paced packet of %d bytes after %ld us in queue", tPacket.Size, tNow - tPacket.EnqueueTime);
+        #endif
+
+        if ((!mBrokenSocket) && (!mSocket->Send(tPacket.TargetHost, tPacket.TargetPort, (void*)tPacket.Data, (ssize_t)tPacket.Size)))
+        {
+            LOG(LOG_ERROR, "Error when sending paced data to %s:%u", tPacket.TargetHost.c_str(), tPacket.TargetPort);
+            mBrokenSocket = true;
+        }
+        MEMORY_POOL.Free(tPacket.Data);
+
+        mQueueMutex.lock();
+    }
+    mQueueMutex.unlock();
+
+    LOG(LOG_VERBOSE, "Pacer for local port %u finished", mSocket->GetLocalPort());
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -0,0 +1,347 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: EmuConnection
+ * Author:  Thomas Volkert
+ * Since:   2012-12-07
+ */
+
+#include <NAPI.h>
+#include <Emulator/EmuConnection.h>
+
+#include <HBMemoryPool.h>
+#include <HBTime.h>
+#include <Logger.h>
+
+#include <math.h>
+#include <string.h>
+#include <string>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+EmuConnection::EmuConnection(IConnection *pConnection, EmuSettings pSettings, string pTarget, unsigned int pTargetPort)
+{
+    mConnection = pConnection;
+    mSettings = pSettings;
+    mEmulatorNeeded = false;
+    mLinkFreeTime = 0;
+    mPackets = 0;
+    mLostPackets = 0;
+    mReorderedPackets = 0;
+    mCorruptedPackets = 0;
+
+    // every connection gets its own random sequence, derived from the seed and the target (FNV-1a hash)
+    // to get the same results for the same setup independent from the order of connection establishment
+    string tTarget = pTarget + ":" + toString(pTargetPort);
+    mRandomState = 14695981039346656037ULL ^ pSettings.Seed;
+    for (unsigned int i = 0; i < tTarget.size(); i++)
+    {
+        mRandomState ^= (unsigned char)tTarget[i];
+        mRandomState *= 1099511628211ULL;
+    }
+    if (mRandomState == 0)
+        mRandomState = 1;
+
+    LOG(LOG_VERBOSE, "Emulating for %s delay: %d ms, jitter: %d ms, loss: %.2f %%, reordering: %.2f %%, data rate: %d KB/s, bit error rate: %g, seed: %u", tTarget.c_str(), mSettings.Delay, mSettings.Jitter, mSettings.Loss, mSettings.Reordering, mSettings.DataRate, mSettings.BitErrorRate, mSettings.Seed);
+
+    // delivery thread is only needed if packets are delayed
+    if ((mSettings.Delay > 0) || (mSettings.Jitter > 0) || (mSettings.DataRate > 0))
+    {
+        mEmulatorNeeded = true;
+        StartThread();
+    }
+}
+
+EmuConnection::~EmuConnection()
+{
+    LOG(LOG_VERBOSE, "Going to destroy emulated connection");
+
+    StopEmulator();
+
+    mQueueMutex.lock();
+    while (!mQueue.empty())
+    {
+        MEMORY_POOL.Free(mQueue.begin()->second.Data);
+        mQueue.erase(mQueue.begin());
+    }
+    mQueueMutex.unlock();
+
+    LOG(LOG_VERBOSE, "Emulated %ld packets: %ld lost, %ld reordered, %ld corrupted", mPackets, mLostPackets, mReorderedPackets, mCorruptedPackets);
+
+    delete mConnection;
+
+    LOG(LOG_VERBOSE, "Destroyed");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+double EmuConnection::GetRandom()
+{
+    // xorshift64*
+    mRandomState ^= mRandomState >> 12;
+    mRandomState ^= mRandomState << 25;
+    mRandomState ^= mRandomState >> 27;
+
+    return (double)((mRandomState * 2685821657736338717ULL) >> 11) / 9007199254740992.0 /* 2^53 */;
+}
+
+void EmuConnection::ApplyBitErrors(char *pData, int pSize)
+{
+    int64_t tBits = (int64_t)pSize * 8;
+    double tLogNoError = log(1.0 - mSettings.BitErrorRate);
+    bool tCorrupted = false;
+
+    // jump from bit error to bit error with geometrically distributed distances
+    int64_t tBit = (int64_t)floor(log(1.0 - GetRandom()) / tLogNoError);
+    while (tBit < tBits)
+    {
+        pData[tBit / 8] ^= (char)(1 << (tBit % 8));
+        tCorrupted = true;
+        tBit += 1 + (int64_t)floor(log(1.0 - GetRandom()) / tLogNoError);
+    }
+
+    if (tCorrupted)
+        mCorruptedPackets++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool EmuConnection::isClosed()
+{
+    return mConnection->isClosed();
+}
+
+int EmuConnection::availableBytes()
+{
+    return mConnection->availableBytes();
+}
+
+void EmuConnection::read(char* pBuffer, int &pBufferSize)
+{
+    mConnection->read(pBuffer, pBufferSize);
+}
+
+void EmuConnection::write(char* pBuffer, int pBufferSize)
+{
+    mQueueMutex.lock();
+
+    mPackets++;
+
+    // draw all random values of this packet before any early return, otherwise drops caused by timing shift the random sequence
+    double tLossDraw = (mSettings.Loss > 0) ? GetRandom() : 1.0;
+    double tJitterDraw = (mSettings.Jitter > 0) ? GetRandom() : 0.5;
+    double tReorderDraw = (mSettings.Reordering > 0) ? GetRandom() : 1.0;
+
+    if ((mSettings.Loss > 0) && (tLossDraw * 100 < mSettings.Loss))
+    {
+        mLostPackets++;
+        mQueueMutex.unlock();
+        #ifdef EMU_DEBUG_PACKETS
+            LOG(LOG_VERBOSE, "Dropped packet %ld of %d bytes", mPackets, pBufferSize);
+        #endif
+        return;
+    }
+
+    // the caller's buffer isn't modified
+    char *tData = pBuffer;
+    if ((mEmulatorNeeded) || (mSettings.BitErrorRate > 0))
+    {
+        tData = (char*)MEMORY_POOL.Alloc("Emulator", (unsigned int)pBufferSize);
+        if (tData == NULL)
+        {
+            mQueueMutex.unlock();
+            return;
+        }
+        memcpy(tData, pBuffer, pBufferSize);
+    }
+
+    if (mSettings.BitErrorRate > 0)
+        ApplyBitErrors(tData, pBufferSize);
+
+    if (!mEmulatorNeeded)
+    {
+        mQueueMutex.unlock();
+        mConnection->write(tData, pBufferSize);
+        if (tData != pBuffer)
+            MEMORY_POOL.Free(tData);
+        return;
+    }
+
+    int64_t tNow = Time::GetTimeStamp();
+    int64_t tDeliveryTime = tNow;
+
+    // serialization on the emulated link
+    if (mSettings.DataRate > 0)
+    {
+        if (mLinkFreeTime < tNow)
+            mLinkFreeTime = tNow;
+        if (mLinkFreeTime - tNow > (int64_t)EMU_RATE_QUEUE_LIMIT * 1000)
+        {
+            mLostPackets++;
+            mQueueMutex.unlock();
+            MEMORY_POOL.Free(tData);
+            #ifdef EMU_DEBUG_PACKETS
+                LOG(LOG_VERBOSE, "Link queue overflow, dropped packet %ld of %d bytes", mPackets, pBufferSize);
+            #endif
+            return;
+        }
+        mLinkFreeTime += (int64_t)pBufferSize * 1000 * 1000 / ((int64_t)mSettings.DataRate * 1024);
+        tDeliveryTime = mLinkFreeTime;
+    }
+
+    // propagation delay
+    int64_t tDelay = (int64_t)mSettings.Delay * 1000;
+    if (mSettings.Jitter > 0)
+        tDelay += (int64_t)((tJitterDraw * 2 - 1) * mSettings.Jitter * 1000);
+    if ((mSettings.Reordering > 0) && (tReorderDraw * 100 < mSettings.Reordering))
+    {// overtake the delayed packets
+        tDelay = 0;
+        mReorderedPackets++;
+    }
+    if (tDelay > 0)
+        tDeliveryTime += tDelay;
+
+    EmuPacket tPacket;
+    tPacket.Data = tData;
+    tPacket.Size = pBufferSize;
+    mQueue.insert(pair<int64_t, EmuPacket>(tDeliveryTime, tPacket));
+
+    mQueueCondition.SignalOne();
+
+    mQueueMutex.unlock();
+}
+
+int EmuConnection::getQueueDelay()
+{
+    return mConnection->getQueueDelay();
+}
+
+bool EmuConnection::getBlocking()
+{
+    return mConnection->getBlocking();
+}
+
+void EmuConnection::setBlocking(bool pState)
+{
+    mConnection->setBlocking(pState);
+}
+
+void EmuConnection::cancel()
+{
+    mConnection->cancel();
+}
+
+Name* EmuConnection::getName()
+{
+    return mConnection->getName();
+}
+
+Name* EmuConnection::getRemoteName()
+{
+    return mConnection->getRemoteName();
+}
+
+bool EmuConnection::changeRequirements(Requirements *pRequirements)
+{
+    return mConnection->changeRequirements(pRequirements);
+}
+
+Requirements* EmuConnection::getRequirements()
+{
+    return mConnection->getRequirements();
+}
+
+Events EmuConnection::getEvents()
+{
+    // the emulator doesn't create events on its own, Events can't be copied from a temporary
+    Events tResult;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void EmuConnection::StopEmulator()
+{
+    int tSignalingRound = 0;
+
+    if (!mEmulatorNeeded)
+        return;
+
+    mEmulatorNeeded = false;
+    do
+    {
+        if(tSignalingRound > 0)
+            LOG(LOG_WARN, "Signaling round %d to stop emulator, system has high load", tSignalingRound);
+        tSignalingRound++;
+
+        // awake the delivery thread as long as it still runs
+        mQueueMutex.lock();
+        mQueueCondition.SignalAll();
+        mQueueMutex.unlock();
+    }while(!StopThread(1000));
+}
+
+void* EmuConnection::Run(void* pArgs)
+{
+    LOG(LOG_VERBOSE, "Network emulator started");
+
+    mQueueMutex.lock();
+    while(mEmulatorNeeded)
+    {
+        if (mQueue.empty())
+        {
+            mQueueCondition.Wait(&mQueueMutex);
+            continue;
+        }
+
+        int64_t tWaitTime = mQueue.begin()->first - Time::GetTimeStamp();
+        if (tWaitTime > 0)
+        {
+            // new packets may be due earlier (reordering), hence we wait for the condition
+            mQueueCondition.Wait(&mQueueMutex, (int)((tWaitTime + 999) / 1000));
+            continue;
+        }
+
+        EmuPacket tPacket = mQueue.begin()->second;
+        mQueue.erase(mQueue.begin());
+        mQueueMutex.unlock();
+
+        mConnection->write(tPacket.Data, tPacket.Size);
+        MEMORY_POOL.Free(tPacket.Data);
+
+        mQueueMutex.lock();
+    }
+    mQueueMutex.unlock();
+
+    LOG(LOG_VERBOSE, "Network emulator finished");
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
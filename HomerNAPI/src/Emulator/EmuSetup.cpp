@@ -0,0 +1,190 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: EmuSetup
+ * Author:  Thomas Volkert
+ * Since:   2012-12-07
+ */
+
+#include <NAPI.h>
+#include <Emulator/EmuSetup.h>
+#include <Emulator/EmuConnection.h>
+#include <Berkeley/SocketBinding.h>
+#include <Berkeley/SocketConnection.h>
+#include <RequirementTargetPort.h>
+
+#include <HBMutex.h>
+#include <Logger.h>
+
+#include <stdlib.h>
+#include <map>
+#include <string>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+typedef map<unsigned int, EmuSettings> EmuPortSettings;
+
+static EmuSettings sDefaultSettings = { 0, 0, 0, 0, 0, 0, 0 };
+static EmuPortSettings sPortSettings;
+static Mutex sSettingsMutex;
+
+///////////////////////////////////////////////////////////////////////////////
+
+EmuSetup::EmuSetup()
+{
+}
+
+EmuSetup::~EmuSetup()
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+IConnection* EmuSetup::connect(Name *pName, Requirements *pRequirements)
+{
+    unsigned int tTargetPort = 0;
+    RequirementTargetPort *tRequPort = (RequirementTargetPort*)pRequirements->get(RequirementTargetPort::type());
+    if (tRequPort != NULL)
+        tTargetPort = tRequPort->getPort();
+
+    // like netem: the network conditions are applied to outgoing packets
+    return new EmuConnection(new SocketConnection(pName->toString(), pRequirements), getSettings(tTargetPort), pName->toString(), tTargetPort);
+}
+
+IBinding* EmuSetup::bind(Name *pName, Requirements *pRequirements)
+{
+    return new SocketBinding(pName->toString(), pRequirements);
+}
+
+Requirements EmuSetup::getCapabilities(Name *pName, Requirements *pImportantRequirements)
+{
+    // no capabilities are reported: the emulated loss, reordering, bit errors and data rate limits void any guarantee of the underlying Berkeley sockets,
+    // and the returned copy of a filled Requirements object would share its entries
+    Requirements tResult;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void EmuSetup::setDefaultSettings(EmuSettings pSettings)
+{
+    sSettingsMutex.lock();
+    sDefaultSettings = pSettings;
+    sSettingsMutex.unlock();
+}
+
+EmuSettings EmuSetup::getDefaultSettings()
+{
+    EmuSettings tResult;
+
+    sSettingsMutex.lock();
+    tResult = sDefaultSettings;
+    sSettingsMutex.unlock();
+
+    return tResult;
+}
+
+void EmuSetup::setSettings(unsigned int pTargetPort, EmuSettings pSettings)
+{
+    sSettingsMutex.lock();
+    sPortSettings[pTargetPort] = pSettings;
+    sSettingsMutex.unlock();
+}
+
+EmuSettings EmuSetup::getSettings(unsigned int pTargetPort)
+{
+    EmuSettings tResult;
+
+    sSettingsMutex.lock();
+    EmuPortSettings::iterator tIt = sPortSettings.find(pTargetPort);
+    if (tIt != sPortSettings.end())
+        tResult = tIt->second;
+    else
+        tResult = sDefaultSettings;
+    sSettingsMutex.unlock();
+
+    return tResult;
+}
+
+bool EmuSetup::parseSettings(string pDescription, EmuSettings &pSettings)
+{
+    EmuSettings tResult = { 0, 0, 0, 0, 0, 0, 0 };
+    size_t tPos = 0;
+
+    while (tPos < pDescription.size())
+    {
+        size_t tEnd = pDescription.find(',', tPos);
+        if (tEnd == string::npos)
+            tEnd = pDescription.size();
+        string tEntry = pDescription.substr(tPos, tEnd - tPos);
+        tPos = tEnd + 1;
+
+        size_t tSeparator = tEntry.find('=');
+        if (tSeparator == string::npos)
+        {
+            LOGEX(EmuSetup, LOG_ERROR, "Invalid network emulator setting \"%s\"", tEntry.c_str());
+            return false;
+        }
+        string tKey = tEntry.substr(0, tSeparator);
+        const char *tValue = tEntry.c_str() + tSeparator + 1;
+
+        if (tKey == "delay")
+            tResult.Delay = atoi(tValue);
+        else if (tKey == "jitter")
+            tResult.Jitter = atoi(tValue);
+        else if (tKey == "loss")
+            tResult.Loss = (float)atof(tValue);
+        else if (tKey == "reorder")
+            tResult.Reordering = (float)atof(tValue);
+        else if (tKey == "rate")
+            tResult.DataRate = atoi(tValue);
+        else if (tKey == "ber")
+            tResult.BitErrorRate = atof(tValue);
+        else if (tKey == "seed")
+            tResult.Seed = (unsigned int)strtoul(tValue, NULL, 10);
+        else
+        {
+            LOGEX(EmuSetup, LOG_ERROR, "Unknown network emulator setting \"%s\"", tKey.c_str());
+            return false;
+        }
+    }
+
+    if ((tResult.Delay < 0) || (tResult.Jitter < 0) || (tResult.Loss < 0) || (tResult.Loss > 100) || (tResult.Reordering < 0) || (tResult.Reordering > 100) || (tResult.DataRate < 0) || (tResult.BitErrorRate < 0) || (tResult.BitErrorRate >= 1))
+    {
+        LOGEX(EmuSetup, LOG_ERROR, "Network emulator settings \"%s\" are out of range", pDescription.c_str());
+        return false;
+    }
+
+    pSettings = tResult;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
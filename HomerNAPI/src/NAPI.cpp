@@ -27,6 +27,8 @@
 
 #include <NAPI.h>
 #include <Berkeley/SocketSetup.h>
+#include <SharedMemory/ShmSetup.h>
+#include <Emulator/EmuSetup.h>
 
 #include <Logger.h>
 
@@ -44,7 +46,13 @@ NAPIService::NAPIService()
 {
 	mSetupInterface = NULL;
 	mSetupInterfaceName = "";
+	mLocalSetupInterface = NULL;
 	registerImpl(new SocketSetup(), BERKEYLEY_SOCKETS);
+	#if defined(LINUX)
+		mLocalSetupInterface = new ShmSetup();
+		registerImpl(mLocalSetupInterface, SHARED_MEMORY);
+	#endif
+	registerImpl(new EmuSetup(), NETWORK_EMULATOR);
 }
 
 NAPIService::~NAPIService()
@@ -152,7 +160,15 @@ IConnection* NAPIService::connect(Name *pName, Requirements *pRequirements)
 	if(mSetupInterface == NULL)
 		LOG(LOG_ERROR, "No setup interface available");
 	else
-		tResult = mSetupInterface->connect(pName, pRequirements);
+	{
+		// local peers which listen via shared memory are reached without the network stack
+		if ((mLocalSetupInterface != NULL) && (mSetupInterface != mLocalSetupInterface) && (ShmSetup::isListening(pName, pRequirements)))
+		{
+			LOG(LOG_VERBOSE, "Found local binding for \"%s\", using shared memory", pName->toString().c_str());
+			tResult = mLocalSetupInterface->connect(pName, pRequirements);
+		}else
+			tResult = mSetupInterface->connect(pName, pRequirements);
+	}
 
 	return tResult;
 }
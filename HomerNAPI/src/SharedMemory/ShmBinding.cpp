@@ -0,0 +1,183 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: ShmBinding
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#include <NAPI.h>
+#include <SharedMemory/ShmSetup.h>
+#include <SharedMemory/ShmBinding.h>
+#include <SharedMemory/ShmConnection.h>
+#include <Berkeley/SocketName.h>
+#include <RequirementTargetPort.h>
+
+#include <Logger.h>
+
+#include <string>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+ShmBinding::ShmBinding(std::string pLocalName, Requirements *pRequirements)
+{
+    unsigned int tLocalPort = 0;
+    RequirementTargetPort *tRequPort = (RequirementTargetPort*)pRequirements->get(RequirementTargetPort::type());
+    if (tRequPort != NULL)
+    {
+        tLocalPort = tRequPort->getPort();
+
+    }else
+    {
+        LOG(LOG_WARN, "No target port given within requirement set, falling back to port 0");
+        tLocalPort = 0;
+    }
+    mIsClosed = true;
+    mConnection = NULL;
+    mRequirements = pRequirements;
+    mRing = new ShmRing();
+
+    // use the requested port if no other local process listens there
+    mLocalPort = 0;
+    if ((tLocalPort != 0) && (mRing->Create(ShmSetup::getRingName(pRequirements, tLocalPort))))
+        mLocalPort = tLocalPort;
+
+    // .. otherwise search a free one
+    if (mLocalPort == 0)
+    {
+        for (unsigned int tPort = SHM_BINDING_AUTO_PORT_BASE; tPort < SHM_BINDING_AUTO_PORT_BASE + SHM_BINDING_AUTO_PORT_RANGE; tPort++)
+        {
+            if (mRing->Create(ShmSetup::getRingName(pRequirements, tPort)))
+            {
+                mLocalPort = tPort;
+                break;
+            }
+        }
+    }
+
+    if (mLocalPort != 0)
+    {
+        if ((tRequPort != NULL) && (mLocalPort != tLocalPort))
+        {
+            LOG(LOG_WARN, "Shared memory ring was bound to another port (%u) than requested (%u)", mLocalPort, tLocalPort);
+            tRequPort->setPort(mLocalPort);
+        }
+
+        mIsClosed = false;
+
+        LOG(LOG_VERBOSE, "New shared memory binding at %s and requirements %s created", getName()->toString().c_str(), mRequirements->getDescription().c_str());
+    }else
+    {
+        LOG(LOG_ERROR, "Haven't found a free port for a shared memory ring");
+    }
+}
+
+ShmBinding::~ShmBinding()
+{
+    LOG(LOG_VERBOSE, "Destroying NAPI bind object..");
+    if (!isClosed())
+    {
+        cancel();
+    }
+    delete mRing;
+    LOG(LOG_VERBOSE, "Destroyed");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShmBinding::isClosed()
+{
+    return mIsClosed;
+}
+
+IConnection* ShmBinding::readConnection()
+{
+    if (mIsClosed)
+        return NULL;
+
+    if (mConnection == NULL)
+    {
+        LOG(LOG_VERBOSE, "Creating new association");
+        mConnection = new ShmConnection(mRing, mLocalPort, mRequirements);
+    }
+
+    return mConnection;
+}
+
+Name* ShmBinding::getName()
+{
+    return new SocketName("localhost", mLocalPort);
+}
+
+void ShmBinding::cancel()
+{
+    if (!isClosed())
+    {
+        LOG(LOG_VERBOSE, "All connections will be canceled now");
+
+        if (mConnection != NULL)
+        {
+            LOG(LOG_VERBOSE, "..destroying connection");
+            delete mConnection;
+            mConnection = NULL;
+        }
+
+        LOG(LOG_VERBOSE, "..closing shared memory ring");
+        mRing->Close();
+    }
+    LOG(LOG_VERBOSE, "Canceled");
+    mIsClosed = true;
+}
+
+bool ShmBinding::changeRequirements(Requirements *pRequirements)
+{
+    bool tResult = true;
+
+    if (mConnection != NULL)
+        tResult = mConnection->changeRequirements(pRequirements);
+
+    if (tResult)
+        mRequirements = pRequirements;
+
+    return tResult;
+}
+
+Requirements* ShmBinding::getRequirements()
+{
+    return mRequirements;
+}
+
+Events ShmBinding::getEvents()
+{
+    // the ring doesn't create events, a closed ring is reported via isClosed()
+    Events tResult;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
@@ -0,0 +1,189 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: ShmConnection
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#include <NAPI.h>
+#include <SharedMemory/ShmConnection.h>
+#include <Berkeley/SocketName.h>
+
+#include <Logger.h>
+
+#include <string>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+ShmConnection::ShmConnection(string pRingName, unsigned int pPeerPort, Requirements *pRequirements)
+{
+    mBlockingMode = true;
+    mRequirements = pRequirements;
+    mReliable = isReliable(pRequirements);
+    mLocalPort = 0;
+    mPeerPort = pPeerPort;
+    mOwnRing = true;
+    mRing = new ShmRing();
+    mIsClosed = !mRing->Open(pRingName);
+
+    if (!mIsClosed)
+        LOG(LOG_VERBOSE, "New shared memory association with local port %u and requirements %s created", mPeerPort, mRequirements->getDescription().c_str());
+}
+
+ShmConnection::ShmConnection(ShmRing *pRing, unsigned int pLocalPort, Requirements *pRequirements)
+{
+    mBlockingMode = true;
+    mRequirements = pRequirements;
+    mReliable = isReliable(pRequirements);
+    mLocalPort = pLocalPort;
+    mPeerPort = 0;
+    mOwnRing = false;
+    mRing = pRing;
+    mIsClosed = false;
+
+    LOG(LOG_VERBOSE, "New shared memory association for local port %u created", mLocalPort);
+}
+
+ShmConnection::~ShmConnection()
+{
+    LOG(LOG_VERBOSE, "Going to destroy shared memory connection for local port %u and remote port %u", mLocalPort, mPeerPort);
+
+    if (!isClosed())
+    {
+        LOG(LOG_VERBOSE, "..cancel the connection");
+        cancel();
+    }
+
+    if (mOwnRing)
+    {
+        LOG(LOG_VERBOSE, "..closing the shared memory ring");
+        delete mRing;
+    }
+    mRing = NULL;
+
+    LOG(LOG_VERBOSE, "Destroyed");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShmConnection::isReliable(Requirements *pRequirements)
+{
+    return ((pRequirements != NULL) && ((pRequirements->contains(RequirementTransmitLossless::type())) || (pRequirements->contains(RequirementTransmitStream::type()))));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShmConnection::isClosed()
+{
+    return mIsClosed;
+}
+
+int ShmConnection::availableBytes()
+{
+    return mRing->GetUsage();
+}
+
+void ShmConnection::read(char* pBuffer, int &pBufferSize)
+{
+    if ((!mRing->Read(pBuffer, pBufferSize)) && (!mIsClosed))
+    {
+        LOG(LOG_ERROR, "NAPI connection marked as closed");
+        mIsClosed = true;
+    }
+}
+
+void ShmConnection::write(char* pBuffer, int pBufferSize)
+{
+    if (mOwnRing)
+    {
+        mIsClosed = !mRing->Write(pBuffer, pBufferSize, mReliable);
+        if (mIsClosed)
+            LOG(LOG_ERROR, "NAPI connection marked as closed");
+    }else
+        LOG(LOG_ERROR, "Shared memory bindings don't support a back channel");
+}
+
+int ShmConnection::getQueueDelay()
+{
+    return 0;
+}
+
+bool ShmConnection::getBlocking()
+{
+    return mBlockingMode;
+}
+
+void ShmConnection::setBlocking(bool pState)
+{
+    mBlockingMode = pState;
+}
+
+void ShmConnection::cancel()
+{
+    if (!isClosed())
+    {
+        LOG(LOG_VERBOSE, "Connection for local port %u will be canceled now", mLocalPort);
+        mIsClosed = true;
+        mRing->Cancel();
+    }
+    LOG(LOG_VERBOSE, "Canceled");
+}
+
+Name* ShmConnection::getName()
+{
+    return new SocketName("localhost", mLocalPort);
+}
+
+Name* ShmConnection::getRemoteName()
+{
+    return new SocketName("localhost", mPeerPort);
+}
+
+bool ShmConnection::changeRequirements(Requirements *pRequirements)
+{
+    mRequirements = pRequirements;
+    mReliable = isReliable(pRequirements);
+
+    return true;
+}
+
+Requirements* ShmConnection::getRequirements()
+{
+    return mRequirements;
+}
+
+Events ShmConnection::getEvents()
+{
+    // the ring doesn't create events, a closed ring is reported via isClosed()
+    Events tResult;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
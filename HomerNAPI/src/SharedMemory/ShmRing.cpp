@@ -0,0 +1,476 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: Implementation of a packet ring in shared memory
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#include <SharedMemory/ShmRing.h>
+
+#include <Logger.h>
+
+#include <string.h>
+
+#if defined(LINUX)
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// the data area starts behind the control block
+#define SHM_RING_DATA_OFFSET                    64
+
+#define SHM_RING_RECORD_SIZE(x)                 (SHM_RING_RECORD_HEADER_SIZE + (((x) + 7) & ~7))
+
+#if defined(LINUX)
+static int FutexWait(volatile int32_t *pAddress, int32_t pValue, int pMSecs)
+{
+    struct timespec tTimeout;
+    tTimeout.tv_sec = pMSecs / 1000;
+    tTimeout.tv_nsec = (pMSecs % 1000) * 1000 * 1000;
+
+    // no FUTEX_PRIVATE_FLAG: the futex is shared between processes
+    return syscall(SYS_futex, pAddress, FUTEX_WAIT, pValue, &tTimeout, NULL, 0);
+}
+
+static int FutexWake(volatile int32_t *pAddress)
+{
+    return syscall(SYS_futex, pAddress, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+ShmRing::ShmRing()
+{
+    mRingName = "";
+    mOwner = false;
+    mCanceled = false;
+    mHeader = NULL;
+    mData = NULL;
+    mSegmentSize = 0;
+}
+
+ShmRing::~ShmRing()
+{
+    Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+string ShmRing::GetRingName(string pTransport, unsigned int pPort)
+{
+    return "/homer-napi-" + pTransport + "-" + toString(pPort);
+}
+
+bool ShmRing::IsListening(string pRingName)
+{
+    bool tResult = false;
+
+    #if defined(LINUX)
+        int tFd = shm_open(pRingName.c_str(), O_RDONLY, 0);
+        if (tFd < 0)
+            return false;
+
+        ShmRingHeader tHeader;
+        if (read(tFd, &tHeader, sizeof(tHeader)) == (ssize_t)sizeof(tHeader))
+        {
+            // a crashed reader leaves its ring behind
+            tResult = ((tHeader.Magic == SHM_RING_MAGIC) && (tHeader.Version == SHM_RING_VERSION) && (!tHeader.Closed) && ((kill(tHeader.OwnerPid, 0) == 0) || (errno == EPERM)));
+        }
+        close(tFd);
+    #endif
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShmRing::Create(string pRingName)
+{
+    #if defined(LINUX)
+        if (mHeader != NULL)
+        {
+            LOG(LOG_ERROR, "Ring %s is already open", mRingName.c_str());
+            return false;
+        }
+
+        // never truncate an existing ring, another reader could have created it in the meantime
+        int tFd = shm_open(pRingName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if ((tFd < 0) && (errno == EEXIST) && (!IsListening(pRingName)))
+        {// a crashed reader left its ring behind
+            LOG(LOG_VERBOSE, "Removing stale shared memory ring %s", pRingName.c_str());
+            shm_unlink(pRingName.c_str());
+            tFd = shm_open(pRingName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        }
+        if (tFd < 0)
+        {
+            if (errno != EEXIST)
+                LOG(LOG_ERROR, "Failed to create shared memory %s because \"%s\"", pRingName.c_str(), strerror(errno));
+            return false;
+        }
+
+        mSegmentSize = SHM_RING_DATA_OFFSET + SHM_RING_SIZE;
+        if (ftruncate(tFd, mSegmentSize) != 0)
+        {
+            LOG(LOG_ERROR, "Failed to set size of shared memory %s because \"%s\"", pRingName.c_str(), strerror(errno));
+            close(tFd);
+            shm_unlink(pRingName.c_str());
+            return false;
+        }
+
+        void *tSegment = mmap(NULL, mSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, tFd, 0);
+        close(tFd);
+        if (tSegment == MAP_FAILED)
+        {
+            LOG(LOG_ERROR, "Failed to map shared memory %s because \"%s\"", pRingName.c_str(), strerror(errno));
+            shm_unlink(pRingName.c_str());
+            return false;
+        }
+
+        mHeader = (ShmRingHeader*)tSegment;
+        mData = (char*)tSegment + SHM_RING_DATA_OFFSET;
+        memset(mHeader, 0, sizeof(ShmRingHeader));
+        mHeader->Version = SHM_RING_VERSION;
+        mHeader->Size = SHM_RING_SIZE;
+        mHeader->OwnerPid = getpid();
+        __sync_synchronize();
+        // writers accept the ring as soon as they see the magic
+        mHeader->Magic = SHM_RING_MAGIC;
+
+        mRingName = pRingName;
+        mOwner = true;
+        mCanceled = false;
+
+        LOG(LOG_VERBOSE, "Created shared memory ring %s with %d bytes", mRingName.c_str(), SHM_RING_SIZE);
+
+        return true;
+    #else
+        LOG(LOG_ERROR, "Shared memory rings aren't supported on this platform");
+        return false;
+    #endif
+}
+
+bool ShmRing::Open(string pRingName)
+{
+    #if defined(LINUX)
+        if (mHeader != NULL)
+        {
+            LOG(LOG_ERROR, "Ring %s is already open", mRingName.c_str());
+            return false;
+        }
+
+        int tFd = shm_open(pRingName.c_str(), O_RDWR, 0);
+        if (tFd < 0)
+        {
+            LOG(LOG_ERROR, "Failed to open shared memory %s because \"%s\"", pRingName.c_str(), strerror(errno));
+            return false;
+        }
+
+        struct stat tStat;
+        if ((fstat(tFd, &tStat) != 0) || (tStat.st_size < SHM_RING_DATA_OFFSET + SHM_RING_SIZE))
+        {
+            LOG(LOG_ERROR, "Shared memory %s has an invalid size", pRingName.c_str());
+            close(tFd);
+            return false;
+        }
+
+        mSegmentSize = SHM_RING_DATA_OFFSET + SHM_RING_SIZE;
+        void *tSegment = mmap(NULL, mSegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, tFd, 0);
+        close(tFd);
+        if (tSegment == MAP_FAILED)
+        {
+            LOG(LOG_ERROR, "Failed to map shared memory %s because \"%s\"", pRingName.c_str(), strerror(errno));
+            return false;
+        }
+
+        mHeader = (ShmRingHeader*)tSegment;
+        mData = (char*)tSegment + SHM_RING_DATA_OFFSET;
+        if ((mHeader->Magic != SHM_RING_MAGIC) || (mHeader->Version != SHM_RING_VERSION) || (mHeader->Size != SHM_RING_SIZE))
+        {
+            LOG(LOG_ERROR, "Shared memory %s contains an incompatible ring", pRingName.c_str());
+            munmap(tSegment, mSegmentSize);
+            mHeader = NULL;
+            mData = NULL;
+            return false;
+        }
+
+        mRingName = pRingName;
+        mOwner = false;
+        mCanceled = false;
+
+        LOG(LOG_VERBOSE, "Opened shared memory ring %s", mRingName.c_str());
+
+        return true;
+    #else
+        LOG(LOG_ERROR, "Shared memory rings aren't supported on this platform");
+        return false;
+    #endif
+}
+
+void ShmRing::Close()
+{
+    #if defined(LINUX)
+        if (mHeader == NULL)
+            return;
+
+        if (mOwner)
+        {
+            // tell the writers and wake up a waiting reader
+            mHeader->Closed = 1;
+            __sync_fetch_and_add(&mHeader->Sequence, 1);
+            FutexWake(&mHeader->Sequence);
+            shm_unlink(mRingName.c_str());
+        }
+        munmap(mHeader, mSegmentSize);
+        mHeader = NULL;
+        mData = NULL;
+
+        LOG(LOG_VERBOSE, "Closed shared memory ring %s", mRingName.c_str());
+    #endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ShmRing::LockWriter()
+{
+    #if defined(LINUX)
+        int32_t tOwnPid = getpid();
+        int32_t tOwnerPid;
+        int tTurn = 0;
+
+        while ((tOwnerPid = __sync_val_compare_and_swap(&mHeader->WriterLock, 0, tOwnPid)) != 0)
+        {
+            // a writer which died within the critical section would block all other writers forever:
+            // take over its lock, the ring stays consistent because a record is published as last step
+            if ((++tTurn % SHM_RING_WRITER_LOCK_CHECK_PERIOD == 0) && (kill(tOwnerPid, 0) != 0) && (errno == ESRCH))
+            {
+                if (__sync_bool_compare_and_swap(&mHeader->WriterLock, tOwnerPid, tOwnPid))
+                {
+                    LOG(LOG_WARN, "Writer %d died while holding the lock of ring %s, lock recovered", tOwnerPid, mRingName.c_str());
+                    return;
+                }
+            }
+            sched_yield();
+        }
+    #endif
+}
+
+void ShmRing::UnlockWriter()
+{
+    #if defined(LINUX)
+        __sync_lock_release(&mHeader->WriterLock);
+    #endif
+}
+
+bool ShmRing::Write(const char *pData, int pSize, bool pReliable)
+{
+    #if defined(LINUX)
+        if ((mHeader == NULL) || (mHeader->Closed))
+            return false;
+
+        uint32_t tRecordSize = SHM_RING_RECORD_SIZE((uint32_t)pSize);
+        if ((pSize <= 0) || (tRecordSize > SHM_RING_SIZE / 4))
+        {
+            LOG(LOG_ERROR, "Packet of %d bytes doesn't fit into the ring", pSize);
+            return true;
+        }
+
+        uint32_t tWriteIndex, tReadIndex, tOffset, tSizeTillEnd, tNeededSize;
+        while(true)
+        {
+            // several writers may share the ring, the critical section is short
+            LockWriter();
+
+            tWriteIndex = mHeader->WriteIndex;
+            tReadIndex = mHeader->ReadIndex;
+            tOffset = tWriteIndex & (SHM_RING_SIZE - 1);
+            tSizeTillEnd = SHM_RING_SIZE - tOffset;
+            tNeededSize = tRecordSize;
+
+            // records aren't split: skip the rest of the data area if the record doesn't fit
+            if (tSizeTillEnd < tRecordSize)
+                tNeededSize += tSizeTillEnd;
+
+            if (SHM_RING_SIZE - (tWriteIndex - tReadIndex) >= tNeededSize)
+                break;
+
+            UnlockWriter();
+
+            if (!pReliable)
+            {// like a datagram socket buffer: drop the packet if the reader is too slow
+                __sync_fetch_and_add(&mHeader->DroppedPackets, 1);
+                #ifdef SHM_RING_DEBUG_PACKETS
+                    LOG(LOG_WARN, "Ring %s is full, dropped packet of %d bytes", mRingName.c_str(), pSize);
+                #endif
+                return true;
+            }
+
+            // like a stream socket: block until the reader has freed enough space, but not for a dead reader
+            if ((mCanceled) || (mHeader->Closed) || ((kill(mHeader->OwnerPid, 0) != 0) && (errno != EPERM)))
+                return false;
+            #ifdef SHM_RING_DEBUG_PACKETS
+                LOG(LOG_VERBOSE, "Ring %s is full, waiting for the reader", mRingName.c_str());
+            #endif
+            usleep(SHM_RING_WRITER_WAIT_TIME * 1000);
+        }
+
+        if (tSizeTillEnd < tRecordSize)
+        {
+            *(uint32_t*)(mData + tOffset) = SHM_RING_WRAP_MARKER;
+            tWriteIndex += tSizeTillEnd;
+            tOffset = 0;
+        }
+
+        *(uint32_t*)(mData + tOffset) = (uint32_t)pSize;
+        memcpy(mData + tOffset + SHM_RING_RECORD_HEADER_SIZE, pData, pSize);
+
+        // publish the record
+        __sync_synchronize();
+        mHeader->WriteIndex = tWriteIndex + tRecordSize;
+        UnlockWriter();
+
+        // wake up the reader only if it sleeps, otherwise we don't need a syscall
+        __sync_fetch_and_add(&mHeader->Sequence, 1);
+        if (mHeader->ReaderWaiting)
+            FutexWake(&mHeader->Sequence);
+
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+bool ShmRing::Read(char *pBuffer, int &pBufferSize)
+{
+    #if defined(LINUX)
+        if (mHeader == NULL)
+        {
+            pBufferSize = 0;
+            return false;
+        }
+
+        while(true)
+        {
+            uint32_t tReadIndex = mHeader->ReadIndex;
+            uint32_t tWriteIndex = mHeader->WriteIndex;
+            __sync_synchronize();
+
+            if (tReadIndex != tWriteIndex)
+            {
+                uint32_t tOffset = tReadIndex & (SHM_RING_SIZE - 1);
+                uint32_t tSize = *(uint32_t*)(mData + tOffset);
+
+                if (tSize == SHM_RING_WRAP_MARKER)
+                {
+                    mHeader->ReadIndex = tReadIndex + (SHM_RING_SIZE - tOffset);
+                    continue;
+                }
+
+                // like a datagram socket: truncate the packet if the buffer is too small
+                if ((int)tSize > pBufferSize)
+                {
+                    LOG(LOG_WARN, "Receive buffer of %d bytes is too small for packet of %u bytes", pBufferSize, tSize);
+                    tSize = pBufferSize;
+                }
+                memcpy(pBuffer, mData + tOffset + SHM_RING_RECORD_HEADER_SIZE, tSize);
+                pBufferSize = (int)tSize;
+
+                // release the record
+                __sync_synchronize();
+                mHeader->ReadIndex = tReadIndex + SHM_RING_RECORD_SIZE(*(uint32_t*)(mData + tOffset));
+
+                return true;
+            }
+
+            if ((mCanceled) || (mHeader->Closed))
+            {
+                pBufferSize = 0;
+                return false;
+            }
+
+            // announce that we go to sleep and check the ring again afterwards to avoid lost wake ups
+            int32_t tSequence = mHeader->Sequence;
+            mHeader->ReaderWaiting = 1;
+            __sync_synchronize();
+            if ((mHeader->WriteIndex == tReadIndex) && (!mCanceled))
+                FutexWait(&mHeader->Sequence, tSequence, SHM_RING_WAIT_TIMEOUT);
+            mHeader->ReaderWaiting = 0;
+        }
+    #else
+        pBufferSize = 0;
+        return false;
+    #endif
+}
+
+void ShmRing::Cancel()
+{
+    mCanceled = true;
+
+    #if defined(LINUX)
+        if (mHeader != NULL)
+        {
+            __sync_fetch_and_add(&mHeader->Sequence, 1);
+            FutexWake(&mHeader->Sequence);
+        }
+    #endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShmRing::IsClosed()
+{
+    return ((mHeader == NULL) || (mHeader->Closed));
+}
+
+int ShmRing::GetUsage()
+{
+    if (mHeader == NULL)
+        return 0;
+
+    return (int)(mHeader->WriteIndex - mHeader->ReadIndex);
+}
+
+int64_t ShmRing::GetDroppedPackets()
+{
+    if (mHeader == NULL)
+        return 0;
+
+    return mHeader->DroppedPackets;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
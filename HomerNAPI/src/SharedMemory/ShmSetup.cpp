@@ -0,0 +1,120 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2012 Thomas Volkert <thomas@homer-conferencing.com>
+ *
+ * This software is free software.
+ * Your are allowed to redistribute it and/or modify it under the terms of
+ * the GNU General Public License version 2 as published by the Free Software
+ * Foundation.
+ *
+ * This source is published in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License version 2 for more details.
+ *
+ * You should have received a copy of the GNU General Public License version 2
+ * along with this program. Otherwise, you can write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111, USA.
+ * Alternatively, you find an online version of the license text under
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ *****************************************************************************/
+
+/*
+ * Purpose: ShmSetup
+ * Author:  Thomas Volkert
+ * Since:   2012-12-06
+ */
+
+#include <NAPI.h>
+#include <SharedMemory/ShmSetup.h>
+#include <SharedMemory/ShmBinding.h>
+#include <SharedMemory/ShmConnection.h>
+#include <SharedMemory/ShmRing.h>
+#include <Berkeley/SocketConnection.h>
+#include <RequirementTransmitStream.h>
+#include <RequirementTransmitBitErrors.h>
+#include <RequirementTargetPort.h>
+
+#include <Logger.h>
+
+#include <string>
+
+namespace Homer { namespace Base {
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+
+ShmSetup::ShmSetup()
+{
+}
+
+ShmSetup::~ShmSetup()
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+IConnection* ShmSetup::connect(Name *pName, Requirements *pRequirements)
+{
+    if (isListening(pName, pRequirements))
+    {
+        unsigned int tPeerPort = ((RequirementTargetPort*)pRequirements->get(RequirementTargetPort::type()))->getPort();
+        return new ShmConnection(getRingName(pRequirements, tPeerPort), tPeerPort, pRequirements);
+    }
+
+    // remote peer or no local binding: fall back to Berkeley sockets
+    LOG(LOG_VERBOSE, "No local binding found for %s, using Berkeley sockets", pName->toString().c_str());
+    return new SocketConnection(pName->toString(), pRequirements);
+}
+
+IBinding* ShmSetup::bind(Name *pName, Requirements *pRequirements)
+{
+    return new ShmBinding(pName->toString(), pRequirements);
+}
+
+Requirements ShmSetup::getCapabilities(Name *pName, Requirements *pImportantRequirements)
+{
+    // no capabilities are reported: a local peer gets ordered and chunked transfers, lossless for stream and lossless requirements,
+    // a remote one gets the Berkeley sockets, and the returned copy of a filled Requirements object would share its entries
+    Requirements tResult;
+
+    return tResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShmSetup::isLocalName(string pName)
+{
+    return ((pName == "localhost") || (pName.find("127.") == 0) || (pName == "::1") || (pName == "0:0:0:0:0:0:0:1"));
+}
+
+bool ShmSetup::isListening(Name *pName, Requirements *pRequirements)
+{
+    if ((pName == NULL) || (pRequirements == NULL) || (!isLocalName(pName->toString())))
+        return false;
+
+    RequirementTargetPort *tRequPort = (RequirementTargetPort*)pRequirements->get(RequirementTargetPort::type());
+    if ((tRequPort == NULL) || (tRequPort->getPort() == 0))
+        return false;
+
+    return ShmRing::IsListening(getRingName(pRequirements, tRequPort->getPort()));
+}
+
+string ShmSetup::getRingName(Requirements *pRequirements, unsigned int pPort)
+{
+    string tTransport = "udp";
+
+    // separate name spaces per transport like the ports of the OS
+    if (pRequirements->contains(RequirementTransmitStream::type()))
+        tTransport = "tcp";
+    else if (pRequirements->contains(RequirementTransmitBitErrors::type()))
+        tTransport = "udplite";
+
+    return ShmRing::GetRingName(tTransport, pPort);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} //namespace
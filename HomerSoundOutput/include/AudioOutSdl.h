@@ -31,6 +31,8 @@
 
 #include <HBMutex.h>
 
+#include <stdint.h>
+
 #include <list>
 #include <map>
 #include <string>
@@ -47,6 +49,10 @@ namespace Homer { namespace SoundOutput {
 //#define DEBUG_AUDIO_OUT_SDL
 
 #define AUDIO_BUFFER_QUEUE_LIMIT                32
+// amount of pre-allocated chunk slots per channel, has to be a power of 2 and larger than AUDIO_BUFFER_QUEUE_LIMIT
+#define AUDIO_BUFFER_QUEUE_SLOTS                64
+// maximum size of one chunk slot (8192 bytes = 2048 stereo samples of 16 bit)
+#define AUDIO_BUFFER_CHUNK_SIZE                 8192
 
 #define AUDIOOUTSDL AudioOutSdl::getInstance()
 // amount of mixing channels (independent from stereo/mono)
@@ -113,10 +119,24 @@ public:
      * @param pBuffer - pointer to audio buffer
      * @param pBufferSize - size of audio buffer
      * @param pLimitBucket - limits the amount of elements within the chunk queue per channel, exact limit is hard coded
-     * @return false if audio output is closed or memory allocation failed
+     * @return false if audio output is closed or the chunk couldn't be stored in the channel's ring buffer
      */
     bool Enqueue(int pChannel, void *pBuffer, int pBufferSize = 4096, bool pLimitBucket = true);
 
+    /**
+     * @brief get the amount of buffer underruns since the channel was allocated
+     * @param pChannel - channel id
+     * @return amount of situations where the mixer found an empty chunk queue
+     */
+    int64_t GetUnderrunCounter(int pChannel);
+
+    /**
+     * @brief get the time until a chunk which is enqueued now gets audible
+     * @param pChannel - channel id
+     * @return latency of the queued chunks and the mixer's device buffer in ms, -1 if unknown
+     */
+    int GetPlaybackLatency(int pChannel);
+
     /**
      * @brief Query Audio Device Information
      * @return deviceInfo List
@@ -133,16 +153,40 @@ private:
 
     bool mAudioOutOpened;
     int mChannels;
+    int mBytesPerSecond;
+    int mDeviceLatency; // in ms
+
+    /* pre-allocated chunk slot, the Mix_Chunk structure is stored in ChunkDescriptor to avoid the dependency to SDL_mixer in this header */
+    struct ChunkSlot
+    {
+        void    *ChunkDescriptor;
+        char    *Buffer;
+    };
 
+    /*
+     * lock-free single producer ring buffer: Enqueue() writes at WriteIndex,
+     * Play() and PlayerCallBack() consume at ReadIndex after they have
+     * claimed the channel via IsPlaying, ReleaseIndex marks the slot which
+     * is currently played by SDL and mustn't be overwritten
+     */
     struct ChannelEntry
     {
-        std::list<void*> Chunks;
-        void*   LastChunk;
+        ChunkSlot Slots[AUDIO_BUFFER_QUEUE_SLOTS];
+        volatile unsigned int WriteIndex;
+        volatile unsigned int ReadIndex;
+        volatile unsigned int ReleaseIndex;
+        volatile int IsPlaying;
+        volatile int64_t UnderrunCounter;
         Mutex   mMutex;
         bool    Assigned;
-        bool    IsPlaying;
+        bool    SlotsAllocated;
         int 	CallbackRecursionCounter;
     };
+
+    bool AllocateChannelSlots(ChannelEntry *pChannelDesc);
+    void FreeChannelSlots(ChannelEntry *pChannelDesc);
+    /* consumer side, only called after channel was claimed via IsPlaying */
+    bool StartNextChunk(int pChannel, ChannelEntry *pChannelDesc);
     std::map<int, ChannelEntry*> mChannelMap;
 };
 
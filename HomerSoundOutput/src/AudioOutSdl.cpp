@@ -28,10 +28,13 @@
 
 #include <Header_SdlMixer.h>
 #include <AudioOutSdl.h>
+#include <HBAtomic.h>
+#include <HBThread.h>
 #include <Logger.h>
 #include <map>
 #include <string>
 #include <stdlib.h>
+#include <string.h>
 
 namespace Homer { namespace SoundOutput {
 
@@ -41,10 +44,15 @@ using namespace std;
 
 AudioOutSdl AudioOutSdl::sAudioOut;
 
+// SDL's audio thread gets the scheduling policy of audio threads with its first call back
+static volatile int sPlaybackThreadRoleApplied = 0;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 AudioOutSdl::AudioOutSdl()
 {
+    mBytesPerSecond = 0;
+    mDeviceLatency = 0;
 }
 
 AudioOutSdl::~AudioOutSdl()
@@ -167,14 +175,28 @@ bool AudioOutSdl::OpenPlaybackDevice(int pSampleRate, bool pStereo, string pDriv
     LOG(LOG_INFO, "    ..format: %d", tGotSampleFormat);
     LOG(LOG_INFO, "    ..mix channels: %d", mChannels);
 
+    // MIX_DEFAULT_FORMAT uses 16 bit samples, the mixer buffers one chunk of tReqChunksize samples towards the device
+    mBytesPerSecond = tGotSampleRate * tGotChannels * 2;
+    mDeviceLatency = tReqChunksize * 1000 / tGotSampleRate;
+
     // init channel map
     for (int i = 0; i < mChannels; i++)
     {
         ChannelEntry *tChannelEntry = new ChannelEntry();
-        tChannelEntry->LastChunk = NULL;
+        tChannelEntry->WriteIndex = 0;
+        tChannelEntry->ReadIndex = 0;
+        tChannelEntry->ReleaseIndex = 0;
+        tChannelEntry->IsPlaying = 0;
+        tChannelEntry->UnderrunCounter = 0;
         tChannelEntry->Assigned = false;
-        tChannelEntry->IsPlaying = false;
+        tChannelEntry->SlotsAllocated = false;
         tChannelEntry->CallbackRecursionCounter = 0;
+        // chunk slots are allocated in AllocateChannel()
+        for (int j = 0; j < AUDIO_BUFFER_QUEUE_SLOTS; j++)
+        {
+            tChannelEntry->Slots[j].Buffer = NULL;
+            tChannelEntry->Slots[j].ChunkDescriptor = NULL;
+        }
 
         // add this channel descriptor to the channel map (without mutex locking! -> run before anything else)
         mChannelMap[i] = tChannelEntry;
@@ -210,17 +232,24 @@ void AudioOutSdl::ClosePlaybackDevice()
         Mix_ChannelFinished(NULL);
 
         mAudioOutOpened = false;
+        sPlaybackThreadRoleApplied = 0;
+
+        // stop all channels before their chunk slots are freed
+        Mix_HaltChannel(-1);
 
         //HINT: Ignore this request in Windows because it uses different heaps to allocate
         //		when we deallocate perhaps Windows mixes the heaps and our app. crashes to hell -> it's better to lose some memory than go to binary hell
         //see http://mail-archives.apache.org/mod_mbox/xerces-c-dev/200004.mbox/%3C1DBD6F6FF0F9D311BD4000A0C9979E3201A4C7@cvo1.cvo.roguewave.com%3E
 		#ifndef WIN32
-			for (int i = mChannels; i != 0; --i)
+			for (int i = 0; i < mChannels; i++)
+			{
+				FreeChannelSlots(mChannelMap[i]);
 				delete mChannelMap[i];
+			}
 		#endif
         mChannelMap.clear();
 
-        // stop all channels
+        // stop music playback
         Mix_HaltMusic();
 
         // close SDL_mixer
@@ -231,6 +260,51 @@ void AudioOutSdl::ClosePlaybackDevice()
     }
 }
 
+bool AudioOutSdl::AllocateChannelSlots(ChannelEntry *pChannelDesc)
+{
+    for (int i = 0; i < AUDIO_BUFFER_QUEUE_SLOTS; i++)
+    {
+        ChunkSlot *tSlot = &pChannelDesc->Slots[i];
+
+        tSlot->Buffer = (char*)malloc(AUDIO_BUFFER_CHUNK_SIZE);
+        Mix_Chunk *tChunk = (Mix_Chunk*)malloc(sizeof(Mix_Chunk));
+        if ((tSlot->Buffer == NULL) || (tChunk == NULL))
+        {
+            LOG(LOG_ERROR, "Can not allocate chunk slot %d because an out of memory occurred", i);
+            free(tSlot->Buffer);
+            free(tChunk);
+            tSlot->Buffer = NULL;
+            tSlot->ChunkDescriptor = NULL;
+            FreeChannelSlots(pChannelDesc);
+            return false;
+        }
+
+        // the buffer belongs to us, SDL_mixer mustn't free it
+        tChunk->allocated = 0;
+        tChunk->abuf = (Uint8*)tSlot->Buffer;
+        tChunk->alen = 0;
+        tChunk->volume = MIX_MAX_VOLUME;
+        tSlot->ChunkDescriptor = tChunk;
+    }
+    pChannelDesc->SlotsAllocated = true;
+
+    return true;
+}
+
+void AudioOutSdl::FreeChannelSlots(ChannelEntry *pChannelDesc)
+{
+    for (int i = 0; i < AUDIO_BUFFER_QUEUE_SLOTS; i++)
+    {
+        ChunkSlot *tSlot = &pChannelDesc->Slots[i];
+
+        free(tSlot->Buffer);
+        free(tSlot->ChunkDescriptor);
+        tSlot->Buffer = NULL;
+        tSlot->ChunkDescriptor = NULL;
+    }
+    pChannelDesc->SlotsAllocated = false;
+}
+
 int AudioOutSdl::AllocateChannel()
 {
     int tResult = -1;
@@ -247,10 +321,18 @@ int AudioOutSdl::AllocateChannel()
 
         if (!tChannelDesc->Assigned)
         {
-            tChannelDesc->Assigned = true;
-            tChannelDesc->Chunks.clear();
-            tChannelDesc->IsPlaying = false;
-            tResult = i;
+            // allocate the chunk slots only once, they are reused if the channel gets assigned again
+            if ((tChannelDesc->SlotsAllocated) || (AllocateChannelSlots(tChannelDesc)))
+            {
+                tChannelDesc->WriteIndex = 0;
+                tChannelDesc->ReadIndex = 0;
+                tChannelDesc->ReleaseIndex = 0;
+                tChannelDesc->IsPlaying = 0;
+                tChannelDesc->UnderrunCounter = 0;
+                Atomic::Barrier();
+                tChannelDesc->Assigned = true;
+                tResult = i;
+            }
         }
 
         // unlock
@@ -280,22 +362,9 @@ void AudioOutSdl::ReleaseChannel(int pChannel)
 
     if (tChannelDesc->Assigned)
     {
-        // unassign the channel
+        // unassign the channel, the chunk slots stay allocated because SDL might still play the last chunk
         tChannelDesc->Assigned = false;
 
-        Mix_Chunk* tLastChunk = (Mix_Chunk*)tChannelDesc->LastChunk;
-
-        // reset and free possible current buffer
-        if (tLastChunk != NULL)
-        {
-
-            // free buffer memory of old chunk
-            Mix_FreeChunk(tLastChunk);
-
-            // reset pointer
-            tChannelDesc->LastChunk = NULL;
-        }
-
         ClearChunkListInternal(pChannel);
     }
 
@@ -312,42 +381,68 @@ void AudioOutSdl::ClearChunkList(int pChannel)
     if (!mAudioOutOpened)
         return;
 
-    ChannelEntry* tChannelDesc = mChannelMap[pChannel];
-
-    tChannelDesc->mMutex.lock();
-
     ClearChunkListInternal(pChannel);
-
-    tChannelDesc->mMutex.unlock();
 }
 
 void AudioOutSdl::ClearChunkListInternal(int pChannel)
 {
     ChannelEntry* tChannelDesc = mChannelMap[pChannel];
+    unsigned int tReadIndex, tWriteIndex;
 
 	#ifdef DEBUG_AUDIO_OUT_SDL
 		LOG(LOG_VERBOSE, "Clearing chunk list internally");
 	#endif
 
-    // free chunk list
-    std::list<void*>::iterator tItEnd = tChannelDesc->Chunks.end();
-    for (std::list<void*>::iterator tIt = tChannelDesc->Chunks.begin(); tIt != tItEnd; tIt++)
-    {
-        Mix_Chunk* tChunk = (Mix_Chunk*)(*tIt);
-
-        // free buffer memory of chunk
-        Mix_FreeChunk(tChunk);
-    }
-    tChannelDesc->Chunks.clear();
+    // drop all queued chunks by moving the read index to the write index, races with the consumer side are resolved via CAS
+    do{
+        tReadIndex = tChannelDesc->ReadIndex;
+        tWriteIndex = tChannelDesc->WriteIndex;
+    }while ((tReadIndex != tWriteIndex) && (!Atomic::CompareAndSwap(&tChannelDesc->ReadIndex, tReadIndex, tWriteIndex)));
 
 	#ifdef DEBUG_AUDIO_OUT_SDL
 		LOG(LOG_VERBOSE, "Clearing of chunk list finished");
 	#endif
 }
 
+bool AudioOutSdl::StartNextChunk(int pChannel, ChannelEntry *pChannelDesc)
+{
+    unsigned int tReadIndex;
+
+    // get the next chunk for playing
+    do{
+        tReadIndex = pChannelDesc->ReadIndex;
+        Atomic::Barrier();
+        if (tReadIndex == pChannelDesc->WriteIndex)
+        {
+            // nothing queued, the last played chunk isn't needed anymore
+            pChannelDesc->ReleaseIndex = tReadIndex;
+            return false;
+        }
+    }while (!Atomic::CompareAndSwap(&pChannelDesc->ReadIndex, tReadIndex, tReadIndex + 1));
+
+    // the previous chunk has finished, protect the slot of the new one until its playback has finished
+    pChannelDesc->ReleaseIndex = tReadIndex;
+
+    Mix_Chunk* tChunk = (Mix_Chunk*)pChannelDesc->Slots[tReadIndex & (AUDIO_BUFFER_QUEUE_SLOTS - 1)].ChunkDescriptor;
+
+    // play the new chunk (0 loops), SDL_mixer calls PlayerCallBack recursively if the channel is still busy
+    pChannelDesc->CallbackRecursionCounter++;
+    int tGotChannel = Mix_PlayChannel(pChannel, tChunk, 0);
+    pChannelDesc->CallbackRecursionCounter--;
+
+    if (tGotChannel != pChannel)
+    {
+        LOG(LOG_ERROR, "Unable to play chunk because of: %s", Mix_GetError());
+        pChannelDesc->ReleaseIndex = tReadIndex + 1;
+        ClearChunkListInternal(pChannel);
+        return false;
+    }
+
+    return true;
+}
+
 bool AudioOutSdl::Play(int pChannel)
 {
-    Mix_Chunk* tChunk = NULL;
     bool tResult = false;
 
     if (pChannel == -1)
@@ -369,73 +464,21 @@ bool AudioOutSdl::Play(int pChannel)
     {
         ChannelEntry* tChannelDesc = mChannelMap[pChannel];
 
-		#ifdef DEBUG_AUDIO_OUT_SDL
-			LOG(LOG_VERBOSE, "Locking channel descriptor");
-		#endif
-        // lock
-        tChannelDesc->mMutex.lock();
-
-		#ifdef DEBUG_AUDIO_OUT_SDL
-			LOG(LOG_VERBOSE, "Channel descriptor locked");
-		#endif
-
-        if (!tChannelDesc->IsPlaying)
+        if (tChannelDesc->Assigned)
         {
-            // play new chunk
-            if ((tChannelDesc->Chunks.size() > 0) && (tChannelDesc->Assigned))
+            // claim the channel, otherwise the SDL callback is already in charge of it
+            while ((tChannelDesc->ReadIndex != tChannelDesc->WriteIndex) && (Atomic::CompareAndSwap(&tChannelDesc->IsPlaying, 0, 1)))
             {
-                // get new chunk for playing
-                tChunk = (Mix_Chunk*)tChannelDesc->Chunks.front();
-                tChannelDesc->Chunks.pop_front();
-
-                // unlock to prevent deadlock with SDL_lock
-                tChannelDesc->mMutex.unlock();
-
-                // play the new chunk (0 loops)
-				#ifdef DEBUG_AUDIO_OUT_SDL
-                	LOG(LOG_VERBOSE, "Starting playback on SDL channel %d", pChannel);
-				#endif
+                if (StartNextChunk(pChannel, tChannelDesc))
+                    break;
 
-                int tGotChannel = Mix_PlayChannel(pChannel, tChunk, 0);
-
-				#ifdef DEBUG_AUDIO_OUT_SDL
-					LOG(LOG_VERBOSE, "Playback on SDL channel %d started", pChannel);
-				#endif
-
-				// lock
-                tChannelDesc->mMutex.lock();
-
-                if (tGotChannel != pChannel)
-                {
-                    LOG(LOG_ERROR, "Callback failed, unable to play chunk because of: %s", Mix_GetError());
-                    ClearChunkListInternal(pChannel);
-                }else
-                    tChannelDesc->IsPlaying = true;
+                // nothing to play, give up the claim and check again for a chunk which was enqueued meanwhile
+                Atomic::Exchange(&tChannelDesc->IsPlaying, 0);
             }
-
-	        Mix_Chunk* tLastChunk = (Mix_Chunk*)tChannelDesc->LastChunk;
-	        
-            // free memory
-            if (tLastChunk != NULL)
-            {
-                // free buffer memory of old chunk
-                Mix_FreeChunk(tLastChunk);
-            }
-
-            // update the current chunk pointer
-            tChannelDesc->LastChunk = tChunk;
-        }else
-        {
-			#ifdef DEBUG_AUDIO_OUT_SDL
-        		LOG(LOG_VERBOSE, "Channel %d is already playing", pChannel);
-			#endif
         }
 
         // were we successful?
-        tResult = tChannelDesc->IsPlaying;
-
-        // unlock
-        tChannelDesc->mMutex.unlock();
+        tResult = (tChannelDesc->IsPlaying != 0);
     }else
     {
 		LOG(LOG_WARN, "Channel %d is unknown", pChannel);
@@ -464,13 +507,7 @@ bool AudioOutSdl::Stop(int pChannel)
 
     ChannelEntry* tChannelDesc = mChannelMap[pChannel];
 
-    // lock
-    tChannelDesc->mMutex.lock();
-
-    tChannelDesc->IsPlaying = false;
-
-    // unlock
-    tChannelDesc->mMutex.unlock();
+    Atomic::Exchange(&tChannelDesc->IsPlaying, 0);
 
 	#ifdef DEBUG_AUDIO_OUT_SDL
     	LOG(LOG_VERBOSE, "Stopping of playback on SDL channel %d finished", pChannel);
@@ -495,60 +532,89 @@ bool AudioOutSdl::Enqueue(int pChannel, void *pBuffer, int pBufferSize, bool pLi
     if (!mAudioOutOpened)
         return false;
 
-    if(pBufferSize <= 0)
+    if((pBufferSize <= 0) || (pBufferSize > AUDIO_BUFFER_CHUNK_SIZE))
     {
         LOG(LOG_ERROR, "Invalid buffer size %d, skipping this chunk", pBufferSize);
         return false;
     }
 
-    void *tBuffer = malloc(pBufferSize);
-    if (tBuffer == NULL)
-    {
-        LOG(LOG_ERROR, "Can not enqueue because an out of memory occurred");
-        return false;
-    }
-
-    // copy buffer, hence the original one can be freed within the upper application
-    memcpy(tBuffer, pBuffer, pBufferSize);
-
-    Mix_Chunk *tNewChunk = Mix_QuickLoad_RAW((Uint8 *)tBuffer, (Uint32)pBufferSize);
-    if (tNewChunk == NULL)
-    {
-        LOG(LOG_ERROR, "AudioOutSdl-Error when loading sample for audio output because of: %s", Mix_GetError());
-        return false;
-    }
-
     if (mChannelMap.find(pChannel) != mChannelMap.end())
     {
         ChannelEntry* tChannelDesc = mChannelMap[pChannel];
 
-        // lock
-        tChannelDesc->mMutex.lock();
+        if ((!tChannelDesc->Assigned) || (!tChannelDesc->SlotsAllocated))
+            return false;
+
+        unsigned int tWriteIndex = tChannelDesc->WriteIndex;
+        unsigned int tReadIndex = tChannelDesc->ReadIndex;
+        unsigned int tReleaseIndex = tChannelDesc->ReleaseIndex;
+        Atomic::Barrier();
 
         // check for queue limit
-        if ((pLimitBucket) && (tChannelDesc->Chunks.size() > AUDIO_BUFFER_QUEUE_LIMIT))
+        if ((pLimitBucket) && (tWriteIndex - tReadIndex > AUDIO_BUFFER_QUEUE_LIMIT))
         {
             LOG(LOG_WARN, "AudioOutSdl-Latency too high, dropping audio samples");
-            // free buffer memory of new chunk
-            free(tNewChunk->abuf);
-            // free memory of new chunk
-            free(tNewChunk);
-        }else
+            return true;
+        }
+
+        // check for free slot, the slot of the currently played chunk is still in use
+        if (tWriteIndex - tReleaseIndex >= AUDIO_BUFFER_QUEUE_SLOTS)
         {
-            #ifdef DEBUG_AUDIO_OUT_SDL
-                LOG(LOG_VERBOSE, "Channel %d, queue size: %d", pChannel, (int)tChannelDesc->Chunks.size());
-            #endif
-            // add new chunk to queue
-            tChannelDesc->Chunks.push_back(tNewChunk);
+            LOG(LOG_WARN, "AudioOutSdl-Ring buffer of channel %d is full, dropping audio samples", pChannel);
+            return false;
         }
 
-        // unlock
-        tChannelDesc->mMutex.unlock();
+        #ifdef DEBUG_AUDIO_OUT_SDL
+            LOG(LOG_VERBOSE, "Channel %d, queue size: %u", pChannel, tWriteIndex - tReadIndex);
+        #endif
+
+        // copy buffer to the pre-allocated slot, hence the original one can be freed within the upper application
+        ChunkSlot *tSlot = &tChannelDesc->Slots[tWriteIndex & (AUDIO_BUFFER_QUEUE_SLOTS - 1)];
+        memcpy(tSlot->Buffer, pBuffer, pBufferSize);
+        ((Mix_Chunk*)tSlot->ChunkDescriptor)->alen = (Uint32)pBufferSize;
+
+        // publish the new chunk to the consumer side
+        Atomic::Barrier();
+        tChannelDesc->WriteIndex = tWriteIndex + 1;
     }
 
     return true;
 }
 
+int64_t AudioOutSdl::GetUnderrunCounter(int pChannel)
+{
+    if ((pChannel == -1) || (!mAudioOutOpened))
+        return 0;
+
+    if (mChannelMap.find(pChannel) == mChannelMap.end())
+        return 0;
+
+    return mChannelMap[pChannel]->UnderrunCounter;
+}
+
+int AudioOutSdl::GetPlaybackLatency(int pChannel)
+{
+    if ((pChannel == -1) || (!mAudioOutOpened) || (mBytesPerSecond == 0))
+        return -1;
+
+    if (mChannelMap.find(pChannel) == mChannelMap.end())
+        return -1;
+
+    ChannelEntry* tChannelDesc = mChannelMap[pChannel];
+    if ((!tChannelDesc->Assigned) || (!tChannelDesc->SlotsAllocated))
+        return -1;
+
+    // the slots from the currently played one up to the write index can't be overwritten while the producer is here
+    unsigned int tWriteIndex = tChannelDesc->WriteIndex;
+    unsigned int tReleaseIndex = tChannelDesc->ReleaseIndex;
+    Atomic::Barrier();
+    int64_t tQueuedBytes = 0;
+    for (unsigned int i = tReleaseIndex; i != tWriteIndex; i++)
+        tQueuedBytes += ((Mix_Chunk*)tChannelDesc->Slots[i & (AUDIO_BUFFER_QUEUE_SLOTS - 1)].ChunkDescriptor)->alen;
+
+    return (int)(tQueuedBytes * 1000 / mBytesPerSecond) + mDeviceLatency;
+}
+
 AudioOutInfo AudioOutSdl::QueryAudioOutDevices()
 {
     AudioOutInfo tAudioOutInfo;
@@ -603,8 +669,6 @@ void AudioOutSdl::PlayerCallBack(int pChannel)
     if (pChannel == -1)
         return;
 
-    Mix_Chunk* tChunk = NULL;
-
 	#ifdef DEBUG_AUDIO_OUT_SDL
     	LOGEX(AudioOutSdl, LOG_WARN, "Got request for audio data for channel %d from SDL", pChannel);
 	#endif
@@ -612,52 +676,39 @@ void AudioOutSdl::PlayerCallBack(int pChannel)
     if (!AUDIOOUTSDL.mAudioOutOpened)
         return;
 
+    if (Atomic::CompareAndSwap(&sPlaybackThreadRoleApplied, 0, 1))
+    {
+        string tPolicy;
+        Thread::ApplyRole(THREAD_ROLE_AUDIO_IO, tPolicy);
+    }
+
     if (AUDIOOUTSDL.mChannelMap.find(pChannel) != AUDIOOUTSDL.mChannelMap.end())
     {
         ChannelEntry* tChannelDesc = AUDIOOUTSDL.mChannelMap[pChannel];
         if (tChannelDesc->CallbackRecursionCounter == 0)
         {
-			// lock
-			if (!tChannelDesc->mMutex.tryLock(5000))
-			{
-				LOGEX(AudioOutSdl, LOG_WARN, "System is so terribly slow?, PlayerCallBack couldn't lock the mutex for channel %d", pChannel);
-				return;
-			}
+            // the current chunk has finished, the channel is ours now: no locking and no memory management within SDL's audio thread
+            Atomic::Exchange(&tChannelDesc->IsPlaying, 0);
 
-			tChannelDesc->CallbackRecursionCounter++;
-			tChannelDesc->IsPlaying = false;
+            if (!tChannelDesc->Assigned)
+                return;
 
-			// play new chunk
-			if ((tChannelDesc->Chunks.size() > 0) && (tChannelDesc->Assigned))
-			{
-				// get new chunk for playing
-				tChunk = (Mix_Chunk*)tChannelDesc->Chunks.front();
-				if (tChunk != NULL)
-				{
-					tChannelDesc->Chunks.pop_front();
-
-					// play the new chunk (0 loops)
-					int tGotChannel = Mix_PlayChannel(pChannel, tChunk, 0);
-
-					if (tGotChannel == -1)
-					{
-						LOGEX(AudioOutSdl, LOG_ERROR, "Callback failed, unable to play chunk because of: %s", Mix_GetError());
-						AUDIOOUTSDL.ClearChunkListInternal(pChannel);
-					}else
-						tChannelDesc->IsPlaying = true;
-				}
-			}
-
-			Mix_Chunk* tLastChunk = (Mix_Chunk*)tChannelDesc->LastChunk;
-
-			// update the current chunk pointer
-			tChannelDesc->LastChunk = (void*)tChunk;
-
-			// unlock
-			tChannelDesc->mMutex.unlock();
+            while (Atomic::CompareAndSwap(&tChannelDesc->IsPlaying, 0, 1))
+            {
+                if (AUDIOOUTSDL.StartNextChunk(pChannel, tChannelDesc))
+                    break;
 
-			Mix_FreeChunk(tLastChunk);
-			tChannelDesc->CallbackRecursionCounter--;
+                // nothing to play, give up the claim and check again for a chunk which was enqueued meanwhile
+                Atomic::Exchange(&tChannelDesc->IsPlaying, 0);
+                if (tChannelDesc->ReadIndex == tChannelDesc->WriteIndex)
+                {
+                    tChannelDesc->UnderrunCounter++;
+                    #ifdef DEBUG_AUDIO_OUT_SDL
+                        LOGEX(AudioOutSdl, LOG_WARN, "Chunk queue of channel %d ran empty, underruns: %ld", pChannel, (long)tChannelDesc->UnderrunCounter);
+                    #endif
+                    break;
+                }
+            }
         }else
         	LOGEX(AudioOutSdl, LOG_WARN, "Callback recursion detected, will break recursion here at depth of 1");
 	}